@@ -34,6 +34,9 @@ struct PacketOptions {
   bool is_retransmit = false;
   bool included_in_feedback = false;
   bool included_in_allocation = false;
+  // Whether the packet is part of a paced burst and may be batched with the
+  // following packets by the socket, see rtc::PacketOptions::batchable.
+  bool batchable = false;
 };
 
 class Transport {
@@ -90,6 +90,10 @@ class DataChannelObserver {
   virtual void OnMessage(const DataBuffer& buffer) = 0;
   // The data channel's buffered_amount has changed.
   virtual void OnBufferedAmountChange(uint64_t sent_data_size) {}
+  // The data channel's buffered_amount has dropped from above its
+  // buffered_amount_low_threshold to at or below it. Senders can use this to
+  // refill the buffer without polling buffered_amount.
+  virtual void OnBufferedAmountLow() {}
 
  protected:
   virtual ~DataChannelObserver() = default;
@@ -162,6 +166,12 @@ class DataChannelInterface : public rtc::RefCountInterface {
   // the SCTP level. See comment above Send below.
   virtual uint64_t buffered_amount() const = 0;
 
+  // C++ version of the bufferedAmountLowThreshold attribute. When
+  // buffered_amount() drops from above this threshold to at or below it,
+  // DataChannelObserver::OnBufferedAmountLow is called. Defaults to 0.
+  virtual uint64_t buffered_amount_low_threshold() const;
+  virtual void SetBufferedAmountLowThreshold(uint64_t threshold);
+
   // Begins the graceful data channel closing procedure. See:
   // https://tools.ietf.org/html/draft-ietf-rtcweb-data-channel-13#section-6.7
   virtual void Close() = 0;
@@ -171,9 +181,9 @@ class DataChannelInterface : public rtc::RefCountInterface {
   // up to a maximum of 16MB. If Send is called while this buffer is full, the
   // data channel will be closed abruptly.
   //
-  // So, it's important to use buffered_amount() and OnBufferedAmountChange to
-  // ensure the data channel is used efficiently but without filling this
-  // buffer.
+  // So, it's important to use buffered_amount() and OnBufferedAmountChange or
+  // OnBufferedAmountLow to ensure the data channel is used efficiently but
+  // without filling this buffer.
   virtual bool Send(const DataBuffer& buffer) = 0;
 
  protected:
@@ -0,0 +1,37 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef API_NETWORK_THREAD_ASSIGNMENT_POLICY_H_
+#define API_NETWORK_THREAD_ASSIGNMENT_POLICY_H_
+
+#include <stddef.h>
+
+#include "api/array_view.h"
+
+namespace webrtc {
+
+// Chooses which of the network threads owned by a PeerConnectionFactory a new
+// PeerConnection is pinned to. All of the PeerConnection's transports, ICE
+// channels and sockets then live on that thread. Called on the signaling
+// thread.
+class NetworkThreadAssignmentPolicy {
+ public:
+  virtual ~NetworkThreadAssignmentPolicy() {}
+
+  // |peer_connections_per_thread| holds, for each network thread, the number
+  // of live PeerConnections pinned to it. Returns the index of the thread to
+  // use; out-of-range values are clamped to the last thread.
+  virtual size_t SelectNetworkThread(
+      rtc::ArrayView<const int> peer_connections_per_thread) = 0;
+};
+
+}  // namespace webrtc
+
+#endif  // API_NETWORK_THREAD_ASSIGNMENT_POLICY_H_
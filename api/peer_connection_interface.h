@@ -84,6 +84,7 @@
 #include "api/media_stream_interface.h"
 #include "api/media_transport_interface.h"
 #include "api/network_state_predictor.h"
+#include "api/network_thread_assignment_policy.h"
 #include "api/rtc_error.h"
 #include "api/rtc_event_log_output.h"
 #include "api/rtp_receiver_interface.h"
@@ -1254,6 +1255,16 @@ struct PeerConnectionFactoryDependencies final {
 
   // Optional dependencies
   rtc::Thread* network_thread = nullptr;
+  // Number of network threads the factory creates and owns when
+  // |network_thread| is not set. Each PeerConnection is pinned to one of them
+  // by |network_thread_policy|, so packet I/O, SRTP and ICE of different
+  // PeerConnections run in parallel. PeerConnections created with an injected
+  // PortAllocator always use the first network thread, since the allocator is
+  // bound to a thread before the choice is made.
+  int network_thread_count = 1;
+  // Picks the network thread for each new PeerConnection. If not set, the
+  // thread with the fewest PeerConnections is used.
+  std::unique_ptr<NetworkThreadAssignmentPolicy> network_thread_policy;
   rtc::Thread* worker_thread = nullptr;
   rtc::Thread* signaling_thread = nullptr;
   std::unique_ptr<TaskQueueFactory> task_queue_factory;
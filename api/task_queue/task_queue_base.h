@@ -10,7 +10,9 @@
 #ifndef API_TASK_QUEUE_TASK_QUEUE_BASE_H_
 #define API_TASK_QUEUE_TASK_QUEUE_BASE_H_
 
+#include <stdint.h>
 #include <memory>
+#include <utility>
 
 #include "api/task_queue/queued_task.h"
 #include "rtc_base/thread_annotations.h"
@@ -51,6 +53,19 @@ class RTC_LOCKABLE TaskQueueBase {
   virtual void PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                uint32_t milliseconds) = 0;
 
+  // Like PostDelayedTask(), but with the delay in microseconds, for the few
+  // users that need better than millisecond precision, e.g. a pacer sending
+  // a packet every few hundred microseconds. All task queues in this tree
+  // override it. What remains millisecond granular, with the delay rounded up:
+  // the libevent queue outside Linux, where it has no timerfd, and the Windows
+  // queue before Windows 10 version 1803, which lacks high resolution
+  // waitable timers. This default does the same for other implementations.
+  virtual void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                 int64_t microseconds) {
+    PostDelayedTask(std::move(task),
+                    static_cast<uint32_t>((microseconds + 999) / 1000));
+  }
+
   // Returns the task queue that is running the current thread.
   // Returns nullptr if this thread is not associated with any task queue.
   static TaskQueueBase* Current();
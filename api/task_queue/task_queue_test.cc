@@ -9,6 +9,8 @@
  */
 #include "api/task_queue/task_queue_test.h"
 
+#include <functional>
+
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "rtc_base/event.h"
@@ -110,6 +112,52 @@ TEST_P(TaskQueueTest, PostDelayed) {
   EXPECT_NEAR(end - start, 190u, 100u);  // Accept 90-290.
 }
 
+TEST_P(TaskQueueTest, PostDelayedUs) {
+  std::unique_ptr<webrtc::TaskQueueFactory> factory = GetParam()();
+  rtc::Event event;
+  auto queue = CreateTaskQueue(factory, "PostDelayedUs",
+                               TaskQueueFactory::Priority::HIGH);
+
+  int64_t start_us = rtc::TimeMicros();
+  queue->PostDelayedTaskUs(ToQueuedTask([&event, &queue] {
+                             EXPECT_TRUE(queue->IsCurrent());
+                             event.Set();
+                           }),
+                           1500);
+  EXPECT_TRUE(event.Wait(1000));
+  // Implementations without a high resolution timer round up to whole
+  // milliseconds, which may fire up to a millisecond early on a coarse clock.
+  EXPECT_GE(rtc::TimeMicros() - start_us, 500);
+}
+
+TEST_P(TaskQueueTest, PostDelayedUsFinerThanMilliseconds) {
+  // A chain of short delays finishes well before the same chain rounded up to
+  // whole milliseconds would.
+  constexpr int kTasks = 50;
+  constexpr int64_t kDelayUs = 200;
+  std::unique_ptr<webrtc::TaskQueueFactory> factory = GetParam()();
+  rtc::Event event;
+  auto queue = CreateTaskQueue(factory, "PostDelayedUsFinerThanMilliseconds",
+                               TaskQueueFactory::Priority::HIGH);
+
+  int remaining = kTasks;
+  std::function<void()> post_next = [&] {
+    queue->PostDelayedTaskUs(ToQueuedTask([&] {
+                               if (--remaining == 0)
+                                 event.Set();
+                               else
+                                 post_next();
+                             }),
+                             kDelayUs);
+  };
+  int64_t start_us = rtc::TimeMicros();
+  queue->PostTask(ToQueuedTask([&post_next] { post_next(); }));
+  EXPECT_TRUE(event.Wait(1000));
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_GE(elapsed_us, kTasks * kDelayUs - rtc::kNumMicrosecsPerMillisec);
+  EXPECT_LT(elapsed_us, kTasks * rtc::kNumMicrosecsPerMillisec * 4 / 5);
+}
+
 TEST_P(TaskQueueTest, PostMultipleDelayed) {
   std::unique_ptr<webrtc::TaskQueueFactory> factory = GetParam()();
   auto queue = CreateTaskQueue(factory, "PostMultipleDelayed");
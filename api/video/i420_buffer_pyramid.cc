@@ -0,0 +1,188 @@
+/*
+ *  Copyright 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/video/i420_buffer_pyramid.h"
+
+#include "rtc_base/atomic_ops.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/ref_counted_object.h"
+
+namespace webrtc {
+
+namespace {
+
+// Bounds the memory held by a buffer that is scaled to many resolutions.
+// Requests beyond this are computed, but not cached.
+const size_t kMaxLevels = 16;
+
+}  // namespace
+
+I420BufferPyramid::Level::Level(int offset_x,
+                                int offset_y,
+                                int crop_width,
+                                int crop_height,
+                                int width,
+                                int height)
+    : offset_x(offset_x),
+      offset_y(offset_y),
+      crop_width(crop_width),
+      crop_height(crop_height),
+      width(width),
+      height(height) {}
+
+I420BufferPyramid::Level::~Level() = default;
+
+I420BufferPyramid::I420BufferPyramid(I420BufferInterface* source)
+    : source_(source) {}
+
+I420BufferPyramid::~I420BufferPyramid() = default;
+
+// static
+I420BufferPyramid* I420BufferPyramid::Of(I420BufferInterface* buffer) {
+  RTC_DCHECK(buffer);
+  rtc::RefCountInterface* pyramid =
+      rtc::AtomicOps::AcquireLoadPtr(&buffer->scaling_pyramid_);
+  if (!pyramid) {
+    rtc::RefCountInterface* created =
+        new rtc::RefCountedObject<I420BufferPyramid>(buffer);
+    created->AddRef();
+    pyramid = rtc::AtomicOps::CompareAndSwapPtr(
+        &buffer->scaling_pyramid_,
+        static_cast<rtc::RefCountInterface*>(nullptr), created);
+    if (pyramid) {
+      // Another thread attached a pyramid first.
+      created->Release();
+    } else {
+      pyramid = created;
+    }
+  }
+  return static_cast<I420BufferPyramid*>(pyramid);
+}
+
+// static
+void I420BufferPyramid::Invalidate(I420BufferInterface* buffer) {
+  rtc::RefCountInterface* pyramid =
+      rtc::AtomicOps::AcquireLoadPtr(&buffer->scaling_pyramid_);
+  if (!pyramid)
+    return;
+  I420BufferPyramid* self = static_cast<I420BufferPyramid*>(pyramid);
+  std::vector<rtc::scoped_refptr<Level>> levels;
+  {
+    rtc::CritScope cs(&self->levels_lock_);
+    levels.swap(self->levels_);
+  }
+}
+
+rtc::scoped_refptr<I420BufferInterface> I420BufferPyramid::Scale(
+    int scaled_width,
+    int scaled_height) {
+  return CropAndScale(0, 0, source_->width(), source_->height(), scaled_width,
+                      scaled_height);
+}
+
+rtc::scoped_refptr<I420BufferInterface> I420BufferPyramid::CropAndScale(
+    int offset_x,
+    int offset_y,
+    int crop_width,
+    int crop_height,
+    int scaled_width,
+    int scaled_height) {
+  RTC_CHECK_GE(offset_x, 0);
+  RTC_CHECK_GE(offset_y, 0);
+  RTC_CHECK_LE(crop_width + offset_x, source_->width());
+  RTC_CHECK_LE(crop_height + offset_y, source_->height());
+  RTC_CHECK_GT(scaled_width, 0);
+  RTC_CHECK_GT(scaled_height, 0);
+
+  // Same rounding as I420Buffer::CropAndScaleFrom(), so that equivalent
+  // requests share a level.
+  offset_x = offset_x / 2 * 2;
+  offset_y = offset_y / 2 * 2;
+
+  if (offset_x == 0 && offset_y == 0 && crop_width == source_->width() &&
+      crop_height == source_->height() && scaled_width == crop_width &&
+      scaled_height == crop_height) {
+    return source_;
+  }
+
+  rtc::scoped_refptr<Level> level = GetLevel(
+      offset_x, offset_y, crop_width, crop_height, scaled_width, scaled_height);
+  if (!level) {
+    rtc::scoped_refptr<I420Buffer> buffer =
+        I420Buffer::Create(scaled_width, scaled_height);
+    ScaleInto(offset_x, offset_y, crop_width, crop_height, buffer.get());
+    return buffer;
+  }
+
+  rtc::CritScope cs(&level->lock);
+  if (!level->buffer) {
+    rtc::scoped_refptr<I420Buffer> buffer =
+        I420Buffer::Create(scaled_width, scaled_height);
+    ScaleInto(offset_x, offset_y, crop_width, crop_height, buffer.get());
+    level->buffer = buffer;
+  }
+  return level->buffer;
+}
+
+rtc::scoped_refptr<I420BufferPyramid::Level> I420BufferPyramid::GetLevel(
+    int offset_x,
+    int offset_y,
+    int crop_width,
+    int crop_height,
+    int width,
+    int height) {
+  rtc::CritScope cs(&levels_lock_);
+  for (const rtc::scoped_refptr<Level>& level : levels_) {
+    if (level->offset_x == offset_x && level->offset_y == offset_y &&
+        level->crop_width == crop_width && level->crop_height == crop_height &&
+        level->width == width && level->height == height) {
+      return level;
+    }
+  }
+  if (levels_.size() >= kMaxLevels)
+    return nullptr;
+  levels_.push_back(new rtc::RefCountedObject<Level>(
+      offset_x, offset_y, crop_width, crop_height, width, height));
+  return levels_.back();
+}
+
+void I420BufferPyramid::ScaleInto(int offset_x,
+                                  int offset_y,
+                                  int crop_width,
+                                  int crop_height,
+                                  I420Buffer* buffer) {
+  const int width = buffer->width();
+  const int height = buffer->height();
+  // Find the smallest level at 1/2^n of the crop that covers |buffer|. A
+  // level at exactly that size is computed from the level above it.
+  int n = 0;
+  while ((crop_width >> (n + 1)) >= width &&
+         (crop_height >> (n + 1)) >= height) {
+    ++n;
+  }
+  if (n > 0 && (crop_width >> n) == width && (crop_height >> n) == height)
+    --n;
+
+  if (n == 0) {
+    buffer->CropAndScaleFrom(*source_, offset_x, offset_y, crop_width,
+                             crop_height);
+    return;
+  }
+  // The caller may hold the lock of the level being computed while this locks
+  // the larger parent level. Locks are thus always taken from smaller to
+  // larger levels, and |levels_lock_| only while holding level locks, so this
+  // can't deadlock.
+  rtc::scoped_refptr<I420BufferInterface> parent =
+      CropAndScale(offset_x, offset_y, crop_width, crop_height,
+                   crop_width >> n, crop_height >> n);
+  buffer->ScaleFrom(*parent);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef API_VIDEO_I420_BUFFER_PYRAMID_H_
+#define API_VIDEO_I420_BUFFER_PYRAMID_H_
+
+#include <vector>
+
+#include "api/scoped_refptr.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame_buffer.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/system/rtc_export.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Lazily computed, downscaled versions of an I420 buffer, shared by everyone
+// who holds a reference to the buffer. When a frame is delivered to several
+// consumers that scale it, e.g. the layers of a simulcast encoder and a local
+// preview, each resolution is computed at most once.
+//
+// Scaled versions are computed with a box filter from the nearest level at
+// 1/2, 1/4, ... of the source resolution that is at least as large, and those
+// levels are in turn computed from the level above. The result therefore does
+// not depend on the order of requests.
+//
+// The returned buffers are shared and must not be modified. All methods are
+// thread safe.
+class RTC_EXPORT I420BufferPyramid : public rtc::RefCountInterface {
+ public:
+  // Returns the pyramid of |buffer|, creating it on first use. It is owned by
+  // |buffer| and valid for as long as the caller holds a reference to
+  // |buffer|.
+  static I420BufferPyramid* Of(I420BufferInterface* buffer);
+
+  // Drops all scaled versions of |buffer|. Must be called before pixel data of
+  // a buffer is modified after the buffer has been scaled, e.g. by a buffer
+  // pool that recycles it, and only while no one else holds a reference.
+  // Scaled buffers that were already returned stay valid.
+  static void Invalidate(I420BufferInterface* buffer);
+
+  // Returns the source scaled to |scaled_width| x |scaled_height|.
+  rtc::scoped_refptr<I420BufferInterface> Scale(int scaled_width,
+                                                int scaled_height);
+
+  // Returns the cropped area of the source scaled to |scaled_width| x
+  // |scaled_height|. As with I420Buffer::CropAndScaleFrom(), the offsets are
+  // rounded down to even numbers.
+  rtc::scoped_refptr<I420BufferInterface> CropAndScale(int offset_x,
+                                                       int offset_y,
+                                                       int crop_width,
+                                                       int crop_height,
+                                                       int scaled_width,
+                                                       int scaled_height);
+
+ protected:
+  explicit I420BufferPyramid(I420BufferInterface* source);
+  ~I420BufferPyramid() override;
+
+ private:
+  // Reference counted, so that Invalidate() can't free a level that a
+  // concurrent CropAndScale() is still computing.
+  struct Level : public rtc::RefCountInterface {
+    Level(int offset_x,
+          int offset_y,
+          int crop_width,
+          int crop_height,
+          int width,
+          int height);
+    ~Level() override;
+
+    const int offset_x;
+    const int offset_y;
+    const int crop_width;
+    const int crop_height;
+    const int width;
+    const int height;
+    // Held while the level is computed, so that concurrent requests for the
+    // same resolution wait instead of scaling again.
+    rtc::CriticalSection lock;
+    rtc::scoped_refptr<I420Buffer> buffer RTC_GUARDED_BY(lock);
+  };
+
+  // Returns the level for the given crop and resolution, adding it if there
+  // is room. Returns null if the pyramid is full.
+  rtc::scoped_refptr<Level> GetLevel(int offset_x,
+                                     int offset_y,
+                                     int crop_width,
+                                     int crop_height,
+                                     int width,
+                                     int height);
+
+  // Scales the cropped area of the source into |buffer|, reading from the
+  // nearest larger level at 1/2^n of the crop.
+  void ScaleInto(int offset_x,
+                 int offset_y,
+                 int crop_width,
+                 int crop_height,
+                 I420Buffer* buffer);
+
+  // Not a reference, since the source owns the pyramid.
+  I420BufferInterface* const source_;
+
+  rtc::CriticalSection levels_lock_;
+  std::vector<rtc::scoped_refptr<Level>> levels_ RTC_GUARDED_BY(levels_lock_);
+};
+
+}  // namespace webrtc
+
+#endif  // API_VIDEO_I420_BUFFER_PYRAMID_H_
@@ -0,0 +1,124 @@
+/*
+ *  Copyright 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/video/i420_buffer_pyramid.h"
+
+#include <string.h>
+
+#include "api/video/i420_buffer.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+rtc::scoped_refptr<I420Buffer> CreateGradient(int width, int height) {
+  rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x)
+      buffer->MutableDataY()[y * buffer->StrideY() + x] = (x * 7 + y * 3) % 256;
+  }
+  for (int y = 0; y < buffer->ChromaHeight(); ++y) {
+    for (int x = 0; x < buffer->ChromaWidth(); ++x) {
+      buffer->MutableDataU()[y * buffer->StrideU() + x] = (x * 5 + y) % 256;
+      buffer->MutableDataV()[y * buffer->StrideV() + x] = (x + y * 5) % 256;
+    }
+  }
+  return buffer;
+}
+
+bool PlaneEquals(const uint8_t* a,
+                 int stride_a,
+                 const uint8_t* b,
+                 int stride_b,
+                 int width,
+                 int height) {
+  for (int y = 0; y < height; ++y) {
+    if (memcmp(a + y * stride_a, b + y * stride_b, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+bool BuffersEqual(const I420BufferInterface& a, const I420BufferInterface& b) {
+  return a.width() == b.width() && a.height() == b.height() &&
+         PlaneEquals(a.DataY(), a.StrideY(), b.DataY(), b.StrideY(), a.width(),
+                     a.height()) &&
+         PlaneEquals(a.DataU(), a.StrideU(), b.DataU(), b.StrideU(),
+                     a.ChromaWidth(), a.ChromaHeight()) &&
+         PlaneEquals(a.DataV(), a.StrideV(), b.DataV(), b.StrideV(),
+                     a.ChromaWidth(), a.ChromaHeight());
+}
+
+}  // namespace
+
+TEST(I420BufferPyramidTest, SharesScaledBuffers) {
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(1280, 720);
+  I420BufferPyramid* pyramid = I420BufferPyramid::Of(source);
+  EXPECT_EQ(pyramid, I420BufferPyramid::Of(source));
+
+  EXPECT_EQ(source.get(), pyramid->Scale(1280, 720).get());
+  rtc::scoped_refptr<I420BufferInterface> scaled = pyramid->Scale(640, 360);
+  EXPECT_EQ(640, scaled->width());
+  EXPECT_EQ(360, scaled->height());
+  EXPECT_EQ(scaled.get(), pyramid->Scale(640, 360).get());
+  // Same crop after rounding the offsets down to even numbers.
+  EXPECT_EQ(pyramid->CropAndScale(2, 2, 640, 360, 320, 180).get(),
+            pyramid->CropAndScale(3, 3, 640, 360, 320, 180).get());
+}
+
+TEST(I420BufferPyramidTest, CascadesFromHalvedLevels) {
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(1280, 720);
+  rtc::scoped_refptr<I420Buffer> half = I420Buffer::Create(640, 360);
+  half->ScaleFrom(*source);
+  rtc::scoped_refptr<I420Buffer> quarter = I420Buffer::Create(320, 180);
+  quarter->ScaleFrom(*half);
+  // Other resolutions are scaled from the nearest larger halved level.
+  rtc::scoped_refptr<I420Buffer> preview = I420Buffer::Create(480, 270);
+  preview->ScaleFrom(*half);
+  rtc::scoped_refptr<I420Buffer> thumbnail = I420Buffer::Create(200, 112);
+  thumbnail->ScaleFrom(*quarter);
+
+  I420BufferPyramid* pyramid = I420BufferPyramid::Of(source);
+  EXPECT_TRUE(BuffersEqual(*quarter, *pyramid->Scale(320, 180)));
+  EXPECT_TRUE(BuffersEqual(*half, *pyramid->Scale(640, 360)));
+  EXPECT_TRUE(BuffersEqual(*preview, *pyramid->Scale(480, 270)));
+  EXPECT_TRUE(BuffersEqual(*thumbnail, *pyramid->Scale(200, 112)));
+}
+
+TEST(I420BufferPyramidTest, ResultDoesNotDependOnRequestOrder) {
+  rtc::scoped_refptr<I420Buffer> source_a = CreateGradient(1280, 720);
+  rtc::scoped_refptr<I420Buffer> source_b = CreateGradient(1280, 720);
+  I420BufferPyramid* pyramid_a = I420BufferPyramid::Of(source_a);
+  I420BufferPyramid* pyramid_b = I420BufferPyramid::Of(source_b);
+
+  rtc::scoped_refptr<I420BufferInterface> small_a = pyramid_a->Scale(160, 90);
+  rtc::scoped_refptr<I420BufferInterface> large_a = pyramid_a->Scale(640, 360);
+  rtc::scoped_refptr<I420BufferInterface> large_b = pyramid_b->Scale(640, 360);
+  rtc::scoped_refptr<I420BufferInterface> small_b = pyramid_b->Scale(160, 90);
+  EXPECT_TRUE(BuffersEqual(*small_a, *small_b));
+  EXPECT_TRUE(BuffersEqual(*large_a, *large_b));
+}
+
+TEST(I420BufferPyramidTest, InvalidateDropsScaledBuffers) {
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(640, 360);
+  rtc::scoped_refptr<I420BufferInterface> scaled =
+      I420BufferPyramid::Of(source)->Scale(320, 180);
+
+  I420Buffer::SetBlack(source);
+  I420BufferPyramid::Invalidate(source);
+  rtc::scoped_refptr<I420BufferInterface> rescaled =
+      I420BufferPyramid::Of(source)->Scale(320, 180);
+  EXPECT_NE(scaled.get(), rescaled.get());
+  rtc::scoped_refptr<I420Buffer> black = I420Buffer::Create(320, 180);
+  I420Buffer::SetBlack(black);
+  EXPECT_TRUE(BuffersEqual(*black, *rescaled));
+}
+
+}  // namespace webrtc
@@ -89,6 +89,11 @@ rtc::scoped_refptr<I420BufferInterface> I420BufferInterface::ToI420() {
   return this;
 }
 
+I420BufferInterface::~I420BufferInterface() {
+  if (scaling_pyramid_)
+    scaling_pyramid_->Release();
+}
+
 VideoFrameBuffer::Type I420ABufferInterface::type() const {
   return Type::kI420A;
 }
@@ -19,6 +19,7 @@
 namespace webrtc {
 
 class I420BufferInterface;
+class I420BufferPyramid;
 class I420ABufferInterface;
 class I444BufferInterface;
 class I010BufferInterface;
@@ -128,7 +129,16 @@ class I420BufferInterface : public PlanarYuv8Buffer {
   rtc::scoped_refptr<I420BufferInterface> ToI420() final;
   void* m_texture;
  protected:
-  ~I420BufferInterface() override {}
+  ~I420BufferInterface() override;
+
+ private:
+  friend class I420BufferPyramid;
+  // Owned. Created on first use by I420BufferPyramid::Of(), which caches
+  // scaled versions of the buffer here. The pixel data of a buffer must
+  // therefore not change once it has been passed on. A producer that recycles
+  // buffers must call I420BufferPyramid::Invalidate() while it holds the only
+  // reference and before writing new pixels, as I420BufferPool does.
+  rtc::RefCountInterface* volatile scaling_pyramid_ = nullptr;
 };
 
 class I420ABufferInterface : public I420BufferInterface {
@@ -42,6 +42,12 @@ struct RTC_EXPORT VideoSinkWants {
   absl::optional<int> target_pixel_count;
   // Tells the source the maximum framerate the sink wants.
   int max_framerate_fps = std::numeric_limits<int>::max();
+  // Tells a source that fans frames out to several sinks, such as
+  // rtc::VideoBroadcaster, to deliver frames to this sink on a thread of its
+  // own through a queue of at most this many frames, dropping the oldest
+  // queued frame when it is full. This keeps a slow sink from delaying the
+  // source and the other sinks. Not aggregated across sinks.
+  absl::optional<int> max_queued_frames;
 };
 
 template <typename VideoFrameT>
@@ -1386,7 +1386,8 @@ PacketReceiver::DeliveryStatus Call::DeliverRtp(MediaType media_type,
                                                 int64_t packet_time_us) {
   TRACE_EVENT0("webrtc", "Call::DeliverRtp");
 
-  RtpPacketReceived parsed_packet;
+  // Parse() takes over the buffer of |packet|, don't allocate one.
+  RtpPacketReceived parsed_packet(nullptr, /*capacity=*/0);
   if (!parsed_packet.Parse(std::move(packet)))
   {
 	  return DELIVERY_PACKET_ERROR;
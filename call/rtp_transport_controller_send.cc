@@ -136,13 +136,20 @@ RtpTransportControllerSend::RtpTransportControllerSend(
 
   pacer_.SetPacingRates(bitrate_config.start_bitrate_bps, 0);
   // TODO@chensong 2022-09-29 注册网络发送包  会不停调用 pacer_中方法Process
-  process_thread_->RegisterModule(&pacer_, RTC_FROM_HERE);
+  if (pacer_.high_resolution()) {
+    // The pacer wakes itself up when the next packet may be sent, which the
+    // millisecond resolution of the process thread can't do.
+    pacer_.StartOnTaskQueue(task_queue_factory);
+  } else {
+    process_thread_->RegisterModule(&pacer_, RTC_FROM_HERE);
+  }
   process_thread_->Start();
 }
 
 RtpTransportControllerSend::~RtpTransportControllerSend() {
   process_thread_->Stop();
-  process_thread_->DeRegisterModule(&pacer_);
+  if (!pacer_.high_resolution())
+    process_thread_->DeRegisterModule(&pacer_);
 }
 
 RtpVideoSenderInterface* RtpTransportControllerSend::CreateRtpVideoSender(
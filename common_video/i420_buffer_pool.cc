@@ -12,6 +12,7 @@
 
 #include <limits>
 
+#include "api/video/i420_buffer_pyramid.h"
 #include "rtc_base/checks.h"
 
 namespace webrtc {
@@ -58,8 +59,11 @@ rtc::scoped_refptr<I420Buffer> I420BufferPool::CreateBuffer(int width,
     // are looping over and one from the application. If the ref count is 1,
     // then the list we are looping over holds the only reference and it's safe
     // to reuse.
-    if (buffer->HasOneRef())
+    if (buffer->HasOneRef()) {
+      // The pixels are about to be overwritten.
+      I420BufferPyramid::Invalidate(buffer.get());
       return buffer;
+    }
   }
 
   if (buffers_.size() >= max_number_of_buffers_)
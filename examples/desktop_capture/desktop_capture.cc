@@ -93,10 +93,7 @@ void DesktopCapture::OnCaptureResult(
   int height = frame->size().height();
   // int half_width = (width + 1) / 2;
 
-  if (!i420_buffer_.get() ||
-      i420_buffer_->width() * i420_buffer_->height() < width * height) {
-    i420_buffer_ = webrtc::I420Buffer::Create(width, height);
-  }
+  i420_buffer_ = buffer_pool_.CreateBuffer(width, height);
   if (width == 1080 && height == 1920)
   {
 	  fwrite(frame->data(), 1, width * height * 4, out_file_ptr);
@@ -93,10 +93,7 @@ void DesktopCapture::OnCaptureResult(
   int height = frame->size().height();
   // int half_width = (width + 1) / 2;
 
-  if (!i420_buffer_.get() ||
-      i420_buffer_->width() * i420_buffer_->height() < width * height) {
-    i420_buffer_ = webrtc::I420Buffer::Create(width, height);
-  }
+  i420_buffer_ = buffer_pool_.CreateBuffer(width, height);
   i420_buffer_->set_texture
   libyuv::ConvertToI420(frame->data(), 0, i420_buffer_->MutableDataY(),
                         i420_buffer_->StrideY(), i420_buffer_->MutableDataU(),
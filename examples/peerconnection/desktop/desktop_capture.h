@@ -7,6 +7,7 @@
 #include "modules/desktop_capture/desktop_capturer.h"
 #include "modules/desktop_capture/desktop_frame.h"
 #include "api/video/i420_buffer.h"
+#include "common_video/include/i420_buffer_pool.h"
 
 
 #include <thread>
@@ -47,6 +48,9 @@ class DesktopCapture : public DesktopCaptureSource,
   std::unique_ptr<std::thread> capture_thread_;
   std::atomic_bool start_flag_;
 
+  // Frames still being encoded or scaled keep their buffer; see
+  // I420BufferPool::CreateBuffer().
+  webrtc::I420BufferPool buffer_pool_;
   rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer_;
 };
 }  // namespace webrtc_demo
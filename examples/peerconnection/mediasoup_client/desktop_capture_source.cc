@@ -1,6 +1,7 @@
 ﻿#include "examples/peerconnection/mediasoup_client/desktop_capture_source.h"
 
 #include "api/video/i420_buffer.h"
+#include "api/video/i420_buffer_pyramid.h"
 #include "api/video/video_rotation.h"
 #include "rtc_base/logging.h"
 
@@ -43,9 +44,11 @@ void DesktopCaptureSource::OnFrame(const webrtc::VideoFrame& frame) {
     // Video adapter has requested a down-scale. Allocate a new buffer and
     // return scaled version.
     // For simplicity, only scale here without cropping.
-    rtc::scoped_refptr<webrtc::I420Buffer> scaled_buffer =
-        webrtc::I420Buffer::Create(out_width, out_height);
-    scaled_buffer->ScaleFrom(*frame.video_frame_buffer()->ToI420());
+    rtc::scoped_refptr<webrtc::I420BufferInterface> source_buffer =
+        frame.video_frame_buffer()->ToI420();
+    rtc::scoped_refptr<webrtc::I420BufferInterface> scaled_buffer =
+        webrtc::I420BufferPyramid::Of(source_buffer)
+            ->Scale(out_width, out_height);
     webrtc::VideoFrame::Builder new_frame_builder =
         webrtc::VideoFrame::Builder()
             .set_video_frame_buffer(scaled_buffer)
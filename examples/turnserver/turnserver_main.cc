@@ -15,18 +15,18 @@
 #include <utility>
 
 #include "examples/turnserver/read_auth_file.h"
-#include "p2p/base/basic_packet_socket_factory.h"
 #include "p2p/base/port_interface.h"
+#include "p2p/base/sharded_turn_server.h"
 #include "p2p/base/turn_server.h"
-#include "rtc_base/async_udp_socket.h"
 #include "rtc_base/ip_address.h"
 #include "rtc_base/socket_address.h"
-#include "rtc_base/socket_server.h"
+#include "rtc_base/string_encode.h"
 #include "rtc_base/thread.h"
 
 namespace {
 const char kSoftware[] = "libjingle TurnServer";
 
+// Only reads the keys, so all server threads can share it.
 class TurnFileAuth : public cricket::TurnAuthInterface {
  public:
   explicit TurnFileAuth(std::map<std::string, std::string> name_to_key)
@@ -51,8 +51,8 @@ class TurnFileAuth : public cricket::TurnAuthInterface {
 }  // namespace
 
 int main(int argc, char* argv[]) {
-  if (argc != 5) {
-    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file"
+  if (argc != 5 && argc != 6) {
+    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file [threads]"
               << std::endl;
     return 1;
   }
@@ -69,30 +69,38 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  rtc::Thread* main = rtc::Thread::Current();
-  rtc::AsyncUDPSocket* int_socket =
-      rtc::AsyncUDPSocket::Create(main->socketserver(), int_addr);
-  if (!int_socket) {
-    std::cerr << "Failed to create a UDP socket bound at" << int_addr.ToString()
-              << std::endl;
+  int num_threads = 1;
+  if (argc == 6 && (!rtc::FromString(argv[5], &num_threads) ||
+                    num_threads < 1)) {
+    std::cerr << "Invalid number of threads: " << argv[5] << std::endl;
     return 1;
   }
 
-  cricket::TurnServer server(main);
   std::fstream auth_file(argv[4], std::fstream::in);
 
   TurnFileAuth auth(auth_file.is_open()
                         ? webrtc_examples::ReadAuthFile(&auth_file)
                         : std::map<std::string, std::string>());
-  server.set_realm(argv[3]);
-  server.set_software(kSoftware);
-  server.set_auth_hook(&auth);
-  server.AddInternalSocket(int_socket, cricket::PROTO_UDP);
-  server.SetExternalSocketFactory(new rtc::BasicPacketSocketFactory(),
-                                  rtc::SocketAddress(ext_addr, 0));
+  std::string realm = argv[3];
+
+  // Each thread listens on its own socket bound to |int_addr| and owns the
+  // allocations of the clients the kernel steers to that socket.
+  cricket::ShardedTurnServer server(num_threads);
+  if (!server.Start(int_addr, ext_addr,
+                    [&auth, &realm](cricket::TurnServer* turn_server) {
+                      turn_server->set_realm(realm);
+                      turn_server->set_software(kSoftware);
+                      turn_server->set_auth_hook(&auth);
+                    })) {
+    std::cerr << "Failed to create a UDP socket bound at" << int_addr.ToString()
+              << std::endl;
+    return 1;
+  }
 
-  std::cout << "Listening internally at " << int_addr.ToString() << std::endl;
+  std::cout << "Listening internally at "
+            << server.internal_address().ToString() << " with " << num_threads
+            << " threads" << std::endl;
 
-  main->Run();
+  rtc::Thread::Current()->Run();
   return 0;
 }
@@ -10,23 +10,239 @@
 
 #include "media/base/video_broadcaster.h"
 
+#include <algorithm>
+#include <deque>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/types/optional.h"
+#include "api/task_queue/global_task_queue_factory.h"
 #include "api/video/i420_buffer.h"
 #include "api/video/video_rotation.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/task_queue.h"
+#include "rtc_base/time_utils.h"
 
 namespace rtc {
 
+class VideoBroadcaster::SinkDelivery : public rtc::RefCountInterface {
+ public:
+  SinkDelivery(VideoSinkInterface<webrtc::VideoFrame>* sink,
+               absl::optional<int> max_queued_frames)
+      : sink_(sink) {
+    if (max_queued_frames) {
+      max_queued_frames_ = std::max(*max_queued_frames, 1);
+      task_queue_ = absl::make_unique<rtc::TaskQueue>(
+          webrtc::GlobalTaskQueueFactory().CreateTaskQueue(
+              "VideoSinkDelivery", webrtc::TaskQueueFactory::Priority::NORMAL));
+    }
+  }
+
+  // A sink keeps the delivery mode it was added with; only the size of its
+  // queue can be changed.
+  void SetMaxQueuedFrames(absl::optional<int> max_queued_frames) {
+    rtc::CritScope cs(&lock_);
+    if (task_queue_ && max_queued_frames)
+      max_queued_frames_ = std::max(*max_queued_frames, 1);
+  }
+
+  void OnFrame(const webrtc::VideoFrame& frame, int64_t receive_time_us) {
+    {
+      rtc::CritScope cs(&lock_);
+      if (stopped_)
+        return;
+      if (task_queue_) {
+        queued_frames_.push_back(QueuedFrame{frame, receive_time_us});
+        while (queued_frames_.size() > max_queued_frames_) {
+          // The sink never sees the dropped frame, so the next one must also
+          // cover the area that changed in it.
+          MergeUpdateRect(queued_frames_[0].frame, &queued_frames_[1].frame);
+          queued_frames_.pop_front();
+          ++frames_dropped_;
+          ++pending_discards_;
+        }
+        ScheduleDelivery();
+        return;
+      }
+    }
+    Deliver(frame, receive_time_us);
+  }
+
+  void OnDiscardedFrame() {
+    {
+      rtc::CritScope cs(&lock_);
+      if (stopped_)
+        return;
+      if (task_queue_) {
+        ++pending_discards_;
+        ScheduleDelivery();
+        return;
+      }
+    }
+    DeliverDiscardedFrame();
+  }
+
+  // Waits for a call into the sink in progress to return, and makes sure no
+  // more calls are made. Returns false if called from the sink's own delivery
+  // queue, which then keeps running until Stop() is called again from another
+  // thread.
+  bool Stop() {
+    std::unique_ptr<rtc::TaskQueue> task_queue;
+    {
+      rtc::CritScope delivery_cs(&delivery_lock_);
+      rtc::CritScope cs(&lock_);
+      stopped_ = true;
+      queued_frames_.clear();
+      if (task_queue_ && task_queue_->IsCurrent())
+        return false;
+      task_queue = std::move(task_queue_);
+    }
+    // Destroyed without holding the locks, since a pending delivery task may
+    // still need them before it sees |stopped_|.
+    return true;
+  }
+
+  SinkStats GetStats() const {
+    rtc::CritScope cs(&lock_);
+    SinkStats stats;
+    stats.frames_delivered = frames_delivered_;
+    stats.frames_dropped = frames_dropped_;
+    if (frames_delivered_ > 0) {
+      stats.average_delivery_latency_us =
+          total_delivery_latency_us_ / frames_delivered_;
+    }
+    stats.max_delivery_latency_us = max_delivery_latency_us_;
+    return stats;
+  }
+
+ protected:
+  ~SinkDelivery() override = default;
+
+ private:
+  struct QueuedFrame {
+    webrtc::VideoFrame frame;
+    int64_t receive_time_us;
+  };
+
+  static void MergeUpdateRect(const webrtc::VideoFrame& dropped_frame,
+                              webrtc::VideoFrame* next_frame) {
+    webrtc::VideoFrame::UpdateRect update_rect{0, 0, next_frame->width(),
+                                               next_frame->height()};
+    if (dropped_frame.width() == next_frame->width() &&
+        dropped_frame.height() == next_frame->height()) {
+      update_rect = next_frame->update_rect();
+      update_rect.Union(dropped_frame.update_rect());
+    }
+    next_frame->set_update_rect(update_rect);
+  }
+
+  void ScheduleDelivery() RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    if (delivery_scheduled_)
+      return;
+    delivery_scheduled_ = true;
+    // |this| outlives the task queue, see Stop().
+    task_queue_->PostTask([this] { DeliverQueuedFrames(); });
+  }
+
+  void DeliverQueuedFrames() {
+    while (true) {
+      absl::optional<QueuedFrame> next;
+      int discards;
+      {
+        rtc::CritScope cs(&lock_);
+        discards = pending_discards_;
+        pending_discards_ = 0;
+        if (queued_frames_.empty()) {
+          delivery_scheduled_ = false;
+        } else {
+          next.emplace(std::move(queued_frames_.front()));
+          queued_frames_.pop_front();
+        }
+      }
+      for (int i = 0; i < discards; ++i)
+        DeliverDiscardedFrame();
+      if (!next)
+        return;
+      Deliver(next->frame, next->receive_time_us);
+    }
+  }
+
+  void Deliver(const webrtc::VideoFrame& frame, int64_t receive_time_us) {
+    rtc::CritScope delivery_cs(&delivery_lock_);
+    {
+      rtc::CritScope cs(&lock_);
+      if (stopped_)
+        return;
+    }
+    sink_->OnFrame(frame);
+    const int64_t latency_us = rtc::TimeMicros() - receive_time_us;
+    rtc::CritScope cs(&lock_);
+    ++frames_delivered_;
+    total_delivery_latency_us_ += latency_us;
+    max_delivery_latency_us_ = std::max(max_delivery_latency_us_, latency_us);
+  }
+
+  void DeliverDiscardedFrame() {
+    rtc::CritScope delivery_cs(&delivery_lock_);
+    {
+      rtc::CritScope cs(&lock_);
+      if (stopped_)
+        return;
+    }
+    sink_->OnDiscardedFrame();
+  }
+
+  VideoSinkInterface<webrtc::VideoFrame>* const sink_;
+
+  // Held while calling into the sink, so that Stop() can wait for the call to
+  // return. Acquired before |lock_|.
+  rtc::CriticalSection delivery_lock_;
+
+  rtc::CriticalSection lock_;
+  bool stopped_ RTC_GUARDED_BY(lock_) = false;
+  size_t max_queued_frames_ RTC_GUARDED_BY(lock_) = 0;
+  std::deque<QueuedFrame> queued_frames_ RTC_GUARDED_BY(lock_);
+  int pending_discards_ RTC_GUARDED_BY(lock_) = 0;
+  bool delivery_scheduled_ RTC_GUARDED_BY(lock_) = false;
+  int frames_delivered_ RTC_GUARDED_BY(lock_) = 0;
+  int frames_dropped_ RTC_GUARDED_BY(lock_) = 0;
+  int64_t total_delivery_latency_us_ RTC_GUARDED_BY(lock_) = 0;
+  int64_t max_delivery_latency_us_ RTC_GUARDED_BY(lock_) = 0;
+
+  // Declared last, so that it is destroyed, and its pending tasks with it,
+  // before the members they use.
+  std::unique_ptr<rtc::TaskQueue> task_queue_ RTC_GUARDED_BY(lock_);
+};
+
 VideoBroadcaster::VideoBroadcaster() = default;
-VideoBroadcaster::~VideoBroadcaster() = default;
+
+VideoBroadcaster::~VideoBroadcaster() {
+  std::vector<rtc::scoped_refptr<SinkDelivery>> deliveries;
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    if (snapshot_) {
+      for (const SinkSnapshot::Entry& entry : snapshot_->entries)
+        deliveries.push_back(entry.delivery);
+    }
+    deliveries.insert(deliveries.end(), removed_deliveries_.begin(),
+                      removed_deliveries_.end());
+  }
+  for (const rtc::scoped_refptr<SinkDelivery>& delivery : deliveries) {
+    // Unlike RemoveSink(), there is nothing left to hand the delivery queue
+    // to, so a queued sink must not destroy the broadcaster that feeds it.
+    if (!delivery->Stop())
+      RTC_NOTREACHED() << "VideoBroadcaster destroyed on a sink's queue.";
+  }
+}
 
 void VideoBroadcaster::AddOrUpdateSink(
     VideoSinkInterface<webrtc::VideoFrame>* sink,
     const VideoSinkWants& wants) {
   RTC_DCHECK(sink != nullptr);
+  StopRemovedDeliveries();
   rtc::CritScope cs(&sinks_and_wants_lock_);
   if (!FindSinkPair(sink)) {
     // |Sink| is a new sink, which didn't receive previous frame.
@@ -34,14 +250,28 @@ void VideoBroadcaster::AddOrUpdateSink(
   }
   VideoSourceBase::AddOrUpdateSink(sink, wants);
   UpdateWants();
+  UpdateSnapshot();
 }
 
 void VideoBroadcaster::RemoveSink(
     VideoSinkInterface<webrtc::VideoFrame>* sink) {
   RTC_DCHECK(sink != nullptr);
-  rtc::CritScope cs(&sinks_and_wants_lock_);
-  VideoSourceBase::RemoveSink(sink);
-  UpdateWants();
+  rtc::scoped_refptr<SinkDelivery> delivery;
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    delivery = FindDelivery(sink);
+    VideoSourceBase::RemoveSink(sink);
+    UpdateWants();
+    UpdateSnapshot();
+  }
+  // Stopped without holding |sinks_and_wants_lock_|, since a frame being
+  // delivered to |sink| may add or remove sinks.
+  if (delivery && !delivery->Stop()) {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    removed_deliveries_.push_back(delivery);
+    return;
+  }
+  StopRemovedDeliveries();
 }
 
 bool VideoBroadcaster::frame_wanted() const {
@@ -54,48 +284,133 @@ VideoSinkWants VideoBroadcaster::wants() const {
   return current_wants_;
 }
 
+absl::optional<VideoBroadcaster::SinkStats> VideoBroadcaster::GetSinkStats(
+    const VideoSinkInterface<webrtc::VideoFrame>* sink) const {
+  rtc::scoped_refptr<SinkDelivery> delivery;
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    delivery = FindDelivery(sink);
+  }
+  if (!delivery)
+    return absl::nullopt;
+  return delivery->GetStats();
+}
+
 void VideoBroadcaster::OnFrame(const webrtc::VideoFrame& frame) {
-  rtc::CritScope cs(&sinks_and_wants_lock_);
-  bool current_frame_was_discarded = false;
-  for (auto& sink_pair : sink_pairs()) {
-    if (sink_pair.wants.rotation_applied &&
+  const int64_t receive_time_us = rtc::TimeMicros();
+  rtc::scoped_refptr<SinkSnapshot> snapshot;
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> black_frame_buffer;
+  bool full_update_needed;
+  StopRemovedDeliveries();
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    if (!snapshot_)
+      return;
+    snapshot = snapshot_;
+    full_update_needed = !previous_frame_sent_to_all_sinks_;
+    bool current_frame_was_discarded = false;
+    for (const SinkSnapshot::Entry& entry : snapshot->entries) {
+      if (entry.wants.rotation_applied &&
+          frame.rotation() != webrtc::kVideoRotation_0) {
+        current_frame_was_discarded = true;
+      } else if (entry.wants.black_frames && !black_frame_buffer) {
+        black_frame_buffer = GetBlackFrameBuffer(frame.width(), frame.height());
+      }
+    }
+    previous_frame_sent_to_all_sinks_ = !current_frame_was_discarded;
+  }
+
+  for (const SinkSnapshot::Entry& entry : snapshot->entries) {
+    if (entry.wants.rotation_applied &&
         frame.rotation() != webrtc::kVideoRotation_0) {
       // Calls to OnFrame are not synchronized with changes to the sink wants.
       // When rotation_applied is set to true, one or a few frames may get here
       // with rotation still pending. Protect sinks that don't expect any
       // pending rotation.
       RTC_LOG(LS_VERBOSE) << "Discarding frame with unexpected rotation.";
-      sink_pair.sink->OnDiscardedFrame();
-      current_frame_was_discarded = true;
+      entry.delivery->OnDiscardedFrame();
       continue;
     }
-    if (sink_pair.wants.black_frames) {
+    if (entry.wants.black_frames) {
       webrtc::VideoFrame black_frame =
           webrtc::VideoFrame::Builder()
-              .set_video_frame_buffer(
-                  GetBlackFrameBuffer(frame.width(), frame.height()))
+              .set_video_frame_buffer(black_frame_buffer)
               .set_rotation(frame.rotation())
               .set_timestamp_us(frame.timestamp_us())
               .set_id(frame.id())
               .build();
-      sink_pair.sink->OnFrame(black_frame);
-    } else if (!previous_frame_sent_to_all_sinks_) {
+      entry.delivery->OnFrame(black_frame, receive_time_us);
+    } else if (full_update_needed) {
       // Since last frame was not sent to some sinks, full update is needed.
       webrtc::VideoFrame copy = frame;
       copy.set_update_rect(
           webrtc::VideoFrame::UpdateRect{0, 0, frame.width(), frame.height()});
-      sink_pair.sink->OnFrame(copy);
+      entry.delivery->OnFrame(copy, receive_time_us);
     } else {
-      sink_pair.sink->OnFrame(frame);
+      entry.delivery->OnFrame(frame, receive_time_us);
     }
   }
-  previous_frame_sent_to_all_sinks_ = !current_frame_was_discarded;
 }
 
 void VideoBroadcaster::OnDiscardedFrame() {
-  for (auto& sink_pair : sink_pairs()) {
-    sink_pair.sink->OnDiscardedFrame();
+  rtc::scoped_refptr<SinkSnapshot> snapshot;
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    snapshot = snapshot_;
+  }
+  if (!snapshot)
+    return;
+  for (const SinkSnapshot::Entry& entry : snapshot->entries)
+    entry.delivery->OnDiscardedFrame();
+}
+
+void VideoBroadcaster::StopRemovedDeliveries() {
+  std::vector<rtc::scoped_refptr<SinkDelivery>> deliveries;
+  {
+    rtc::CritScope cs(&sinks_and_wants_lock_);
+    if (removed_deliveries_.empty())
+      return;
+    deliveries.swap(removed_deliveries_);
+  }
+  for (const rtc::scoped_refptr<SinkDelivery>& delivery : deliveries) {
+    // Still on the queue of that sink, e.g. if it adds itself back.
+    if (!delivery->Stop()) {
+      rtc::CritScope cs(&sinks_and_wants_lock_);
+      removed_deliveries_.push_back(delivery);
+    }
+  }
+}
+
+void VideoBroadcaster::UpdateSnapshot() {
+  rtc::scoped_refptr<SinkSnapshot> snapshot;
+  if (!sink_pairs().empty()) {
+    snapshot = new rtc::RefCountedObject<SinkSnapshot>();
+    for (const SinkPair& sink_pair : sink_pairs()) {
+      rtc::scoped_refptr<SinkDelivery> delivery = FindDelivery(sink_pair.sink);
+      if (delivery) {
+        delivery->SetMaxQueuedFrames(sink_pair.wants.max_queued_frames);
+      } else {
+        delivery = new rtc::RefCountedObject<SinkDelivery>(
+            sink_pair.sink, sink_pair.wants.max_queued_frames);
+      }
+      snapshot->entries.push_back(
+          SinkSnapshot::Entry{sink_pair.sink, sink_pair.wants, delivery});
+    }
+  }
+  // Frames being delivered keep using the previous snapshot.
+  snapshot_ = snapshot;
+}
+
+rtc::scoped_refptr<VideoBroadcaster::SinkDelivery>
+VideoBroadcaster::FindDelivery(
+    const VideoSinkInterface<webrtc::VideoFrame>* sink) const {
+  if (snapshot_) {
+    for (const SinkSnapshot::Entry& entry : snapshot_->entries) {
+      if (entry.sink == sink)
+        return entry.delivery;
+    }
   }
+  return nullptr;
 }
 
 void VideoBroadcaster::UpdateWants() {
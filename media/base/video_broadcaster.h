@@ -11,11 +11,15 @@
 #ifndef MEDIA_BASE_VIDEO_BROADCASTER_H_
 #define MEDIA_BASE_VIDEO_BROADCASTER_H_
 
+#include <vector>
+
+#include "absl/types/optional.h"
 #include "api/scoped_refptr.h"
 #include "api/video/video_frame_buffer.h"
 #include "api/video/video_source_interface.h"
 #include "media/base/video_source_base.h"
 #include "rtc_base/critical_section.h"
+#include "rtc_base/ref_count.h"
 #include "rtc_base/thread_annotations.h"
 #include "rtc_base/thread_checker.h"
 
@@ -26,10 +30,30 @@ namespace rtc {
 // rtc::VideoSinkInterface. The class is threadsafe; methods may be called on
 // any thread. This is needed because VideoStreamEncoder calls AddOrUpdateSink
 // both on the worker thread and on the encoder task queue.
+//
+// Frames are delivered from a snapshot of the sink list, so the lock is only
+// held briefly in OnFrame() and sinks may add or remove sinks while handling a
+// frame. By default a frame is delivered to all sinks on the calling thread.
+// Sinks that set VideoSinkWants::max_queued_frames are instead fed from a
+// bounded queue on a thread of their own, so that they can't stall the source
+// or the other sinks.
 class VideoBroadcaster : public VideoSourceBase,
                          public VideoSinkInterface<webrtc::VideoFrame> {
  public:
+  struct SinkStats {
+    // Frames passed to the sink's OnFrame().
+    int frames_delivered = 0;
+    // Frames dropped from the sink's queue because it was full.
+    int frames_dropped = 0;
+    // Time from VideoBroadcaster::OnFrame() until the sink's OnFrame()
+    // returned, including any time the frame spent in the sink's queue.
+    int64_t average_delivery_latency_us = 0;
+    int64_t max_delivery_latency_us = 0;
+  };
+
   VideoBroadcaster();
+  // Must not be called from a queued sink's OnFrame(), whose delivery queue
+  // it has to stop.
   ~VideoBroadcaster() override;
   void AddOrUpdateSink(VideoSinkInterface<webrtc::VideoFrame>* sink,
                        const VideoSinkWants& wants) override;
@@ -42,6 +66,10 @@ class VideoBroadcaster : public VideoSourceBase,
   // aggregated by all VideoSinkWants from all sinks.
   VideoSinkWants wants() const;
 
+  // Returns delivery statistics for |sink|, or nullopt if it is not added.
+  absl::optional<SinkStats> GetSinkStats(
+      const VideoSinkInterface<webrtc::VideoFrame>* sink) const;
+
   // This method ensures that if a sink sets rotation_applied == true,
   // it will never receive a frame with pending rotation. Our caller
   // may pass in frames without precise synchronization with changes
@@ -62,6 +90,37 @@ class VideoBroadcaster : public VideoSourceBase,
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> black_frame_buffer_;
   bool previous_frame_sent_to_all_sinks_ RTC_GUARDED_BY(sinks_and_wants_lock_) =
       true;
+
+ private:
+  // Delivers frames to one sink, either directly or through its queue.
+  class SinkDelivery;
+
+  // Immutable list of the sinks that OnFrame() delivers to. A new snapshot
+  // replaces the current one whenever a sink is added, updated or removed.
+  struct SinkSnapshot : public rtc::RefCountInterface {
+    struct Entry {
+      VideoSinkInterface<webrtc::VideoFrame>* sink;
+      VideoSinkWants wants;
+      rtc::scoped_refptr<SinkDelivery> delivery;
+    };
+    std::vector<Entry> entries;
+  };
+
+  // Stops the deliveries parked in |removed_deliveries_|, releasing their
+  // queues, unless called from one of those queues.
+  void StopRemovedDeliveries() RTC_LOCKS_EXCLUDED(sinks_and_wants_lock_);
+  void UpdateSnapshot() RTC_EXCLUSIVE_LOCKS_REQUIRED(sinks_and_wants_lock_);
+  rtc::scoped_refptr<SinkDelivery> FindDelivery(
+      const VideoSinkInterface<webrtc::VideoFrame>* sink) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(sinks_and_wants_lock_);
+
+  rtc::scoped_refptr<SinkSnapshot> snapshot_
+      RTC_GUARDED_BY(sinks_and_wants_lock_);
+  // Deliveries of sinks that removed themselves from their own delivery
+  // queue, which can't be stopped from there. Stopped by the next call to
+  // AddOrUpdateSink(), RemoveSink() or OnFrame() from another thread.
+  std::vector<rtc::scoped_refptr<SinkDelivery>> removed_deliveries_
+      RTC_GUARDED_BY(sinks_and_wants_lock_);
 };
 
 }  // namespace rtc
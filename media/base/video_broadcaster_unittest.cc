@@ -9,6 +9,7 @@
  */
 
 #include <limits>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "api/video/i420_buffer.h"
@@ -16,12 +17,104 @@
 #include "api/video/video_rotation.h"
 #include "media/base/fake_video_renderer.h"
 #include "media/base/video_broadcaster.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/thread.h"
 #include "test/gtest.h"
 
 using rtc::VideoBroadcaster;
 using rtc::VideoSinkWants;
 using cricket::FakeVideoRenderer;
 
+namespace {
+
+const int kWaitTimeoutMs = 5000;
+
+webrtc::VideoFrame CreateFrame(int64_t timestamp_us) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer(
+      webrtc::I420Buffer::Create(100, 50));
+  webrtc::I420Buffer::SetBlack(buffer);
+  return webrtc::VideoFrame::Builder()
+      .set_video_frame_buffer(buffer)
+      .set_rotation(webrtc::kVideoRotation_0)
+      .set_timestamp_us(timestamp_us)
+      .build();
+}
+
+webrtc::VideoFrame CreateFrameWithUpdateRect(
+    int64_t timestamp_us,
+    const webrtc::VideoFrame::UpdateRect& update_rect) {
+  webrtc::VideoFrame frame = CreateFrame(timestamp_us);
+  frame.set_update_rect(update_rect);
+  return frame;
+}
+
+bool UpdateRectEquals(const webrtc::VideoFrame::UpdateRect& a,
+                      const webrtc::VideoFrame::UpdateRect& b) {
+  return a.offset_x == b.offset_x && a.offset_y == b.offset_y &&
+         a.width == b.width && a.height == b.height;
+}
+
+// Sink that records timestamps and blocks in OnFrame() until unblocked.
+class BlockingSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  BlockingSink()
+      : unblocked_(/*manual_reset=*/true, /*initially_signaled=*/true) {}
+
+  void OnFrame(const webrtc::VideoFrame& frame) override {
+    {
+      rtc::CritScope cs(&lock_);
+      timestamps_us_.push_back(frame.timestamp_us());
+      update_rects_.push_back(frame.update_rect());
+    }
+    frame_started_.Set();
+    unblocked_.Wait(rtc::Event::kForever);
+    {
+      rtc::CritScope cs(&lock_);
+      ++delivered_frames_;
+    }
+    frame_delivered_.Set();
+  }
+
+  void Block() { unblocked_.Reset(); }
+  void Unblock() { unblocked_.Set(); }
+  bool WaitForFrameStarted() { return frame_started_.Wait(kWaitTimeoutMs); }
+  bool WaitForDeliveredFrames(size_t count) {
+    while (true) {
+      {
+        rtc::CritScope cs(&lock_);
+        if (delivered_frames_ >= count)
+          return true;
+      }
+      if (!frame_delivered_.Wait(kWaitTimeoutMs))
+        return false;
+    }
+  }
+
+  std::vector<int64_t> timestamps_us() const {
+    rtc::CritScope cs(&lock_);
+    return timestamps_us_;
+  }
+
+  std::vector<webrtc::VideoFrame::UpdateRect> update_rects() const {
+    rtc::CritScope cs(&lock_);
+    return update_rects_;
+  }
+
+ private:
+  rtc::CriticalSection lock_;
+  std::vector<int64_t> timestamps_us_ RTC_GUARDED_BY(lock_);
+  std::vector<webrtc::VideoFrame::UpdateRect> update_rects_
+      RTC_GUARDED_BY(lock_);
+  size_t delivered_frames_ RTC_GUARDED_BY(lock_) = 0;
+  rtc::Event frame_started_;
+  rtc::Event frame_delivered_;
+  rtc::Event unblocked_;
+};
+
+}  // namespace
+
 TEST(VideoBroadcasterTest, frame_wanted) {
   VideoBroadcaster broadcaster;
   EXPECT_FALSE(broadcaster.frame_wanted());
@@ -204,3 +297,163 @@ TEST(VideoBroadcasterTest, SinkWantsBlackFrames) {
   EXPECT_TRUE(sink2.black_frame());
   EXPECT_EQ(30, sink2.timestamp_us());
 }
+
+TEST(VideoBroadcasterTest, QueuedSinkDoesNotBlockOtherSinks) {
+  VideoBroadcaster broadcaster;
+  BlockingSink slow_sink;
+  VideoSinkWants queued_wants;
+  queued_wants.max_queued_frames = 2;
+  broadcaster.AddOrUpdateSink(&slow_sink, queued_wants);
+  FakeVideoRenderer sink;
+  broadcaster.AddOrUpdateSink(&sink, VideoSinkWants());
+
+  slow_sink.Block();
+  broadcaster.OnFrame(CreateFrame(10));
+  ASSERT_TRUE(slow_sink.WaitForFrameStarted());
+  broadcaster.OnFrame(CreateFrame(20));
+  EXPECT_EQ(2, sink.num_rendered_frames());
+  EXPECT_EQ(20, sink.timestamp_us());
+
+  slow_sink.Unblock();
+  ASSERT_TRUE(slow_sink.WaitForDeliveredFrames(2));
+  EXPECT_EQ((std::vector<int64_t>{10, 20}), slow_sink.timestamps_us());
+  broadcaster.RemoveSink(&slow_sink);
+}
+
+TEST(VideoBroadcasterTest, QueuedSinkDropsOldestFrames) {
+  VideoBroadcaster broadcaster;
+  BlockingSink slow_sink;
+  VideoSinkWants wants;
+  wants.max_queued_frames = 2;
+  broadcaster.AddOrUpdateSink(&slow_sink, wants);
+
+  slow_sink.Block();
+  broadcaster.OnFrame(CreateFrame(10));
+  ASSERT_TRUE(slow_sink.WaitForFrameStarted());
+  for (int64_t timestamp_us = 20; timestamp_us <= 50; timestamp_us += 10)
+    broadcaster.OnFrame(CreateFrame(timestamp_us));
+
+  slow_sink.Unblock();
+  ASSERT_TRUE(slow_sink.WaitForDeliveredFrames(3));
+  EXPECT_EQ((std::vector<int64_t>{10, 40, 50}), slow_sink.timestamps_us());
+  // Counted once the sink's OnFrame() has returned.
+  EXPECT_EQ_WAIT(3, broadcaster.GetSinkStats(&slow_sink)->frames_delivered,
+                 kWaitTimeoutMs);
+  EXPECT_EQ(2, broadcaster.GetSinkStats(&slow_sink)->frames_dropped);
+  broadcaster.RemoveSink(&slow_sink);
+}
+
+TEST(VideoBroadcasterTest, QueuedSinkKeepsUpdateRectOfDroppedFrames) {
+  VideoBroadcaster broadcaster;
+  BlockingSink slow_sink;
+  VideoSinkWants wants;
+  wants.max_queued_frames = 2;
+  broadcaster.AddOrUpdateSink(&slow_sink, wants);
+
+  slow_sink.Block();
+  broadcaster.OnFrame(CreateFrame(10));
+  ASSERT_TRUE(slow_sink.WaitForFrameStarted());
+  broadcaster.OnFrame(CreateFrameWithUpdateRect(20, {0, 0, 10, 10}));
+  broadcaster.OnFrame(CreateFrameWithUpdateRect(30, {50, 20, 10, 10}));
+  // Drops the frame with timestamp 20.
+  broadcaster.OnFrame(CreateFrameWithUpdateRect(40, {20, 20, 5, 5}));
+
+  slow_sink.Unblock();
+  ASSERT_TRUE(slow_sink.WaitForDeliveredFrames(3));
+  EXPECT_EQ((std::vector<int64_t>{10, 30, 40}), slow_sink.timestamps_us());
+  std::vector<webrtc::VideoFrame::UpdateRect> update_rects =
+      slow_sink.update_rects();
+  ASSERT_EQ(3u, update_rects.size());
+  EXPECT_TRUE(UpdateRectEquals({0, 0, 60, 30}, update_rects[1]));
+  EXPECT_TRUE(UpdateRectEquals({20, 20, 5, 5}, update_rects[2]));
+  broadcaster.RemoveSink(&slow_sink);
+}
+
+TEST(VideoBroadcasterTest, ReportsDeliveryStats) {
+  VideoBroadcaster broadcaster;
+  FakeVideoRenderer sink;
+  EXPECT_FALSE(broadcaster.GetSinkStats(&sink));
+
+  broadcaster.AddOrUpdateSink(&sink, VideoSinkWants());
+  broadcaster.OnFrame(CreateFrame(10));
+  broadcaster.OnFrame(CreateFrame(20));
+  absl::optional<VideoBroadcaster::SinkStats> stats =
+      broadcaster.GetSinkStats(&sink);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(2, stats->frames_delivered);
+  EXPECT_EQ(0, stats->frames_dropped);
+  EXPECT_GE(stats->max_delivery_latency_us,
+            stats->average_delivery_latency_us);
+
+  broadcaster.RemoveSink(&sink);
+  EXPECT_FALSE(broadcaster.GetSinkStats(&sink));
+}
+
+TEST(VideoBroadcasterTest, RemoveSinkWaitsForQueuedDelivery) {
+  VideoBroadcaster broadcaster;
+  BlockingSink slow_sink;
+  VideoSinkWants wants;
+  wants.max_queued_frames = 2;
+  broadcaster.AddOrUpdateSink(&slow_sink, wants);
+
+  slow_sink.Block();
+  broadcaster.OnFrame(CreateFrame(10));
+  broadcaster.OnFrame(CreateFrame(20));
+  ASSERT_TRUE(slow_sink.WaitForFrameStarted());
+  slow_sink.Unblock();
+  broadcaster.RemoveSink(&slow_sink);
+  // Whether or not the queued frame made it, nothing is delivered after
+  // RemoveSink() returned.
+  const size_t delivered_frames = slow_sink.timestamps_us().size();
+  EXPECT_GE(delivered_frames, 1u);
+  broadcaster.OnFrame(CreateFrame(30));
+  EXPECT_EQ(delivered_frames, slow_sink.timestamps_us().size());
+}
+
+// A queued sink that removes itself while handling a frame can't have its
+// queue stopped from there; the broadcaster's next call from another thread
+// does it, which waits for the sink to return.
+TEST(VideoBroadcasterTest, StopsQueueOfSinkThatRemovedItself) {
+  class SelfRemovingSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+   public:
+    explicit SelfRemovingSink(VideoBroadcaster* broadcaster)
+        : broadcaster_(broadcaster) {}
+
+    void OnFrame(const webrtc::VideoFrame& frame) override {
+      broadcaster_->RemoveSink(this);
+      removed_.Set();
+      unblocked_.Wait(rtc::Event::kForever);
+      // Gives a caller that doesn't wait for the sink time to return first.
+      rtc::Thread::SleepMs(10);
+      rtc::CritScope cs(&lock_);
+      returned_ = true;
+    }
+
+    bool WaitForRemoved() { return removed_.Wait(kWaitTimeoutMs); }
+    void Unblock() { unblocked_.Set(); }
+    bool returned() const {
+      rtc::CritScope cs(&lock_);
+      return returned_;
+    }
+
+   private:
+    VideoBroadcaster* const broadcaster_;
+    rtc::CriticalSection lock_;
+    bool returned_ RTC_GUARDED_BY(lock_) = false;
+    rtc::Event removed_;
+    rtc::Event unblocked_;
+  };
+
+  VideoBroadcaster broadcaster;
+  SelfRemovingSink sink(&broadcaster);
+  VideoSinkWants wants;
+  wants.max_queued_frames = 1;
+  broadcaster.AddOrUpdateSink(&sink, wants);
+
+  broadcaster.OnFrame(CreateFrame(10));
+  ASSERT_TRUE(sink.WaitForRemoved());
+  EXPECT_FALSE(broadcaster.frame_wanted());
+  sink.Unblock();
+  broadcaster.OnFrame(CreateFrame(20));
+  EXPECT_TRUE(sink.returned());
+}
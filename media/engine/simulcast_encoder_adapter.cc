@@ -17,8 +17,11 @@
 #include <string>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "api/scoped_refptr.h"
+#include "api/task_queue/global_task_queue_factory.h"
 #include "api/video/i420_buffer.h"
+#include "api/video/i420_buffer_pyramid.h"
 #include "api/video/video_codec_constants.h"
 #include "api/video/video_frame_buffer.h"
 #include "api/video/video_rotation.h"
@@ -27,9 +30,9 @@
 #include "modules/video_coding/utility/simulcast_rate_allocator.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/event.h"
 #include "rtc_base/experiments/rate_control_settings.h"
 #include "system_wrappers/include/field_trial.h"
-#include "third_party/libyuv/include/libyuv/scale.h"
 
 namespace {
 
@@ -127,7 +130,10 @@ SimulcastEncoderAdapter::SimulcastEncoderAdapter(VideoEncoderFactory* factory,
       encoded_complete_callback_(nullptr),
       experimental_boosted_screenshare_qp_(GetScreenshareBoostedQpValue()),
       boost_base_layer_quality_(RateControlSettings::ParseFromFieldTrials()
-                                    .Vp8BoostBaseLayerQuality()) {
+                                    .Vp8BoostBaseLayerQuality()),
+      parallel_encoding_(webrtc::field_trial::IsEnabled(
+          "WebRTC-SimulcastEncoderAdapter-ParallelEncoding")),
+      collecting_encoded_images_(false) {
   RTC_DCHECK(factory_);
   encoder_info_.implementation_name = "SimulcastEncoderAdapter";
 
@@ -149,11 +155,13 @@ int SimulcastEncoderAdapter::Release() {
   while (!streaminfos_.empty()) {
     std::unique_ptr<VideoEncoder> encoder =
         std::move(streaminfos_.back().encoder);
-    // Even though it seems very unlikely, there are no guarantees that the
-    // encoder will not call back after being Release()'d. Therefore, we first
-    // disable the callbacks here.
-    encoder->RegisterEncodeCompleteCallback(nullptr);
-    encoder->Release();
+    RunOnStreamQueue(streaminfos_.size() - 1, [&encoder] {
+      // Even though it seems very unlikely, there are no guarantees that the
+      // encoder will not call back after being Release()'d. Therefore, we
+      // first disable the callbacks here.
+      encoder->RegisterEncodeCompleteCallback(nullptr);
+      encoder->Release();
+    });
     streaminfos_.pop_back();  // Deletes callback adapter.
     stored_encoders_.push(std::move(encoder));
   }
@@ -215,6 +223,14 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
   RTC_DCHECK_LT(lowest_resolution_stream_index, number_of_streams);
   RTC_DCHECK_LT(highest_resolution_stream_index, number_of_streams);
 
+  if (parallel_encoding_) {
+    while (encode_queues_.size() + 1 < static_cast<size_t>(number_of_streams)) {
+      encode_queues_.push_back(absl::make_unique<rtc::TaskQueue>(
+          GlobalTaskQueueFactory().CreateTaskQueue(
+              "SimulcastEncode", TaskQueueFactory::Priority::NORMAL)));
+    }
+  }
+
   for (int i = 0; i < number_of_streams; ++i) {
     VideoCodec stream_codec;
     uint32_t start_bitrate_kbps = start_bitrates[i];
@@ -255,7 +271,17 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
           codec_.codecType == webrtc::kVideoCodecVP8 ? "VP8" : "H264"));
     }
 
-    ret = encoder->InitEncode(&stream_codec, number_of_cores, max_payload_size);
+    std::unique_ptr<EncodedImageCallback> callback(
+        new AdapterEncodedImageCallback(this, i));
+    EncoderInfo encoder_impl_info;
+    RunOnStreamQueue(i, [&] {
+      ret =
+          encoder->InitEncode(&stream_codec, number_of_cores, max_payload_size);
+      if (ret >= 0) {
+        encoder->RegisterEncodeCompleteCallback(callback.get());
+        encoder_impl_info = encoder->GetEncoderInfo();
+      }
+    });
     if (ret < 0) {
       // Explicitly destroy the current encoder; because we haven't registered a
       // StreamInfo for it yet, Release won't do anything about it.
@@ -264,9 +290,6 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
       return ret;
     }
 
-    std::unique_ptr<EncodedImageCallback> callback(
-        new AdapterEncodedImageCallback(this, i));
-    encoder->RegisterEncodeCompleteCallback(callback.get());
     streaminfos_.emplace_back(std::move(encoder), std::move(callback),
                               stream_codec.width, stream_codec.height,
                               send_stream);
@@ -274,11 +297,8 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
     if (!doing_simulcast) {
       // Without simulcast, just pass through the encoder info from the one
       // active encoder.
-      encoder_info_ = streaminfos_[0].encoder->GetEncoderInfo();
+      encoder_info_ = encoder_impl_info;
     } else {
-      const EncoderInfo encoder_impl_info =
-          streaminfos_[i].encoder->GetEncoderInfo();
-
       if (i == 0) {
         // Quality scaling not enabled for simulcast.
         encoder_info_.scaling_settings = VideoEncoder::ScalingSettings::kOff;
@@ -367,75 +387,164 @@ int SimulcastEncoderAdapter::Encode(
     }
   }
 
-  int src_width = input_image.width();
-  int src_height = input_image.height();
+  std::vector<size_t> stream_indices;
   for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
     // Don't encode frames in resolutions that we don't intend to send.
     if (!streaminfos_[stream_idx].send_stream) {
       continue;
     }
-
-    std::vector<VideoFrameType> stream_frame_types;
+    if (streaminfos_[stream_idx].drop_next_frame) {
+      streaminfos_[stream_idx].drop_next_frame = false;
+      if (send_key_frame) {
+        streaminfos_[stream_idx].key_frame_request = true;
+      }
+      continue;
+    }
     if (send_key_frame) {
-      stream_frame_types.push_back(VideoFrameType::kVideoFrameKey);
       streaminfos_[stream_idx].key_frame_request = false;
-    } else {
-      stream_frame_types.push_back(VideoFrameType::kVideoFrameDelta);
     }
+    stream_indices.push_back(stream_idx);
+  }
+  const VideoFrameType frame_type = send_key_frame
+                                        ? VideoFrameType::kVideoFrameKey
+                                        : VideoFrameType::kVideoFrameDelta;
 
-    int dst_width = streaminfos_[stream_idx].width;
-    int dst_height = streaminfos_[stream_idx].height;
-    // If scaling isn't required, because the input resolution
-    // matches the destination or the input image is empty (e.g.
-    // a keyframe request for encoders with internal camera
-    // sources) or the source image has a native handle, pass the image on
-    // directly. Otherwise, we'll scale it to match what the encoder expects
-    // (below).
-    // For texture frames, the underlying encoder is expected to be able to
-    // correctly sample/scale the source texture.
-    // TODO(perkj): ensure that works going forward, and figure out how this
-    // affects webrtc:5683.
-    if ((dst_width == src_width && dst_height == src_height) ||
-        input_image.video_frame_buffer()->type() ==
-            VideoFrameBuffer::Type::kNative) {
-      int ret = streaminfos_[stream_idx].encoder->Encode(input_image,
-                                                         &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
-    } else {
-      rtc::scoped_refptr<I420Buffer> dst_buffer =
-          I420Buffer::Create(dst_width, dst_height);
-      rtc::scoped_refptr<I420BufferInterface> src_buffer =
-          input_image.video_frame_buffer()->ToI420();
-      libyuv::I420Scale(src_buffer->DataY(), src_buffer->StrideY(),
-                        src_buffer->DataU(), src_buffer->StrideU(),
-                        src_buffer->DataV(), src_buffer->StrideV(), src_width,
-                        src_height, dst_buffer->MutableDataY(),
-                        dst_buffer->StrideY(), dst_buffer->MutableDataU(),
-                        dst_buffer->StrideU(), dst_buffer->MutableDataV(),
-                        dst_buffer->StrideV(), dst_width, dst_height,
-                        libyuv::kFilterBilinear);
-
-      // UpdateRect is not propagated to lower simulcast layers currently.
-      // TODO(ilnik): Consider scaling UpdateRect together with the buffer.
-      VideoFrame frame = VideoFrame::Builder()
-                             .set_video_frame_buffer(dst_buffer)
-                             .set_timestamp_rtp(input_image.timestamp())
-                             .set_rotation(webrtc::kVideoRotation_0)
-                             .set_timestamp_ms(input_image.render_time_ms())
-                             .build();
-      int ret =
-          streaminfos_[stream_idx].encoder->Encode(frame, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
+  if (parallel_encoding_ && !stream_indices.empty()) {
+    return EncodeStreamsInParallel(input_image, stream_indices, frame_type);
+  }
+
+  for (size_t stream_idx : stream_indices) {
+    int ret = EncodeStream(stream_idx, input_image, frame_type);
+    if (ret != WEBRTC_VIDEO_CODEC_OK) {
+      return ret;
     }
   }
 
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+int SimulcastEncoderAdapter::EncodeStream(size_t stream_idx,
+                                          const VideoFrame& input_image,
+                                          VideoFrameType frame_type) {
+  std::vector<VideoFrameType> stream_frame_types(1, frame_type);
+  int src_width = input_image.width();
+  int src_height = input_image.height();
+  int dst_width = streaminfos_[stream_idx].width;
+  int dst_height = streaminfos_[stream_idx].height;
+  // If scaling isn't required, because the input resolution
+  // matches the destination or the input image is empty (e.g.
+  // a keyframe request for encoders with internal camera
+  // sources) or the source image has a native handle, pass the image on
+  // directly. Otherwise, we'll scale it to match what the encoder expects
+  // (below).
+  // For texture frames, the underlying encoder is expected to be able to
+  // correctly sample/scale the source texture.
+  // TODO(perkj): ensure that works going forward, and figure out how this
+  // affects webrtc:5683.
+  if ((dst_width == src_width && dst_height == src_height) ||
+      input_image.video_frame_buffer()->type() ==
+          VideoFrameBuffer::Type::kNative) {
+    return streaminfos_[stream_idx].encoder->Encode(input_image,
+                                                    &stream_frame_types);
+  }
+
+  // Scaled versions are shared with other consumers of the same buffer, e.g.
+  // the other streams.
+  rtc::scoped_refptr<I420BufferInterface> src_buffer =
+      input_image.video_frame_buffer()->ToI420();
+  rtc::scoped_refptr<I420BufferInterface> dst_buffer =
+      I420BufferPyramid::Of(src_buffer)->Scale(dst_width, dst_height);
+
+  // UpdateRect is not propagated to lower simulcast layers currently.
+  // TODO(ilnik): Consider scaling UpdateRect together with the buffer.
+  VideoFrame frame = VideoFrame::Builder()
+                         .set_video_frame_buffer(dst_buffer)
+                         .set_timestamp_rtp(input_image.timestamp())
+                         .set_rotation(webrtc::kVideoRotation_0)
+                         .set_timestamp_ms(input_image.render_time_ms())
+                         .build();
+  return streaminfos_[stream_idx].encoder->Encode(frame, &stream_frame_types);
+}
+
+int SimulcastEncoderAdapter::EncodeStreamsInParallel(
+    const VideoFrame& input_image,
+    const std::vector<size_t>& stream_indices,
+    VideoFrameType frame_type) {
+  {
+    rtc::CritScope cs(&pending_images_lock_);
+    collecting_encoded_images_ = true;
+  }
+
+  // Stream 0 is encoded on the calling queue, the others on their own
+  // queues. The tasks finish before this method returns.
+  std::vector<int> results(stream_indices.size(), WEBRTC_VIDEO_CODEC_OK);
+  const int num_tasks = static_cast<int>(
+      stream_indices.size() -
+      std::count(stream_indices.begin(), stream_indices.end(), 0));
+  volatile int pending_tasks = num_tasks;
+  rtc::Event done;
+  for (size_t i = 0; i < stream_indices.size(); ++i) {
+    if (stream_indices[i] == 0)
+      continue;
+    encode_queues_[stream_indices[i] - 1]->PostTask([&, i] {
+      results[i] = EncodeStream(stream_indices[i], input_image, frame_type);
+      if (rtc::AtomicOps::Decrement(&pending_tasks) == 0)
+        done.Set();
+    });
+  }
+  if (stream_indices[0] == 0)
+    results[0] = EncodeStream(0, input_image, frame_type);
+  if (num_tasks > 0)
+    done.Wait(rtc::Event::kForever);
+
+  std::vector<PendingEncodedImage> encoded_images;
+  {
+    rtc::CritScope cs(&pending_images_lock_);
+    collecting_encoded_images_ = false;
+    encoded_images.swap(pending_encoded_images_);
+  }
+  // Deliver in stream order, and in the order produced within a stream.
+  std::stable_sort(
+      encoded_images.begin(), encoded_images.end(),
+      [](const PendingEncodedImage& a, const PendingEncodedImage& b) {
+        return a.stream_idx < b.stream_idx;
+      });
+  // The encoders have already returned, so the sink's feedback is applied
+  // here on their behalf.
+  bool send_failed = false;
+  for (const PendingEncodedImage& image : encoded_images) {
+    EncodedImageCallback::Result result = DeliverEncodedImage(
+        image.stream_idx, image.encoded_image, &image.codec_specific_info,
+        image.has_fragmentation ? &image.fragmentation : nullptr);
+    if (result.error != EncodedImageCallback::Result::OK)
+      send_failed = true;
+    if (result.drop_next_frame)
+      streaminfos_[image.stream_idx].drop_next_frame = true;
+  }
+
+  for (int ret : results) {
+    if (ret != WEBRTC_VIDEO_CODEC_OK) {
+      return ret;
+    }
+  }
+  return send_failed ? WEBRTC_VIDEO_CODEC_ERROR : WEBRTC_VIDEO_CODEC_OK;
+}
+
+void SimulcastEncoderAdapter::RunOnStreamQueue(
+    size_t stream_idx,
+    rtc::FunctionView<void()> task) {
+  if (!parallel_encoding_ || stream_idx == 0) {
+    task();
+    return;
+  }
+  rtc::Event done;
+  encode_queues_[stream_idx - 1]->PostTask([&task, &done] {
+    task();
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+}
+
 int SimulcastEncoderAdapter::RegisterEncodeCompleteCallback(
     EncodedImageCallback* callback) {
   RTC_DCHECK_RUN_ON(&encoder_queue_);
@@ -493,8 +602,10 @@ int SimulcastEncoderAdapter::SetRateAllocation(
         stream_allocation.SetBitrate(0, i, bitrate.GetBitrate(stream_idx, i));
       }
     }
-    streaminfos_[stream_idx].encoder->SetRateAllocation(stream_allocation,
-                                                        new_framerate);
+    RunOnStreamQueue(stream_idx, [&] {
+      streaminfos_[stream_idx].encoder->SetRateAllocation(stream_allocation,
+                                                          new_framerate);
+    });
   }
 
   return WEBRTC_VIDEO_CODEC_OK;
@@ -507,6 +618,25 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
     const EncodedImage& encodedImage,
     const CodecSpecificInfo* codecSpecificInfo,
     const RTPFragmentationHeader* fragmentation) {
+  {
+    rtc::CritScope cs(&pending_images_lock_);
+    if (collecting_encoded_images_) {
+      // Held back until all streams of the frame are encoded; see
+      // EncodeStreamsInParallel(). The sink's feedback is not available yet.
+      pending_encoded_images_.emplace_back(stream_idx, encodedImage,
+                                           *codecSpecificInfo, fragmentation);
+      return EncodedImageCallback::Result(EncodedImageCallback::Result::OK);
+    }
+  }
+  return DeliverEncodedImage(stream_idx, encodedImage, codecSpecificInfo,
+                             fragmentation);
+}
+
+EncodedImageCallback::Result SimulcastEncoderAdapter::DeliverEncodedImage(
+    size_t stream_idx,
+    const EncodedImage& encodedImage,
+    const CodecSpecificInfo* codecSpecificInfo,
+    const RTPFragmentationHeader* fragmentation) {
   EncodedImage stream_image(encodedImage);
   CodecSpecificInfo stream_codec_specific = *codecSpecificInfo;
 
@@ -516,6 +646,28 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
       stream_image, &stream_codec_specific, fragmentation);
 }
 
+SimulcastEncoderAdapter::PendingEncodedImage::PendingEncodedImage(
+    size_t stream_idx,
+    const EncodedImage& encoded_image,
+    const CodecSpecificInfo& codec_specific_info,
+    const RTPFragmentationHeader* fragmentation)
+    : stream_idx(stream_idx),
+      encoded_image(encoded_image),
+      codec_specific_info(codec_specific_info),
+      has_fragmentation(fragmentation != nullptr) {
+  // Encoders may pass a fragmentation header that only lives for the
+  // duration of the callback, so take a deep copy.
+  if (fragmentation)
+    this->fragmentation.CopyFrom(*fragmentation);
+}
+
+SimulcastEncoderAdapter::PendingEncodedImage::PendingEncodedImage(
+    PendingEncodedImage&&) = default;
+SimulcastEncoderAdapter::PendingEncodedImage&
+SimulcastEncoderAdapter::PendingEncodedImage::operator=(
+    PendingEncodedImage&&) = default;
+SimulcastEncoderAdapter::PendingEncodedImage::~PendingEncodedImage() = default;
+
 void SimulcastEncoderAdapter::PopulateStreamCodec(
     const webrtc::VideoCodec& inst,
     int stream_index,
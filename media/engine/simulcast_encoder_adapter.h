@@ -20,10 +20,15 @@
 
 #include "absl/types/optional.h"
 #include "api/video_codecs/sdp_video_format.h"
+#include "modules/include/module_common_types.h"
 #include "modules/video_coding/include/video_codec_interface.h"
 #include "rtc_base/atomic_ops.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/function_view.h"
 #include "rtc_base/synchronization/sequence_checker.h"
 #include "rtc_base/system/rtc_export.h"
+#include "rtc_base/task_queue.h"
+#include "rtc_base/thread_annotations.h"
 
 namespace webrtc {
 
@@ -34,6 +39,11 @@ class VideoEncoderFactory;
 // webrtc::VideoEncoder instances with the given VideoEncoderFactory.
 // The object is created and destroyed on the worker thread, but all public
 // interfaces should be called from the encoder task queue.
+//
+// With the "WebRTC-SimulcastEncoderAdapter-ParallelEncoding" field trial
+// enabled, the streams of a frame are scaled and encoded concurrently on
+// internal task queues. Encode() still returns only once all streams are
+// encoded, and the encoded images are delivered in stream order.
 class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
  public:
   explicit SimulcastEncoderAdapter(VideoEncoderFactory* factory,
@@ -74,13 +84,36 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
           width(width),
           height(height),
           key_frame_request(false),
-          send_stream(send_stream) {}
+          send_stream(send_stream),
+          drop_next_frame(false) {}
     std::unique_ptr<VideoEncoder> encoder;
     std::unique_ptr<EncodedImageCallback> callback;
     uint16_t width;
     uint16_t height;
     bool key_frame_request;
     bool send_stream;
+    // Set when the sink asked to drop the next frame of a stream that was
+    // encoded in parallel, and whose encoder therefore never saw the answer.
+    bool drop_next_frame;
+  };
+
+  // An encoded image that is held back while streams are encoded in
+  // parallel. |encoded_image| refers to the encoder's buffer, which stays
+  // valid until that encoder's next Encode() call.
+  struct PendingEncodedImage {
+    PendingEncodedImage(size_t stream_idx,
+                        const EncodedImage& encoded_image,
+                        const CodecSpecificInfo& codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation);
+    PendingEncodedImage(PendingEncodedImage&&);
+    PendingEncodedImage& operator=(PendingEncodedImage&&);
+    ~PendingEncodedImage();
+
+    size_t stream_idx;
+    EncodedImage encoded_image;
+    CodecSpecificInfo codec_specific_info;
+    bool has_fragmentation;
+    RTPFragmentationHeader fragmentation;
   };
 
   enum class StreamResolution {
@@ -98,6 +131,30 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
 
   bool Initialized() const;
 
+  // Scales |input_image| to the resolution of stream |stream_idx|, if needed,
+  // and encodes it with that stream's encoder.
+  int EncodeStream(size_t stream_idx,
+                   const VideoFrame& input_image,
+                   VideoFrameType frame_type);
+
+  // Encodes each stream in |stream_indices| on the queue that owns it, then
+  // delivers the encoded images in stream order and applies the sink's
+  // results to the streams. Returns the first encode error, in stream order,
+  // or WEBRTC_VIDEO_CODEC_ERROR if the sink failed to send an image.
+  int EncodeStreamsInParallel(const VideoFrame& input_image,
+                              const std::vector<size_t>& stream_indices,
+                              VideoFrameType frame_type);
+
+  EncodedImageCallback::Result DeliverEncodedImage(
+      size_t stream_idx,
+      const EncodedImage& encoded_image,
+      const CodecSpecificInfo* codec_specific_info,
+      const RTPFragmentationHeader* fragmentation);
+
+  // Runs |task| on the queue that owns the encoder of stream |stream_idx| and
+  // waits for it to finish.
+  void RunOnStreamQueue(size_t stream_idx, rtc::FunctionView<void()> task);
+
   void DestroyStoredEncoders();
 
   volatile int inited_;  // Accessed atomically.
@@ -117,6 +174,18 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
 
   const absl::optional<unsigned int> experimental_boosted_screenshare_qp_;
   const bool boost_base_layer_quality_;
+
+  const bool parallel_encoding_;
+  // Created on demand by InitEncode(), one per stream beyond the first. With
+  // parallel encoding, every call to the encoder of stream i > 0 is made on
+  // encode_queues_[i - 1], so each encoder stays on a single sequence.
+  // Stream 0 is always operated on the encoder queue.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> encode_queues_;
+
+  rtc::CriticalSection pending_images_lock_;
+  bool collecting_encoded_images_ RTC_GUARDED_BY(pending_images_lock_);
+  std::vector<PendingEncodedImage> pending_encoded_images_
+      RTC_GUARDED_BY(pending_images_lock_);
 };
 
 }  // namespace webrtc
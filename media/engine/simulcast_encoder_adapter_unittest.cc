@@ -26,10 +26,16 @@
 #include "modules/video_coding/codecs/vp8/include/vp8.h"
 #include "modules/video_coding/include/video_codec_interface.h"
 #include "modules/video_coding/utility/simulcast_test_fixture_impl.h"
+#include "rtc_base/atomic_ops.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread_types.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/field_trial.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
 
 using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 using EncoderInfo = webrtc::VideoEncoder::EncoderInfo;
 using FramerateFractions =
@@ -375,8 +381,12 @@ class TestSimulcastEncoderAdapterFake : public ::testing::Test,
     last_encoded_image_height_ = encoded_image._encodedHeight;
     last_encoded_image_simulcast_index_ =
         encoded_image.SpatialIndex().value_or(-1);
+    encoded_simulcast_indices_.push_back(last_encoded_image_simulcast_index_);
 
-    return Result(Result::OK, encoded_image.Timestamp());
+    Result result(Result::OK, encoded_image.Timestamp());
+    result.drop_next_frame =
+        last_encoded_image_simulcast_index_ == drop_next_frame_of_stream_;
+    return result;
   }
 
   bool GetLastEncodedImageInfo(int* out_width,
@@ -477,6 +487,8 @@ class TestSimulcastEncoderAdapterFake : public ::testing::Test,
   int last_encoded_image_width_;
   int last_encoded_image_height_;
   int last_encoded_image_simulcast_index_;
+  int drop_next_frame_of_stream_ = -1;
+  std::vector<int> encoded_simulcast_indices_;
   std::unique_ptr<SimulcastRateAllocator> rate_allocator_;
 };
 
@@ -920,6 +932,160 @@ TEST_F(TestSimulcastEncoderAdapterFake, TestFailureReturnCodesFromEncodeCalls) {
             adapter_->Encode(input_frame, &frame_types));
 }
 
+TEST_F(TestSimulcastEncoderAdapterFake, EncodesStreamsInParallel) {
+  ScopedFieldTrials field_trials(
+      "WebRTC-SimulcastEncoderAdapter-ParallelEncoding/Enabled/");
+  adapter_.reset(new SimulcastEncoderAdapter(helper_->factory(),
+                                             SdpVideoFormat("VP8")));
+  SimulcastTestFixtureImpl::DefaultSettings(
+      &codec_, static_cast<const int*>(kTestTemporalLayerProfile),
+      kVideoCodecVP8);
+  codec_.numberOfSimulcastStreams = 3;
+  // High start bitrate, so all streams are enabled.
+  codec_.startBitrate = 3000;
+  EXPECT_EQ(0, adapter_->InitEncode(&codec_, 1, 1200));
+  adapter_->RegisterEncodeCompleteCallback(this);
+  ASSERT_EQ(3u, helper_->factory()->encoders().size());
+
+  // Each encoder waits until all of them have started, which only completes
+  // if the streams are encoded concurrently. The highest stream is encoded
+  // first, but the images must still be delivered in stream order.
+  volatile int started_encoders = 0;
+  rtc::Event all_started(/*manual_reset=*/true, /*initially_signaled=*/false);
+  for (size_t i = 0; i < 3; ++i) {
+    MockVideoEncoder* encoder = helper_->factory()->encoders()[i];
+    EXPECT_CALL(*encoder, Encode(_, _))
+        .WillOnce(Invoke([&, i, encoder](const VideoFrame& frame,
+                                         const std::vector<VideoFrameType>*) {
+          if (rtc::AtomicOps::Increment(&started_encoders) == 3)
+            all_started.Set();
+          EXPECT_TRUE(all_started.Wait(5000));
+          if (i != 2)
+            SleepMs(10);
+          encoder->SendEncodedImage(frame.width(), frame.height());
+          return WEBRTC_VIDEO_CODEC_OK;
+        }));
+  }
+
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  VideoFrame input_frame = VideoFrame::Builder()
+                               .set_video_frame_buffer(input_buffer)
+                               .set_timestamp_rtp(0)
+                               .set_timestamp_us(0)
+                               .set_rotation(kVideoRotation_0)
+                               .build();
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameKey);
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+  EXPECT_THAT(encoded_simulcast_indices_, ::testing::ElementsAre(0, 1, 2));
+  int width;
+  int height;
+  int simulcast_index;
+  EXPECT_TRUE(GetLastEncodedImageInfo(&width, &height, &simulcast_index));
+  EXPECT_EQ(codec_.simulcastStream[2].width, width);
+  EXPECT_EQ(codec_.simulcastStream[2].height, height);
+}
+
+TEST_F(TestSimulcastEncoderAdapterFake,
+       OperatesEachEncoderOnOneThreadWhenEncodingInParallel) {
+  ScopedFieldTrials field_trials(
+      "WebRTC-SimulcastEncoderAdapter-ParallelEncoding/Enabled/");
+  adapter_.reset(new SimulcastEncoderAdapter(helper_->factory(),
+                                             SdpVideoFormat("VP8")));
+  SimulcastTestFixtureImpl::DefaultSettings(
+      &codec_, static_cast<const int*>(kTestTemporalLayerProfile),
+      kVideoCodecVP8);
+  codec_.numberOfSimulcastStreams = 3;
+  codec_.startBitrate = 3000;
+  EXPECT_EQ(0, adapter_->InitEncode(&codec_, 1, 1200));
+  adapter_->RegisterEncodeCompleteCallback(this);
+  ASSERT_EQ(3u, helper_->factory()->encoders().size());
+
+  std::array<rtc::PlatformThreadRef, 3> encode_threads;
+  std::array<rtc::PlatformThreadRef, 3> release_threads;
+  for (size_t i = 0; i < 3; ++i) {
+    MockVideoEncoder* encoder = helper_->factory()->encoders()[i];
+    EXPECT_CALL(*encoder, Encode(_, _))
+        .WillOnce(Invoke([&, i](const VideoFrame& frame,
+                                const std::vector<VideoFrameType>*) {
+          encode_threads[i] = rtc::CurrentThreadRef();
+          return WEBRTC_VIDEO_CODEC_OK;
+        }));
+    EXPECT_CALL(*encoder, Release()).WillOnce(Invoke([&, i] {
+      release_threads[i] = rtc::CurrentThreadRef();
+      return WEBRTC_VIDEO_CODEC_OK;
+    }));
+  }
+
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  VideoFrame input_frame = VideoFrame::Builder()
+                               .set_video_frame_buffer(input_buffer)
+                               .set_timestamp_rtp(0)
+                               .set_timestamp_us(0)
+                               .set_rotation(kVideoRotation_0)
+                               .build();
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameKey);
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+  EXPECT_EQ(0, adapter_->Release());
+
+  // Stream 0 stays on the calling thread, the others each get their own.
+  EXPECT_TRUE(rtc::IsThreadRefEqual(encode_threads[0], rtc::CurrentThreadRef()));
+  EXPECT_FALSE(rtc::IsThreadRefEqual(encode_threads[1], encode_threads[2]));
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(rtc::IsThreadRefEqual(encode_threads[i], release_threads[i]));
+  }
+  adapter_.reset();
+}
+
+TEST_F(TestSimulcastEncoderAdapterFake,
+       AppliesDropNextFrameWhenEncodingInParallel) {
+  ScopedFieldTrials field_trials(
+      "WebRTC-SimulcastEncoderAdapter-ParallelEncoding/Enabled/");
+  adapter_.reset(new SimulcastEncoderAdapter(helper_->factory(),
+                                             SdpVideoFormat("VP8")));
+  SimulcastTestFixtureImpl::DefaultSettings(
+      &codec_, static_cast<const int*>(kTestTemporalLayerProfile),
+      kVideoCodecVP8);
+  codec_.numberOfSimulcastStreams = 3;
+  codec_.startBitrate = 3000;
+  EXPECT_EQ(0, adapter_->InitEncode(&codec_, 1, 1200));
+  adapter_->RegisterEncodeCompleteCallback(this);
+  ASSERT_EQ(3u, helper_->factory()->encoders().size());
+
+  // The sink asks to drop the next frame of stream 1 only.
+  drop_next_frame_of_stream_ = 1;
+  for (size_t i = 0; i < 3; ++i) {
+    MockVideoEncoder* encoder = helper_->factory()->encoders()[i];
+    EXPECT_CALL(*encoder, Encode(_, _))
+        .Times(i == 1 ? 2 : 3)
+        .WillRepeatedly(Invoke([encoder](const VideoFrame& frame,
+                                         const std::vector<VideoFrameType>*) {
+          encoder->SendEncodedImage(frame.width(), frame.height());
+          return WEBRTC_VIDEO_CODEC_OK;
+        }));
+  }
+
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  VideoFrame input_frame = VideoFrame::Builder()
+                               .set_video_frame_buffer(input_buffer)
+                               .set_timestamp_rtp(0)
+                               .set_timestamp_us(0)
+                               .set_rotation(kVideoRotation_0)
+                               .build();
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameDelta);
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+  drop_next_frame_of_stream_ = -1;
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+  EXPECT_THAT(encoded_simulcast_indices_,
+              ::testing::ElementsAre(0, 1, 2, 0, 2, 0, 1, 2));
+}
+
 TEST_F(TestSimulcastEncoderAdapterFake, TestInitFailureCleansUpEncoders) {
   SimulcastTestFixtureImpl::DefaultSettings(
       &codec_, static_cast<const int*>(kTestTemporalLayerProfile),
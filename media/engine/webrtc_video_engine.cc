@@ -1752,6 +1752,7 @@ bool WebRtcVideoChannel::SendRtp(const uint8_t* data,
   }
   rtc_options.info_signaled_after_sent.included_in_feedback = options.included_in_feedback;
   rtc_options.info_signaled_after_sent.included_in_allocation = options.included_in_allocation;
+  rtc_options.batchable = options.batchable;
   return MediaChannel::SendPacket(&packet, rtc_options);
 }
 
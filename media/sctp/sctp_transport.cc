@@ -38,6 +38,7 @@ enum PreservedErrno {
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/thread_checker.h"
 #include "rtc_base/trace_event.h"
+#include "system_wrappers/include/field_trial.h"
 #include "usrsctplib/usrsctp.h"
 
 namespace {
@@ -258,12 +259,7 @@ class SctpTransport::UsrSctpWrapper {
 
     VerboseLogPacket(data, length, SCTP_DUMP_OUTBOUND);
     // Note: We have to copy the data; the caller will delete it.
-    rtc::CopyOnWriteBuffer buf(reinterpret_cast<uint8_t*>(data), length);
-    // TODO(deadbeef): Why do we need an AsyncInvoke here? We're already on the
-    // right thread and don't need to unwind the stack.
-    transport->invoker_.AsyncInvoke<void>(
-        RTC_FROM_HERE, transport->network_thread_,
-        rtc::Bind(&SctpTransport::OnPacketFromSctpToNetwork, transport, buf));
+    transport->QueueOutboundPacket(data, length);
     return 0;
   }
 
@@ -383,7 +379,9 @@ SctpTransport::SctpTransport(rtc::Thread* network_thread,
                              rtc::PacketTransportInternal* transport)
     : network_thread_(network_thread),
       transport_(transport),
-      was_ever_writable_(transport ? transport->writable() : false) {
+      was_ever_writable_(transport ? transport->writable() : false),
+      message_bundling_(
+          webrtc::field_trial::IsEnabled("WebRTC-SctpMessageBundling")) {
   RTC_DCHECK(network_thread_);
   RTC_DCHECK_RUN_ON(network_thread_);
   ConnectTransportSignals();
@@ -538,9 +536,12 @@ bool SctpTransport::SendData(const SendDataParams& params,
   }
 
   // We don't fragment.
+  defer_outbound_flush_ = true;
   send_res = usrsctp_sendv(
       sock_, payload.data(), static_cast<size_t>(payload.size()), NULL, 0, &spa,
       rtc::checked_cast<socklen_t>(sizeof(spa)), SCTP_SENDV_SPA, 0);
+  defer_outbound_flush_ = false;
+  FlushOutboundPackets();
   if (send_res < 0) {
     if (errno == SCTP_EWOULDBLOCK) {
       if (result) {
@@ -720,8 +721,9 @@ bool SctpTransport::ConfigureSctpSocket() {
     return false;
   }
 
-  // Nagle.
-  uint32_t nodelay = 1;
+  // Nagle. Only enabled when message bundling was asked for, since it holds
+  // back small messages while earlier data is unacknowledged.
+  uint32_t nodelay = message_bundling_ ? 0 : 1;
   if (usrsctp_setsockopt(sock_, IPPROTO_SCTP, SCTP_NODELAY, &nodelay,
                          sizeof(nodelay))) {
     RTC_LOG_ERRNO(LS_ERROR) << debug_name_ << "->ConfigureSctpSocket(): "
@@ -880,7 +882,11 @@ void SctpTransport::OnPacketRead(rtc::PacketTransportInternal* transport,
     // will be will be given to the global OnSctpInboundData, and then,
     // marshalled by the AsyncInvoker.
     VerboseLogPacket(data, len, SCTP_DUMP_INBOUND);
+    defer_outbound_flush_ = true;
     usrsctp_conninput(this, data, len, 0);
+    defer_outbound_flush_ = false;
+    // Send the SACKs and any data released by them right away.
+    FlushOutboundPackets();
   } else {
     // TODO(ldixon): Consider caching the packet for very slightly better
     // reliability.
@@ -904,8 +910,57 @@ sockaddr_conn SctpTransport::GetSctpSockAddr(int port) {
   return sconn;
 }
 
-void SctpTransport::OnPacketFromSctpToNetwork(
-    const rtc::CopyOnWriteBuffer& buffer) {
+void SctpTransport::QueueOutboundPacket(const void* data, size_t length) {
+  bool post_flush = false;
+  {
+    rtc::CritScope cs(&outbound_lock_);
+    if (num_outbound_packets_ == outbound_packets_.size()) {
+      outbound_packets_.emplace_back();
+    }
+    outbound_packets_[num_outbound_packets_++].SetData(
+        static_cast<const uint8_t*>(data), length);
+    // |defer_outbound_flush_| is only touched on the network thread.
+    if (!outbound_flush_pending_ &&
+        !(network_thread_->IsCurrent() && defer_outbound_flush_)) {
+      outbound_flush_pending_ = true;
+      post_flush = true;
+    }
+  }
+  if (post_flush) {
+    invoker_.AsyncInvoke<void>(
+        RTC_FROM_HERE, network_thread_,
+        rtc::Bind(&SctpTransport::FlushOutboundPackets, this));
+  }
+}
+
+void SctpTransport::FlushOutboundPackets() {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  // Sending a packet may synchronously deliver a reply to OnPacketRead, which
+  // queues more packets and flushes again; the outermost call sends them.
+  if (flushing_outbound_packets_) {
+    return;
+  }
+  flushing_outbound_packets_ = true;
+  while (true) {
+    size_t num_packets;
+    {
+      rtc::CritScope cs(&outbound_lock_);
+      outbound_flush_pending_ = false;
+      num_packets = num_outbound_packets_;
+      if (num_packets == 0) {
+        break;
+      }
+      outbound_packets_.swap(sending_packets_);
+      num_outbound_packets_ = 0;
+    }
+    for (size_t i = 0; i < num_packets; ++i) {
+      OnPacketFromSctpToNetwork(sending_packets_[i]);
+    }
+  }
+  flushing_outbound_packets_ = false;
+}
+
+void SctpTransport::OnPacketFromSctpToNetwork(const rtc::Buffer& buffer) {
   RTC_DCHECK_RUN_ON(network_thread_);
   if (buffer.size() > (kSctpMtu)) {
     RTC_LOG(LS_ERROR) << debug_name_ << "->OnPacketFromSctpToNetwork(...): "
@@ -20,10 +20,14 @@
 #include <vector>
 
 #include "rtc_base/async_invoker.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/checks.h"
 #include "rtc_base/constructor_magic.h"
 #include "rtc_base/copy_on_write_buffer.h"
+#include "rtc_base/critical_section.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/thread_annotations.h"
 // For SendDataParams/ReceiveDataParams.
 #include "media/base/media_channel.h"
 #include "media/sctp/sctp_transport_internal.h"
@@ -45,18 +49,22 @@ struct SctpInboundPacket;
 //  2.  usrsctp_sendv(data)
 // [network thread returns; sctp thread then calls the following]
 //  3.  OnSctpOutboundPacket(wrapped_data)
-// [sctp thread returns having async invoked on the network thread]
-//  4.  SctpTransport::OnPacketFromSctpToNetwork(wrapped_data)
-//  5.  DtlsTransport::SendPacket(wrapped_data)
-//  6.  ... across network ... a packet is sent back ...
-//  7.  SctpTransport::OnPacketReceived(wrapped_data)
-//  8.  usrsctp_conninput(wrapped_data)
+//  4.  SctpTransport::QueueOutboundPacket(wrapped_data)
+// [sctp thread returns; if usrsctp_sendv is still on the stack, the network
+//  thread flushes the queue when it returns, otherwise a flush is async
+//  invoked on the network thread]
+//  5.  SctpTransport::FlushOutboundPackets()
+//  6.  SctpTransport::OnPacketFromSctpToNetwork(wrapped_data), per packet
+//  7.  DtlsTransport::SendPacket(wrapped_data)
+//  8.  ... across network ... a packet is sent back ...
+//  9.  SctpTransport::OnPacketReceived(wrapped_data)
+//  10. usrsctp_conninput(wrapped_data)
 // [network thread returns; sctp thread then calls the following]
-//  9.  OnSctpInboundData(data)
+//  11. OnSctpInboundData(data)
 // [sctp thread returns having async invoked on the network thread]
-//  10. SctpTransport::OnInboundPacketFromSctpToTransport(inboundpacket)
-//  11. SctpTransport::OnDataFromSctpToTransport(data)
-//  12. SctpTransport::SignalDataReceived(data)
+//  12. SctpTransport::OnInboundPacketFromSctpToTransport(inboundpacket)
+//  13. SctpTransport::OnDataFromSctpToTransport(data)
+//  14. SctpTransport::SignalDataReceived(data)
 // [from the same thread, methods registered/connected to
 //  SctpTransport are called with the recieved data]
 class SctpTransport : public SctpTransportInternal,
@@ -83,6 +91,17 @@ class SctpTransport : public SctpTransportInternal,
     debug_name_ = debug_name;
   }
 
+  // When enabled, usrsctp is allowed to hold back small messages (Nagle) so
+  // that several of them are bundled as DATA chunks into one SCTP packet. This
+  // trades up to a round trip of latency on small messages for far fewer
+  // packets (and DTLS records) when an application sends many small messages
+  // in a row. Disabled by default, unless the "WebRTC-SctpMessageBundling"
+  // field trial is enabled; must be set before Start().
+  void set_message_bundling(bool enabled) {
+    RTC_DCHECK(!sock_);
+    message_bundling_ = enabled;
+  }
+
   // Exposed to allow Post call from c-callbacks.
   // TODO(deadbeef): Remove this or at least make it return a const pointer.
   rtc::Thread* network_thread() const { return network_thread_; }
@@ -119,8 +138,14 @@ class SctpTransport : public SctpTransportInternal,
   void OnSendThresholdCallback();
   sockaddr_conn GetSctpSockAddr(int port);
 
-  // Called using |invoker_| to send packet on the network.
-  void OnPacketFromSctpToNetwork(const rtc::CopyOnWriteBuffer& buffer);
+  // Called from the usrsctp outbound callback, on any thread. Copies the
+  // packet into |outbound_packets_| and, unless the network thread will flush
+  // the queue once usrsctp returns, async invokes FlushOutboundPackets.
+  void QueueOutboundPacket(const void* data, size_t length);
+  // Sends all queued outbound packets on the network, in order.
+  void FlushOutboundPackets();
+  // Sends one packet on the network.
+  void OnPacketFromSctpToNetwork(const rtc::Buffer& buffer);
   // Called using |invoker_| to decide what to do with the packet.
   // The |flags| parameter is used by SCTP to distinguish notification packets
   // from other types of packets.
@@ -142,6 +167,23 @@ class SctpTransport : public SctpTransportInternal,
   // Underlying DTLS transport.
   rtc::PacketTransportInternal* transport_ = nullptr;
 
+  // Outbound SCTP packets waiting to be passed to |transport_|. usrsctp hands
+  // us packets on the network thread while it runs usrsctp_sendv or
+  // usrsctp_conninput, and on its own timer thread for retransmissions, so
+  // the queue is guarded by |outbound_lock_|. The buffers are reused; only the
+  // first |num_outbound_packets_| are queued.
+  rtc::CriticalSection outbound_lock_;
+  std::vector<rtc::Buffer> outbound_packets_ RTC_GUARDED_BY(outbound_lock_);
+  size_t num_outbound_packets_ RTC_GUARDED_BY(outbound_lock_) = 0;
+  bool outbound_flush_pending_ RTC_GUARDED_BY(outbound_lock_) = false;
+  // Swapped with |outbound_packets_| by FlushOutboundPackets, so that packets
+  // can be sent without holding |outbound_lock_|.
+  std::vector<rtc::Buffer> sending_packets_;
+  // True while the network thread is inside a usrsctp call that is followed
+  // by FlushOutboundPackets.
+  bool defer_outbound_flush_ = false;
+  bool flushing_outbound_packets_ = false;
+
   // Track the data received from usrsctp between callbacks until the EOR bit
   // arrives.
   rtc::CopyOnWriteBuffer partial_message_;
@@ -152,6 +194,7 @@ class SctpTransport : public SctpTransportInternal,
   int local_port_ = kSctpDefaultPort;
   int remote_port_ = kSctpDefaultPort;
   struct socket* sock_ = nullptr;  // The socket created by usrsctp_socket(...).
+  bool message_bundling_ = false;
 
   // Has Start been called? Don't create SCTP socket until it has.
   bool started_ = false;
@@ -44,6 +44,7 @@ class SctpFakeDataReceiver : public sigslot::has_slots<> {
 
   void Clear() {
     received_ = false;
+    num_messages_received_ = 0;
     last_data_ = "";
     last_params_ = ReceiveDataParams();
   }
@@ -51,16 +52,19 @@ class SctpFakeDataReceiver : public sigslot::has_slots<> {
   void OnDataReceived(const ReceiveDataParams& params,
                       const rtc::CopyOnWriteBuffer& data) {
     received_ = true;
+    ++num_messages_received_;
     last_data_ = std::string(data.data<char>(), data.size());
     last_params_ = params;
   }
 
   bool received() const { return received_; }
+  int num_messages_received() const { return num_messages_received_; }
   std::string last_data() const { return last_data_; }
   ReceiveDataParams last_params() const { return last_params_; }
 
  private:
   bool received_;
+  int num_messages_received_ = 0;
   std::string last_data_;
   ReceiveDataParams last_params_;
 };
@@ -422,6 +426,103 @@ TEST_F(SctpTransportTest, SendData) {
                       << ", recv1.last_data=" << receiver1()->last_data();
 }
 
+// Counts the packets an SctpTransport hands to its DTLS transport.
+class SentPacketCounter : public sigslot::has_slots<> {
+ public:
+  explicit SentPacketCounter(FakeDtlsTransport* fake_dtls) {
+    fake_dtls->fake_ice_transport()->SignalSentPacket.connect(
+        this, &SentPacketCounter::OnSentPacket);
+  }
+
+  int count() const { return count_; }
+  void Reset() { count_ = 0; }
+
+ private:
+  void OnSentPacket(rtc::PacketTransportInternal* transport,
+                    const rtc::SentPacket& sent_packet) {
+    ++count_;
+  }
+
+  int count_ = 0;
+};
+
+// Packets that usrsctp produces inside SendData are queued and flushed to the
+// DTLS transport before SendData returns, not in a task posted to the network
+// thread.
+TEST_F(SctpTransportTest, SendsOutboundPacketsWithoutThreadHop) {
+  FakeDtlsTransport fake_dtls1("fake dtls 1", 0);
+  FakeDtlsTransport fake_dtls2("fake dtls 2", 0);
+  SctpFakeDataReceiver recv1;
+  SctpFakeDataReceiver recv2;
+  std::unique_ptr<SctpTransport> transport1(
+      CreateTransport(&fake_dtls1, &recv1));
+  std::unique_ptr<SctpTransport> transport2(
+      CreateTransport(&fake_dtls2, &recv2));
+  SctpTransportObserver observer(transport1.get());
+  SentPacketCounter sent_packets(&fake_dtls1);
+
+  transport1->OpenStream(1);
+  transport2->OpenStream(1);
+  bool asymmetric = false;
+  fake_dtls1.SetDestination(&fake_dtls2, asymmetric);
+  transport1->Start(kTransport1Port, kTransport2Port);
+  transport2->Start(kTransport2Port, kTransport1Port);
+  ASSERT_TRUE_WAIT(observer.ReadyToSend(), kDefaultTimeout);
+
+  sent_packets.Reset();
+  SendDataParams params;
+  params.sid = 1;
+  SendDataResult result;
+  ASSERT_TRUE(transport1->SendData(params, rtc::CopyOnWriteBuffer("hello", 5),
+                                   &result));
+  EXPECT_EQ(SDR_SUCCESS, result);
+  // No messages have been processed on this thread since SendData was called.
+  EXPECT_GT(sent_packets.count(), 0);
+  EXPECT_TRUE_WAIT(recv2.received(), kDefaultTimeout);
+  EXPECT_EQ("hello", recv2.last_data());
+}
+
+// With message bundling, a burst of small messages is bundled into far fewer
+// SCTP packets, and still arrives complete and in order.
+TEST_F(SctpTransportTest, BundlesSmallMessages) {
+  const int kNumMessages = 200;
+  FakeDtlsTransport fake_dtls1("fake dtls 1", 0);
+  FakeDtlsTransport fake_dtls2("fake dtls 2", 0);
+  SctpFakeDataReceiver recv1;
+  SctpFakeDataReceiver recv2;
+  std::unique_ptr<SctpTransport> transport1(
+      CreateTransport(&fake_dtls1, &recv1));
+  std::unique_ptr<SctpTransport> transport2(
+      CreateTransport(&fake_dtls2, &recv2));
+  transport1->set_message_bundling(true);
+  SctpTransportObserver observer(transport1.get());
+  SentPacketCounter sent_packets(&fake_dtls1);
+
+  transport1->OpenStream(1);
+  transport2->OpenStream(1);
+  bool asymmetric = false;
+  fake_dtls1.SetDestination(&fake_dtls2, asymmetric);
+  transport1->Start(kTransport1Port, kTransport2Port);
+  transport2->Start(kTransport2Port, kTransport1Port);
+  ASSERT_TRUE_WAIT(observer.ReadyToSend(), kDefaultTimeout);
+
+  sent_packets.Reset();
+  SendDataParams params;
+  params.sid = 1;
+  params.ordered = true;
+  SendDataResult result;
+  for (int i = 0; i < kNumMessages; ++i) {
+    std::string msg = std::to_string(i);
+    ASSERT_TRUE(transport1->SendData(
+        params, rtc::CopyOnWriteBuffer(msg.data(), msg.size()), &result));
+    EXPECT_EQ(SDR_SUCCESS, result);
+  }
+  EXPECT_EQ_WAIT(kNumMessages, recv2.num_messages_received(),
+                 kDefaultTimeout);
+  EXPECT_EQ(std::to_string(kNumMessages - 1), recv2.last_data());
+  EXPECT_LT(sent_packets.count(), kNumMessages / 2);
+}
+
 // Sends a lot of large messages at once and verifies SDR_BLOCK is returned.
 TEST_F(SctpTransportTest, SendDataBlocked) {
   SetupConnectedTransportsWithTwoStreams();
@@ -31,7 +31,8 @@ IntervalBudget::IntervalBudget(int initial_target_rate_kbps)
 
 IntervalBudget::IntervalBudget(int initial_target_rate_kbps, bool can_build_up_underuse)
     : bytes_remaining_(0)
-	, can_build_up_underuse_(can_build_up_underuse) 
+	, can_build_up_underuse_(can_build_up_underuse)
+	, sub_byte_remainder_(0)
 {
   set_target_rate_kbps(initial_target_rate_kbps);
 }
@@ -49,7 +50,19 @@ void IntervalBudget::set_target_rate_kbps(int target_rate_kbps)
 void IntervalBudget::IncreaseBudget(int64_t delta_time_ms) 
 {
   // 一般来说，can_build_up_underuse_ 都会关闭，关于这个开关的介绍见最后一部分介绍
-  int bytes = rtc::dchecked_cast<int>(target_rate_kbps_ * delta_time_ms / 8);
+  AddBytes(rtc::dchecked_cast<int>(target_rate_kbps_ * delta_time_ms / 8));
+}
+
+void IntervalBudget::IncreaseBudgetUs(int64_t delta_time_us) {
+  // kbps * us gives the budget in 1/1000 bit.
+  const int64_t millibits =
+      target_rate_kbps_ * delta_time_us + sub_byte_remainder_;
+  sub_byte_remainder_ = millibits % 8000;
+  AddBytes(rtc::dchecked_cast<int>(millibits / 8000));
+}
+
+void IntervalBudget::AddBytes(int bytes)
+{
   if (bytes_remaining_ < 0 || can_build_up_underuse_) 
   {
     // We overused last interval, compensate this interval.
@@ -80,6 +93,10 @@ size_t IntervalBudget::bytes_remaining() const
   return static_cast<size_t>(std::max(0, bytes_remaining_));
 }
 
+size_t IntervalBudget::bytes_overused() const {
+  return static_cast<size_t>(std::max(0, -bytes_remaining_));
+}
+
 int IntervalBudget::budget_level_percent() const 
 {
   if (max_bytes_in_budget_ == 0)
@@ -28,16 +28,25 @@ class IntervalBudget {
   // TODO(tschumim): Unify IncreaseBudget and UseBudget to one function.
   // 时间流逝后增加budget
   void IncreaseBudget(int64_t delta_time_ms);
+  // Same as IncreaseBudget(), for callers updating the budget more often
+  // than once per millisecond. Fractions of a byte are carried over to the
+  // next call.
+  void IncreaseBudgetUs(int64_t delta_time_us);
   // 发送数据后减少budget
   void UseBudget(size_t bytes);
   // 剩余budget
   size_t bytes_remaining() const;
+  // Bytes sent beyond the budget, that the budget has to catch up with before
+  // bytes_remaining() becomes positive again.
+  size_t bytes_overused() const;
   // 剩余budget占当前窗口数据量比例
   int budget_level_percent() const;
   // 目标发送码率
   int target_rate_kbps() const;
 
  private:
+  void AddBytes(int bytes);
+
   // 设置的目标码率，按照这个码率控制数据发送
   int target_rate_kbps_;
   // 窗口内（500ms）对应的最大字节数=窗口大小*target_rate_kbps_/8
@@ -46,6 +55,9 @@ class IntervalBudget {
   int bytes_remaining_;
   // 上个周期underuse，本周期是否可以借用上个周期的剩余量
   bool can_build_up_underuse_;
+  // Budget for less than a byte left over by IncreaseBudgetUs(), in units of
+  // 1/1000 bit.
+  int64_t sub_byte_remainder_;
 };
 
 }  // namespace webrtc
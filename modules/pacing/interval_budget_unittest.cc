@@ -116,4 +116,22 @@ TEST(IntervalBudgetTest, CanNotBuildUpUnderuseWhenConfigured) {
             TimeToBytes(kBitrateKbps, delta_time_ms));
 }
 
+TEST(IntervalBudgetTest, IncreaseBudgetUsCarriesFractionalBytes) {
+  IntervalBudget interval_budget(kBitrateKbps, kCanBuildUpUnderuse);
+  // 100 kbps is 12.5 bytes per millisecond; 100 us slots give 1.25 bytes each.
+  for (int i = 0; i < 40; ++i)
+    interval_budget.IncreaseBudgetUs(100);
+  EXPECT_EQ(interval_budget.bytes_remaining(), TimeToBytes(kBitrateKbps, 4));
+}
+
+TEST(IntervalBudgetTest, BytesOverused) {
+  IntervalBudget interval_budget(kBitrateKbps);
+  interval_budget.IncreaseBudget(10);
+  interval_budget.UseBudget(TimeToBytes(kBitrateKbps, 30));
+  EXPECT_EQ(interval_budget.bytes_remaining(), 0u);
+  EXPECT_EQ(interval_budget.bytes_overused(), TimeToBytes(kBitrateKbps, 20));
+  interval_budget.IncreaseBudgetUs(20000);
+  EXPECT_EQ(interval_budget.bytes_overused(), 0u);
+}
+
 }  // namespace webrtc
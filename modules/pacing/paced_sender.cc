@@ -11,6 +11,7 @@
 #include "modules/pacing/paced_sender.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <utility>
 
 #include "absl/memory/memory.h"
@@ -21,6 +22,7 @@
 #include "modules/utility/include/process_thread.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/task_utils/to_queued_task.h"
 #include "system_wrappers/include/clock.h"
 
 namespace webrtc {
@@ -35,6 +37,12 @@ const int64_t kMaxElapsedTimeMs = 2000;
 // time.
 const int64_t kMaxIntervalTimeMs = 30;
 
+// Shortest interval between two Process() calls in high resolution mode, so
+// that a high pacing rate doesn't turn into a busy loop. Task queues without a
+// high resolution timer round it up to 1 ms, see
+// TaskQueueBase::PostDelayedTaskUs().
+const int64_t kMinProcessIntervalUs = 250;
+
 bool IsDisabled(const WebRtcKeyValueConfig& field_trials,
                 absl::string_view key) {
   return field_trials.Lookup(key).find("Disabled") == 0;
@@ -73,6 +81,8 @@ PacedSender::PacedSender(Clock* clock,
       send_padding_if_silent_(
           IsEnabled(field_trials, "WebRTC-Pacer-PadInSilence")),
       pace_audio_(!IsDisabled(field_trials, "WebRTC-Pacer-BlockAudio")),
+      high_resolution_(
+          IsEnabled(field_trials, "WebRTC-Pacer-HighResolution")),
       min_packet_limit_ms_("", kDefaultMinPacketLimitMs),// TODO@chensong 20220828 paced模块 是默认5毫秒检查要发送包
       last_timestamp_ms_(clock_->TimeInMilliseconds()),
       paused_(false),
@@ -91,7 +101,9 @@ PacedSender::PacedSender(Clock* clock,
       packet_counter_(0),
       pacing_factor_(kDefaultPaceMultiplier),
       queue_time_limit(kMaxQueueLengthMs),
-      account_for_audio_(false) {
+      account_for_audio_(false),
+      ideal_send_time_us_(-1),
+      next_scheduled_process_us_(-1) {
   if (!drain_large_queues_) {
     RTC_LOG(LS_WARNING) << "Pacer queues will not be drained,"
                            "pushback experiment must be enabled.";
@@ -103,9 +115,46 @@ PacedSender::PacedSender(Clock* clock,
 
 PacedSender::~PacedSender() {}
 
+void PacedSender::StartOnTaskQueue(TaskQueueFactory* task_queue_factory) {
+  rtc::CritScope cs(&critsect_);
+  RTC_DCHECK(!task_queue_);
+  task_queue_ = task_queue_factory->CreateTaskQueue(
+      "PacerQueue", TaskQueueFactory::Priority::HIGH);
+  ScheduleProcess(TimeUntilNextProcessUs());
+}
+
+void PacedSender::ScheduleProcess(int64_t delay_us) {
+  if (!task_queue_)
+    return;
+  int64_t process_at_us = clock_->TimeInMicroseconds() + delay_us;
+  if (next_scheduled_process_us_ != -1 &&
+      next_scheduled_process_us_ <= process_at_us) {
+    return;
+  }
+  // A task posted earlier for a later time is left to run, and does nothing.
+  next_scheduled_process_us_ = process_at_us;
+  task_queue_->PostDelayedTaskUs(
+      ToQueuedTask(
+          [this, process_at_us] { RunScheduledProcess(process_at_us); }),
+      delay_us);
+}
+
+void PacedSender::RunScheduledProcess(int64_t scheduled_us) {
+  {
+    rtc::CritScope cs(&critsect_);
+    if (scheduled_us != next_scheduled_process_us_)
+      return;
+    next_scheduled_process_us_ = -1;
+  }
+  Process();
+  rtc::CritScope cs(&critsect_);
+  ScheduleProcess(TimeUntilNextProcessUs());
+}
+
 void PacedSender::CreateProbeCluster(int bitrate_bps, int cluster_id) {
   rtc::CritScope cs(&critsect_);
   prober_.CreateProbeCluster(bitrate_bps, TimeMilliseconds(), cluster_id);
+  ScheduleProcess(TimeUntilNextProcessUs());
 }
 
 void PacedSender::Pause() {
@@ -117,6 +166,7 @@ void PacedSender::Pause() {
 	}
     paused_ = true;
     packets_.SetPauseState(true, TimeMilliseconds());
+    ideal_send_time_us_ = -1;
   }
   rtc::CritScope cs(&process_thread_lock_);
   // Tell the process thread to call our TimeUntilNextProcess() method to get
@@ -136,6 +186,7 @@ void PacedSender::Resume() {
 	}
     paused_ = false;
     packets_.SetPauseState(false, TimeMilliseconds());
+    ScheduleProcess(TimeUntilNextProcessUs());
   }
   rtc::CritScope cs(&process_thread_lock_);
   // Tell the process thread to call our TimeUntilNextProcess() method to
@@ -221,6 +272,7 @@ void PacedSender::SetPacingRates(uint32_t pacing_rate_bps, uint32_t padding_rate
   RTC_LOG(LS_VERBOSE) << "bwe:pacer_updated pacing_kbps="
                       << pacing_bitrate_kbps_
                       << " padding_budget_kbps=" << padding_rate_bps / 1000;
+  ScheduleProcess(TimeUntilNextProcessUs());
 }
 
 void PacedSender::InsertPacket(RtpPacketSender::Priority priority,
@@ -244,6 +296,7 @@ void PacedSender::InsertPacket(RtpPacketSender::Priority priority,
   // TODO@chensong 2022-12-08  发送包的序号 队列 
   packets_.Push(RoundRobinPacketQueue::Packet(
       priority, ssrc, sequence_number, capture_time_ms, now_ms, bytes, retransmission, packet_counter_++));
+  ScheduleProcess(TimeUntilNextProcessUs());
 }
 
 void PacedSender::SetAccountForAudioPackets(bool account_for_audio) {
@@ -274,6 +327,11 @@ int64_t PacedSender::QueueSizeBytes() const {
   return packets_.SizeInBytes();
 }
 
+PacedSender::PacingStats PacedSender::GetPacingStats() const {
+  rtc::CritScope cs(&critsect_);
+  return stats_;
+}
+
 int64_t PacedSender::FirstSentPacketTimeMs() const {
   rtc::CritScope cs(&critsect_);
   return first_sent_packet_ms_;
@@ -291,6 +349,8 @@ int64_t PacedSender::QueueInMs() const {
 
 int64_t PacedSender::TimeUntilNextProcess() 
 {
+  if (high_resolution_)
+    return (TimeUntilNextProcessUs() + 999) / 1000;
   rtc::CritScope cs(&critsect_);
   int64_t elapsed_time_us = clock_->TimeInMicroseconds() - time_last_process_us_;
   int64_t elapsed_time_ms = (elapsed_time_us + 500) / 1000;
@@ -318,6 +378,36 @@ int64_t PacedSender::TimeUntilNextProcess()
   return std::max<int64_t>(min_packet_limit_ms_ - elapsed_time_ms, 0);
 }
 
+int64_t PacedSender::TimeUntilNextProcessUs() {
+  rtc::CritScope cs(&critsect_);
+  if (!high_resolution_)
+    return TimeUntilNextProcess() * 1000;
+  int64_t elapsed_time_us = clock_->TimeInMicroseconds() - time_last_process_us_;
+  if (paused_)
+    return std::max<int64_t>(kPausedProcessIntervalMs * 1000 - elapsed_time_us, 0);
+
+  if (prober_.IsProbing()) {
+    int64_t ret = prober_.TimeUntilNextProbe(TimeMilliseconds());
+    if (ret > 0 || (ret == 0 && !probing_send_failure_))
+      return ret * 1000;
+  }
+  if (packets_.Empty() || Congested()) {
+    // Nothing to pace, wake up at the regular interval for padding and
+    // keep-alives; InsertPacket() brings the next wake-up forward.
+    return std::max<int64_t>(min_packet_limit_ms_ * 1000 - elapsed_time_us, 0);
+  }
+  // Wake up when the media budget has caught up with what was overused by
+  // the last packet sent.
+  int64_t wait_us = 0;
+  const int rate_kbps = media_budget_.target_rate_kbps();
+  if (media_budget_.bytes_remaining() == 0 && rate_kbps > 0) {
+    const int64_t bytes = media_budget_.bytes_overused() + 1;
+    wait_us = (bytes * 8000 + rate_kbps - 1) / rate_kbps;
+  }
+  return std::max<int64_t>(
+      std::max(wait_us, kMinProcessIntervalUs) - elapsed_time_us, 0);
+}
+
 int64_t PacedSender::UpdateTimeAndGetElapsedMs(int64_t now_us) 
 {
   int64_t elapsed_time_ms = (now_us - time_last_process_us_ + 500) / 1000;
@@ -332,6 +422,18 @@ int64_t PacedSender::UpdateTimeAndGetElapsedMs(int64_t now_us)
   return elapsed_time_ms;
 }
 
+int64_t PacedSender::UpdateTimeAndGetElapsedUs(int64_t now_us) {
+  int64_t elapsed_time_us = now_us - time_last_process_us_;
+  time_last_process_us_ = now_us;
+  if (elapsed_time_us > kMaxElapsedTimeMs * 1000) {
+    RTC_LOG(LS_WARNING) << "Elapsed time (" << elapsed_time_us
+                        << " us) longer than expected, limiting to "
+                        << kMaxElapsedTimeMs << " ms";
+    elapsed_time_us = kMaxElapsedTimeMs * 1000;
+  }
+  return elapsed_time_us;
+}
+
 bool PacedSender::ShouldSendKeepalive(int64_t now_us) const 
 {
   if (send_padding_if_silent_ || paused_ || Congested()) 
@@ -363,7 +465,11 @@ void PacedSender::Process()
   rtc::CritScope cs(&critsect_);
   int64_t now_us = clock_->TimeInMicroseconds();
   // elapsed_time_ms = [0 - 2000ms]
-  int64_t elapsed_time_ms = UpdateTimeAndGetElapsedMs(now_us);
+  // In high resolution mode Process() runs more than once per millisecond,
+  // so the budget is updated with the exact elapsed time instead.
+  int64_t elapsed_time_us = high_resolution_
+                                ? UpdateTimeAndGetElapsedUs(now_us)
+                                : UpdateTimeAndGetElapsedMs(now_us) * 1000;
   // TODO@chensong 20220803
   // 检查是否需要发送keepalive包,
   // 判定的依据如下，如果需要则构造一个1Bytes的包发送
@@ -386,7 +492,7 @@ void PacedSender::Process()
   }
   // 根据发送队列大小计算目标码率，使用目标码率更新
   // 预算
-  if (elapsed_time_ms > 0) 
+  if (elapsed_time_us > 0) 
   {
 	  // 三个重要接口修改 目标码流
 	  // 接口1. PacedSender::SetEstimatedBitrate
@@ -415,13 +521,18 @@ void PacedSender::Process()
 
     media_budget_.set_target_rate_kbps(target_bitrate_kbps);
 	//更新媒体和pping的数据的大小
-    UpdateBudgetWithElapsedTime(elapsed_time_ms);
+    if (high_resolution_)
+      UpdateBudgetWithElapsedTimeUs(elapsed_time_us);
+    else
+      UpdateBudgetWithElapsedTime(elapsed_time_us / 1000);
   }
   // 从prober_获取探测码率
   bool is_probing = prober_.IsProbing();
   PacedPacketInfo pacing_info;
   size_t bytes_sent = 0;
   size_t recommended_probe_size = 0;
+  size_t burst_packets = 0;
+  size_t burst_bytes = 0;
   if (is_probing) 
   {
     // 从当前探测包簇中获取探测码率
@@ -459,6 +570,8 @@ void PacedSender::Process()
     if (success) 
 	{
       bytes_sent += packet->bytes;
+      ++burst_packets;
+      burst_bytes += packet->bytes;
       // Send succeeded, remove it from the queue.
       OnPacketSent(packet);
 	  if (is_probing && bytes_sent > (recommended_probe_size ))
@@ -481,6 +594,16 @@ void PacedSender::Process()
     }
   }
 
+  if (burst_packets > 0) {
+    ++stats_.num_bursts;
+    stats_.max_burst_packets = std::max(stats_.max_burst_packets, burst_packets);
+    stats_.max_burst_bytes = std::max(stats_.max_burst_bytes, burst_bytes);
+  }
+  if (packets_.Empty()) {
+    // The ideal pacer would also have gone idle here.
+    ideal_send_time_us_ = -1;
+  }
+
   if (packets_.Empty() && !Congested()) 
   {
     // We can not send padding unless a normal packet has first been sent. If we
@@ -550,6 +673,7 @@ void PacedSender::OnPacketSent(const RoundRobinPacketQueue::Packet* packet) {
     // https://bugs.chromium.org/p/webrtc/issues/detail?id=8052
     UpdateBudgetWithBytesSent(packet->bytes);
     last_send_time_us_ = clock_->TimeInMicroseconds();
+    UpdatePacingStats(packet->bytes, last_send_time_us_);
   }
   // Send succeeded, remove it from the queue.
   packets_.FinalizePop(*packet);
@@ -570,6 +694,29 @@ void PacedSender::UpdateBudgetWithElapsedTime(int64_t delta_time_ms)
   padding_budget_.IncreaseBudget(delta_time_ms);
 }
 
+void PacedSender::UpdateBudgetWithElapsedTimeUs(int64_t delta_time_us) {
+  delta_time_us = std::min(kMaxIntervalTimeMs * 1000, delta_time_us);
+  media_budget_.IncreaseBudgetUs(delta_time_us);
+  padding_budget_.IncreaseBudgetUs(delta_time_us);
+}
+
+void PacedSender::UpdatePacingStats(size_t bytes, int64_t now_us) {
+  ++stats_.num_packets;
+  if (ideal_send_time_us_ == -1)
+    ideal_send_time_us_ = now_us;
+  int64_t jitter_us = std::abs(now_us - ideal_send_time_us_);
+  stats_.total_jitter_us += jitter_us;
+  stats_.max_jitter_us = std::max(stats_.max_jitter_us, jitter_us);
+  const int rate_kbps = media_budget_.target_rate_kbps();
+  if (rate_kbps <= 0 || jitter_us > kMaxIntervalTimeMs * 1000) {
+    // Too far off schedule to be compared with it any longer, e.g. after the
+    // rate was changed; restart the ideal schedule from this packet.
+    ideal_send_time_us_ = now_us;
+  }
+  if (rate_kbps > 0)
+    ideal_send_time_us_ += static_cast<int64_t>(bytes) * 8000 / rate_kbps;
+}
+
 void PacedSender::UpdateBudgetWithBytesSent(size_t bytes_sent) {
   outstanding_bytes_ += bytes_sent;
   media_budget_.UseBudget(bytes_sent);
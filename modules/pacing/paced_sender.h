@@ -17,6 +17,8 @@
 #include <memory>
 
 #include "absl/types/optional.h"
+#include "api/task_queue/task_queue_base.h"
+#include "api/task_queue/task_queue_factory.h"
 #include "api/transport/field_trial_based_config.h"
 #include "api/transport/network_types.h"
 #include "api/transport/webrtc_key_value_config.h"
@@ -82,6 +84,19 @@ class PacedSender : public Pacer {
   // overshoots from the encoder.
   static const float kDefaultPaceMultiplier;
 
+  // How evenly media packets have been spread out in time. A burst is the set
+  // of packets sent by one Process() call. Jitter is measured against an ideal
+  // pacer that sends every packet exactly when the pacing rate allows it,
+  // restarting whenever the queue runs empty or the pacer is paused.
+  struct PacingStats {
+    int64_t num_bursts = 0;
+    int64_t num_packets = 0;
+    size_t max_burst_packets = 0;
+    size_t max_burst_bytes = 0;
+    int64_t total_jitter_us = 0;
+    int64_t max_jitter_us = 0;
+  };
+
   PacedSender(Clock* clock,
               PacketSender* packet_sender,
               RtcEventLog* event_log,
@@ -157,12 +172,26 @@ class PacedSender : public Pacer {
   // Returns the number of milliseconds until the module want a worker thread
   // to call Process.
   int64_t TimeUntilNextProcess() override;
+  // Same as TimeUntilNextProcess(), in microseconds. With the
+  // "WebRTC-Pacer-HighResolution" field trial enabled this is the time until
+  // the media budget allows the next queued packet to be sent, rather than a
+  // fixed 5 ms interval.
+  int64_t TimeUntilNextProcessUs();
 
   // Process any pending packets in the queue(s).
   void Process() override;
 
   // Called when the prober is associated with a process thread.
   void ProcessThreadAttached(ProcessThread* process_thread) override;
+
+  // Drives Process() from a dedicated high priority task queue, woken up at
+  // TimeUntilNextProcessUs(), instead of from a ProcessThread. Must be called
+  // at most once, and not together with registering the pacer as a module.
+  void StartOnTaskQueue(TaskQueueFactory* task_queue_factory);
+
+  bool high_resolution() const { return high_resolution_; }
+  PacingStats GetPacingStats() const;
+
   // Deprecated, SetPacingRates should be used instead.
   void SetPacingFactor(float pacing_factor);
   void SetQueueTimeLimit(int limit_ms);
@@ -174,16 +203,24 @@ class PacedSender : public Pacer {
               const WebRtcKeyValueConfig& field_trials);
 
   int64_t UpdateTimeAndGetElapsedMs(int64_t now_us) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+  int64_t UpdateTimeAndGetElapsedUs(int64_t now_us) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   bool ShouldSendKeepalive(int64_t at_time_us) const RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
 
   // Updates the number of bytes that can be sent for the next time interval.
   void UpdateBudgetWithElapsedTime(int64_t delta_time_in_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+  void UpdateBudgetWithElapsedTimeUs(int64_t delta_time_us) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   void UpdateBudgetWithBytesSent(size_t bytes) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
 
   const RoundRobinPacketQueue::Packet* GetPendingPacket(const PacedPacketInfo& pacing_info)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   void OnPacketSent(const RoundRobinPacketQueue::Packet* packet) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   void OnPaddingSent(size_t padding_sent) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+  void UpdatePacingStats(size_t bytes, int64_t now_us) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+
+  // Makes sure a Process() task is posted to |task_queue_| no later than
+  // |delay_us| from now.
+  void ScheduleProcess(int64_t delay_us) RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+  void RunScheduledProcess(int64_t scheduled_us);
 
   bool Congested() const RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   int64_t TimeMilliseconds() const RTC_EXCLUSIVE_LOCKS_REQUIRED(critsect_);
@@ -195,6 +232,7 @@ class PacedSender : public Pacer {
   const bool drain_large_queues_;
   const bool send_padding_if_silent_;
   const bool pace_audio_;
+  const bool high_resolution_;
   FieldTrialParameter<int> min_packet_limit_ms_;
 
   rtc::CriticalSection critsect_;
@@ -240,6 +278,18 @@ class PacedSender : public Pacer {
 
   int64_t queue_time_limit RTC_GUARDED_BY(critsect_);
   bool account_for_audio_ RTC_GUARDED_BY(critsect_);
+
+  PacingStats stats_ RTC_GUARDED_BY(critsect_);
+  // When the next media packet would be sent by an ideal pacer, or -1 if the
+  // ideal schedule restarts at the next packet.
+  int64_t ideal_send_time_us_ RTC_GUARDED_BY(critsect_);
+
+  // Time of the earliest Process() task posted to |task_queue_|, or -1.
+  int64_t next_scheduled_process_us_ RTC_GUARDED_BY(critsect_);
+  // Declared last, so that it is destroyed, and its pending tasks stopped,
+  // before any state they use.
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> task_queue_
+      RTC_GUARDED_BY(critsect_);
 };
 }  // namespace webrtc
 #endif  // MODULES_PACING_PACED_SENDER_H_
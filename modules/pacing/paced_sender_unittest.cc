@@ -11,8 +11,11 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "api/task_queue/default_task_queue_factory.h"
 #include "modules/pacing/paced_sender.h"
+#include "rtc_base/event.h"
 #include "system_wrappers/include/clock.h"
 #include "system_wrappers/include/field_trial.h"
 #include "test/field_trial.h"
@@ -21,6 +24,7 @@
 
 using ::testing::_;
 using ::testing::Field;
+using ::testing::Invoke;
 using ::testing::Return;
 
 namespace {
@@ -199,6 +203,89 @@ TEST_F(PacedSenderFieldTrialTest, PaddingInSilenceWithTrial) {
   pacer.Process();
 }
 
+TEST_F(PacedSenderFieldTrialTest, HighResolutionSendsPacketsWhenBudgetAllows) {
+  ScopedFieldTrials trial("WebRTC-Pacer-HighResolution/Enabled/");
+  PacedSender pacer(&clock_, &callback_, nullptr);
+  EXPECT_TRUE(pacer.high_resolution());
+  pacer.SetProbingEnabled(false);
+  // 1000 byte packets at 960 kbps, one every 8333 us.
+  pacer.SetPacingRates(960000, 0);
+  const int kNumPackets = 10;
+  for (int i = 0; i < kNumPackets; ++i)
+    InsertPacket(&pacer, &video);
+  std::vector<int64_t> send_times_us;
+  EXPECT_CALL(callback_, TimeToSendPacket)
+      .WillRepeatedly(Invoke([&](uint32_t, uint16_t, int64_t, bool,
+                                 const PacedPacketInfo&) {
+        send_times_us.push_back(clock_.TimeInMicroseconds());
+        return true;
+      }));
+  while (send_times_us.size() < static_cast<size_t>(kNumPackets)) {
+    int64_t wait_us = pacer.TimeUntilNextProcessUs();
+    ASSERT_LE(wait_us, 10000);
+    clock_.AdvanceTimeMicroseconds(wait_us);
+    pacer.Process();
+  }
+  for (int i = 2; i < kNumPackets; ++i) {
+    // Sent within a process interval of when the budget allows, instead of
+    // on the next 5 ms boundary.
+    EXPECT_NEAR(8333, send_times_us[i] - send_times_us[i - 1], 250);
+  }
+  PacedSender::PacingStats stats = pacer.GetPacingStats();
+  EXPECT_EQ(kNumPackets, stats.num_packets);
+  EXPECT_EQ(1u, stats.max_burst_packets);
+  EXPECT_LT(stats.max_jitter_us, 1000);
+}
+
+TEST_F(PacedSenderFieldTrialTest, PacingStatsCountBursts) {
+  PacedSender pacer(&clock_, &callback_, nullptr);
+  EXPECT_FALSE(pacer.high_resolution());
+  pacer.SetProbingEnabled(false);
+  pacer.SetPacingRates(kTargetBitrateBps, 0);
+  MediaStream small_video{PacedSender::kNormalPriority, /*ssrc*/ 4444,
+                          /*packet_size*/ 100, /*seq_num*/ 1000};
+  for (int i = 0; i < 5; ++i)
+    InsertPacket(&pacer, &small_video);
+  EXPECT_CALL(callback_, TimeToSendPacket).WillRepeatedly(Return(true));
+  ProcessNext(&pacer);
+  PacedSender::PacingStats stats = pacer.GetPacingStats();
+  EXPECT_EQ(1, stats.num_bursts);
+  EXPECT_EQ(5, stats.num_packets);
+  EXPECT_EQ(5u, stats.max_burst_packets);
+  EXPECT_EQ(500u, stats.max_burst_bytes);
+  // The ideal pacer would have spread the burst out over 4 ms.
+  EXPECT_EQ(4 * 1000, stats.max_jitter_us);
+}
+
+TEST_F(PacedSenderFieldTrialTest, HighResolutionRunsOnTaskQueue) {
+  ScopedFieldTrials trial("WebRTC-Pacer-HighResolution/Enabled/");
+  Clock* clock = Clock::GetRealTimeClock();
+  PacedSender pacer(clock, &callback_, nullptr);
+  pacer.SetProbingEnabled(false);
+  pacer.SetPacingRates(kTargetBitrateBps, 0);
+  std::unique_ptr<TaskQueueFactory> task_queue_factory =
+      CreateDefaultTaskQueueFactory();
+  pacer.StartOnTaskQueue(task_queue_factory.get());
+
+  const int kNumPackets = 20;
+  rtc::Event done;
+  int packets_sent = 0;
+  EXPECT_CALL(callback_, TimeToSendPacket)
+      .WillRepeatedly(Invoke([&](uint32_t, uint16_t, int64_t, bool,
+                                 const PacedPacketInfo&) {
+        if (++packets_sent == kNumPackets)
+          done.Set();
+        return true;
+      }));
+  EXPECT_CALL(callback_, TimeToSendPadding).WillRepeatedly(Return(0));
+  for (int i = 0; i < kNumPackets; ++i) {
+    pacer.InsertPacket(video.priority, video.ssrc, video.seq_num++,
+                       clock->TimeInMilliseconds(), video.packet_size, false);
+  }
+  // 20 kB at 800 kbps takes 200 ms.
+  EXPECT_TRUE(done.Wait(5000));
+}
+
 TEST_F(PacedSenderFieldTrialTest, DefaultCongestionWindowAffectsAudio) {
   EXPECT_CALL(callback_, TimeToSendPadding).Times(0);
   PacedSender pacer(&clock_, &callback_, nullptr);
@@ -50,46 +50,46 @@ bool RoundRobinPacketQueue::Packet::operator<(
   return enqueue_order > other.enqueue_order;
 }
 
-RoundRobinPacketQueue::Stream::Stream() : bytes(0), ssrc(0) {}
-RoundRobinPacketQueue::Stream::Stream(const Stream& stream) = default;
-RoundRobinPacketQueue::Stream::~Stream() {}
+RoundRobinPacketQueue::PacketNode::PacketNode(const Packet& packet)
+    : packet(packet), enqueue_time_ms(packet.enqueue_time_ms) {}
+
+RoundRobinPacketQueue::Stream::Stream(uint32_t ssrc) : ssrc(ssrc) {
+  std::fill(first, first + kNumPacketClasses, kNoIndex);
+  std::fill(last, last + kNumPacketClasses, kNoIndex);
+}
+
+constexpr RoundRobinPacketQueue::Index RoundRobinPacketQueue::kNoIndex;
+constexpr int RoundRobinPacketQueue::kNumPacketClasses;
 
 RoundRobinPacketQueue::RoundRobinPacketQueue(int64_t start_time_us)
     : time_last_updated_ms_(start_time_us / 1000) {}
 
 RoundRobinPacketQueue::~RoundRobinPacketQueue() {}
 
-void RoundRobinPacketQueue::Push(const Packet& packet_to_insert) 
-{
-  Packet packet(packet_to_insert);
-
-  auto stream_info_it = streams_.find(packet.ssrc);
-  if (stream_info_it == streams_.end()) 
-  {
-    stream_info_it = streams_.emplace(packet.ssrc, Stream()).first;
-    stream_info_it->second.priority_it = stream_priorities_.end();
-    stream_info_it->second.ssrc = packet.ssrc;
+void RoundRobinPacketQueue::Push(const Packet& packet_to_insert) {
+  Index stream_index = GetOrCreateStream(packet_to_insert.ssrc);
+  Stream* stream = &streams_[stream_index];
+
+  if (stream->heap_index == kNoIndex) {
+    // If the SSRC is not currently scheduled, add it to |stream_heap_|.
+    Schedule(stream_index, packet_to_insert.priority);
+  } else if (packet_to_insert.priority < stream->priority) {
+    // If the priority of this SSRC increased, reschedule it with the new
+    // priority. Note that RtpPacketSender::Priority uses lower ordinal for
+    // higher priority.
+    Unschedule(stream_index);
+    Schedule(stream_index, packet_to_insert.priority);
   }
+  RTC_DCHECK_NE(stream->heap_index, kNoIndex);
 
-  Stream* stream = &stream_info_it->second;
-
-  if (stream->priority_it == stream_priorities_.end()) 
-  {
-    // If the SSRC is not currently scheduled, add it to |stream_priorities_|.
-    RTC_CHECK(!IsSsrcScheduled(stream->ssrc));
-    stream->priority_it = stream_priorities_.emplace( StreamPrioKey(packet.priority, stream->bytes), packet.ssrc);
-  }
-  else if (packet.priority < stream->priority_it->first.priority) 
-  {
-    // If the priority of this SSRC increased, remove the outdated StreamPrioKey
-    // and insert a new one with the new priority. Note that
-    // RtpPacketSender::Priority uses lower ordinal for higher priority.
-    stream_priorities_.erase(stream->priority_it);
-    stream->priority_it = stream_priorities_.emplace(StreamPrioKey(packet.priority, stream->bytes), packet.ssrc);
-  }
-  RTC_CHECK(stream->priority_it != stream_priorities_.end());
-
-  packet.enqueue_time_it = enqueue_times_.insert(packet.enqueue_time_ms);
+  Index node = AllocateNode(packet_to_insert);
+  PacketNode& packet_node = nodes_[node];
+  packet_node.older = newest_node_;
+  if (newest_node_ != kNoIndex)
+    nodes_[newest_node_].newer = node;
+  else
+    oldest_node_ = node;
+  newest_node_ = node;
 
   // In order to figure out how much time a packet has spent in the queue while
   // not in a paused state, we subtract the total amount of time the queue has
@@ -97,39 +97,46 @@ void RoundRobinPacketQueue::Push(const Packet& packet_to_insert)
   // amount of time the queue has been paused at that moment. This way we
   // subtract the total amount of time the packet has spent in the queue while
   // in a paused state.
-  UpdateQueueTime(packet.enqueue_time_ms);
-  packet.enqueue_time_ms -= pause_time_sum_ms_;
-  stream->packet_queue.push(packet);
+  UpdateQueueTime(packet_node.packet.enqueue_time_ms);
+  packet_node.packet.enqueue_time_ms -= pause_time_sum_ms_;
+  LinkLast(stream, node);
 
   size_packets_ += 1;
-  size_bytes_ += packet.bytes;
+  size_bytes_ += packet_node.packet.bytes;
 }
 
 const RoundRobinPacketQueue::Packet& RoundRobinPacketQueue::BeginPop() {
-  RTC_CHECK(!pop_packet_ && !pop_stream_);
-
-  Stream* stream = GetHighestPriorityStream();
-  pop_stream_.emplace(stream);
-  pop_packet_.emplace(stream->packet_queue.top());
-  stream->packet_queue.pop();
+  RTC_CHECK(!pop_packet_ && pop_stream_ == kNoIndex);
+
+  Index stream_index = GetHighestPriorityStream();
+  Stream* stream = &streams_[stream_index];
+  Index node = FirstPacket(*stream);
+  RTC_CHECK_NE(node, kNoIndex);
+  Unlink(stream, node);
+  pop_stream_ = stream_index;
+  pop_node_ = node;
+  // The packet is handed out by reference while the caller may push more
+  // packets, which can move |nodes_|; keep a copy.
+  pop_packet_.emplace(nodes_[node].packet);
 
   return *pop_packet_;
 }
 
 void RoundRobinPacketQueue::CancelPop(const Packet& packet) {
-  RTC_CHECK(pop_packet_ && pop_stream_);
-  (*pop_stream_)->packet_queue.push(*pop_packet_);
+  RTC_CHECK(pop_packet_ && pop_stream_ != kNoIndex);
+  // It was first in its class, and anything pushed since is newer.
+  LinkFirst(&streams_[pop_stream_], pop_node_);
   pop_packet_.reset();
-  pop_stream_.reset();
+  pop_node_ = kNoIndex;
+  pop_stream_ = kNoIndex;
 }
 
-void RoundRobinPacketQueue::FinalizePop(const Packet& packet) 
-{
-  if (!Empty()) 
-  {
-    RTC_CHECK(pop_packet_ && pop_stream_);
-    Stream* stream = *pop_stream_;
-    stream_priorities_.erase(stream->priority_it);
+void RoundRobinPacketQueue::FinalizePop(const Packet& packet) {
+  if (!Empty()) {
+    RTC_CHECK(pop_packet_ && pop_stream_ != kNoIndex);
+    Index stream_index = pop_stream_;
+    Stream* stream = &streams_[stream_index];
+    Unschedule(stream_index);
     const Packet& packet = *pop_packet_;
 
     // Calculate the total amount of time spent by this packet in the queue
@@ -137,46 +144,41 @@ void RoundRobinPacketQueue::FinalizePop(const Packet& packet)
     // subtracted from |packet.enqueue_time_ms| when the packet was pushed, and
     // by subtracting it now we effectively remove the time spent in in the
     // queue while in a paused state.
-    int64_t time_in_non_paused_state_ms = time_last_updated_ms_ - packet.enqueue_time_ms - pause_time_sum_ms_;
+    int64_t time_in_non_paused_state_ms =
+        time_last_updated_ms_ - packet.enqueue_time_ms - pause_time_sum_ms_;
     queue_time_sum_ms_ -= time_in_non_paused_state_ms;
 
-    RTC_CHECK(packet.enqueue_time_it != enqueue_times_.end());
-    enqueue_times_.erase(packet.enqueue_time_it);
-
     // Update |bytes| of this stream. The general idea is that the stream that
     // has sent the least amount of bytes should have the highest priority.
     // The problem with that is if streams send with different rates, in which
     // case a "budget" will be built up for the stream sending at the lower
     // rate. To avoid building a too large budget we limit |bytes| to be within
     // kMaxLeading bytes of the stream that has sent the most amount of bytes.
-    stream->bytes = std::max(stream->bytes + packet.bytes, max_bytes_ - kMaxLeadingBytes);
+    stream->bytes =
+        std::max(stream->bytes + packet.bytes, max_bytes_ - kMaxLeadingBytes);
     max_bytes_ = std::max(max_bytes_, stream->bytes);
 
     size_bytes_ -= packet.bytes;
     size_packets_ -= 1;
     RTC_CHECK(size_packets_ > 0 || queue_time_sum_ms_ == 0);
 
+    FreeNode(pop_node_);
+
     // If there are packets left to be sent, schedule the stream again.
-    RTC_CHECK(!IsSsrcScheduled(stream->ssrc));
-    if (stream->packet_queue.empty()) 
-	{
-      stream->priority_it = stream_priorities_.end();
-    }
-	else 
-	{
-      RtpPacketSender::Priority priority = stream->packet_queue.top().priority;
-      stream->priority_it = stream_priorities_.emplace(StreamPrioKey(priority, stream->bytes), stream->ssrc);
-    }
+    Index next = FirstPacket(*stream);
+    if (next != kNoIndex)
+      Schedule(stream_index, nodes_[next].packet.priority);
 
     pop_packet_.reset();
-    pop_stream_.reset();
+    pop_node_ = kNoIndex;
+    pop_stream_ = kNoIndex;
   }
 }
 
 bool RoundRobinPacketQueue::Empty() const {
-  RTC_CHECK((!stream_priorities_.empty() && size_packets_ > 0) ||
-            (stream_priorities_.empty() && size_packets_ == 0));
-  return stream_priorities_.empty();
+  RTC_CHECK((!stream_heap_.empty() && size_packets_ > 0) ||
+            (stream_heap_.empty() && size_packets_ == 0));
+  return stream_heap_.empty();
 }
 
 size_t RoundRobinPacketQueue::SizeInPackets() const {
@@ -190,8 +192,8 @@ uint64_t RoundRobinPacketQueue::SizeInBytes() const {
 int64_t RoundRobinPacketQueue::OldestEnqueueTimeMs() const {
   if (Empty())
     return 0;
-  RTC_CHECK(!enqueue_times_.empty());
-  return *enqueue_times_.begin();
+  RTC_CHECK_NE(oldest_node_, kNoIndex);
+  return nodes_[oldest_node_].enqueue_time_ms;
 }
 
 void RoundRobinPacketQueue::UpdateQueueTime(int64_t timestamp_ms) 
@@ -233,24 +235,189 @@ int64_t RoundRobinPacketQueue::AverageQueueTimeMs() const {
   return queue_time_sum_ms_ / size_packets_;
 }
 
-RoundRobinPacketQueue::Stream*
-RoundRobinPacketQueue::GetHighestPriorityStream() {
-  RTC_CHECK(!stream_priorities_.empty());
-  uint32_t ssrc = stream_priorities_.begin()->second;
+// static
+int RoundRobinPacketQueue::PacketClass(const Packet& packet) {
+  RTC_DCHECK_GE(packet.priority, RtpPacketSender::kHighPriority);
+  RTC_DCHECK_LE(packet.priority, RtpPacketSender::kLowPriority);
+  return 2 * packet.priority + (packet.retransmission ? 0 : 1);
+}
+
+RoundRobinPacketQueue::Index RoundRobinPacketQueue::GetOrCreateStream(
+    uint32_t ssrc) {
+  auto it = std::lower_bound(
+      stream_by_ssrc_.begin(), stream_by_ssrc_.end(), ssrc,
+      [](const std::pair<uint32_t, Index>& entry, uint32_t ssrc) {
+        return entry.first < ssrc;
+      });
+  if (it != stream_by_ssrc_.end() && it->first == ssrc)
+    return it->second;
+
+  Index stream = static_cast<Index>(streams_.size());
+  streams_.emplace_back(ssrc);
+  stream_by_ssrc_.emplace(it, ssrc, stream);
+  return stream;
+}
+
+RoundRobinPacketQueue::Index RoundRobinPacketQueue::GetHighestPriorityStream()
+    const {
+  RTC_CHECK(!stream_heap_.empty());
+  Index stream = stream_heap_.front();
+  RTC_DCHECK_EQ(streams_[stream].heap_index, 0);
+  return stream;
+}
+
+RoundRobinPacketQueue::Index RoundRobinPacketQueue::FirstPacket(
+    const Stream& stream) const {
+  for (Index node : stream.first) {
+    if (node != kNoIndex)
+      return node;
+  }
+  return kNoIndex;
+}
+
+RoundRobinPacketQueue::Index RoundRobinPacketQueue::AllocateNode(
+    const Packet& packet) {
+  if (free_nodes_ == kNoIndex) {
+    nodes_.emplace_back(packet);
+    return static_cast<Index>(nodes_.size() - 1);
+  }
+  Index node = free_nodes_;
+  free_nodes_ = nodes_[node].next;
+  nodes_[node] = PacketNode(packet);
+  return node;
+}
 
-  auto stream_info_it = streams_.find(ssrc);
-  RTC_CHECK(stream_info_it != streams_.end());
-  RTC_CHECK(stream_info_it->second.priority_it == stream_priorities_.begin());
-  RTC_CHECK(!stream_info_it->second.packet_queue.empty());
-  return &stream_info_it->second;
+void RoundRobinPacketQueue::FreeNode(Index node) {
+  PacketNode& packet_node = nodes_[node];
+  if (packet_node.older != kNoIndex)
+    nodes_[packet_node.older].newer = packet_node.newer;
+  else
+    oldest_node_ = packet_node.newer;
+  if (packet_node.newer != kNoIndex)
+    nodes_[packet_node.newer].older = packet_node.older;
+  else
+    newest_node_ = packet_node.older;
+  packet_node.next = free_nodes_;
+  free_nodes_ = node;
 }
 
-bool RoundRobinPacketQueue::IsSsrcScheduled(uint32_t ssrc) const {
-  for (const auto& scheduled_stream : stream_priorities_) {
-    if (scheduled_stream.second == ssrc)
-      return true;
+void RoundRobinPacketQueue::LinkFirst(Stream* stream, Index node) {
+  PacketNode& packet_node = nodes_[node];
+  const int packet_class = PacketClass(packet_node.packet);
+  Index& first = stream->first[packet_class];
+  RTC_DCHECK(first == kNoIndex ||
+             nodes_[first].packet.enqueue_order >
+                 packet_node.packet.enqueue_order);
+  packet_node.prev = kNoIndex;
+  packet_node.next = first;
+  if (first != kNoIndex)
+    nodes_[first].prev = node;
+  else
+    stream->last[packet_class] = node;
+  first = node;
+}
+
+void RoundRobinPacketQueue::LinkLast(Stream* stream, Index node) {
+  PacketNode& packet_node = nodes_[node];
+  const int packet_class = PacketClass(packet_node.packet);
+  Index& last = stream->last[packet_class];
+  // PacedSender hands out increasing enqueue orders, so appending keeps each
+  // class sorted.
+  RTC_DCHECK(last == kNoIndex ||
+             nodes_[last].packet.enqueue_order <
+                 packet_node.packet.enqueue_order);
+  packet_node.next = kNoIndex;
+  packet_node.prev = last;
+  if (last != kNoIndex)
+    nodes_[last].next = node;
+  else
+    stream->first[packet_class] = node;
+  last = node;
+}
+
+void RoundRobinPacketQueue::Unlink(Stream* stream, Index node) {
+  PacketNode& packet_node = nodes_[node];
+  const int packet_class = PacketClass(packet_node.packet);
+  if (packet_node.prev != kNoIndex)
+    nodes_[packet_node.prev].next = packet_node.next;
+  else
+    stream->first[packet_class] = packet_node.next;
+  if (packet_node.next != kNoIndex)
+    nodes_[packet_node.next].prev = packet_node.prev;
+  else
+    stream->last[packet_class] = packet_node.prev;
+  packet_node.prev = packet_node.next = kNoIndex;
+}
+
+bool RoundRobinPacketQueue::HasPriorityOver(Index a, Index b) const {
+  const Stream& stream_a = streams_[a];
+  const Stream& stream_b = streams_[b];
+  if (stream_a.priority != stream_b.priority)
+    return stream_a.priority < stream_b.priority;
+  if (stream_a.bytes != stream_b.bytes)
+    return stream_a.bytes < stream_b.bytes;
+  return stream_a.schedule_order < stream_b.schedule_order;
+}
+
+void RoundRobinPacketQueue::Schedule(Index stream,
+                                     RtpPacketSender::Priority priority) {
+  Stream& scheduled = streams_[stream];
+  RTC_DCHECK_EQ(scheduled.heap_index, kNoIndex);
+  scheduled.priority = priority;
+  scheduled.schedule_order = schedule_order_++;
+  stream_heap_.push_back(stream);
+  scheduled.heap_index = static_cast<Index>(stream_heap_.size() - 1);
+  SiftUp(stream_heap_.size() - 1);
+}
+
+void RoundRobinPacketQueue::Unschedule(Index stream) {
+  const Index heap_index = streams_[stream].heap_index;
+  RTC_DCHECK_NE(heap_index, kNoIndex);
+  RTC_DCHECK_EQ(stream_heap_[heap_index], stream);
+  streams_[stream].heap_index = kNoIndex;
+  const Index moved = stream_heap_.back();
+  stream_heap_.pop_back();
+  if (moved == stream)
+    return;
+  SetHeapEntry(heap_index, moved);
+  SiftDown(heap_index);
+  SiftUp(streams_[moved].heap_index);
+}
+
+void RoundRobinPacketQueue::SiftUp(size_t heap_index) {
+  const Index stream = stream_heap_[heap_index];
+  while (heap_index > 0) {
+    const size_t parent = (heap_index - 1) / 2;
+    if (!HasPriorityOver(stream, stream_heap_[parent]))
+      break;
+    SetHeapEntry(heap_index, stream_heap_[parent]);
+    heap_index = parent;
   }
-  return false;
+  SetHeapEntry(heap_index, stream);
+}
+
+void RoundRobinPacketQueue::SiftDown(size_t heap_index) {
+  const Index stream = stream_heap_[heap_index];
+  const size_t size = stream_heap_.size();
+  while (true) {
+    size_t child = 2 * heap_index + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size &&
+        HasPriorityOver(stream_heap_[child + 1], stream_heap_[child])) {
+      ++child;
+    }
+    if (!HasPriorityOver(stream_heap_[child], stream))
+      break;
+    SetHeapEntry(heap_index, stream_heap_[child]);
+    heap_index = child;
+  }
+  SetHeapEntry(heap_index, stream);
+}
+
+void RoundRobinPacketQueue::SetHeapEntry(size_t heap_index, Index stream) {
+  stream_heap_[heap_index] = stream;
+  streams_[stream].heap_index = static_cast<Index>(heap_index);
 }
 
 }  // namespace webrtc
@@ -13,10 +13,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <list>
-#include <map>
-#include <queue>
-#include <set>
+#include <utility>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
@@ -54,8 +52,6 @@ class RoundRobinPacketQueue {
     size_t bytes;
     bool retransmission;
     uint64_t enqueue_order;
-    std::list<Packet>::iterator this_it;
-    std::multiset<int64_t>::iterator enqueue_time_it;
   };
 
   void Push(const Packet& packet);
@@ -73,48 +69,77 @@ class RoundRobinPacketQueue {
   void SetPauseState(bool paused, int64_t timestamp_ms);
 
  private:
-  struct StreamPrioKey {
-    StreamPrioKey(RtpPacketSender::Priority priority, int64_t bytes)
-        : priority(priority), bytes(bytes) {}
-
-    bool operator<(const StreamPrioKey& other) const {
-      if (priority != other.priority)
-        return priority < other.priority;
-      return bytes < other.bytes;
-    }
-
-    const RtpPacketSender::Priority priority;
-    const size_t bytes;
+  // Index into |nodes_| or |streams_|, or kNoIndex.
+  using Index = int;
+  static constexpr Index kNoIndex = -1;
+
+  // A stream keeps one FIFO of packets per (priority, retransmission) class
+  // and sends from the first non-empty one, which is the order given by
+  // Packet::operator<.
+  static constexpr int kNumPacketClasses =
+      2 * (RtpPacketSender::kLowPriority + 1);
+
+  // A pooled packet slot. Slots are reused, so a steady packet rate does not
+  // allocate.
+  struct PacketNode {
+    explicit PacketNode(const Packet& packet);
+
+    Packet packet;
+    // The enqueue time as given to Push(), without the pause compensation
+    // applied to |packet.enqueue_time_ms|.
+    int64_t enqueue_time_ms;
+    // Links in the FIFO of the stream's packet class, or in the free list.
+    Index prev = kNoIndex;
+    Index next = kNoIndex;
+    // Links in the list of all queued packets, in enqueue order.
+    Index older = kNoIndex;
+    Index newer = kNoIndex;
   };
 
   struct Stream {
-    Stream();
-    Stream(const Stream&);
+    explicit Stream(uint32_t ssrc);
 
-    virtual ~Stream();
-
-    size_t bytes;
     uint32_t ssrc;
-    std::priority_queue<Packet> packet_queue;
-
-    // Whenever a packet is inserted for this stream we check if |priority_it|
-    // points to an element in |stream_priorities_|, and if it does it means
-    // this stream has already been scheduled, and if the scheduled priority is
-    // lower than the priority of the incoming packet we reschedule this stream
-    // with the higher priority.
-    std::multimap<StreamPrioKey, uint32_t>::iterator priority_it;
+    size_t bytes = 0;
+
+    // While the stream is scheduled, its position in |stream_heap_| and the
+    // key it is ordered by, together with |bytes|. |schedule_order| keeps
+    // streams with equal priority and bytes in the order they were scheduled.
+    Index heap_index = kNoIndex;
+    RtpPacketSender::Priority priority = RtpPacketSender::kNormalPriority;
+    uint64_t schedule_order = 0;
+
+    Index first[kNumPacketClasses];
+    Index last[kNumPacketClasses];
   };
 
   static constexpr size_t kMaxLeadingBytes = 1400;
 
-  Stream* GetHighestPriorityStream();
+  static int PacketClass(const Packet& packet);
 
-  // Just used to verify correctness.
-  bool IsSsrcScheduled(uint32_t ssrc) const;
+  Index GetOrCreateStream(uint32_t ssrc);
+  Index GetHighestPriorityStream() const;
+  // Returns the node of the packet |stream| should send next, if any.
+  Index FirstPacket(const Stream& stream) const;
+
+  Index AllocateNode(const Packet& packet);
+  void FreeNode(Index node);
+  void LinkFirst(Stream* stream, Index node);
+  void LinkLast(Stream* stream, Index node);
+  void Unlink(Stream* stream, Index node);
+
+  // Min-heap of scheduled streams.
+  bool HasPriorityOver(Index a, Index b) const;
+  void Schedule(Index stream, RtpPacketSender::Priority priority);
+  void Unschedule(Index stream);
+  void SiftUp(size_t heap_index);
+  void SiftDown(size_t heap_index);
+  void SetHeapEntry(size_t heap_index, Index stream);
 
   int64_t time_last_updated_ms_;
   absl::optional<Packet> pop_packet_;
-  absl::optional<Stream*> pop_stream_;
+  Index pop_node_ = kNoIndex;
+  Index pop_stream_ = kNoIndex;
 
   bool paused_ = false;
   // TODO@chensong 2023-04-25 
@@ -128,20 +153,26 @@ class RoundRobinPacketQueue {
   int64_t queue_time_sum_ms_ = 0;
   int64_t pause_time_sum_ms_ = 0;
 
-  // A map of streams used to prioritize from which stream to send next. We use
-  // a multimap instead of a priority_queue since the priority of a stream can
-  // change as a new packet is inserted, and a multimap allows us to remove and
-  // then reinsert a StreamPrioKey if the priority has increased.
-  // 带有优先级的流的Map表，通过优先级找到Stream，方便优先级变化
-  std::multimap<StreamPrioKey, uint32_t> stream_priorities_;
-
-  // A map of SSRCs to Streams.
-  // ssrc 到Stream的对应
-  std::map<uint32_t, Stream> streams_;
-
-  // The enqueue time of every packet currently in the queue. Used to figure out
-  // the age of the oldest packet in the queue.
-  std::multiset<int64_t> enqueue_times_;
+  // Packet slots, and the head of the list of unused ones.
+  std::vector<PacketNode> nodes_;
+  Index free_nodes_ = kNoIndex;
+
+  // All queued packets in enqueue order. Enqueue times never decrease, so the
+  // oldest one has the oldest enqueue time.
+  Index oldest_node_ = kNoIndex;
+  Index newest_node_ = kNoIndex;
+
+  // Streams are never removed, so indices stay valid.
+  std::vector<Stream> streams_;
+  // ssrc 到Stream的对应, sorted by ssrc.
+  std::vector<std::pair<uint32_t, Index>> stream_by_ssrc_;
+
+  // Streams with packets, used to prioritize from which stream to send next.
+  // The priority of a stream can change as a new packet is inserted, so each
+  // stream knows its position in the heap.
+  // 带有优先级的流的堆，方便优先级变化
+  std::vector<Index> stream_heap_;
+  uint64_t schedule_order_ = 0;
 };
 }  // namespace webrtc
 
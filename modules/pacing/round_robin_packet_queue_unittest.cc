@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/pacing/round_robin_packet_queue.h"
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int64_t kStartTimeMs = 1000;
+constexpr size_t kPacketSize = 1000;
+
+class RoundRobinPacketQueueTest : public ::testing::Test {
+ protected:
+  RoundRobinPacketQueueTest() : queue_(kStartTimeMs * 1000) {}
+
+  void Push(RtpPacketSender::Priority priority,
+            uint32_t ssrc,
+            bool retransmission = false,
+            size_t bytes = kPacketSize) {
+    queue_.Push(RoundRobinPacketQueue::Packet(
+        priority, ssrc, sequence_number_++, now_ms_, now_ms_, bytes,
+        retransmission, enqueue_order_++));
+  }
+
+  RoundRobinPacketQueue::Packet Pop() {
+    RoundRobinPacketQueue::Packet packet = queue_.BeginPop();
+    queue_.FinalizePop(packet);
+    return packet;
+  }
+
+  int64_t now_ms_ = kStartTimeMs;
+  uint16_t sequence_number_ = 0;
+  uint64_t enqueue_order_ = 0;
+  RoundRobinPacketQueue queue_;
+};
+
+TEST_F(RoundRobinPacketQueueTest, SendsHighestPriorityStreamFirst) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  Push(RtpPacketSender::kLowPriority, 2);
+  Push(RtpPacketSender::kHighPriority, 3);
+  EXPECT_EQ(3u, queue_.SizeInPackets());
+  EXPECT_EQ(3u, Pop().ssrc);
+  EXPECT_EQ(1u, Pop().ssrc);
+  EXPECT_EQ(2u, Pop().ssrc);
+  EXPECT_TRUE(queue_.Empty());
+}
+
+TEST_F(RoundRobinPacketQueueTest, SendsRetransmissionsFirstWithinStream) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  Push(RtpPacketSender::kNormalPriority, 1, /*retransmission=*/true);
+  Push(RtpPacketSender::kNormalPriority, 1);
+  EXPECT_TRUE(Pop().retransmission);
+  EXPECT_EQ(0u, Pop().sequence_number);
+  EXPECT_EQ(2u, Pop().sequence_number);
+}
+
+TEST_F(RoundRobinPacketQueueTest, RaisesStreamPriorityForHigherPriorityPacket) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  Push(RtpPacketSender::kNormalPriority, 2);
+  Push(RtpPacketSender::kHighPriority, 2);
+  RoundRobinPacketQueue::Packet packet = Pop();
+  EXPECT_EQ(2u, packet.ssrc);
+  EXPECT_EQ(RtpPacketSender::kHighPriority, packet.priority);
+}
+
+TEST_F(RoundRobinPacketQueueTest, AlternatesBetweenStreamsByBytesSent) {
+  for (int i = 0; i < 4; ++i) {
+    Push(RtpPacketSender::kNormalPriority, 1);
+    Push(RtpPacketSender::kNormalPriority, 2);
+  }
+  std::vector<uint32_t> ssrcs;
+  while (!queue_.Empty())
+    ssrcs.push_back(Pop().ssrc);
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 1, 2, 1, 2, 1, 2}), ssrcs);
+}
+
+TEST_F(RoundRobinPacketQueueTest, CancelledPopIsSentNext) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  Push(RtpPacketSender::kNormalPriority, 1);
+  RoundRobinPacketQueue::Packet packet = queue_.BeginPop();
+  EXPECT_EQ(0u, packet.sequence_number);
+  // Packets can be pushed while a pop is pending.
+  Push(RtpPacketSender::kNormalPriority, 1);
+  queue_.CancelPop(packet);
+  EXPECT_EQ(3u, queue_.SizeInPackets());
+  EXPECT_EQ(0u, Pop().sequence_number);
+  EXPECT_EQ(1u, Pop().sequence_number);
+  EXPECT_EQ(2u, Pop().sequence_number);
+}
+
+TEST_F(RoundRobinPacketQueueTest, TracksOldestEnqueueTime) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  now_ms_ += 10;
+  Push(RtpPacketSender::kHighPriority, 2);
+  EXPECT_EQ(kStartTimeMs, queue_.OldestEnqueueTimeMs());
+  // The high priority packet is sent first, the oldest one is still queued.
+  EXPECT_EQ(2u, Pop().ssrc);
+  EXPECT_EQ(kStartTimeMs, queue_.OldestEnqueueTimeMs());
+  EXPECT_EQ(1u, Pop().ssrc);
+  EXPECT_EQ(0, queue_.OldestEnqueueTimeMs());
+}
+
+TEST_F(RoundRobinPacketQueueTest, AverageQueueTimeExcludesPausedTime) {
+  Push(RtpPacketSender::kNormalPriority, 1);
+  queue_.SetPauseState(true, kStartTimeMs + 10);
+  queue_.SetPauseState(false, kStartTimeMs + 30);
+  queue_.UpdateQueueTime(kStartTimeMs + 40);
+  EXPECT_EQ(20, queue_.AverageQueueTimeMs());
+}
+
+// Enqueues 50 streams at 1000 packets/s each and drains the queue as a pacer
+// would, one millisecond at a time. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*Performance*.
+TEST(RoundRobinPacketQueuePerfTest, DISABLED_FiftyStreamsPerformance) {
+  static const int kNumStreams = 50;
+  static const int kDurationMs = 20000;
+  static const int kBacklogMs = 20;
+  RoundRobinPacketQueue queue(0);
+  uint64_t enqueue_order = 0;
+  uint16_t sequence_number = 0;
+  int64_t now_ms = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int ms = 0; ms < kDurationMs; ++ms, ++now_ms) {
+    for (int stream = 0; stream < kNumStreams; ++stream) {
+      // Every fifth stream is audio, and a few percent are retransmissions.
+      RtpPacketSender::Priority priority = stream % 5 == 0
+                                               ? RtpPacketSender::kHighPriority
+                                               : RtpPacketSender::kNormalPriority;
+      bool retransmission = (ms + stream) % 32 == 0;
+      queue.Push(RoundRobinPacketQueue::Packet(
+          priority, 1000 + stream, sequence_number++, now_ms, now_ms,
+          stream % 5 == 0 ? 100 : 1200, retransmission, enqueue_order++));
+    }
+    // Keep a backlog in the queue, like a pacer limited by its budget.
+    if (ms < kBacklogMs)
+      continue;
+    queue.UpdateQueueTime(now_ms);
+    for (int i = 0; i < kNumStreams; ++i) {
+      const RoundRobinPacketQueue::Packet& packet = queue.BeginPop();
+      queue.FinalizePop(packet);
+    }
+  }
+  while (!queue.Empty()) {
+    const RoundRobinPacketQueue::Packet& packet = queue.BeginPop();
+    queue.FinalizePop(packet);
+  }
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  const double num_packets = static_cast<double>(kNumStreams) * kDurationMs;
+  printf("%d streams, %.0f packets: %.1f ns per push+pop, %.2f%% of real time\n",
+         kNumStreams, num_packets, elapsed_us * 1000.0 / num_packets,
+         100.0 * elapsed_us / (kDurationMs * 1000.0));
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -62,7 +62,7 @@ RtpPacket::RtpPacket(const RtpPacket&) = default;
 RtpPacket::RtpPacket(const ExtensionManager* extensions, size_t capacity)
     : extensions_(extensions ? *extensions : ExtensionManager()),
       buffer_(capacity) {
-  RTC_DCHECK_GE(capacity, kFixedHeaderSize);
+  RTC_DCHECK(capacity == 0 || capacity >= kFixedHeaderSize);
   Clear();
 }
 
@@ -388,6 +388,10 @@ void RtpPacket::Clear() {
   extensions_size_ = 0;
   extension_entries_.clear();
 
+  if (capacity() == 0) {
+    // No buffer yet, nothing to write the header into.
+    return;
+  }
   memset(WriteAt(0), 0, kFixedHeaderSize);
   buffer_.SetSize(kFixedHeaderSize);
   WriteAt(0, kRtpVersion << 6);
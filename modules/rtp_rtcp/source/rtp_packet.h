@@ -12,6 +12,7 @@
 
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "api/array_view.h"
 #include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
@@ -31,6 +32,10 @@ class RtpPacket {
   // packet creating and used if available in Parse function.
   // Adding and getting extensions will fail until |extensions| is
   // provided via constructor or IdentifyExtensions function.
+  // A packet constructed with zero |capacity| has no buffer, and can't be
+  // written to, until a buffer is parsed into it. This saves an allocation on
+  // the receive path, where Parse(rtc::CopyOnWriteBuffer) would replace the
+  // buffer anyway.
   RtpPacket();
   explicit RtpPacket(const ExtensionManager* extensions);
   RtpPacket(const RtpPacket&);
@@ -43,7 +48,7 @@ class RtpPacket {
   bool Parse(const uint8_t* buffer, size_t size);
   bool Parse(rtc::ArrayView<const uint8_t> packet);
 
-  // Parse and move given buffer into Packet.
+  // Parse and move given buffer into Packet. Doesn't copy or allocate.
   bool Parse(rtc::CopyOnWriteBuffer packet);
 
   // Maps extensions id to their types.
@@ -133,6 +138,12 @@ class RtpPacket {
   bool SetPadding(size_t padding_size);
 
  private:
+  // Number of extensions stored without a heap allocation. Ids are unique
+  // within a packet, so this covers every packet using the one-byte header
+  // (ids 1-14, RFC 8285 section 4.2), and two-byte header packets carrying
+  // no more extensions than there are extension types known to WebRTC.
+  static constexpr size_t kInlineExtensions = kRtpExtensionNumberOfExtensions;
+
   struct ExtensionInfo {
     explicit ExtensionInfo(uint8_t id) : ExtensionInfo(id, 0, 0) {}
     ExtensionInfo(uint8_t id, uint8_t length, uint16_t offset)
@@ -178,7 +189,7 @@ class RtpPacket {
   size_t payload_size_;
 
   ExtensionManager extensions_;
-  std::vector<ExtensionInfo> extension_entries_;
+  absl::InlinedVector<ExtensionInfo, kInlineExtensions> extension_entries_;
   size_t extensions_size_ = 0;  // Unaligned.
   rtc::CopyOnWriteBuffer buffer_;
 };
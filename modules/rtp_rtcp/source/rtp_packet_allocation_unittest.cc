@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// These tests count heap allocations by replacing the global operator new,
+// which affects every test linked into the same binary. They are therefore
+// built as the separate rtp_packet_allocation_tests executable.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "modules/rtp_rtcp/source/rtp_packet_received.h"
+#include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/copy_on_write_buffer.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+// Allocations are counted by replacing the global operator new, which would
+// take over from the allocator of the sanitizers.
+#if !defined(ADDRESS_SANITIZER) && !defined(MEMORY_SANITIZER) && \
+    !defined(THREAD_SANITIZER)
+#define RTP_PACKET_TEST_COUNT_ALLOCATIONS
+
+namespace {
+std::atomic<bool> g_count_allocations(false);
+std::atomic<int64_t> g_num_allocations(0);
+}  // namespace
+
+void* operator new(size_t size) {
+  if (g_count_allocations.load(std::memory_order_relaxed))
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  RTC_CHECK(ptr);
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+#endif
+
+namespace webrtc {
+namespace {
+
+// Counts the heap allocations made while it is alive, or returns -1 if
+// allocations can't be counted in this build.
+class AllocationCounter {
+ public:
+#if defined(RTP_PACKET_TEST_COUNT_ALLOCATIONS)
+  AllocationCounter() {
+    g_num_allocations = 0;
+    g_count_allocations = true;
+  }
+  ~AllocationCounter() { g_count_allocations = false; }
+  int64_t count() const { return g_num_allocations.load(); }
+#else
+  int64_t count() const { return -1; }
+#endif
+};
+
+constexpr int8_t kPayloadType = 100;
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr uint16_t kSeqNum = 0x1234;
+constexpr uint8_t kSeqNumFirstByte = kSeqNum >> 8;
+constexpr uint8_t kSeqNumSecondByte = kSeqNum & 0xff;
+constexpr uint32_t kTimestamp = 0x65431278;
+constexpr uint8_t kTransmissionOffsetExtensionId = 1;
+constexpr uint8_t kAudioLevelExtensionId = 9;
+constexpr int32_t kTimeOffset = 0x56ce;
+constexpr uint8_t kAudioLevel = 0x5a;
+// clang-format off
+constexpr uint8_t kPacketWithTOAndAL[] = {
+    0x90, kPayloadType, kSeqNumFirstByte, kSeqNumSecondByte,
+    0x65, 0x43, 0x12, 0x78,
+    0x12, 0x34, 0x56, 0x78,
+    0xbe, 0xde, 0x00, 0x02,
+    0x12, 0x00, 0x56, 0xce,
+    0x90, 0x80|kAudioLevel, 0x00, 0x00};
+// clang-format on
+
+}  // namespace
+
+#if defined(RTP_PACKET_TEST_COUNT_ALLOCATIONS)
+TEST(RtpPacketTest, ParseReceivedBufferDoesNotAllocate) {
+  RtpPacketReceived::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  extensions.Register<AudioLevel>(kAudioLevelExtensionId);
+  rtc::CopyOnWriteBuffer buffer(kPacketWithTOAndAL);
+  int64_t allocations;
+  {
+    AllocationCounter counter;
+    RtpPacketReceived packet(nullptr, /*capacity=*/0);
+    EXPECT_TRUE(packet.Parse(buffer));
+    packet.IdentifyExtensions(extensions);
+    int32_t time_offset;
+    bool voice_active;
+    uint8_t audio_level;
+    EXPECT_TRUE(packet.GetExtension<TransmissionOffset>(&time_offset));
+    EXPECT_TRUE(packet.GetExtension<AudioLevel>(&voice_active, &audio_level));
+    allocations = counter.count();
+  }
+  EXPECT_EQ(0, allocations);
+}
+#endif
+
+// Parses a typical video packet the ways the receive path has done it, and
+// prints heap allocations and time per packet. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*ReceivePathPerformance*.
+TEST(RtpPacketTest, DISABLED_ReceivePathPerformance) {
+  static const int kNumPackets = 1000000;
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(1);
+  extensions.Register<AbsoluteSendTime>(2);
+  extensions.Register<TransportSequenceNumber>(3);
+  extensions.Register<VideoOrientation>(4);
+  RtpPacketToSend send_packet(&extensions);
+  send_packet.SetPayloadType(kPayloadType);
+  send_packet.SetSequenceNumber(kSeqNum);
+  send_packet.SetTimestamp(kTimestamp);
+  send_packet.SetSsrc(kSsrc);
+  send_packet.SetExtension<TransmissionOffset>(kTimeOffset);
+  send_packet.SetExtension<AbsoluteSendTime>(0x123456);
+  send_packet.SetExtension<TransportSequenceNumber>(1234);
+  send_packet.SetExtension<VideoOrientation>(kVideoRotation_90);
+  memset(send_packet.AllocatePayload(1100), 0x5a, 1100);
+  const rtc::CopyOnWriteBuffer wire = send_packet.Buffer();
+
+  enum Mode { kCopy, kMoveIntoDefaultPacket, kMoveIntoPacketWithoutBuffer };
+  const struct {
+    Mode mode;
+    const char* name;
+  } kModes[] = {
+      {kCopy, "Parse(data, size)"},
+      {kMoveIntoDefaultPacket, "Parse(CopyOnWriteBuffer)"},
+      {kMoveIntoPacketWithoutBuffer,
+       "Parse(CopyOnWriteBuffer), zero capacity"},
+  };
+  for (const auto& mode : kModes) {
+    uint32_t checksum = 0;
+    int64_t allocations;
+    int64_t start_us = rtc::TimeMicros();
+    {
+      AllocationCounter counter;
+      for (int i = 0; i < kNumPackets; ++i) {
+        RtpPacketReceived packet(
+            nullptr, mode.mode == kMoveIntoPacketWithoutBuffer ? 0 : 1500);
+        bool parsed = mode.mode == kCopy ? packet.Parse(wire.cdata(), wire.size())
+                                         : packet.Parse(wire);
+        RTC_CHECK(parsed);
+        packet.IdentifyExtensions(extensions);
+        uint16_t transport_sequence_number = 0;
+        packet.GetExtension<TransportSequenceNumber>(&transport_sequence_number);
+        checksum += transport_sequence_number + packet.payload_size();
+      }
+      allocations = counter.count();
+    }
+    int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    printf("%-42s %.2f allocations, %.1f ns per packet (checksum %u)\n",
+           mode.name, static_cast<double>(allocations) / kNumPackets,
+           elapsed_us * 1000.0 / kNumPackets, checksum);
+  }
+}
+
+}  // namespace webrtc
@@ -15,6 +15,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "modules/include/module_common_types_public.h"
 #include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
@@ -25,6 +26,12 @@ namespace {
 // Min packet size for BestFittingPacket() to honor.
 constexpr size_t kMinPacketRequestBytes = 50;
 
+// Initial number of slots in the ring buffer, grown by doubling.
+constexpr size_t kMinRingSize = 64;
+// The ring buffer never covers more than half the sequence number space, so
+// that the offset from the oldest packet is unambiguous.
+constexpr size_t kMaxRingSize = 1 << 15;
+
 // Utility function to get the absolute difference in size between the provided
 // target size and the size of packet.
 size_t SizeDiff(size_t packet_size, size_t size) {
@@ -54,7 +61,10 @@ RtpPacketHistory::RtpPacketHistory(Clock* clock)
     : clock_(clock),
       number_to_store_(0),
       mode_(StorageMode::kDisabled),
-      rtt_ms_(-1) {}
+      rtt_ms_(-1),
+      first_index_(0),
+      num_slots_(0),
+      num_packets_(0) {}
 
 RtpPacketHistory::~RtpPacketHistory() {}
 
@@ -82,8 +92,8 @@ void RtpPacketHistory::SetRtt(int64_t rtt_ms) {
 }
 
 void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
-                                    StorageType type, absl::optional<int64_t> send_time_ms) 
-{
+                                    StorageType type,
+                                    absl::optional<int64_t> send_time_ms) {
   RTC_DCHECK(packet);
   rtc::CritScope cs(&lock_);
   int64_t now_ms = clock_->TimeInMilliseconds();
@@ -95,37 +105,36 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
 
   // Store packet.
   const uint16_t rtp_seq_no = packet->SequenceNumber();
-  StoredPacket& stored_packet = packet_history_[rtp_seq_no];
-  RTC_DCHECK(stored_packet.packet == nullptr);
-  if (stored_packet.packet)
-  {
+  StoredPacket* stored_packet = GetOrCreateSlot(rtp_seq_no);
+  if (!stored_packet) {
+    // The sequence numbers have jumped too far from what is stored, likely
+    // because they restarted without the history being reset.
+    RTC_LOG(LS_WARNING) << "Sequence number " << rtp_seq_no
+                        << " out of range, purging packet history.";
+    Reset();
+    stored_packet = GetOrCreateSlot(rtp_seq_no);
+    RTC_DCHECK(stored_packet);
+  }
+  RTC_DCHECK(stored_packet->packet == nullptr);
+  if (stored_packet->packet) {
     // It is an error if this happen. But it can happen if the sequence numbers
     // for some reason restart without that the history has been reset.
-    auto size_iterator = packet_size_.find(stored_packet.packet->size());
-    if (size_iterator != packet_size_.end() &&
-        size_iterator->second == stored_packet.packet->SequenceNumber()) 
-	{
-      packet_size_.erase(size_iterator);
-    }
+    RemoveFromSizeIndex(stored_packet->packet->size(), rtp_seq_no);
+  } else {
+    ++num_packets_;
   }
-  stored_packet.packet = std::move(packet);
+  stored_packet->packet = std::move(packet);
 
-  if (stored_packet.packet->capture_time_ms() <= 0) 
-  {
-    stored_packet.packet->set_capture_time_ms(now_ms);
+  if (stored_packet->packet->capture_time_ms() <= 0) {
+    stored_packet->packet->set_capture_time_ms(now_ms);
   }
-  stored_packet.send_time_ms = send_time_ms;
-  stored_packet.storage_type = type;
-  stored_packet.times_retransmitted = 0;
+  stored_packet->send_time_ms = send_time_ms;
+  stored_packet->storage_type = type;
+  stored_packet->times_retransmitted = 0;
 
-  if (!start_seqno_) 
-  {
-    start_seqno_ = rtp_seq_no;
-  }
   // Store the sequence number of the last send packet with this size.
-  if (type != StorageType::kDontRetransmit)
-  {
-    packet_size_[stored_packet.packet->size()] = rtp_seq_no;
+  if (type != StorageType::kDontRetransmit) {
+    AddToSizeIndex(stored_packet->packet->size(), rtp_seq_no);
   }
 }
 
@@ -137,49 +146,47 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetPacketAndSetSendTime(
   }
 
   int64_t now_ms = clock_->TimeInMilliseconds();
-  StoredPacketIterator rtp_it = packet_history_.find(sequence_number);
-  if (rtp_it == packet_history_.end()) {
+  StoredPacket* packet = GetStoredPacket(sequence_number);
+  if (!packet) {
     return nullptr;
   }
 
-  StoredPacket& packet = rtp_it->second;
-  if (!VerifyRtt(rtp_it->second, now_ms)) {
+  if (!VerifyRtt(*packet, now_ms)) {
     return nullptr;
   }
 
-  if (packet.send_time_ms) {
-    ++packet.times_retransmitted;
+  if (packet->send_time_ms) {
+    ++packet->times_retransmitted;
   }
 
   // Update send-time and return copy of packet instance.
-  packet.send_time_ms = now_ms;
+  packet->send_time_ms = now_ms;
 
-  if (packet.storage_type == StorageType::kDontRetransmit) {
+  if (packet->storage_type == StorageType::kDontRetransmit) {
     // Non retransmittable packet, so call must come from paced sender.
     // Remove from history and return actual packet instance.
-    return RemovePacket(rtp_it);
+    return RemovePacket(sequence_number);
   }
-  return absl::make_unique<RtpPacketToSend>(*packet.packet);
+  return absl::make_unique<RtpPacketToSend>(*packet->packet);
 }
 
-absl::optional<RtpPacketHistory::PacketState> RtpPacketHistory::GetPacketState(uint16_t sequence_number) const 
-{
+absl::optional<RtpPacketHistory::PacketState> RtpPacketHistory::GetPacketState(
+    uint16_t sequence_number) const {
   rtc::CritScope cs(&lock_);
-  if (mode_ == StorageMode::kDisabled) 
-  {
+  if (mode_ == StorageMode::kDisabled) {
     return absl::nullopt;
   }
 
-  auto rtp_it = packet_history_.find(sequence_number);
-  if (rtp_it == packet_history_.end()) {
+  const StoredPacket* packet = GetStoredPacket(sequence_number);
+  if (!packet) {
     return absl::nullopt;
   }
 
-  if (!VerifyRtt(rtp_it->second, clock_->TimeInMilliseconds())) {
+  if (!VerifyRtt(*packet, clock_->TimeInMilliseconds())) {
     return absl::nullopt;
   }
 
-  return StoredPacketToPacketState(rtp_it->second);
+  return StoredPacketToPacketState(*packet);
 }
 
 bool RtpPacketHistory::VerifyRtt(const RtpPacketHistory::StoredPacket& packet,
@@ -206,7 +213,11 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetBestFittingPacket(
     return nullptr;
   }
 
-  auto size_iter_upper = packet_size_.upper_bound(packet_length);
+  auto size_iter_upper = std::upper_bound(
+      packet_size_.begin(), packet_size_.end(), packet_length,
+      [](size_t size, const std::pair<size_t, uint16_t>& entry) {
+        return size < entry.first;
+      });
   auto size_iter_lower = size_iter_upper;
   if (size_iter_upper == packet_size_.end()) {
     --size_iter_upper;
@@ -222,105 +233,198 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetBestFittingPacket(
   const uint16_t seq_no = upper_bound_diff < lower_bound_diff
                               ? size_iter_upper->second
                               : size_iter_lower->second;
-  auto history_it = packet_history_.find(seq_no);
-  if (history_it == packet_history_.end()) {
+  const StoredPacket* best_packet = GetStoredPacket(seq_no);
+  if (!best_packet) {
     RTC_LOG(LS_ERROR) << "Can't find packet in history with seq_no" << seq_no;
     RTC_DCHECK(false);
     return nullptr;
   }
-  if (!history_it->second.packet) {
-    RTC_LOG(LS_ERROR) << "Packet pointer is null in history for seq_no"
-                      << seq_no;
-    RTC_DCHECK(false);
-    return nullptr;
-  }
-  RtpPacketToSend* best_packet = history_it->second.packet.get();
-  return absl::make_unique<RtpPacketToSend>(*best_packet);
+  return absl::make_unique<RtpPacketToSend>(*best_packet->packet);
 }
 
 void RtpPacketHistory::Reset() {
-  packet_history_.clear();
+  for (size_t i = 0; i < num_slots_; ++i) {
+    SlotAt(i) = StoredPacket();
+  }
+  first_index_ = 0;
+  num_slots_ = 0;
+  num_packets_ = 0;
   packet_size_.clear();
   start_seqno_.reset();
 }
 
-void RtpPacketHistory::CullOldPackets(int64_t now_ms) 
-{
-  int64_t packet_duration_ms = std::max(kMinPacketDurationRtt * rtt_ms_, kMinPacketDurationMs);
-  while (!packet_history_.empty())
-  {
-    auto stored_packet_it = packet_history_.find(*start_seqno_);
-    RTC_DCHECK(stored_packet_it != packet_history_.end());
+void RtpPacketHistory::CullOldPackets(int64_t now_ms) {
+  int64_t packet_duration_ms =
+      std::max(kMinPacketDurationRtt * rtt_ms_, kMinPacketDurationMs);
+  while (num_packets_ > 0) {
+    // The slot of the oldest packet is never empty.
+    const StoredPacket& stored_packet = SlotAt(0);
+    RTC_DCHECK(stored_packet.packet);
 
-    if (packet_history_.size() >= kMaxCapacity /* 9600*/) 
-	{
+    if (num_packets_ >= kMaxCapacity) {
       // We have reached the absolute max capacity, remove one packet
       // unconditionally.
-      RemovePacket(stored_packet_it);
+      RemovePacket(*start_seqno_);
       continue;
     }
 
-    const StoredPacket& stored_packet = stored_packet_it->second;
-    if (!stored_packet.send_time_ms) 
-	{
+    if (!stored_packet.send_time_ms) {
       // Don't remove packets that have not been sent.
       return;
     }
 
-    if (*stored_packet.send_time_ms + packet_duration_ms > now_ms) 
-	{
+    if (*stored_packet.send_time_ms + packet_duration_ms > now_ms) {
       // Don't cull packets too early to avoid failed retransmission requests.
       return;
     }
 
-    if (packet_history_.size() >= number_to_store_ ||
-        (mode_ == StorageMode::kStoreAndCull && *stored_packet.send_time_ms + (packet_duration_ms * kPacketCullingDelayFactor) <= now_ms)) 
-	{
+    if (num_packets_ >= number_to_store_ ||
+        (mode_ == StorageMode::kStoreAndCull &&
+         *stored_packet.send_time_ms +
+                 (packet_duration_ms * kPacketCullingDelayFactor) <=
+             now_ms)) {
       // Too many packets in history, or this packet has timed out. Remove it
       // and continue.
-      RemovePacket(stored_packet_it);
-    }
-	else 
-	{
+      RemovePacket(*start_seqno_);
+    } else {
       // No more packets can be removed right now.
       return;
     }
   }
 }
 
-std::unique_ptr<RtpPacketToSend> RtpPacketHistory::RemovePacket(StoredPacketIterator packet_it) 
-{
-  // Move the packet out from the StoredPacket container.
-  std::unique_ptr<RtpPacketToSend> rtp_packet = std::move(packet_it->second.packet);
-  // Erase the packet from the map, and capture iterator to the next one.
-  StoredPacketIterator next_it = packet_history_.erase(packet_it);
+RtpPacketHistory::StoredPacket* RtpPacketHistory::GetStoredPacket(
+    uint16_t sequence_number) {
+  if (!start_seqno_) {
+    return nullptr;
+  }
+  const uint16_t offset = sequence_number - *start_seqno_;
+  if (offset >= num_slots_) {
+    return nullptr;
+  }
+  StoredPacket& stored_packet = SlotAt(offset);
+  return stored_packet.packet ? &stored_packet : nullptr;
+}
+
+const RtpPacketHistory::StoredPacket* RtpPacketHistory::GetStoredPacket(
+    uint16_t sequence_number) const {
+  return const_cast<RtpPacketHistory*>(this)->GetStoredPacket(sequence_number);
+}
+
+RtpPacketHistory::StoredPacket* RtpPacketHistory::GetOrCreateSlot(
+    uint16_t sequence_number) {
+  if (!start_seqno_) {
+    EnsureCapacity(1);
+    first_index_ = 0;
+    num_slots_ = 1;
+    start_seqno_ = sequence_number;
+    return &SlotAt(0);
+  }
+
+  if (sequence_number == *start_seqno_ ||
+      IsNewerSequenceNumber(sequence_number, *start_seqno_)) {
+    const size_t offset = static_cast<uint16_t>(sequence_number - *start_seqno_);
+    if (offset >= num_slots_) {
+      // Newer than anything stored; the slots in between are already empty.
+      if (offset >= kMaxRingSize) {
+        return nullptr;
+      }
+      EnsureCapacity(offset + 1);
+      num_slots_ = offset + 1;
+    }
+    return &SlotAt(offset);
+  }
 
-  // |next_it| now points to the next element, or to the end. If the end,
-  // check if we can wrap around.
-  if (next_it == packet_history_.end()) 
-  {
-    next_it = packet_history_.begin();
+  // Older than the oldest stored packet, grow the covered range backwards.
+  // The packet becomes the oldest one, and the next to be culled.
+  const size_t extra_slots =
+      static_cast<uint16_t>(*start_seqno_ - sequence_number);
+  if (num_slots_ + extra_slots > kMaxRingSize) {
+    return nullptr;
   }
+  EnsureCapacity(num_slots_ + extra_slots);
+  first_index_ = (first_index_ - extra_slots) & (ring_.size() - 1);
+  num_slots_ += extra_slots;
+  start_seqno_ = sequence_number;
+  return &SlotAt(0);
+}
 
-  // Update |start_seq_no| to the new oldest item.
-  if (next_it != packet_history_.end()) 
-  {
-    start_seqno_ = next_it->first;
+void RtpPacketHistory::EnsureCapacity(size_t num_slots) {
+  if (num_slots <= ring_.size()) {
+    return;
   }
-  else 
-  {
-    start_seqno_.reset();
+  size_t new_size = std::max(kMinRingSize, ring_.size());
+  while (new_size < num_slots) {
+    new_size *= 2;
+  }
+  std::vector<StoredPacket> new_ring(new_size);
+  for (size_t i = 0; i < num_slots_; ++i) {
+    new_ring[i] = std::move(SlotAt(i));
   }
+  ring_.swap(new_ring);
+  first_index_ = 0;
+}
 
-  auto size_iterator = packet_size_.find(rtp_packet->size());
-  if (size_iterator != packet_size_.end() && size_iterator->second == rtp_packet->SequenceNumber()) 
-  {
-    packet_size_.erase(size_iterator);
+std::unique_ptr<RtpPacketToSend> RtpPacketHistory::RemovePacket(
+    uint16_t sequence_number) {
+  StoredPacket* stored_packet = GetStoredPacket(sequence_number);
+  RTC_DCHECK(stored_packet);
+  // Move the packet out from the StoredPacket container, leaving an empty
+  // slot behind.
+  std::unique_ptr<RtpPacketToSend> rtp_packet =
+      std::move(stored_packet->packet);
+  *stored_packet = StoredPacket();
+  --num_packets_;
+
+  if (num_packets_ == 0) {
+    first_index_ = 0;
+    num_slots_ = 0;
+    start_seqno_.reset();
+  } else {
+    // Update |start_seqno_| to the new oldest item, and drop empty slots at
+    // either end of the covered range.
+    while (!SlotAt(0).packet) {
+      first_index_ = (first_index_ + 1) & (ring_.size() - 1);
+      --num_slots_;
+      ++*start_seqno_;
+    }
+    while (!SlotAt(num_slots_ - 1).packet) {
+      --num_slots_;
+    }
   }
 
+  RemoveFromSizeIndex(rtp_packet->size(), rtp_packet->SequenceNumber());
+
   return rtp_packet;
 }
 
+void RtpPacketHistory::AddToSizeIndex(size_t packet_size,
+                                      uint16_t sequence_number) {
+  auto it = std::lower_bound(
+      packet_size_.begin(), packet_size_.end(), packet_size,
+      [](const std::pair<size_t, uint16_t>& entry, size_t size) {
+        return entry.first < size;
+      });
+  if (it != packet_size_.end() && it->first == packet_size) {
+    it->second = sequence_number;
+  } else {
+    packet_size_.emplace(it, packet_size, sequence_number);
+  }
+}
+
+void RtpPacketHistory::RemoveFromSizeIndex(size_t packet_size,
+                                           uint16_t sequence_number) {
+  auto it = std::lower_bound(
+      packet_size_.begin(), packet_size_.end(), packet_size,
+      [](const std::pair<size_t, uint16_t>& entry, size_t size) {
+        return entry.first < size;
+      });
+  if (it != packet_size_.end() && it->first == packet_size &&
+      it->second == sequence_number) {
+    packet_size_.erase(it);
+  }
+}
+
 RtpPacketHistory::PacketState RtpPacketHistory::StoredPacketToPacketState(
     const RtpPacketHistory::StoredPacket& stored_packet) {
   RtpPacketHistory::PacketState state;
@@ -11,8 +11,8 @@
 #ifndef MODULES_RTP_RTCP_SOURCE_RTP_PACKET_HISTORY_H_
 #define MODULES_RTP_RTCP_SOURCE_RTP_PACKET_HISTORY_H_
 
-#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
@@ -70,7 +70,8 @@ class RtpPacketHistory {
   void SetRtt(int64_t rtt_ms);
 
   // If |send_time| is set, packet was sent without using pacer, so state will
-  // be set accordingly.
+  // be set accordingly. Packets are culled in sequence number order, so a
+  // packet stored after one with a newer sequence number is culled first.
   void PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
                     StorageType type,
                     absl::optional<int64_t> send_time_ms);
@@ -110,17 +111,35 @@ class RtpPacketHistory {
     std::unique_ptr<RtpPacketToSend> packet;
   };
 
-  using StoredPacketIterator = std::map<uint16_t, StoredPacket>::iterator;
-
   // Helper method used by GetPacketAndSetSendTime() and GetPacketState() to
   // check if packet has too recently been sent.
   bool VerifyRtt(const StoredPacket& packet, int64_t now_ms) const
       RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void Reset() RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void CullOldPackets(int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the slot for |sequence_number| if it holds a packet, otherwise
+  // nullptr.
+  StoredPacket* GetStoredPacket(uint16_t sequence_number)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  const StoredPacket* GetStoredPacket(uint16_t sequence_number) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the slot for |sequence_number|, extending the covered range of
+  // the ring buffer if needed. Returns nullptr if the sequence number is too
+  // far from the packets already stored.
+  StoredPacket* GetOrCreateSlot(uint16_t sequence_number)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Makes room for at least |num_slots| slots, keeping the stored ones.
+  void EnsureCapacity(size_t num_slots) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  StoredPacket& SlotAt(size_t offset) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return ring_[(first_index_ + offset) & (ring_.size() - 1)];
+  }
   // Removes the packet from the history, and context/mapping that has been
   // stored. Returns the RTP packet instance contained within the StoredPacket.
-  std::unique_ptr<RtpPacketToSend> RemovePacket(StoredPacketIterator packet)
+  std::unique_ptr<RtpPacketToSend> RemovePacket(uint16_t sequence_number)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void AddToSizeIndex(size_t packet_size, uint16_t sequence_number)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void RemoveFromSizeIndex(size_t packet_size, uint16_t sequence_number)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   static PacketState StoredPacketToPacketState(
       const StoredPacket& stored_packet);
@@ -131,12 +150,24 @@ class RtpPacketHistory {
   StorageMode mode_ RTC_GUARDED_BY(lock_);
   int64_t rtt_ms_ RTC_GUARDED_BY(lock_);
 
-  // Map from rtp sequence numbers to stored packet.
-  std::map<uint16_t, StoredPacket> packet_history_ RTC_GUARDED_BY(lock_);
-  std::map<size_t, uint16_t> packet_size_ RTC_GUARDED_BY(lock_);
-
-  // The earliest packet in the history. This might not be the lowest sequence
-  // number, in case there is a wraparound.
+  // Ring buffer of stored packets, indexed by the offset of the rtp sequence
+  // number from |start_seqno_|. The size is a power of two. Slots of removed
+  // packets, or of sequence numbers never stored, have a null |packet|.
+  std::vector<StoredPacket> ring_ RTC_GUARDED_BY(lock_);
+  // Position in |ring_| of the slot for |start_seqno_|.
+  size_t first_index_ RTC_GUARDED_BY(lock_);
+  // Number of slots from the oldest to the newest stored packet, inclusive.
+  size_t num_slots_ RTC_GUARDED_BY(lock_);
+  // Number of slots that hold a packet.
+  size_t num_packets_ RTC_GUARDED_BY(lock_);
+
+  // The sequence number of the last stored retransmittable packet of each
+  // size, sorted by size.
+  std::vector<std::pair<size_t, uint16_t>> packet_size_ RTC_GUARDED_BY(lock_);
+
+  // The oldest sequence number in the history, with wraparound taken into
+  // account. Culling starts here. Storing an older packet moves it back, even
+  // if newer packets were stored first.
   absl::optional<uint16_t> start_seqno_ RTC_GUARDED_BY(lock_);
 
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(RtpPacketHistory);
@@ -331,6 +331,70 @@ TEST_F(RtpPacketHistoryTest, RemovesOldestPacketWhenAtMaxCapacity) {
   EXPECT_TRUE(hist_.GetPacketState(kStartSeqNum + 1));
 }
 
+TEST_F(RtpPacketHistoryTest, StoresPacketsOutOfOrder) {
+  hist_.SetStorePacketsStatus(StorageMode::kStore, 10);
+  hist_.PutRtpPacket(CreateRtpPacket(To16u(kStartSeqNum + 2)),
+                     kAllowRetransmission, absl::nullopt);
+  hist_.PutRtpPacket(CreateRtpPacket(kStartSeqNum), kAllowRetransmission,
+                     absl::nullopt);
+  EXPECT_TRUE(hist_.GetPacketState(kStartSeqNum));
+  EXPECT_FALSE(hist_.GetPacketState(kStartSeqNum + 1));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 2)));
+
+  // Fill the gap with a packet only meant for the pacer and send it.
+  hist_.PutRtpPacket(CreateRtpPacket(kStartSeqNum + 1), kDontRetransmit,
+                     absl::nullopt);
+  EXPECT_TRUE(hist_.GetPacketAndSetSendTime(kStartSeqNum + 1));
+  EXPECT_FALSE(hist_.GetPacketState(kStartSeqNum + 1));
+  EXPECT_TRUE(hist_.GetPacketState(kStartSeqNum));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 2)));
+}
+
+TEST_F(RtpPacketHistoryTest, CullsOutOfOrderPacketsInSequenceNumberOrder) {
+  hist_.SetStorePacketsStatus(StorageMode::kStore, 2);
+  // Store a packet, then one with an older sequence number across the wrap.
+  hist_.PutRtpPacket(CreateRtpPacket(To16u(kStartSeqNum + 2)),
+                     kAllowRetransmission, fake_clock_.TimeInMilliseconds());
+  hist_.PutRtpPacket(CreateRtpPacket(kStartSeqNum), kAllowRetransmission,
+                     fake_clock_.TimeInMilliseconds());
+  fake_clock_.AdvanceTimeMilliseconds(RtpPacketHistory::kMinPacketDurationMs);
+
+  // The history is full, so storing a new packet culls one. That is the one
+  // with the oldest sequence number, even though it was stored last.
+  hist_.PutRtpPacket(CreateRtpPacket(To16u(kStartSeqNum + 3)),
+                     kAllowRetransmission, fake_clock_.TimeInMilliseconds());
+  EXPECT_FALSE(hist_.GetPacketState(kStartSeqNum));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 2)));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 3)));
+
+  // Culling continues from the next stored sequence number.
+  hist_.PutRtpPacket(CreateRtpPacket(To16u(kStartSeqNum + 4)),
+                     kAllowRetransmission, fake_clock_.TimeInMilliseconds());
+  EXPECT_FALSE(hist_.GetPacketState(To16u(kStartSeqNum + 2)));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 3)));
+  EXPECT_TRUE(hist_.GetPacketState(To16u(kStartSeqNum + 4)));
+}
+
+TEST_F(RtpPacketHistoryTest, PurgesHistoryOnLargeSequenceNumberJump) {
+  hist_.SetStorePacketsStatus(StorageMode::kStore, 10);
+  hist_.PutRtpPacket(CreateRtpPacket(kStartSeqNum), kAllowRetransmission,
+                     absl::nullopt);
+  // Still within half the sequence number space, so kept.
+  const uint16_t kFarSeqNum = To16u(kStartSeqNum + 30000);
+  hist_.PutRtpPacket(CreateRtpPacket(kFarSeqNum), kAllowRetransmission,
+                     absl::nullopt);
+  EXPECT_TRUE(hist_.GetPacketState(kStartSeqNum));
+  EXPECT_TRUE(hist_.GetPacketState(kFarSeqNum));
+
+  // Looks older than the oldest packet, but does not fit in the history.
+  const uint16_t kOldSeqNum = To16u(kStartSeqNum - 10000);
+  hist_.PutRtpPacket(CreateRtpPacket(kOldSeqNum), kAllowRetransmission,
+                     absl::nullopt);
+  EXPECT_FALSE(hist_.GetPacketState(kStartSeqNum));
+  EXPECT_FALSE(hist_.GetPacketState(kFarSeqNum));
+  EXPECT_TRUE(hist_.GetPacketState(kOldSeqNum));
+}
+
 TEST_F(RtpPacketHistoryTest, DontRemoveUnsentPackets) {
   const size_t kMaxNumPackets = 10;
   hist_.SetStorePacketsStatus(StorageMode::kStore, kMaxNumPackets);
@@ -22,6 +22,9 @@ namespace webrtc {
 RtpPacketReceived::RtpPacketReceived() = default;
 RtpPacketReceived::RtpPacketReceived(const ExtensionManager* extensions)
     : RtpPacket(extensions) {}
+RtpPacketReceived::RtpPacketReceived(const ExtensionManager* extensions,
+                                     size_t capacity)
+    : RtpPacket(extensions, capacity) {}
 RtpPacketReceived::RtpPacketReceived(const RtpPacketReceived& packet) = default;
 RtpPacketReceived::RtpPacketReceived(RtpPacketReceived&& packet) = default;
 
@@ -24,6 +24,7 @@ class RtpPacketReceived : public RtpPacket {
  public:
   RtpPacketReceived();
   explicit RtpPacketReceived(const ExtensionManager* extensions);
+  RtpPacketReceived(const ExtensionManager* extensions, size_t capacity);
   RtpPacketReceived(const RtpPacketReceived& packet);
   RtpPacketReceived(RtpPacketReceived&& packet);
 
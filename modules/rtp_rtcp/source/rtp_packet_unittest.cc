@@ -13,6 +13,7 @@
 #include "common_video/test/utilities.h"
 #include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
 #include "modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "rtc_base/checks.h"
 #include "rtc_base/random.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
@@ -952,4 +953,60 @@ TEST(RtpPacketTest,
             kFeedbackRequest->sequence_count);
 }
 
+TEST(RtpPacketTest, ParseIntoPacketWithoutBufferTakesOverBuffer) {
+  RtpPacketReceived::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  RtpPacketReceived packet(&extensions, /*capacity=*/0);
+  EXPECT_EQ(0u, packet.capacity());
+
+  rtc::CopyOnWriteBuffer buffer(kPacketWithTOAndAL);
+  EXPECT_TRUE(packet.Parse(buffer));
+  EXPECT_EQ(buffer.cdata(), packet.data());
+  EXPECT_EQ(kSeqNum, packet.SequenceNumber());
+  int32_t time_offset;
+  EXPECT_TRUE(packet.GetExtension<TransmissionOffset>(&time_offset));
+  EXPECT_EQ(kTimeOffset, time_offset);
+}
+
+TEST(RtpPacketTest, FailedParseIntoPacketWithoutBuffer) {
+  RtpPacketReceived packet(nullptr, /*capacity=*/0);
+  EXPECT_FALSE(packet.Parse(rtc::CopyOnWriteBuffer(kMinimumPacket, 5)));
+  EXPECT_EQ(0u, packet.payload_size());
+  EXPECT_TRUE(packet.Parse(rtc::CopyOnWriteBuffer(kMinimumPacket)));
+  EXPECT_EQ(kSsrc, packet.Ssrc());
+}
+
+TEST(RtpPacketTest, ParseMoreExtensionsThanStoredInline) {
+  // Two-byte header with 40 one-byte extensions, ids 1 to 40, followed by a
+  // transmission offset with id 200.
+  constexpr int kNumFillerExtensions = 40;
+  std::vector<uint8_t> raw = {
+      0x90, kPayloadType, kSeqNumFirstByte, kSeqNumSecondByte,
+      0x65, 0x43, 0x12, 0x78,
+      0x12, 0x34, 0x56, 0x78,
+      0x10, 0x00, 0x00, 0x00};
+  for (int id = 1; id <= kNumFillerExtensions; ++id) {
+    raw.push_back(id);
+    raw.push_back(1);
+    raw.push_back(id);
+  }
+  raw.insert(raw.end(), {200, 3, 0x00, 0x56, 0xce});
+  while (raw.size() % 4 != 0)
+    raw.push_back(0);
+  raw[15] = (raw.size() - 16) / 4;
+
+  RtpPacketReceived::ExtensionManager extensions(/*extmap_allow_mixed=*/true);
+  extensions.Register<TransmissionOffset>(200);
+  extensions.Register<AudioLevel>(kNumFillerExtensions);
+  RtpPacketReceived packet(&extensions, /*capacity=*/0);
+  ASSERT_TRUE(packet.Parse(rtc::CopyOnWriteBuffer(raw.data(), raw.size())));
+  int32_t time_offset;
+  EXPECT_TRUE(packet.GetExtension<TransmissionOffset>(&time_offset));
+  EXPECT_EQ(kTimeOffset, time_offset);
+  bool voice_active;
+  uint8_t audio_level;
+  EXPECT_TRUE(packet.GetExtension<AudioLevel>(&voice_active, &audio_level));
+  EXPECT_EQ(kNumFillerExtensions, audio_level);
+}
+
 }  // namespace webrtc
@@ -409,6 +409,8 @@ size_t RTPSender::SendPadData(size_t bytes,
     PacketOptions options;
     // Padding packets are never retransmissions.
     options.is_retransmit = false;
+    // Padding is only requested by the pacer, as part of a burst.
+    options.batchable = paced_sender_ != nullptr;
     bool has_transport_seq_num;
     {
       rtc::CritScope lock(&send_critsect_);
@@ -612,6 +614,8 @@ bool RTPSender::PrepareAndSendPacket(std::unique_ptr<RtpPacketToSend> packet,
   // E.g. RTPSender::TrySendRedundantPayloads calls PrepareAndSendPacket with
   // send_over_rtx = true but is_retransmit = false.
   options.is_retransmit = is_retransmit || send_over_rtx;
+  // With a pacer, this is only reached from a pacer burst.
+  options.batchable = paced_sender_ != nullptr;
   bool has_transport_seq_num;
   {
     rtc::CritScope lock(&send_critsect_);
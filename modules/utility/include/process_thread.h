@@ -11,7 +11,9 @@
 #ifndef MODULES_UTILITY_INCLUDE_PROCESS_THREAD_H_
 #define MODULES_UTILITY_INCLUDE_PROCESS_THREAD_H_
 
+#include <stdint.h>
 #include <memory>
+#include <vector>
 
 #include "api/task_queue/queued_task.h"
 
@@ -28,6 +30,24 @@ class Module;
 // a nullptr might suffice (or simply an actual ProcessThread instance).
 class ProcessThread {
  public:
+  // Counters for one registered module, to find modules that keep the
+  // thread busy.
+  struct ModuleStats {
+    Module* module = nullptr;
+    // Where the module was registered from.
+    const char* function_name = nullptr;
+    const char* file_and_line = nullptr;
+    // Number of Process() calls, and how many of them were caused by WakeUp().
+    int64_t process_calls = 0;
+    int64_t wake_ups = 0;
+    // Time spent in Process().
+    int64_t total_process_time_us = 0;
+    int64_t max_process_time_us = 0;
+    // How late Process() was called relative to when it was due.
+    int64_t total_delay_ms = 0;
+    int64_t max_delay_ms = 0;
+  };
+
   virtual ~ProcessThread();
 
   static std::unique_ptr<ProcessThread> Create(const char* thread_name);
@@ -64,6 +84,10 @@ class ProcessThread {
   // Removes a previously registered module.
   // Can be called from any thread.
   virtual void DeRegisterModule(Module* module) = 0;
+
+  // Returns counters for the registered modules. Can be called from any
+  // thread. Implementations without counters return an empty list.
+  virtual std::vector<ModuleStats> GetModuleStats() const;
 };
 
 }  // namespace webrtc
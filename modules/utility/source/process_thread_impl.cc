@@ -10,6 +10,7 @@
 
 #include "modules/utility/source/process_thread_impl.h"
 
+#include <algorithm>
 #include <string>
 
 #include "modules/include/module.h"
@@ -20,11 +21,6 @@
 namespace webrtc {
 namespace {
 
-// We use this constant internally to signal that a module has requested
-// a callback right away.  When this is set, no call to TimeUntilNextProcess
-// should be made, but Process() should be called directly.
-const int64_t kCallProcessImmediately = -1;
-
 int64_t GetNextCallbackTime(Module* module, int64_t time_now) {
   int64_t interval = module->TimeUntilNextProcess();
   if (interval < 0) {
@@ -37,13 +33,17 @@ int64_t GetNextCallbackTime(Module* module, int64_t time_now) {
 
 ProcessThread::~ProcessThread() {}
 
+std::vector<ProcessThread::ModuleStats> ProcessThread::GetModuleStats() const {
+  return std::vector<ModuleStats>();
+}
+
 // static
 std::unique_ptr<ProcessThread> ProcessThread::Create(const char* thread_name) {
   return std::unique_ptr<ProcessThread>(new ProcessThreadImpl(thread_name));
 }
 
 ProcessThreadImpl::ProcessThreadImpl(const char* thread_name)
-    : stop_(false), thread_name_(thread_name) {}
+    : timers_(rtc::TimeMillis()), stop_(false), thread_name_(thread_name) {}
 
 ProcessThreadImpl::~ProcessThreadImpl() {
   RTC_DCHECK(thread_checker_.IsCurrent());
@@ -98,9 +98,17 @@ void ProcessThreadImpl::WakeUp(Module* module) {
   // Allowed to be called on any thread.
   {
     rtc::CritScope lock(&lock_);
-    for (ModuleCallback& m : modules_) {
-      if (m.module == module)
-        m.next_callback = kCallProcessImmediately;
+    auto it = modules_by_ptr_.find(module);
+    if (it != modules_by_ptr_.end()) {
+      ModuleCallback* m = it->second;
+      timers_.Cancel(m);
+      if (!m->process_immediately)
+        m->woken_at_ms = rtc::TimeMillis();
+      m->process_immediately = true;
+      if (!m->pending) {
+        m->pending = true;
+        pending_.push_back(m);
+      }
     }
   }
   wake_up_.Set();
@@ -124,11 +132,11 @@ void ProcessThreadImpl::RegisterModule(Module* module,
   {
     // Catch programmer error.
     rtc::CritScope lock(&lock_);
-    for (const ModuleCallback& mc : modules_) {
-      RTC_DCHECK(mc.module != module)
-          << "Already registered here: " << mc.location.ToString() << "\n"
-          << "Now attempting from here: " << from.ToString();
-    }
+    auto it = modules_by_ptr_.find(module);
+    RTC_DCHECK(it == modules_by_ptr_.end())
+        << "Already registered here: " << it->second->location.ToString()
+        << "\n"
+        << "Now attempting from here: " << from.ToString();
   }
 #endif
 
@@ -140,7 +148,15 @@ void ProcessThreadImpl::RegisterModule(Module* module,
 
   {
     rtc::CritScope lock(&lock_);
-    modules_.push_back(ModuleCallback(module, from));
+    modules_.emplace_back(module, from);
+    ModuleCallback* m = &modules_.back();
+    m->stats.module = module;
+    m->stats.function_name = from.function_name();
+    m->stats.file_and_line = from.file_and_line();
+    modules_by_ptr_[module] = m;
+    // Ask for TimeUntilNextProcess() on the worker thread.
+    m->pending = true;
+    pending_.push_back(m);
   }
 
   // Wake the thread calling ProcessThreadImpl::Process() to update the
@@ -155,6 +171,14 @@ void ProcessThreadImpl::DeRegisterModule(Module* module) {
 
   {
     rtc::CritScope lock(&lock_);
+    auto it = modules_by_ptr_.find(module);
+    if (it != modules_by_ptr_.end()) {
+      ModuleCallback* m = it->second;
+      timers_.Cancel(m);
+      if (m->pending)
+        pending_.erase(std::find(pending_.begin(), pending_.end(), m));
+      modules_by_ptr_.erase(it);
+    }
     modules_.remove_if(
         [&module](const ModuleCallback& m) { return m.module == module; });
   }
@@ -179,36 +203,39 @@ bool ProcessThreadImpl::Process()
     if (stop_) {
       return false;
     }
-    for (ModuleCallback& m : modules_) {
-      // TODO(tommi): Would be good to measure the time TimeUntilNextProcess
-      // takes and dcheck if it takes too long (e.g. >=10ms).  Ideally this
-      // operation should not require taking a lock, so querying all modules
-      // should run in a matter of nanoseconds.
-      if (m.next_callback == 0) 
-	  {
-        m.next_callback = GetNextCallbackTime(m.module, now);
-      }
 
-      if (m.next_callback <= now ||  m.next_callback == kCallProcessImmediately) 
-	  {
-        {
-          TRACE_EVENT2("webrtc", "ModuleProcess", "function",
-                       m.location.function_name(), "file",
-                       m.location.file_and_line());
-          m.module->Process();
-        }
-        // Use a new 'now' reference to calculate when the next callback
-        // should occur.  We'll continue to use 'now' above for the baseline
-        // of calculating how long we should wait, to reduce variance.
-        int64_t new_now = rtc::TimeMillis();
-        m.next_callback = GetNextCallbackTime(m.module, new_now);
+    // Modules that were registered or woken up since the last round. Modules
+    // woken up while this runs are added to a fresh |pending_|.
+    processing_.swap(pending_);
+    for (ModuleCallback* m : processing_) {
+      m->pending = false;
+      if (m->process_immediately) {
+        ProcessModule(m, m->woken_at_ms, /*woken_up=*/true);
+        continue;
       }
-
-	  if (m.next_callback < next_checkpoint)
-	  {
-        next_checkpoint = m.next_callback;
-	  }
+      int64_t next_callback = GetNextCallbackTime(m->module, now);
+      if (next_callback <= now) {
+        ProcessModule(m, next_callback, /*woken_up=*/false);
+      } else {
+        timers_.Schedule(m, next_callback);
+      }
+    }
+    processing_.clear();
+
+    // Modules whose time has come. The others are not touched at all.
+    timers_.Advance(now, &expired_);
+    for (TimerWheel::Entry* entry : expired_) {
+      ModuleCallback* m = static_cast<ModuleCallback*>(entry);
+      // Woken up by a module processed before it in this loop. It is in
+      // |pending_| already and is processed once, as woken up, next round.
+      if (m->process_immediately)
+        continue;
+      ProcessModule(m, m->deadline_ms(), /*woken_up=*/false);
     }
+    expired_.clear();
+
+    next_checkpoint =
+        std::min(next_checkpoint, pending_.empty() ? timers_.NextWakeUp() : now);
 
     while (!queue_.empty()) 
 	{
@@ -229,4 +256,50 @@ bool ProcessThreadImpl::Process()
 
   return true;
 }
+
+void ProcessThreadImpl::ProcessModule(ModuleCallback* m,
+                                      int64_t due_ms,
+                                      bool woken_up) {
+  m->process_immediately = false;
+  int64_t start_us = rtc::TimeMicros();
+  {
+    TRACE_EVENT2("webrtc", "ModuleProcess", "function",
+                 m->location.function_name(), "file",
+                 m->location.file_and_line());
+    m->module->Process();
+  }
+  int64_t end_us = rtc::TimeMicros();
+
+  ModuleStats& stats = m->stats;
+  ++stats.process_calls;
+  if (woken_up)
+    ++stats.wake_ups;
+  int64_t process_time_us = end_us - start_us;
+  stats.total_process_time_us += process_time_us;
+  stats.max_process_time_us =
+      std::max(stats.max_process_time_us, process_time_us);
+  int64_t delay_ms =
+      std::max<int64_t>(0, start_us / rtc::kNumMicrosecsPerMillisec - due_ms);
+  stats.total_delay_ms += delay_ms;
+  stats.max_delay_ms = std::max(stats.max_delay_ms, delay_ms);
+
+  if (m->process_immediately) {
+    // Woken up from within Process(); it is in |pending_| already.
+    return;
+  }
+  // Use a new 'now' reference to calculate when the next callback should
+  // occur.
+  timers_.Schedule(m, GetNextCallbackTime(
+                          m->module, end_us / rtc::kNumMicrosecsPerMillisec));
+}
+
+std::vector<ProcessThread::ModuleStats> ProcessThreadImpl::GetModuleStats()
+    const {
+  rtc::CritScope lock(&lock_);
+  std::vector<ModuleStats> stats;
+  stats.reserve(modules_.size());
+  for (const ModuleCallback& m : modules_)
+    stats.push_back(m.stats);
+  return stats;
+}
 }  // namespace webrtc
@@ -15,10 +15,13 @@
 #include <list>
 #include <memory>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 #include "api/task_queue/queued_task.h"
 #include "modules/include/module.h"
 #include "modules/utility/include/process_thread.h"
+#include "modules/utility/source/timer_wheel.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/event.h"
 #include "rtc_base/location.h"
@@ -41,15 +44,19 @@ class ProcessThreadImpl : public ProcessThread {
   void RegisterModule(Module* module, const rtc::Location& from) override;
   void DeRegisterModule(Module* module) override;
 
+  std::vector<ModuleStats> GetModuleStats() const override;
+
  protected:
   static bool Run(void* obj);
   bool Process();
 
  private:
-  struct ModuleCallback {
+  // A module is either scheduled in |timers_| for the time its
+  // TimeUntilNextProcess() asked for, or listed in |pending_| because it was
+  // just registered or woken up. Modules are only queried again after they
+  // have been processed or woken up.
+  struct ModuleCallback : public TimerWheel::Entry {
     ModuleCallback() = delete;
-    ModuleCallback(ModuleCallback&& cb) = default;
-    ModuleCallback(const ModuleCallback& cb) = default;
     ModuleCallback(Module* module, const rtc::Location& location)
         : module(module), location(location) {}
     bool operator==(const ModuleCallback& cb) const {
@@ -57,15 +64,19 @@ class ProcessThreadImpl : public ProcessThread {
     }
 
     Module* const module;
-    int64_t next_callback = 0;  // Absolute timestamp.
     const rtc::Location location;
-
-   private:
-    ModuleCallback& operator=(ModuleCallback&);
+    // Set by WakeUp(): call Process() without asking TimeUntilNextProcess().
+    bool process_immediately = false;
+    bool pending = false;
+    // When the module was woken up, for the delay counters.
+    int64_t woken_at_ms = 0;
+    ModuleStats stats;
   };
 
   typedef std::list<ModuleCallback> ModuleList;
 
+  void ProcessModule(ModuleCallback* m, int64_t due_ms, bool woken_up);
+
   // Warning: For some reason, if |lock_| comes immediately before |modules_|
   // with the current class layout, we will  start to have mysterious crashes
   // on Mac 10.9 debug.  I (Tommi) suspect we're hitting some obscure alignemnt
@@ -80,6 +91,12 @@ class ProcessThreadImpl : public ProcessThread {
   std::unique_ptr<rtc::PlatformThread> thread_;
 
   ModuleList modules_;
+  std::unordered_map<Module*, ModuleCallback*> modules_by_ptr_;
+  TimerWheel timers_;
+  std::vector<ModuleCallback*> pending_;
+  // Scratch space for Process(), kept to avoid reallocating.
+  std::vector<ModuleCallback*> processing_;
+  std::vector<TimerWheel::Entry*> expired_;
   std::queue<QueuedTask*> queue_;
   bool stop_;
   const char* thread_name_;
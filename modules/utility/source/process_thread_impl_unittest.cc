@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "api/task_queue/queued_task.h"
 #include "modules/include/module.h"
@@ -309,4 +310,133 @@ TEST(ProcessThreadImpl, PostTask) {
   thread.Stop();
 }
 
+// Tests that a module that is not due is not asked for TimeUntilNextProcess()
+// when another module is processed, and that both are counted.
+TEST(ProcessThreadImpl, IdleModuleIsNotPolled) {
+  ProcessThreadImpl thread("ProcessThread");
+  thread.Start();
+
+  rtc::Event called;
+  MockModule busy_module;
+  MockModule idle_module;
+  int busy_count = 0;
+
+  EXPECT_CALL(busy_module, TimeUntilNextProcess()).WillRepeatedly(Return(1));
+  EXPECT_CALL(busy_module, Process())
+      .WillRepeatedly(DoAll(Increment(&busy_count), Invoke([&] {
+                              if (busy_count == 20)
+                                called.Set();
+                            })));
+  // Asked once when registered; never due during the test.
+  EXPECT_CALL(idle_module, TimeUntilNextProcess()).WillOnce(Return(100000));
+  EXPECT_CALL(idle_module, Process()).Times(0);
+
+  EXPECT_CALL(busy_module, ProcessThreadAttached(&thread)).Times(1);
+  EXPECT_CALL(idle_module, ProcessThreadAttached(&thread)).Times(1);
+  thread.RegisterModule(&idle_module, RTC_FROM_HERE);
+  thread.RegisterModule(&busy_module, RTC_FROM_HERE);
+
+  EXPECT_TRUE(called.Wait(kEventWaitTimeout));
+
+  EXPECT_CALL(busy_module, ProcessThreadAttached(nullptr)).Times(1);
+  EXPECT_CALL(idle_module, ProcessThreadAttached(nullptr)).Times(1);
+  thread.Stop();
+
+  std::vector<ProcessThread::ModuleStats> stats = thread.GetModuleStats();
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ(&idle_module, stats[0].module);
+  EXPECT_EQ(0, stats[0].process_calls);
+  EXPECT_EQ(&busy_module, stats[1].module);
+  EXPECT_GE(stats[1].process_calls, 20);
+  EXPECT_EQ(0, stats[1].wake_ups);
+  EXPECT_GE(stats[1].total_process_time_us, stats[1].max_process_time_us);
+}
+
+// Tests that processing caused by WakeUp() is counted.
+TEST(ProcessThreadImpl, CountsWakeUps) {
+  ProcessThreadImpl thread("ProcessThread");
+  thread.Start();
+
+  rtc::Event started;
+  rtc::Event called;
+  MockModule module;
+  EXPECT_CALL(module, TimeUntilNextProcess())
+      .WillOnce(DoAll(SetEvent(&started), Return(1000)))
+      .WillRepeatedly(Return(1000));
+  EXPECT_CALL(module, Process()).WillOnce(SetEvent(&called));
+
+  EXPECT_CALL(module, ProcessThreadAttached(&thread)).Times(1);
+  thread.RegisterModule(&module, RTC_FROM_HERE);
+  EXPECT_TRUE(started.Wait(kEventWaitTimeout));
+  thread.WakeUp(&module);
+  EXPECT_TRUE(called.Wait(kEventWaitTimeout));
+
+  EXPECT_CALL(module, ProcessThreadAttached(nullptr)).Times(1);
+  thread.Stop();
+
+  std::vector<ProcessThread::ModuleStats> stats = thread.GetModuleStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(1, stats[0].process_calls);
+  EXPECT_EQ(1, stats[0].wake_ups);
+  EXPECT_LT(stats[0].max_delay_ms, kEventWaitTimeout);
+}
+
+// Tests that a module that is due, and woken up by another module that is
+// processed before it in the same round, is processed only once.
+TEST(ProcessThreadImpl, ModuleWokenUpWhileDueIsProcessedOnce) {
+  ProcessThreadImpl thread("ProcessThread");
+
+  rtc::Event called;
+  MockModule module1;
+  MockModule module2;
+  int process_count = 0;
+  bool woke_other = false;
+  // Both modules are due at the same time. Whichever is processed first
+  // wakes up the other one.
+  auto process = [&](MockModule* other) {
+    if (!woke_other) {
+      woke_other = true;
+      thread.WakeUp(other);
+    }
+    if (++process_count == 2)
+      called.Set();
+  };
+
+  EXPECT_CALL(module1, TimeUntilNextProcess())
+      .WillOnce(Return(10))
+      .WillRepeatedly(Return(100000));
+  EXPECT_CALL(module2, TimeUntilNextProcess())
+      .WillOnce(Return(10))
+      .WillRepeatedly(Return(100000));
+  EXPECT_CALL(module1, Process())
+      .WillRepeatedly(Invoke([&] { process(&module2); }));
+  EXPECT_CALL(module2, Process())
+      .WillRepeatedly(Invoke([&] { process(&module1); }));
+
+  thread.RegisterModule(&module1, RTC_FROM_HERE);
+  thread.RegisterModule(&module2, RTC_FROM_HERE);
+  EXPECT_CALL(module1, ProcessThreadAttached(&thread)).Times(1);
+  EXPECT_CALL(module2, ProcessThreadAttached(&thread)).Times(1);
+  thread.Start();
+  EXPECT_TRUE(called.Wait(kEventWaitTimeout));
+
+  // Let the thread finish two more rounds, where a duplicate call would be.
+  for (int i = 0; i < 2; ++i) {
+    rtc::Event task_ran;
+    std::unique_ptr<RaiseEventTask> task(new RaiseEventTask(&task_ran));
+    thread.PostTask(std::move(task));
+    EXPECT_TRUE(task_ran.Wait(kEventWaitTimeout));
+  }
+
+  EXPECT_CALL(module1, ProcessThreadAttached(nullptr)).Times(1);
+  EXPECT_CALL(module2, ProcessThreadAttached(nullptr)).Times(1);
+  thread.Stop();
+
+  std::vector<ProcessThread::ModuleStats> stats = thread.GetModuleStats();
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ(1, stats[0].process_calls);
+  EXPECT_EQ(1, stats[1].process_calls);
+  EXPECT_EQ(1, stats[0].wake_ups + stats[1].wake_ups);
+}
+
 }  // namespace webrtc
@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/utility/source/timer_wheel.h"
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+constexpr int64_t TimerWheel::kNoDeadline;
+constexpr int TimerWheel::kLevels;
+
+TimerWheel::TimerWheel(int64_t now_ms) : current_ms_(now_ms) {
+  for (int level = 0; level < kLevels; ++level)
+    slots_[level].resize(LevelSlots(level), nullptr);
+}
+
+TimerWheel::~TimerWheel() {
+  // Leave no dangling slot pointers in entries that outlive the wheel.
+  for (int level = 0; level < kLevels; ++level) {
+    for (Entry* head : slots_[level]) {
+      for (Entry* entry = head; entry;) {
+        Entry* next = entry->next_;
+        entry->slot_ = nullptr;
+        entry->prev_ = entry->next_ = nullptr;
+        entry = next;
+      }
+    }
+  }
+}
+
+// static
+int TimerWheel::LevelShift(int level) {
+  return level == 0 ? 0 : kLevel0Bits + (level - 1) * kLevelNBits;
+}
+
+// static
+int TimerWheel::LevelSlots(int level) {
+  return 1 << (level == 0 ? kLevel0Bits : kLevelNBits);
+}
+
+void TimerWheel::Schedule(Entry* entry, int64_t deadline_ms) {
+  RTC_DCHECK(entry);
+  if (entry->scheduled())
+    Unlink(entry);
+  entry->deadline_ms_ = deadline_ms;
+  Insert(entry);
+}
+
+void TimerWheel::Cancel(Entry* entry) {
+  RTC_DCHECK(entry);
+  if (entry->scheduled())
+    Unlink(entry);
+}
+
+void TimerWheel::Insert(Entry* entry) {
+  const int64_t when = std::max(entry->deadline_ms_, current_ms_);
+  const int64_t delta = when - current_ms_;
+  int level = 0;
+  int64_t slot_time = when;
+  while (level < kLevels - 1 &&
+         delta >= (int64_t{1} << (LevelShift(level + 1)))) {
+    ++level;
+  }
+  const int64_t horizon = int64_t{1} << (LevelShift(kLevels - 1) + kLevelNBits);
+  if (delta >= horizon) {
+    // Park it in the farthest slot; it is reinserted when that is cascaded.
+    slot_time = current_ms_ + horizon - 1;
+  }
+  const size_t index = static_cast<size_t>(
+      (slot_time >> LevelShift(level)) & (LevelSlots(level) - 1));
+  Entry** slot = &slots_[level][index];
+  entry->slot_ = slot;
+  entry->level_ = level;
+  entry->prev_ = nullptr;
+  entry->next_ = *slot;
+  if (*slot)
+    (*slot)->prev_ = entry;
+  *slot = entry;
+  ++level_size_[level];
+  ++size_;
+}
+
+void TimerWheel::Unlink(Entry* entry) {
+  if (entry->prev_)
+    entry->prev_->next_ = entry->next_;
+  else
+    *entry->slot_ = entry->next_;
+  if (entry->next_)
+    entry->next_->prev_ = entry->prev_;
+  entry->slot_ = nullptr;
+  entry->prev_ = entry->next_ = nullptr;
+  --level_size_[entry->level_];
+  --size_;
+}
+
+void TimerWheel::Cascade(int level) {
+  const size_t index = static_cast<size_t>(
+      (current_ms_ >> LevelShift(level)) & (LevelSlots(level) - 1));
+  Entry* entry = slots_[level][index];
+  slots_[level][index] = nullptr;
+  while (entry) {
+    Entry* next = entry->next_;
+    entry->slot_ = nullptr;
+    --level_size_[level];
+    --size_;
+    Insert(entry);
+    entry = next;
+  }
+}
+
+void TimerWheel::Advance(int64_t now_ms, std::vector<Entry*>* expired) {
+  RTC_DCHECK(expired);
+  while (current_ms_ <= now_ms) {
+    if (size_ == 0) {
+      current_ms_ = now_ms + 1;
+      return;
+    }
+    // Cascade coarse slots that start at this millisecond, coarsest first so
+    // that their entries can move down more than one level.
+    for (int level = kLevels - 1; level > 0; --level) {
+      const int64_t mask = (int64_t{1} << LevelShift(level)) - 1;
+      if ((current_ms_ & mask) == 0 && level_size_[level] > 0)
+        Cascade(level);
+    }
+    const size_t index =
+        static_cast<size_t>(current_ms_ & (LevelSlots(0) - 1));
+    Entry* entry = slots_[0][index];
+    if (entry) {
+      slots_[0][index] = nullptr;
+      // Entries are pushed to the front; reverse to expire in insertion
+      // order.
+      const size_t first = expired->size();
+      while (entry) {
+        Entry* next = entry->next_;
+        entry->slot_ = nullptr;
+        entry->prev_ = entry->next_ = nullptr;
+        --level_size_[0];
+        --size_;
+        expired->push_back(entry);
+        entry = next;
+      }
+      std::reverse(expired->begin() + first, expired->end());
+    }
+    ++current_ms_;
+  }
+}
+
+int64_t TimerWheel::NextWakeUp() const {
+  if (size_ == 0)
+    return kNoDeadline;
+  int64_t next = kNoDeadline;
+  if (level_size_[0] > 0) {
+    for (int offset = 0; offset < LevelSlots(0); ++offset) {
+      const int64_t ms = current_ms_ + offset;
+      if (slots_[0][ms & (LevelSlots(0) - 1)]) {
+        next = ms;
+        break;
+      }
+    }
+  }
+  for (int level = 1; level < kLevels; ++level) {
+    if (level_size_[level] == 0)
+      continue;
+    const int shift = LevelShift(level);
+    // First slot boundary at or after |current_ms_|.
+    const int64_t first_block =
+        (current_ms_ + (int64_t{1} << shift) - 1) >> shift;
+    for (int offset = 0; offset < LevelSlots(level); ++offset) {
+      const int64_t block = first_block + offset;
+      if (slots_[level][block & (LevelSlots(level) - 1)]) {
+        next = std::min(next, block << shift);
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+}  // namespace webrtc
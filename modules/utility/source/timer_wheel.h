@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_UTILITY_SOURCE_TIMER_WHEEL_H_
+#define MODULES_UTILITY_SOURCE_TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "rtc_base/constructor_magic.h"
+
+namespace webrtc {
+
+// Hierarchical timer wheel with millisecond resolution. Scheduling,
+// cancelling and expiring a timer are O(1); advancing the clock costs one
+// step per elapsed millisecond while timers are pending, plus an occasional
+// cascade of a coarser slot into finer ones.
+//
+// The first level has 256 slots of 1 ms, the second 64 slots of 256 ms and
+// the third 64 slots of 16.384 s. Timers further out than that (~17 minutes)
+// are parked in the last slot of the third level and rescheduled when they
+// are reached.
+//
+// Not thread safe.
+class TimerWheel {
+ public:
+  // Intrusive timer; embed or derive from it. An entry must be cancelled or
+  // have expired before it is destroyed.
+  class Entry {
+   public:
+    Entry() = default;
+    ~Entry() = default;
+
+    bool scheduled() const { return slot_ != nullptr; }
+    int64_t deadline_ms() const { return deadline_ms_; }
+
+   private:
+    friend class TimerWheel;
+
+    int64_t deadline_ms_ = 0;
+    Entry** slot_ = nullptr;
+    int level_ = 0;
+    Entry* prev_ = nullptr;
+    Entry* next_ = nullptr;
+
+    RTC_DISALLOW_COPY_AND_ASSIGN(Entry);
+  };
+
+  static constexpr int64_t kNoDeadline = INT64_MAX;
+
+  explicit TimerWheel(int64_t now_ms);
+  ~TimerWheel();
+
+  // Schedules |entry| to expire at |deadline_ms|, replacing any earlier
+  // deadline. Deadlines in the past expire on the next Advance().
+  void Schedule(Entry* entry, int64_t deadline_ms);
+  void Cancel(Entry* entry);
+
+  // Moves the clock to |now_ms| and appends every entry whose deadline is at
+  // or before |now_ms| to |expired|, in deadline order per millisecond.
+  void Advance(int64_t now_ms, std::vector<Entry*>* expired);
+
+  // Returns a time at which Advance() should be called next: the exact
+  // earliest deadline if it is within the first level, otherwise the time at
+  // which the slot holding it is cascaded. kNoDeadline if nothing is pending.
+  int64_t NextWakeUp() const;
+
+  size_t size() const { return size_; }
+
+ private:
+  static constexpr int kLevels = 3;
+  static constexpr int kLevel0Bits = 8;
+  static constexpr int kLevelNBits = 6;
+
+  static int LevelShift(int level);
+  static int LevelSlots(int level);
+
+  void Insert(Entry* entry);
+  void Unlink(Entry* entry);
+  void Cascade(int level);
+
+  // Next millisecond that has not been expired yet.
+  int64_t current_ms_;
+  size_t size_ = 0;
+  std::vector<Entry*> slots_[kLevels];
+  size_t level_size_[kLevels] = {};
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_UTILITY_SOURCE_TIMER_WHEEL_H_
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/utility/source/timer_wheel.h"
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/random.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+struct TestTimer : public TimerWheel::Entry {};
+
+TEST(TimerWheelTest, ExpiresAtDeadline) {
+  TimerWheel wheel(1000);
+  TestTimer timer;
+  wheel.Schedule(&timer, 1005);
+  EXPECT_EQ(1005, wheel.NextWakeUp());
+
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.Advance(1004, &expired);
+  EXPECT_TRUE(expired.empty());
+  EXPECT_TRUE(timer.scheduled());
+  wheel.Advance(1005, &expired);
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(&timer, expired[0]);
+  EXPECT_FALSE(timer.scheduled());
+  EXPECT_EQ(TimerWheel::kNoDeadline, wheel.NextWakeUp());
+}
+
+TEST(TimerWheelTest, PastDeadlineExpiresOnNextAdvance) {
+  TimerWheel wheel(1000);
+  TestTimer timer;
+  wheel.Schedule(&timer, 10);
+  EXPECT_EQ(1000, wheel.NextWakeUp());
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.Advance(1000, &expired);
+  EXPECT_EQ(1u, expired.size());
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+  TimerWheel wheel(0);
+  TestTimer a, b;
+  wheel.Schedule(&a, 10);
+  wheel.Schedule(&b, 20);
+  wheel.Cancel(&a);
+  EXPECT_FALSE(a.scheduled());
+  EXPECT_EQ(20, wheel.NextWakeUp());
+  wheel.Schedule(&b, 5);
+  EXPECT_EQ(5, wheel.NextWakeUp());
+  EXPECT_EQ(1u, wheel.size());
+
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.Advance(100, &expired);
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(&b, expired[0]);
+}
+
+TEST(TimerWheelTest, SameDeadlineExpiresInScheduleOrder) {
+  TimerWheel wheel(0);
+  TestTimer timers[3];
+  for (auto& timer : timers)
+    wheel.Schedule(&timer, 7);
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.Advance(7, &expired);
+  ASSERT_EQ(3u, expired.size());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(&timers[i], expired[i]);
+}
+
+TEST(TimerWheelTest, NextWakeUpNeverLaterThanEarliestDeadline) {
+  TimerWheel wheel(3);
+  TestTimer near_timer, far_timer;
+  // |far_timer| lands in a coarse slot that is cascaded before |near_timer|,
+  // which sits in the fine level, expires.
+  wheel.Schedule(&near_timer, 250);
+  wheel.Schedule(&far_timer, 260);
+  EXPECT_LE(wheel.NextWakeUp(), 250);
+  std::vector<TimerWheel::Entry*> expired;
+  int64_t now = 3;
+  while (expired.size() < 2) {
+    now = wheel.NextWakeUp();
+    ASSERT_NE(TimerWheel::kNoDeadline, now);
+    wheel.Advance(now, &expired);
+  }
+  EXPECT_EQ(&near_timer, expired[0]);
+  EXPECT_EQ(&far_timer, expired[1]);
+  EXPECT_EQ(260, now);
+}
+
+// Compares against the expected expiry time of randomly scheduled timers,
+// including ones beyond the range of the wheel.
+TEST(TimerWheelTest, RandomTimersExpireOnTime) {
+  static const int kNumTimers = 500;
+  Random random(0x1234);
+  int64_t now = 123456;
+  TimerWheel wheel(now);
+  std::vector<std::unique_ptr<TestTimer>> timers;
+  for (int i = 0; i < kNumTimers; ++i) {
+    timers.push_back(std::unique_ptr<TestTimer>(new TestTimer()));
+    int64_t delay = i % 10 == 0 ? random.Rand(0, 2000000)
+                                : random.Rand(0, 20000);
+    wheel.Schedule(timers.back().get(), now + delay);
+  }
+
+  std::vector<TimerWheel::Entry*> expired;
+  size_t total = 0;
+  while (wheel.size() > 0) {
+    int64_t next = wheel.NextWakeUp();
+    ASSERT_GE(next, now);
+    // Sometimes wake up late, like a busy thread would.
+    now = next + (random.Rand(0, 3) == 0 ? random.Rand(0, 50) : 0);
+    expired.clear();
+    wheel.Advance(now, &expired);
+    for (TimerWheel::Entry* entry : expired) {
+      EXPECT_LE(entry->deadline_ms(), now);
+      // Anything due before |next| should have expired on an earlier call.
+      EXPECT_GE(entry->deadline_ms(), next);
+      ++total;
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumTimers), total);
+}
+
+}  // namespace
+}  // namespace webrtc
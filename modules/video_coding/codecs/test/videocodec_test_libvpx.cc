@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+#include <map>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -20,6 +22,7 @@
 #include "media/engine/simulcast_encoder_adapter.h"
 #include "modules/video_coding/utility/vp8_header_parser.h"
 #include "modules/video_coding/utility/vp9_uncompressed_header_parser.h"
+#include "test/field_trial.h"
 #include "test/gtest.h"
 #include "test/testsupport/file_utils.h"
 
@@ -405,6 +408,57 @@ TEST(VideoCodecTestLibvpx, MAYBE_SimulcastVP8) {
   fixture->RunTest(rate_profiles, &rc_thresholds, &quality_thresholds, nullptr);
 }
 
+// Compares the time from Encode() until the last layer of a frame is
+// delivered, with the simulcast layers encoded serially and in parallel.
+TEST(VideoCodecTestLibvpx, DISABLED_SimulcastVP8EncodeLatency) {
+  printf("--> Summary\n");
+  printf("%8s %14s %14s\n", "mode", "avg_latency_ms", "max_latency_ms");
+  for (bool parallel_encoding : {false, true}) {
+    ScopedFieldTrials field_trials(
+        parallel_encoding
+            ? "WebRTC-SimulcastEncoderAdapter-ParallelEncoding/Enabled/"
+            : "");
+    auto config = CreateConfig();
+    config.filename = "ConferenceMotion_1280_720_50";
+    config.filepath = ResourcePath(config.filename, "yuv");
+    config.num_frames = kNumFramesLong;
+    config.SetCodecSettings(cricket::kVp8CodecName, 3, 1, 3, true, true, false,
+                            1280, 720);
+
+    InternalEncoderFactory internal_encoder_factory;
+    std::unique_ptr<VideoEncoderFactory> adapted_encoder_factory =
+        absl::make_unique<FunctionVideoEncoderFactory>([&]() {
+          return absl::make_unique<SimulcastEncoderAdapter>(
+              &internal_encoder_factory,
+              SdpVideoFormat(cricket::kVp8CodecName));
+        });
+    auto fixture = CreateVideoCodecTestFixture(
+        config, absl::make_unique<InternalDecoderFactory>(),
+        std::move(adapted_encoder_factory));
+
+    std::vector<RateProfile> rate_profiles = {{1500, 30, 0}};
+    fixture->RunTest(rate_profiles, nullptr, nullptr, nullptr);
+
+    // The encode time of each layer is measured from the start of Encode(),
+    // so the latency of a frame is that of its slowest layer.
+    std::map<size_t, size_t> frame_latency_us;
+    for (const auto& frame_stat : fixture->GetStats().GetFrameStatistics()) {
+      size_t& latency_us = frame_latency_us[frame_stat.frame_number];
+      latency_us = std::max(latency_us, frame_stat.encode_time_us);
+    }
+    size_t sum_latency_us = 0;
+    size_t max_latency_us = 0;
+    for (const auto& latency : frame_latency_us) {
+      sum_latency_us += latency.second;
+      max_latency_us = std::max(max_latency_us, latency.second);
+    }
+    ASSERT_FALSE(frame_latency_us.empty());
+    printf("%8s %14.2f %14.2f\n", parallel_encoding ? "parallel" : "serial",
+           sum_latency_us / 1000.0 / frame_latency_us.size(),
+           max_latency_us / 1000.0);
+  }
+}
+
 #if defined(WEBRTC_ANDROID)
 #define MAYBE_SvcVP9 DISABLED_SvcVP9
 #else
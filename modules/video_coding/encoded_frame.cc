@@ -165,7 +165,12 @@ void VCMEncodedFrame::VerifyAndAllocate(size_t minimumSize) {
     // TODO(nisse): EncodedImage::Allocate is implemented as
     // std::vector::resize, which means that old contents is kept. Find out if
     // any code depends on that behavior.
+    const uint8_t* unowned_data = buffer();
     Allocate(minimumSize);
+    // Allocate() doesn't keep the contents of a buffer we don't own, e.g. a
+    // bitstream referenced in a PayloadSlab.
+    if (unowned_data && size() > 0)
+      memcpy(data(), unowned_data, size());
   }
 }
 
@@ -54,9 +54,18 @@ RtpFrameObject::RtpFrameObject(PacketBuffer* packet_buffer,
   // as of the first packet's.
   SetPlayoutDelay(first_packet->video_header.playout_delay);
 
-  AllocateBitstreamBuffer(frame_size);
-  bool bitstream_copied = packet_buffer_->GetBitstream(*this, data());
-  RTC_DCHECK(bitstream_copied);
+  const uint8_t* bitstream =
+      packet_buffer_->GetContiguousBitstream(*this, &payload_slab_);
+  if (bitstream) {
+    // The slab is kept alive by |payload_slab_|, and this part of it isn't
+    // used by any other frame.
+    set_buffer(const_cast<uint8_t*>(bitstream), frame_size);
+    set_size(frame_size);
+  } else {
+    AllocateBitstreamBuffer(frame_size);
+    bool bitstream_copied = packet_buffer_->GetBitstream(*this, data());
+    RTC_DCHECK(bitstream_copied);
+  }
   _encodedWidth = first_packet->width();
   _encodedHeight = first_packet->height();
 
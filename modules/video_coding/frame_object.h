@@ -20,6 +20,7 @@ namespace webrtc {
 namespace video_coding {
 
 class PacketBuffer;
+class PayloadSlab;
 
 class RtpFrameObject : public EncodedFrame {
  public:
@@ -48,6 +49,8 @@ class RtpFrameObject : public EncodedFrame {
   void AllocateBitstreamBuffer(size_t frame_size);
 
   rtc::scoped_refptr<PacketBuffer> packet_buffer_;
+  // Holds the bitstream if it is referenced in place rather than copied.
+  rtc::scoped_refptr<PayloadSlab> payload_slab_;
   VideoFrameType frame_type_;
   VideoCodecType codec_type_;
   uint16_t first_seq_num_;
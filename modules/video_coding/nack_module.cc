@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <utility>
 
 #include "modules/video_coding/nack_module.h"
 
@@ -30,6 +31,11 @@ const int kProcessIntervalMs = 1000 / kProcessFrequency;
 const int kMaxReorderedPackets = 128;
 const int kNumReorderingBuckets = 10;
 const int kDefaultSendNackDelayMs = 0;
+// The nack list only holds packets at most |kMaxPacketAge| older than the
+// newest one, so it never needs to grow beyond this.
+const size_t kInitialNackListSize = 64;
+const size_t kMaxNackListSize = 16384;
+static_assert(kMaxNackListSize > kMaxPacketAge, "");
 
 int64_t GetSendNackDelay() {
   int64_t delay_ms = strtol(
@@ -41,10 +47,30 @@ int64_t GetSendNackDelay() {
   }
   return kDefaultSendNackDelayMs;
 }
+
+// Inserts |seq_num| into |list|, which is in ascending order.
+void InsertSorted(std::deque<uint16_t>* list, uint16_t seq_num) {
+  auto it = std::lower_bound(list->begin(), list->end(), seq_num,
+                             DescendingSeqNumComp<uint16_t>());
+  if (it == list->end() || *it != seq_num)
+    list->insert(it, seq_num);
+}
+
+// Removes the sequence numbers older than |seq_num| from |list|, which is in
+// ascending order.
+void RemoveBefore(std::deque<uint16_t>* list, uint16_t seq_num) {
+  while (!list->empty() && AheadOf(seq_num, list->front()))
+    list->pop_front();
+}
 }  // namespace
 
 NackModule::NackInfo::NackInfo()
-    : seq_num(0), send_at_seq_num(0), sent_at_time(-1), retries(0) {}
+    : seq_num(0),
+      send_at_seq_num(0),
+      created_at_time(-1),
+      sent_at_time(-1),
+      retries(0),
+      used(false) {}
 
 NackModule::NackInfo::NackInfo(uint16_t seq_num,
                                uint16_t send_at_seq_num,
@@ -53,7 +79,8 @@ NackModule::NackInfo::NackInfo(uint16_t seq_num,
       send_at_seq_num(send_at_seq_num),
       created_at_time(created_at_time),
       sent_at_time(-1),
-      retries(0) {}
+      retries(0),
+      used(true) {}
 
 NackModule::NackModule(Clock* clock,
                        NackSender* nack_sender,
@@ -61,6 +88,9 @@ NackModule::NackModule(Clock* clock,
     : clock_(clock),
       nack_sender_(nack_sender),
       keyframe_request_sender_(keyframe_request_sender),
+      nack_list_size_(0),
+      nack_list_first_seq_num_(0),
+      nack_list_last_seq_num_(0),
       reordering_histogram_(kNumReorderingBuckets, kMaxReorderedPackets),
       initialized_(false),
       rtt_ms_(kDefaultRttMs),
@@ -92,7 +122,7 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_rec
     newest_seq_num_ = seq_num;
 	if (is_keyframe)// 这个包是否关键帧===》》 为什么要识别关键帧？？？
 	{   // TODO@chensong 2023-03-29   WebRTC中为什么要把关键针插入keyframe_list_表中   为什么要所有keyframe_list表
-		keyframe_list_.insert(seq_num);
+		InsertSorted(&keyframe_list_, seq_num);
 	}
     initialized_ = true;
     return 0;
@@ -113,12 +143,12 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_rec
   {
 	  // TODO@chensong 2023-03-29  // 说明这个包晚到达了 
     // An out of order packet has been received.
-    auto nack_list_it = nack_list_.find(seq_num);
+    NackInfo* nack_info = FindNack(seq_num);
     int nacks_sent_for_packet = 0;
-    if (nack_list_it != nack_list_.end())
+    if (nack_info)
 	{
-      nacks_sent_for_packet = nack_list_it->second.retries;
-      nack_list_.erase(nack_list_it);
+      nacks_sent_for_packet = nack_info->retries;
+      RemoveNack(nack_info);
     }
 	if (!is_retransmitted)
 	{
@@ -132,31 +162,23 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_rec
   // 4. 如果判断是否是key帧？？？ 哈
   if (is_keyframe)
   {
-    keyframe_list_.insert(seq_num);  // 如果该报属于key帧， 保持起来
+    InsertSorted(&keyframe_list_, seq_num);  // 如果该报属于key帧， 保持起来
   }
 
   // And remove old ones so we don't accumulate keyframes.
   // TODO@chensong 2022-05-30 
   // 5. 找到最小边界点，   超出10000个就要删除之前的数据 ， 这个是实时系统
-  auto it = keyframe_list_.lower_bound(seq_num - kMaxPacketAge/*10000*/);
-  if (it != keyframe_list_.begin())
-  {
-    keyframe_list_.erase(keyframe_list_.begin(), it);
-  }
+  RemoveBefore(&keyframe_list_, seq_num - kMaxPacketAge/*10000*/);
   // TODO@chensong 2022-05-30 
   // 6. 如何判断是否找回来的包？？？  恢复包
   if (is_recovered) 
   {
-    recovered_list_.insert(seq_num);   // TODO@chensong 2022-05-30 // 如果该包是属于key帧，保持起来
+    InsertSorted(&recovered_list_, seq_num);   // TODO@chensong 2022-05-30 // 如果该包是属于key帧，保持起来
 
     // Remove old ones so we don't accumulate recovered packets.
     // TODO@chensong 2022-05-30
 	//  是否超出项 超出项也删除了  ， 最大项也是10000哈
-    auto it = recovered_list_.lower_bound(seq_num - kMaxPacketAge/*10000*/);
-	if (it != recovered_list_.begin())
-	{
-      recovered_list_.erase(recovered_list_.begin(), it);
-	}
+    RemoveBefore(&recovered_list_, seq_num - kMaxPacketAge/*10000*/);
 
     // Do not send nack for packets recovered by FEC or RTX.
     return 0;
@@ -188,9 +210,9 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_rec
 void NackModule::ClearUpTo(uint16_t seq_num) 
 {
   rtc::CritScope lock(&crit_);
-  nack_list_.erase(nack_list_.begin(), nack_list_.lower_bound(seq_num));
-  keyframe_list_.erase(keyframe_list_.begin(), keyframe_list_.lower_bound(seq_num));
-  recovered_list_.erase(recovered_list_.begin(), recovered_list_.lower_bound(seq_num));
+  RemoveNacksBefore(seq_num);
+  RemoveBefore(&keyframe_list_, seq_num);
+  RemoveBefore(&recovered_list_, seq_num);
 }
 
 void NackModule::UpdateRtt(int64_t rtt_ms) {
@@ -200,7 +222,7 @@ void NackModule::UpdateRtt(int64_t rtt_ms) {
 
 void NackModule::Clear() {
   rtc::CritScope lock(&crit_);
-  nack_list_.clear();
+  ClearNackList();
   keyframe_list_.clear();
   recovered_list_.clear();
 }
@@ -255,18 +277,18 @@ bool NackModule::RemovePacketsUntilKeyFrame()
 	// TODO@chensong 2023-03-29 移除所有的包
   while (!keyframe_list_.empty()) 
   {
-    auto it = nack_list_.lower_bound(*keyframe_list_.begin());
-    if (it != nack_list_.begin()) 
+    if (nack_list_size_ > 0 &&
+        AheadOf(keyframe_list_.front(), nack_list_first_seq_num_))
 	{
       // We have found a keyframe that actually is newer than at least one
       // packet in the nack list.
-      nack_list_.erase(nack_list_.begin(), it);
+      RemoveNacksBefore(keyframe_list_.front());
       return true;
     }
 
     // If this keyframe is so old it does not remove any packets from the list,
     // remove it from the list of keyframes and try the next keyframe.
-    keyframe_list_.erase(keyframe_list_.begin());
+    keyframe_list_.pop_front();
   }
   return false;
 }
@@ -274,8 +296,7 @@ bool NackModule::RemovePacketsUntilKeyFrame()
 void NackModule::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end) 
 {
   // Remove old packets.
-  auto it = nack_list_.lower_bound(seq_num_end - kMaxPacketAge);
-  nack_list_.erase(nack_list_.begin(), it);
+  RemoveNacksBefore(seq_num_end - kMaxPacketAge);
 
   // If the nack list is too large, remove packets from the nack list until
   // the latest first packet of a keyframe. If the list is still too large,
@@ -283,16 +304,16 @@ void NackModule::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end)
   // TODO@chensong 2022-05-30
   // 1. 开始到结束之间有多大距离 
   uint16_t num_new_nacks = ForwardDiff(seq_num_start, seq_num_end);
-  if (nack_list_.size() + num_new_nacks > kMaxNackPackets) 
+  if (nack_list_size_ + num_new_nacks > kMaxNackPackets) 
   {
-    while (RemovePacketsUntilKeyFrame() && nack_list_.size() + num_new_nacks > kMaxNackPackets)
+    while (RemovePacketsUntilKeyFrame() && nack_list_size_ + num_new_nacks > kMaxNackPackets)
 	{ }
     // TODO@chensong 2022-05-30
 	// 1.1、 极端情况  没有删除， 就要清除nack， 然后发送请求关键帧给对方  让解码器从新工作哈  
 	// TODO@chensong 2022-12-20  mediasoup 在业务层做了请求关键帧  ？？？ ====> 需要清除缓存的 和下面一样的步骤 这样的设计挺好的哈 ^_^ 
-    if (nack_list_.size() + num_new_nacks > kMaxNackPackets) 
+    if (nack_list_size_ + num_new_nacks > kMaxNackPackets) 
 	{
-      nack_list_.clear();
+      ClearNackList();
       RTC_LOG(LS_WARNING) << "NACK list full, clearing NACK"
                              " list and requesting keyframe.";
       keyframe_request_sender_->RequestKeyFrame();
@@ -301,22 +322,32 @@ void NackModule::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end)
   }
   // TODO@chensong 2022-05-30
   // 2、 遍历seq_num_start 到seq_num_end 之间 是否有丢包 有的话 就放到nack_list_中哈
+  auto recovered_it =
+      std::lower_bound(recovered_list_.begin(), recovered_list_.end(),
+                       seq_num_start, DescendingSeqNumComp<uint16_t>());
   for (uint16_t seq_num = seq_num_start; seq_num != seq_num_end; ++seq_num) 
   {
     // Do not send nack for packets that are already recovered by FEC or RTX
     // TODO@chensong 2022-05-30
 	// 2.1 是否已经通过FEC或者RTX恢复了 该包 恢复了 就不需要放到nack_list_列表中去哈
-	if (recovered_list_.find(seq_num) != recovered_list_.end())
+    while (recovered_it != recovered_list_.end() &&
+           AheadOf(seq_num, *recovered_it)) {
+      ++recovered_it;
+    }
+	if (recovered_it != recovered_list_.end() && *recovered_it == seq_num)
 	{
       continue;
 	}
     NackInfo nack_info(seq_num, seq_num + WaitNumberOfPackets(0.5), clock_->TimeInMilliseconds());
-    RTC_DCHECK(nack_list_.find(seq_num) == nack_list_.end());
-    nack_list_[seq_num] = nack_info;
+    RTC_DCHECK(!FindNack(seq_num));
+    AddNack(nack_info);
+    unsent_nacks_.push_back(seq_num);
   }
 }
 // TODO@chensong 2022-05-30
 // 遍历所有可疑包 如果包符合条件 就插入nack_batch中
+// Only packets that can be due are looked at: those never nacked, and those
+// nacked at least an RTT ago, which are at the front of |sent_nacks_|.
 std::vector<uint16_t> NackModule::GetNackBatch(NackFilterOptions options) 
 {
   // TODO@chensong 2022-05-30
@@ -326,48 +357,150 @@ std::vector<uint16_t> NackModule::GetNackBatch(NackFilterOptions options)
   // 2. 标识以timestamp为判断条件 
   bool consider_timestamp = options != kSeqNumOnly;
   int64_t now_ms = clock_->TimeInMilliseconds();
-  std::vector<uint16_t> nack_batch;
-  auto it = nack_list_.begin();
-  while (it != nack_list_.end()) 
-  {
+  std::vector<NackInfo*> due_nacks;
+
+  // Packets that have never been nacked. Since they were added in order,
+  // the send delay times out for them in order as well.
+  while (!unsent_nacks_.empty()) {
+    NackInfo* nack_info = FindNack(unsent_nacks_.front());
+    if (nack_info && nack_info->sent_at_time == -1)
+      break;
+    unsent_nacks_.pop_front();
+  }
+  for (uint16_t seq_num : unsent_nacks_) {
+    NackInfo* nack_info = FindNack(seq_num);
+    if (!nack_info || nack_info->sent_at_time != -1)
+      continue;
     // TODO@chensong 2022-05-30
 	  // 1. send_nack_delay_ms_ 默认为0 ， 可修改
-    bool delay_timed_out = now_ms - it->second.created_at_time >= send_nack_delay_ms_;
+    bool delay_timed_out =
+        now_ms - nack_info->created_at_time >= send_nack_delay_ms_;
+    if (!delay_timed_out)
+      break;
     // TODO@chensong 2022-05-30
 	// 2. 从一次发送开始到现在， 是否超过了一个RTT的回路的时长 时间  
 	// 需要得到一个RTT防止重复传送的情况 
-    bool nack_on_rtt_passed = now_ms - it->second.sent_at_time >= rtt_ms_;
+    bool nack_on_rtt_passed = now_ms - nack_info->sent_at_time >= rtt_ms_;
     // TODO@chensong 2022-05-30
 	// 3、 第一次发送和最后处理包之前的
-    bool nack_on_seq_num_passed = it->second.sent_at_time /*TODO@chensong 2022-05-30 如果是第一次发送*/== -1 &&
-        AheadOrAt(newest_seq_num_, it->second.send_at_seq_num)/*TODO@chensong 2022-05-30 该包在最后处理的包之前*/;
+    bool nack_on_seq_num_passed =
+        AheadOrAt(newest_seq_num_, nack_info->send_at_seq_num);
+    if ((consider_seq_num && nack_on_seq_num_passed) ||
+        (consider_timestamp && nack_on_rtt_passed)) {
+      due_nacks.push_back(nack_info);
+    }
+  }
+
+  // Packets that have been nacked before are only due once an RTT has passed.
+  while (!sent_nacks_.empty()) {
+    const SentNack& sent_nack = sent_nacks_.front();
+    NackInfo* nack_info = FindNack(sent_nack.seq_num);
+    if (nack_info && nack_info->sent_at_time == sent_nack.sent_at_time) {
+      if (!consider_timestamp || now_ms - sent_nack.sent_at_time < rtt_ms_)
+        break;
+      due_nacks.push_back(nack_info);
+    }
+    sent_nacks_.pop_front();
+  }
+
+  // Nack in ascending order, as if the whole nack list was walked.
+  std::sort(due_nacks.begin(), due_nacks.end(),
+            [](const NackInfo* a, const NackInfo* b) {
+              return AheadOf(b->seq_num, a->seq_num);
+            });
+  std::vector<uint16_t> nack_batch;
+  nack_batch.reserve(due_nacks.size());
+  for (NackInfo* nack_info : due_nacks) {
+    nack_batch.emplace_back(nack_info->seq_num);
+    ++nack_info->retries;
+    nack_info->sent_at_time = now_ms;
     // TODO@chensong 2022-05-30
-	// 符合条件
-	//   1. seq 为判断条件
-	//   2. rtt即时间为判断条件
-    if (delay_timed_out && ((consider_seq_num && nack_on_seq_num_passed) || (consider_timestamp && nack_on_rtt_passed))) 
-	{
-      nack_batch.emplace_back(it->second.seq_num);
-      ++it->second.retries;
-      it->second.sent_at_time = now_ms;
-      // TODO@chensong 2022-05-30
 	  // 尝试10次 在nack_list列表中没有发现 就要删除了
-      if (it->second.retries >= kMaxNackRetries/*kMaxNackRetries= 10*/) 
+    if (nack_info->retries >= kMaxNackRetries/*kMaxNackRetries= 10*/) 
 	  {
-        RTC_LOG(LS_WARNING) << "Sequence number " << it->second.seq_num << " removed from NACK list due to max retries.";
-        it = nack_list_.erase(it);
-      } 
+      RTC_LOG(LS_WARNING) << "Sequence number " << nack_info->seq_num << " removed from NACK list due to max retries.";
+      RemoveNack(nack_info);
+    } 
 	  else 
 	  {
-        ++it;
-      }
-      continue;
+      sent_nacks_.push_back(SentNack{nack_info->seq_num, now_ms});
     }
-    ++it;
   }
   return nack_batch;
 }
 
+NackModule::NackInfo* NackModule::FindNack(uint16_t seq_num) {
+  if (nack_list_size_ == 0 || AheadOf(nack_list_first_seq_num_, seq_num) ||
+      AheadOf(seq_num, nack_list_last_seq_num_)) {
+    return nullptr;
+  }
+  NackInfo& nack_info = nack_list_[seq_num & (nack_list_.size() - 1)];
+  return nack_info.used && nack_info.seq_num == seq_num ? &nack_info : nullptr;
+}
+
+void NackModule::AddNack(const NackInfo& nack_info) {
+  if (nack_list_size_ == 0) {
+    nack_list_first_seq_num_ = nack_info.seq_num;
+  } else {
+    RTC_DCHECK(AheadOf(nack_info.seq_num, nack_list_last_seq_num_));
+  }
+  size_t span = ForwardDiff(nack_list_first_seq_num_, nack_info.seq_num) + 1;
+  if (span > nack_list_.size())
+    ExpandNackList(span);
+  nack_list_[nack_info.seq_num & (nack_list_.size() - 1)] = nack_info;
+  nack_list_last_seq_num_ = nack_info.seq_num;
+  ++nack_list_size_;
+}
+
+void NackModule::RemoveNack(NackInfo* nack_info) {
+  RTC_DCHECK(nack_info->used);
+  nack_info->used = false;
+  if (--nack_list_size_ == 0)
+    return;
+  const size_t mask = nack_list_.size() - 1;
+  // Keep both ends of the list at packets in use.
+  if (nack_info->seq_num == nack_list_first_seq_num_) {
+    do {
+      ++nack_list_first_seq_num_;
+    } while (!nack_list_[nack_list_first_seq_num_ & mask].used);
+  } else if (nack_info->seq_num == nack_list_last_seq_num_) {
+    do {
+      --nack_list_last_seq_num_;
+    } while (!nack_list_[nack_list_last_seq_num_ & mask].used);
+  }
+}
+
+void NackModule::RemoveNacksBefore(uint16_t seq_num) {
+  if (nack_list_size_ > 0 && AheadOf(seq_num, nack_list_last_seq_num_)) {
+    ClearNackList();
+    return;
+  }
+  while (nack_list_size_ > 0 && AheadOf(seq_num, nack_list_first_seq_num_))
+    RemoveNack(&nack_list_[nack_list_first_seq_num_ & (nack_list_.size() - 1)]);
+}
+
+void NackModule::ClearNackList() {
+  // Shrinks the list back after a loss burst.
+  nack_list_.clear();
+  nack_list_.shrink_to_fit();
+  nack_list_size_ = 0;
+  unsent_nacks_.clear();
+  sent_nacks_.clear();
+}
+
+void NackModule::ExpandNackList(size_t span) {
+  RTC_DCHECK_LE(span, kMaxNackListSize);
+  size_t new_size = std::max(nack_list_.size(), kInitialNackListSize);
+  while (new_size < span)
+    new_size *= 2;
+  std::vector<NackInfo> new_nack_list(new_size);
+  for (const NackInfo& nack_info : nack_list_) {
+    if (nack_info.used)
+      new_nack_list[nack_info.seq_num & (new_size - 1)] = nack_info;
+  }
+  nack_list_ = std::move(new_nack_list);
+}
+
 void NackModule::UpdateReorderingStatistics(uint16_t seq_num) {
   RTC_DCHECK(AheadOf(newest_seq_num_, seq_num));
   uint16_t diff = ReverseDiff(newest_seq_num_, seq_num);
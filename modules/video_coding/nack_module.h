@@ -12,8 +12,7 @@
 #define MODULES_VIDEO_CODING_NACK_MODULE_H_
 
 #include <stdint.h>
-#include <map>
-#include <set>
+#include <deque>
 #include <vector>
 
 #include "modules/include/module.h"
@@ -62,7 +61,27 @@ class NackModule : public Module {
     int64_t created_at_time;
     int64_t sent_at_time;
     int retries;
+    // If this slot of |nack_list_| holds a packet to be nacked.
+    bool used;
   };
+
+  // A nacked packet, and when it was nacked.
+  struct SentNack {
+    uint16_t seq_num;
+    int64_t sent_at_time;
+  };
+
+  // Returns the packet with |seq_num| in the nack list, or null.
+  NackInfo* FindNack(uint16_t seq_num) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Adds a packet newer than all packets in the nack list.
+  void AddNack(const NackInfo& nack_info) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void RemoveNack(NackInfo* nack_info) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Removes the packets older than |seq_num| from the nack list.
+  void RemoveNacksBefore(uint16_t seq_num) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void ClearNackList() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Grows |nack_list_| to hold at least |span| consecutive sequence numbers.
+  void ExpandNackList(size_t span) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
   void AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Removes packets from the nack list until the next keyframe. Returns true
@@ -89,11 +108,26 @@ class NackModule : public Module {
   // known thread (e.g. see |initialized_|). Those probably do not need
   // synchronized access.
   // TODO@chensong 2023-03-30   掉包nack_list  的数据
-  std::map<uint16_t, NackInfo, DescendingSeqNumComp<uint16_t>> nack_list_ RTC_GUARDED_BY(crit_);
+  // Circular buffer indexed by sequence number. Its size is a power of two
+  // that covers the sequence numbers from |nack_list_first_seq_num_| to
+  // |nack_list_last_seq_num_|, which are both in use unless the list is empty.
+  std::vector<NackInfo> nack_list_ RTC_GUARDED_BY(crit_);
+  size_t nack_list_size_ RTC_GUARDED_BY(crit_);
+  uint16_t nack_list_first_seq_num_ RTC_GUARDED_BY(crit_);
+  uint16_t nack_list_last_seq_num_ RTC_GUARDED_BY(crit_);
+  // Packets in the nack list that haven't been nacked yet, in ascending order.
+  // May hold packets that have since been nacked or removed.
+  std::deque<uint16_t> unsent_nacks_ RTC_GUARDED_BY(crit_);
+  // Nacked packets in the order they were nacked, which is also the order in
+  // which they are due to be nacked again. May hold packets that have since
+  // been nacked again or removed.
+  std::deque<SentNack> sent_nacks_ RTC_GUARDED_BY(crit_);
   // TODO@chensong 2023-03-30  接受到keyframe_list 表的数据
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> keyframe_list_ RTC_GUARDED_BY(crit_);
+  // Sequence numbers in ascending order.
+  std::deque<uint16_t> keyframe_list_ RTC_GUARDED_BY(crit_);
   // TODO@chensong 2023-03-30  恢复包的数据
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> recovered_list_ RTC_GUARDED_BY(crit_);
+  // Sequence numbers in ascending order.
+  std::deque<uint16_t> recovered_list_ RTC_GUARDED_BY(crit_);
   // TODO@chensong 2023-03-30 视频编码发送接受数据的统计
   video_coding::Histogram reordering_histogram_ RTC_GUARDED_BY(crit_);
   // TODO@chensong 2023-03-30  接受包的是否初始化过了
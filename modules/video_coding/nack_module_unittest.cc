@@ -8,11 +8,19 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdio.h>
+
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "modules/video_coding/nack_module.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/field_trial.h"
 #include "test/gtest.h"
@@ -292,6 +300,112 @@ TEST_F(TestNackModule, SendNackWithoutDelay) {
   EXPECT_EQ(99u, sent_nacks_.size());
 }
 
+TEST_F(TestNackModule, GrowsNackList) {
+  // The nack list starts out with room for 64 packets. Grow it twice while
+  // it holds packets, and check that none of them is lost.
+  nack_module_.OnReceivedPacket(0, false, false);
+  nack_module_.OnReceivedPacket(10, false, false);
+  nack_module_.OnReceivedPacket(100, false, false);
+  nack_module_.OnReceivedPacket(300, false, false);
+  std::vector<uint16_t> expected;
+  for (uint16_t seq_num = 1; seq_num < 300; ++seq_num) {
+    if (seq_num != 10 && seq_num != 100)
+      expected.push_back(seq_num);
+  }
+  EXPECT_EQ(expected, sent_nacks_);
+
+  nack_module_.OnReceivedPacket(5, false, false);
+  nack_module_.OnReceivedPacket(200, false, false);
+  expected.erase(std::find(expected.begin(), expected.end(), 5));
+  expected.erase(std::find(expected.begin(), expected.end(), 200));
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(expected, sent_nacks_);
+}
+
+TEST_F(TestNackModule, GrowsNackListAcrossWrap) {
+  nack_module_.OnReceivedPacket(0xffc0, false, false);
+  nack_module_.OnReceivedPacket(100, false, false);
+  std::vector<uint16_t> expected;
+  for (uint16_t seq_num = 0xffc1; seq_num != 100; ++seq_num)
+    expected.push_back(seq_num);
+  EXPECT_EQ(expected, sent_nacks_);
+
+  // Receive the packets on both sides of the wrap out of order.
+  nack_module_.OnReceivedPacket(0xffff, false, false);
+  nack_module_.OnReceivedPacket(0, false, false);
+  expected.erase(std::find(expected.begin(), expected.end(), 0xffff));
+  expected.erase(std::find(expected.begin(), expected.end(), 0));
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(expected, sent_nacks_);
+
+  expected.clear();
+  for (uint16_t seq_num = 50; seq_num < 100; ++seq_num)
+    expected.push_back(seq_num);
+  sent_nacks_.clear();
+  nack_module_.ClearUpTo(50);
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(expected, sent_nacks_);
+}
+
+TEST_F(TestNackModule, DoesNotNackRemovedPacketsAgain) {
+  nack_module_.OnReceivedPacket(0, false, false);
+  nack_module_.OnReceivedPacket(10, false, false);
+  EXPECT_EQ(9u, sent_nacks_.size());
+
+  // Remove nacked packets both out of order and with ClearUpTo().
+  nack_module_.OnReceivedPacket(7, false, false);
+  nack_module_.ClearUpTo(5);
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(std::vector<uint16_t>({5, 6, 8, 9}), sent_nacks_);
+
+  // The new packets reuse the slots of the removed ones, and are nacked at
+  // the same time as those were last nacked. Each is still nacked once.
+  nack_module_.OnReceivedPacket(70, false, false);
+  std::vector<uint16_t> expected = {5, 6, 8, 9};
+  for (uint16_t seq_num = 11; seq_num < 70; ++seq_num)
+    expected.push_back(seq_num);
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(expected, sent_nacks_);
+}
+
+TEST_F(TestNackModule, RemovesPacketsUntilKeyFrame) {
+  nack_module_.OnReceivedPacket(0, true, false);
+  nack_module_.OnReceivedPacket(100, true, false);
+  nack_module_.OnReceivedPacket(600, true, false);
+  EXPECT_EQ(598u, sent_nacks_.size());
+
+  // Too many packets to nack. Keyframe 0 removes nothing and is dropped,
+  // keyframe 100 removes enough.
+  sent_nacks_.clear();
+  nack_module_.OnReceivedPacket(1050, false, false);
+  EXPECT_EQ(449u, sent_nacks_.size());
+
+  // Again. Keyframe 100 removes nothing any more, keyframe 600 does.
+  sent_nacks_.clear();
+  nack_module_.OnReceivedPacket(1600, false, false);
+  EXPECT_EQ(549u, sent_nacks_.size());
+  EXPECT_EQ(0, keyframes_requested_);
+
+  std::vector<uint16_t> expected;
+  for (uint16_t seq_num = 601; seq_num < 1600; ++seq_num) {
+    if (seq_num != 1050)
+      expected.push_back(seq_num);
+  }
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(expected, sent_nacks_);
+}
+
 class TestNackModuleWithFieldTrial : public ::testing::Test,
                                      public NackSender,
                                      public KeyFrameRequestSender {
@@ -327,4 +441,69 @@ TEST_F(TestNackModuleWithFieldTrial, SendNackWithDelay) {
   nack_module_.OnReceivedPacket(109, false, false);
   EXPECT_EQ(104u, sent_nacks_.size());
 }
+
+TEST_F(TestNackModuleWithFieldTrial, DoesNotNackPacketsRemovedBeforeDelay) {
+  nack_module_.OnReceivedPacket(0, false, false);
+  nack_module_.OnReceivedPacket(10, false, false);
+  EXPECT_EQ(0u, sent_nacks_.size());
+
+  // Remove packets that are still waiting for the send delay.
+  nack_module_.OnReceivedPacket(4, false, false);
+  nack_module_.ClearUpTo(3);
+  clock_->AdvanceTimeMilliseconds(10);
+  nack_module_.OnReceivedPacket(11, false, false);
+  EXPECT_EQ(std::vector<uint16_t>({3, 5, 6, 7, 8, 9}), sent_nacks_);
+
+  sent_nacks_.clear();
+  clock_->AdvanceTimeMilliseconds(100);
+  nack_module_.Process();
+  EXPECT_EQ(std::vector<uint16_t>({3, 5, 6, 7, 8, 9}), sent_nacks_);
+}
+
+// Receives a 5000 packets/s stream with 25% random loss over a 300 ms RTT
+// link, where only two thirds of the retransmissions make it, so the nack
+// list stays long and most of it is waiting for an RTT to pass. Run manually,
+// e.g. with --gtest_also_run_disabled_tests --gtest_filter=*Performance*.
+TEST_F(TestNackModule, DISABLED_LossStormPerformance) {
+  static const int kPacketsPerMs = 5;
+  static const int kDurationMs = 60000;
+  static const int kRttMs = 300;
+  static const int kProcessIntervalMs = 20;
+  Random random(0x4e41434b);
+  nack_module_.UpdateRtt(kRttMs);
+  // Retransmissions in flight, in order of arrival time.
+  std::deque<std::pair<int64_t, uint16_t>> retransmissions;
+  uint16_t seq_num = 0;
+  int64_t num_nacks = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int ms = 0; ms < kDurationMs; ++ms) {
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    for (int i = 0; i < kPacketsPerMs; ++i, ++seq_num) {
+      if (random.Rand(0, 99) >= 25)
+        nack_module_.OnReceivedPacket(seq_num, false, false);
+    }
+    while (!retransmissions.empty() &&
+           retransmissions.front().first <= now_ms) {
+      nack_module_.OnReceivedPacket(retransmissions.front().second, false,
+                                    false);
+      retransmissions.pop_front();
+    }
+    if (ms % kProcessIntervalMs == 0)
+      nack_module_.Process();
+    for (uint16_t nacked_seq_num : sent_nacks_) {
+      if (random.Rand(0, 2) != 0)
+        retransmissions.emplace_back(now_ms + kRttMs, nacked_seq_num);
+    }
+    num_nacks += sent_nacks_.size();
+    sent_nacks_.clear();
+    clock_->AdvanceTimeMilliseconds(1);
+  }
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  const double num_packets = static_cast<double>(kPacketsPerMs) * kDurationMs;
+  printf("%.0f packets, %lld nacks: %.1f ns per packet, %.2f%% of real time\n",
+         num_packets, static_cast<long long>(num_nacks),
+         elapsed_us * 1000.0 / num_packets,
+         100.0 * elapsed_us / (kDurationMs * 1000.0));
+}
+
 }  // namespace webrtc
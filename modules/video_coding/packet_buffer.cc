@@ -25,12 +25,37 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/mod_ops.h"
+#include "rtc_base/ref_counted_object.h"
 #include "system_wrappers/include/clock.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
 namespace video_coding {
 
+namespace {
+
+// Bounds for the size of a PayloadSlab, which is otherwise a few times the
+// largest frame seen.
+const size_t kMinSlabSize = 64 * 1024;
+const size_t kMaxSlabSize = 4 * 1024 * 1024;
+const size_t kFramesPerSlab = 4;
+
+}  // namespace
+
+PayloadSlab::PayloadSlab(size_t capacity)
+    : data_(new uint8_t[capacity]), capacity_(capacity) {}
+
+PayloadSlab::~PayloadSlab() = default;
+
+const uint8_t* PayloadSlab::Append(const uint8_t* data, size_t size) {
+  if (size > capacity_ - size_)
+    return nullptr;
+  uint8_t* destination = data_.get() + size_;
+  memcpy(destination, data, size);
+  size_ += size;
+  return destination;
+}
+
 rtc::scoped_refptr<PacketBuffer> PacketBuffer::Create(
     Clock* clock,
     size_t start_buffer_size,
@@ -51,6 +76,7 @@ PacketBuffer::PacketBuffer(Clock* clock,
       first_packet_received_(false),
       is_cleared_to_first_seq_num_(false),
       data_buffer_(start_buffer_size),
+      payload_slabs_(start_buffer_size),
       sequence_buffer_(start_buffer_size),
       assembled_frame_callback_(assembled_frame_callback),
       unique_frames_seen_(0),
@@ -67,6 +93,21 @@ PacketBuffer::~PacketBuffer() {
 }
 
 bool PacketBuffer::InsertPacket(VCMPacket* packet) {
+  return InsertPacketInternal(packet, /*copy_payload=*/false);
+}
+
+bool PacketBuffer::CopyAndInsertPacket(VCMPacket* packet) {
+  return InsertPacketInternal(packet, /*copy_payload=*/true);
+}
+
+bool PacketBuffer::InsertPacketInternal(VCMPacket* packet, bool copy_payload) {
+  // Drops a payload that isn't inserted.
+  auto discard_payload = [packet, copy_payload] {
+    if (!copy_payload)
+      delete[] packet->dataPtr;
+    packet->dataPtr = nullptr;
+  };
+
   std::vector<std::unique_ptr<RtpFrameObject>> found_frames;
   {
     rtc::CritScope lock(&crit_);
@@ -83,8 +124,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
       // If we have explicitly cleared past this packet then it's old,
       // don't insert it.
       if (is_cleared_to_first_seq_num_) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        discard_payload();
         return false;
       }
 
@@ -94,8 +134,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
     if (sequence_buffer_[index].used) {
       // Duplicate packet, just delete the payload.
       if (data_buffer_[index].seqNum == packet->seqNum) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        discard_payload();
         return true;
       }
 
@@ -106,8 +145,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
 
       // Packet buffer is still full.
       if (sequence_buffer_[index].used) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        discard_payload();
         return false;
       }
     }
@@ -118,6 +156,26 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
     sequence_buffer_[index].continuous = false;
     sequence_buffer_[index].frame_created = false;
     sequence_buffer_[index].used = true;
+    payload_slabs_[index] = nullptr;
+    if (copy_payload && packet->sizeBytes > 0) {
+      const uint8_t* payload =
+          current_slab_ ? current_slab_->Append(packet->dataPtr,
+                                                packet->sizeBytes)
+                        : nullptr;
+      if (!payload) {
+        size_t slab_size =
+            std::min(std::max(kFramesPerSlab * largest_frame_size_,
+                              kMinSlabSize),
+                     kMaxSlabSize);
+        current_slab_ = new rtc::RefCountedObject<PayloadSlab>(
+            std::max(slab_size, packet->sizeBytes));
+        payload = current_slab_->Append(packet->dataPtr, packet->sizeBytes);
+      }
+      packet->dataPtr = payload;
+      payload_slabs_[index] = current_slab_;
+    } else if (copy_payload) {
+      packet->dataPtr = nullptr;
+    }
     data_buffer_[index] = *packet;
     packet->dataPtr = nullptr;
 
@@ -158,8 +216,7 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
     size_t index = first_seq_num_ % size_;
     RTC_DCHECK_EQ(data_buffer_[index].seqNum, sequence_buffer_[index].seq_num);
     if (AheadOf<uint16_t>(seq_num, sequence_buffer_[index].seq_num)) {
-      delete[] data_buffer_[index].dataPtr;
-      data_buffer_[index].dataPtr = nullptr;
+      ReleasePayload(index);
       sequence_buffer_[index].used = false;
     }
     ++first_seq_num_;
@@ -180,8 +237,7 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
 void PacketBuffer::Clear() {
   rtc::CritScope lock(&crit_);
   for (size_t i = 0; i < size_; ++i) {
-    delete[] data_buffer_[i].dataPtr;
-    data_buffer_[i].dataPtr = nullptr;
+    ReleasePayload(i);
     sequence_buffer_[i].used = false;
   }
 
@@ -230,17 +286,20 @@ bool PacketBuffer::ExpandBufferSize() {
 
   size_t new_size = std::min(max_size_, 2 * size_);
   std::vector<VCMPacket> new_data_buffer(new_size);
+  std::vector<rtc::scoped_refptr<PayloadSlab>> new_payload_slabs(new_size);
   std::vector<ContinuityInfo> new_sequence_buffer(new_size);
   for (size_t i = 0; i < size_; ++i) {
     if (sequence_buffer_[i].used) {
       size_t index = sequence_buffer_[i].seq_num % new_size;
       new_sequence_buffer[index] = sequence_buffer_[i];
       new_data_buffer[index] = data_buffer_[i];
+      new_payload_slabs[index] = std::move(payload_slabs_[i]);
     }
   }
   size_ = new_size;
   sequence_buffer_ = std::move(new_sequence_buffer);
   data_buffer_ = std::move(new_data_buffer);
+  payload_slabs_ = std::move(new_payload_slabs);
   RTC_LOG(LS_INFO) << "PacketBuffer size expanded to " << new_size;
   return true;
 }
@@ -401,6 +460,7 @@ std::vector<std::unique_ptr<RtpFrameObject>> PacketBuffer::FindFrames(
       missing_packets_.erase(missing_packets_.begin(),
                              missing_packets_.upper_bound(seq_num));
 
+      largest_frame_size_ = std::max(largest_frame_size_, frame_size);
       found_frames.emplace_back(
           new RtpFrameObject(this, start_seq_num, seq_num, frame_size,
                              max_nack_count, min_recv_time, max_recv_time));
@@ -421,8 +481,7 @@ void PacketBuffer::ReturnFrame(RtpFrameObject* frame) {
     // around too quickly for high packet rates.
     if (sequence_buffer_[index].seq_num == seq_num &&
         data_buffer_[index].timestamp == timestamp) {
-      delete[] data_buffer_[index].dataPtr;
-      data_buffer_[index].dataPtr = nullptr;
+      ReleasePayload(index);
       sequence_buffer_[index].used = false;
     }
 
@@ -469,6 +528,38 @@ bool PacketBuffer::GetBitstream(const RtpFrameObject& frame,
   return true;
 }
 
+const uint8_t* PacketBuffer::GetContiguousBitstream(
+    const RtpFrameObject& frame,
+    rtc::scoped_refptr<PayloadSlab>* slab) {
+  rtc::CritScope lock(&crit_);
+
+  size_t index = frame.first_seq_num() % size_;
+  size_t end = (frame.last_seq_num() + 1) % size_;
+  uint16_t seq_num = frame.first_seq_num();
+  uint32_t timestamp = frame.Timestamp();
+  const PayloadSlab* first_slab = payload_slabs_[index].get();
+  const uint8_t* bitstream = data_buffer_[index].dataPtr;
+  const uint8_t* next_payload = bitstream;
+  if (!first_slab)
+    return nullptr;
+
+  do {
+    if (!sequence_buffer_[index].used ||
+        sequence_buffer_[index].seq_num != seq_num ||
+        data_buffer_[index].timestamp != timestamp ||
+        payload_slabs_[index].get() != first_slab ||
+        data_buffer_[index].dataPtr != next_payload) {
+      return nullptr;
+    }
+    next_payload += data_buffer_[index].sizeBytes;
+    index = (index + 1) % size_;
+    ++seq_num;
+  } while (index != end);
+
+  *slab = payload_slabs_[frame.first_seq_num() % size_];
+  return bitstream;
+}
+
 VCMPacket* PacketBuffer::GetPacket(uint16_t seq_num) {
   size_t index = seq_num % size_;
   if (!sequence_buffer_[index].used ||
@@ -490,6 +581,14 @@ int PacketBuffer::Release() const {
   return count;
 }
 
+void PacketBuffer::ReleasePayload(size_t index) {
+  if (payload_slabs_[index])
+    payload_slabs_[index] = nullptr;
+  else
+    delete[] data_buffer_[index].dataPtr;
+  data_buffer_[index].dataPtr = nullptr;
+}
+
 void PacketBuffer::UpdateMissingPackets(uint16_t seq_num) {
   if (!newest_inserted_seq_num_)
     newest_inserted_seq_num_ = seq_num;
@@ -22,6 +22,7 @@
 #include "modules/video_coding/rtp_frame_reference_finder.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/numerics/sequence_number_util.h"
+#include "rtc_base/ref_count.h"
 #include "rtc_base/thread_annotations.h"
 
 namespace webrtc {
@@ -39,6 +40,26 @@ class OnAssembledFrameCallback {
   virtual void OnAssembledFrame(std::unique_ptr<RtpFrameObject> frame) = 0;
 };
 
+// Storage that the payloads of consecutively received packets are copied to
+// back to back. A frame whose packets were received in order references its
+// bitstream in the slab instead of copying it once more.
+class PayloadSlab : public rtc::RefCountInterface {
+ public:
+  explicit PayloadSlab(size_t capacity);
+
+  // Copies |size| bytes to the end of the slab. Returns where they were
+  // stored, or null if they don't fit.
+  const uint8_t* Append(const uint8_t* data, size_t size);
+
+ protected:
+  ~PayloadSlab() override;
+
+ private:
+  const std::unique_ptr<uint8_t[]> data_;
+  const size_t capacity_;
+  size_t size_ = 0;
+};
+
 class PacketBuffer {
  public:
   static rtc::scoped_refptr<PacketBuffer> Create(
@@ -53,6 +74,10 @@ class PacketBuffer {
   // otherwise. The PacketBuffer will always take ownership of the
   // |packet.dataPtr| when this function is called. Made virtual for testing.
   virtual bool InsertPacket(VCMPacket* packet);
+  // Like InsertPacket(), but doesn't take ownership of |packet.dataPtr|. The
+  // payload is copied to a PayloadSlab, so that frames received in order are
+  // assembled without another copy.
+  bool CopyAndInsertPacket(VCMPacket* packet);
   void ClearTo(uint16_t seq_num);
   void Clear();
   void PaddingReceived(uint16_t seq_num);
@@ -101,6 +126,8 @@ class PacketBuffer {
 
   Clock* const clock_;
 
+  bool InsertPacketInternal(VCMPacket* packet, bool copy_payload);
+
   // Tries to expand the buffer.
   bool ExpandBufferSize() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
@@ -117,6 +144,13 @@ class PacketBuffer {
   // Virtual for testing.
   virtual bool GetBitstream(const RtpFrameObject& frame, uint8_t* destination);
 
+  // If the payloads of |frame| are stored back to back in one slab, sets
+  // |slab| to it and returns the start of the bitstream. Returns null
+  // otherwise. Virtual for testing.
+  virtual const uint8_t* GetContiguousBitstream(
+      const RtpFrameObject& frame,
+      rtc::scoped_refptr<PayloadSlab>* slab);
+
   // Get the packet with sequence number |seq_num|.
   // Virtual for testing.
   virtual VCMPacket* GetPacket(uint16_t seq_num)
@@ -126,6 +160,9 @@ class PacketBuffer {
   // Virtual for testing.
   virtual void ReturnFrame(RtpFrameObject* frame);
 
+  // Frees the payload of the packet at |index|.
+  void ReleasePayload(size_t index) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
   void UpdateMissingPackets(uint16_t seq_num)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
@@ -151,6 +188,17 @@ class PacketBuffer {
   // Buffer that holds the inserted packets.
   std::vector<VCMPacket> data_buffer_ RTC_GUARDED_BY(crit_);
 
+  // The slab holding the payload of each packet in |data_buffer_|, or null if
+  // the packet owns its payload.
+  std::vector<rtc::scoped_refptr<PayloadSlab>> payload_slabs_
+      RTC_GUARDED_BY(crit_);
+
+  // The slab that payloads are currently appended to.
+  rtc::scoped_refptr<PayloadSlab> current_slab_ RTC_GUARDED_BY(crit_);
+
+  // Used to size new slabs, so that several frames fit in one.
+  size_t largest_frame_size_ RTC_GUARDED_BY(crit_) = 0;
+
   // Buffer that holds the information about which slot that is currently in use
   // and information needed to determine the continuity between packets.
   std::vector<ContinuityInfo> sequence_buffer_ RTC_GUARDED_BY(crit_);
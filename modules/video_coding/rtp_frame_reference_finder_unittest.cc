@@ -43,6 +43,12 @@ class FakePacketBuffer : public PacketBuffer {
     return true;
   }
 
+  const uint8_t* GetContiguousBitstream(
+      const RtpFrameObject& frame,
+      rtc::scoped_refptr<PayloadSlab>* slab) override {
+    return nullptr;
+  }
+
   void ReturnFrame(RtpFrameObject* frame) override {
     packets_.erase(frame->first_seq_num());
   }
@@ -12,7 +12,9 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
+#include "api/array_view.h"
 #include "common_video/h264/h264_common.h"
 #include "modules/video_coding/frame_object.h"
 #include "modules/video_coding/packet_buffer.h"
@@ -75,6 +77,25 @@ class TestPacketBuffer : public ::testing::Test,
     return packet_buffer_->InsertPacket(&packet);
   }
 
+  // Inserts a delta frame packet without handing over |data|.
+  bool CopyAndInsert(uint16_t seq_num,
+                     IsFirst first,
+                     IsLast last,
+                     rtc::ArrayView<const uint8_t> data,
+                     uint32_t timestamp) {
+    VCMPacket packet;
+    packet.video_header.codec = kVideoCodecGeneric;
+    packet.timestamp = timestamp;
+    packet.seqNum = seq_num;
+    packet.frameType = VideoFrameType::kVideoFrameDelta;
+    packet.video_header.is_first_packet_in_frame = first == kFirst;
+    packet.video_header.is_last_packet_in_frame = last == kLast;
+    packet.sizeBytes = data.size();
+    packet.dataPtr = data.data();
+
+    return packet_buffer_->CopyAndInsertPacket(&packet);
+  }
+
   void CheckFrame(uint16_t first_seq_num) {
     auto frame_it = frames_from_callback_.find(first_seq_num);
     ASSERT_FALSE(frame_it == frames_from_callback_.end())
@@ -472,6 +493,60 @@ TEST_F(TestPacketBuffer, GetBitstreamOneFrameOnePacket) {
       0);
 }
 
+TEST_F(TestPacketBuffer, ReferencesBitstreamOfFramesReceivedInOrder) {
+  const uint8_t kFirst1[] = {1, 2, 3};
+  const uint8_t kFirst2[] = {4, 5};
+  const uint8_t kSecond[] = {6, 7, 8, 9};
+  const uint16_t seq_num = Rand();
+
+  EXPECT_TRUE(CopyAndInsert(seq_num, kFirst, kNotLast, kFirst1, 1000));
+  EXPECT_TRUE(CopyAndInsert(seq_num + 1, kNotFirst, kLast, kFirst2, 1000));
+  EXPECT_TRUE(CopyAndInsert(seq_num + 2, kFirst, kLast, kSecond, 2000));
+
+  ASSERT_EQ(2UL, frames_from_callback_.size());
+  const RtpFrameObject& first = *frames_from_callback_[seq_num];
+  const RtpFrameObject& second = *frames_from_callback_[seq_num + 2];
+  const uint8_t kExpectedFirst[] = {1, 2, 3, 4, 5};
+  ASSERT_EQ(sizeof(kExpectedFirst), first.size());
+  EXPECT_EQ(0, memcmp(first.data(), kExpectedFirst, sizeof(kExpectedFirst)));
+  ASSERT_EQ(sizeof(kSecond), second.size());
+  EXPECT_EQ(0, memcmp(second.data(), kSecond, sizeof(kSecond)));
+  // Both frames reference the payloads where they were copied on insertion.
+  EXPECT_EQ(first.data() + first.size(), second.data());
+}
+
+TEST_F(TestPacketBuffer, CopiesBitstreamOfReorderedPackets) {
+  const uint8_t kPayload1[] = {1, 2, 3};
+  const uint8_t kPayload2[] = {4, 5};
+  const uint16_t seq_num = Rand();
+
+  EXPECT_TRUE(CopyAndInsert(seq_num + 1, kNotFirst, kLast, kPayload2, 1000));
+  EXPECT_TRUE(CopyAndInsert(seq_num, kFirst, kNotLast, kPayload1, 1000));
+
+  ASSERT_EQ(1UL, frames_from_callback_.size());
+  const RtpFrameObject& frame = *frames_from_callback_[seq_num];
+  const uint8_t kExpected[] = {1, 2, 3, 4, 5};
+  ASSERT_EQ(sizeof(kExpected), frame.size());
+  EXPECT_EQ(0, memcmp(frame.data(), kExpected, sizeof(kExpected)));
+}
+
+TEST_F(TestPacketBuffer, ReferencedBitstreamOutlivesPackets) {
+  const uint8_t kPayload[] = {1, 2, 3, 4};
+  const uint16_t seq_num = Rand();
+
+  EXPECT_TRUE(CopyAndInsert(seq_num, kFirst, kLast, kPayload, 1000));
+  ASSERT_EQ(1UL, frames_from_callback_.size());
+  packet_buffer_->Clear();
+  // Too large for the current slab, so that only the frame references it.
+  std::vector<uint8_t> large_payload(1024 * 1024);
+  EXPECT_TRUE(
+      CopyAndInsert(seq_num + 1, kFirst, kNotLast, large_payload, 2000));
+
+  const RtpFrameObject& frame = *frames_from_callback_[seq_num];
+  ASSERT_EQ(sizeof(kPayload), frame.size());
+  EXPECT_EQ(0, memcmp(frame.data(), kPayload, sizeof(kPayload)));
+}
+
 TEST_F(TestPacketBuffer, GetBitstreamOneFrameFullBuffer) {
   uint8_t* data_arr[kStartSize];
   uint8_t expected[kStartSize];
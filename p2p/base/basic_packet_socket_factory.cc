@@ -11,6 +11,8 @@
 #include "p2p/base/basic_packet_socket_factory.h"
 
 #include <stddef.h>
+#include <stdio.h>
+#include <algorithm>
 #include <string>
 
 #include "p2p/base/async_stun_tcp_socket.h"
@@ -24,9 +26,36 @@
 #include "rtc_base/socket_server.h"
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/thread.h"
+#include "system_wrappers/include/field_trial.h"
 
 namespace rtc {
 
+namespace {
+
+// "WebRTC-UdpSocketBatching/Enabled-<recv>-<send>/" makes UDP sockets read
+// up to <recv> datagrams per read event (recvmmsg) and send bursts of up to
+// <send> paced packets with one system call (sendmmsg or GSO).
+const char kUdpSocketBatchingFieldTrial[] = "WebRTC-UdpSocketBatching";
+const size_t kDefaultUdpBatchSize = 32;
+const size_t kMaxUdpBatchSize = 64;
+
+void MaybeEnableBatching(AsyncUDPSocket* socket) {
+  if (!webrtc::field_trial::IsEnabled(kUdpSocketBatchingFieldTrial))
+    return;
+  size_t recv_batch_size = kDefaultUdpBatchSize;
+  size_t send_batch_size = kDefaultUdpBatchSize;
+  std::string group =
+      webrtc::field_trial::FindFullName(kUdpSocketBatchingFieldTrial);
+  if (sscanf(group.c_str(), "Enabled-%zu-%zu", &recv_batch_size,
+             &send_batch_size) != 2) {
+    recv_batch_size = send_batch_size = kDefaultUdpBatchSize;
+  }
+  socket->SetRecvBatchSize(std::min(recv_batch_size, kMaxUdpBatchSize));
+  socket->SetSendBatchSize(std::min(send_batch_size, kMaxUdpBatchSize));
+}
+
+}  // namespace
+
 BasicPacketSocketFactory::BasicPacketSocketFactory()
     : thread_(Thread::Current()), socket_factory_(NULL) {}
 
@@ -54,7 +83,9 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateUdpSocket(
     delete socket;
     return NULL;
   }
-  return new AsyncUDPSocket(socket);
+  AsyncUDPSocket* udp_socket = new AsyncUDPSocket(socket);
+  MaybeEnableBatching(udp_socket);
+  return udp_socket;
 }
 
 AsyncPacketSocket* BasicPacketSocketFactory::CreateServerTcpSocket(
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/connection_address_table.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/ip_address.h"
+
+namespace cricket {
+
+namespace {
+
+const size_t kMinCapacity = 16;
+
+}  // namespace
+
+ConnectionAddressTable::ConnectionAddressTable() = default;
+ConnectionAddressTable::~ConnectionAddressTable() = default;
+
+// static
+bool ConnectionAddressTable::CanIndex(const rtc::SocketAddress& addr) {
+  const rtc::IPAddress& ip = addr.ipaddr();
+  return !rtc::IPIsUnspec(ip) && !rtc::IPIsAny(ip);
+}
+
+// static
+ConnectionAddressTable::Key ConnectionAddressTable::MakeKey(
+    const rtc::SocketAddress& addr) {
+  const rtc::IPAddress& ip = addr.ipaddr();
+  Key key;
+  if (ip.family() == AF_INET6) {
+    in6_addr v6 = ip.ipv6_address();
+    memcpy(&key.ip_high, &v6.s6_addr[0], sizeof(key.ip_high));
+    memcpy(&key.ip_low, &v6.s6_addr[8], sizeof(key.ip_low));
+  } else {
+    in_addr v4 = ip.ipv4_address();
+    uint32_t ip_low;
+    memcpy(&ip_low, &v4, sizeof(ip_low));
+    key.ip_low = ip_low;
+  }
+  key.family_and_port = (static_cast<uint32_t>(ip.family()) << 16) |
+                        static_cast<uint16_t>(addr.port());
+  return key;
+}
+
+// static
+size_t ConnectionAddressTable::HashKey(const Key& key) {
+  uint64_t h = key.ip_high * 0x9E3779B97F4A7C15ull;
+  h ^= key.ip_low + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+  h ^= key.family_and_port * 0xC2B2AE3D27D4EB4Full;
+  h ^= h >> 29;
+  h *= 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 32;
+  return static_cast<size_t>(h);
+}
+
+size_t ConnectionAddressTable::FindSlot(const Key& key) const {
+  const size_t mask = slots_.size() - 1;
+  size_t index = HashKey(key) & mask;
+  while (slots_[index].connection && !(slots_[index].key == key))
+    index = (index + 1) & mask;
+  return index;
+}
+
+void ConnectionAddressTable::Insert(const rtc::SocketAddress& addr,
+                                    Connection* conn) {
+  RTC_DCHECK(CanIndex(addr));
+  RTC_DCHECK(conn);
+  if ((size_ + 1) * 2 > slots_.size())
+    Grow();
+  const Key key = MakeKey(addr);
+  Slot& slot = slots_[FindSlot(key)];
+  if (!slot.connection) {
+    slot.key = key;
+    ++size_;
+  }
+  slot.connection = conn;
+}
+
+void ConnectionAddressTable::Erase(const rtc::SocketAddress& addr) {
+  if (size_ == 0 || !CanIndex(addr))
+    return;
+  const size_t mask = slots_.size() - 1;
+  size_t hole = FindSlot(MakeKey(addr));
+  if (!slots_[hole].connection)
+    return;
+  slots_[hole].connection = nullptr;
+  --size_;
+  // Backward-shift deletion: move later entries of the probe sequence into
+  // the hole unless that would put them before their home slot. This keeps
+  // lookups free of tombstones.
+  for (size_t index = (hole + 1) & mask; slots_[index].connection;
+       index = (index + 1) & mask) {
+    const size_t home = HashKey(slots_[index].key) & mask;
+    // Distance from the home slot, modulo the table size.
+    if (((index - home) & mask) >= ((index - hole) & mask)) {
+      slots_[hole] = slots_[index];
+      slots_[index].connection = nullptr;
+      hole = index;
+    }
+  }
+}
+
+Connection* ConnectionAddressTable::Find(
+    const rtc::SocketAddress& addr) const {
+  if (size_ == 0 || !CanIndex(addr))
+    return nullptr;
+  return slots_[FindSlot(MakeKey(addr))].connection;
+}
+
+void ConnectionAddressTable::Grow() {
+  std::vector<Slot> old_slots(std::max(kMinCapacity, slots_.size() * 2));
+  old_slots.swap(slots_);
+  for (const Slot& slot : old_slots) {
+    if (slot.connection)
+      slots_[FindSlot(slot.key)] = slot;
+  }
+}
+
+}  // namespace cricket
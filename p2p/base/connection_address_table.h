@@ -0,0 +1,86 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_CONNECTION_ADDRESS_TABLE_H_
+#define P2P_BASE_CONNECTION_ADDRESS_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/socket_address.h"
+
+namespace cricket {
+
+class Connection;
+
+// Open-addressing hash table from remote addresses to connections, used by
+// Port to find the connection of every received packet without walking a
+// tree of SocketAddress objects. Addresses are packed into a fixed-size key of
+// IP, port and family, so probing only compares integers. Keys match the way
+// SocketAddress::operator== compares resolved addresses.
+//
+// Only addresses with a specific IP can be indexed; see CanIndex().
+class ConnectionAddressTable {
+ public:
+  ConnectionAddressTable();
+  ~ConnectionAddressTable();
+
+  // False for addresses whose IP is unspecified or "any", which compare by
+  // hostname instead.
+  static bool CanIndex(const rtc::SocketAddress& addr);
+
+  // Maps |addr| to |conn|, replacing any previous connection for |addr|.
+  void Insert(const rtc::SocketAddress& addr, Connection* conn);
+  void Erase(const rtc::SocketAddress& addr);
+  // Returns nullptr if |addr| is not in the table.
+  Connection* Find(const rtc::SocketAddress& addr) const;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  struct Key {
+    uint64_t ip_high = 0;
+    uint64_t ip_low = 0;
+    // Address family in the upper, port in the lower 16 bits.
+    uint32_t family_and_port = 0;
+
+    bool operator==(const Key& other) const {
+      return ip_low == other.ip_low && ip_high == other.ip_high &&
+             family_and_port == other.family_and_port;
+    }
+  };
+  struct Slot {
+    Key key;
+    // nullptr marks an empty slot.
+    Connection* connection = nullptr;
+  };
+
+  static Key MakeKey(const rtc::SocketAddress& addr);
+  static size_t HashKey(const Key& key);
+
+  // Index of the slot holding |key|, or of the empty slot that ends its probe
+  // sequence.
+  size_t FindSlot(const Key& key) const;
+  void Grow();
+
+  // Power-of-two sized, at most half full; empty until the first Insert().
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ConnectionAddressTable);
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_CONNECTION_ADDRESS_TABLE_H_
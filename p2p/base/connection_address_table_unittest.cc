@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/connection_address_table.h"
+
+#include <stdio.h>
+
+#include <map>
+#include <vector>
+
+#include "rtc_base/ip_address.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace cricket {
+namespace {
+
+// The table never dereferences its values.
+Connection* FakeConnection(uintptr_t id) {
+  return reinterpret_cast<Connection*>(id);
+}
+
+rtc::SocketAddress RandomAddress(webrtc::Random* random) {
+  if (random->Rand(0, 3) == 0) {
+    in6_addr v6;
+    for (uint8_t& byte : v6.s6_addr)
+      byte = static_cast<uint8_t>(random->Rand(0, 255));
+    return rtc::SocketAddress(rtc::IPAddress(v6), random->Rand(1, 65535));
+  }
+  // Few distinct IPs, so that many addresses differ only in the port.
+  return rtc::SocketAddress(random->Rand(0x0A000001, 0x0A000010),
+                            random->Rand(1, 65535));
+}
+
+TEST(ConnectionAddressTableTest, InsertFindErase) {
+  ConnectionAddressTable table;
+  const rtc::SocketAddress a("1.2.3.4", 5000);
+  const rtc::SocketAddress b("1.2.3.4", 5001);
+  const rtc::SocketAddress c("2001:db8::1", 5000);
+  EXPECT_EQ(nullptr, table.Find(a));
+
+  table.Insert(a, FakeConnection(1));
+  table.Insert(b, FakeConnection(2));
+  table.Insert(c, FakeConnection(3));
+  EXPECT_EQ(3u, table.size());
+  EXPECT_EQ(FakeConnection(1), table.Find(a));
+  EXPECT_EQ(FakeConnection(2), table.Find(b));
+  EXPECT_EQ(FakeConnection(3), table.Find(c));
+  EXPECT_EQ(nullptr, table.Find(rtc::SocketAddress("1.2.3.5", 5000)));
+
+  // Inserting an existing address replaces its connection.
+  table.Insert(a, FakeConnection(4));
+  EXPECT_EQ(3u, table.size());
+  EXPECT_EQ(FakeConnection(4), table.Find(a));
+
+  table.Erase(a);
+  table.Erase(a);
+  EXPECT_EQ(2u, table.size());
+  EXPECT_EQ(nullptr, table.Find(a));
+  EXPECT_EQ(FakeConnection(2), table.Find(b));
+}
+
+TEST(ConnectionAddressTableTest, IndexesOnlyResolvedAddresses) {
+  EXPECT_FALSE(ConnectionAddressTable::CanIndex(
+      rtc::SocketAddress("example.org", 5000)));
+  EXPECT_FALSE(ConnectionAddressTable::CanIndex(
+      rtc::SocketAddress(rtc::IPAddress(INADDR_ANY), 5000)));
+  EXPECT_TRUE(
+      ConnectionAddressTable::CanIndex(rtc::SocketAddress("1.2.3.4", 5000)));
+
+  // Like SocketAddress::operator==, the table ignores the hostname of a
+  // resolved address.
+  ConnectionAddressTable table;
+  rtc::SocketAddress resolved("example.org", 5000);
+  resolved.SetResolvedIP(rtc::IPAddress(0x01020304));
+  table.Insert(resolved, FakeConnection(1));
+  EXPECT_EQ(FakeConnection(1),
+            table.Find(rtc::SocketAddress("1.2.3.4", 5000)));
+}
+
+// Compares against a std::map through many inserts and erases, which grows
+// the table and exercises the backward-shift deletion.
+TEST(ConnectionAddressTableTest, MatchesMapUnderRandomOperations) {
+  webrtc::Random random(0x5eed);
+  ConnectionAddressTable table;
+  std::map<rtc::SocketAddress, Connection*> reference;
+  std::vector<rtc::SocketAddress> addresses;
+  for (int i = 0; i < 2000; ++i)
+    addresses.push_back(RandomAddress(&random));
+
+  for (int i = 0; i < 50000; ++i) {
+    const rtc::SocketAddress& addr =
+        addresses[random.Rand(0, static_cast<int>(addresses.size()) - 1)];
+    if (random.Rand(0, 2) == 0) {
+      table.Erase(addr);
+      reference.erase(addr);
+    } else {
+      Connection* conn = FakeConnection(i + 1);
+      table.Insert(addr, conn);
+      reference[addr] = conn;
+    }
+    ASSERT_EQ(reference.size(), table.size());
+  }
+  for (const rtc::SocketAddress& addr : addresses) {
+    auto it = reference.find(addr);
+    EXPECT_EQ(it == reference.end() ? nullptr : it->second, table.Find(addr));
+  }
+}
+
+// Looks up the remote address of each received packet among 5000 connections,
+// as a busy server port does. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*LookupPerformance*.
+TEST(ConnectionAddressTableTest, DISABLED_LookupPerformance) {
+  static const int kNumConnections = 5000;
+  static const int kNumLookups = 10000000;
+  webrtc::Random random(0x1234);
+  ConnectionAddressTable table;
+  std::map<rtc::SocketAddress, Connection*> map;
+  std::vector<rtc::SocketAddress> addresses;
+  for (int i = 0; i < kNumConnections; ++i) {
+    addresses.push_back(RandomAddress(&random));
+    table.Insert(addresses.back(), FakeConnection(i + 1));
+    map[addresses.back()] = FakeConnection(i + 1);
+  }
+
+  uintptr_t checksum = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumLookups; ++i) {
+    const rtc::SocketAddress& addr =
+        addresses[static_cast<size_t>(i) * 7919 % kNumConnections];
+    checksum += reinterpret_cast<uintptr_t>(map.find(addr)->second);
+  }
+  int64_t map_us = rtc::TimeMicros() - start_us;
+  start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumLookups; ++i) {
+    checksum -= reinterpret_cast<uintptr_t>(
+        table.Find(addresses[static_cast<size_t>(i) * 7919 % kNumConnections]));
+  }
+  int64_t table_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(0u, checksum);
+  printf("%d connections: std::map %.1f ns, hash table %.1f ns per lookup\n",
+         kNumConnections, map_us * 1000.0 / kNumLookups,
+         table_us * 1000.0 / kNumLookups);
+}
+
+}  // namespace
+}  // namespace cricket
@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string.h>
 #include <algorithm>
 #include <memory>
 #include <utility>
@@ -106,6 +107,16 @@ rtc::StreamResult StreamInterfaceChannel::Read(void* buffer,
   if (state_ == rtc::SS_OPENING)
     return rtc::SR_BLOCK;
 
+  if (pending_packet_) {
+    size_t size = std::min(buffer_len, pending_packet_size_);
+    memcpy(buffer, pending_packet_, size);
+    if (read) {
+      *read = size;
+    }
+    pending_packet_ = nullptr;
+    return rtc::SR_SUCCESS;
+  }
+
   if (!packets_.ReadFront(buffer, buffer_len, read)) {
     return rtc::SR_BLOCK;
   }
@@ -130,6 +141,24 @@ rtc::StreamResult StreamInterfaceChannel::Write(const void* data,
 }
 
 bool StreamInterfaceChannel::OnPacketReceived(const char* data, size_t size) {
+  RTC_DCHECK(!pending_packet_);
+  if (packets_.size() == 0) {
+    // The SSL stream reads synchronously from the event, straight out of the
+    // received datagram, saving a copy through |packets_|.
+    pending_packet_ = data;
+    pending_packet_size_ = size;
+    SignalEvent(this, rtc::SE_READ, 0);
+    bool consumed = !pending_packet_;
+    pending_packet_ = nullptr;
+    if (consumed || state_ == rtc::SS_CLOSED) {
+      return true;
+    }
+    // Not read yet, e.g. during the handshake. Keep it for a later Read().
+    bool ret = packets_.WriteBack(data, size, NULL);
+    RTC_CHECK(ret) << "Failed to write packet to queue.";
+    return ret;
+  }
+
   // We force a read event here to ensure that we don't overflow our queue.
   bool ret = packets_.WriteBack(data, size, NULL);
   RTC_CHECK(ret) << "Failed to write packet to queue.";
@@ -145,6 +174,7 @@ rtc::StreamState StreamInterfaceChannel::GetState() const {
 
 void StreamInterfaceChannel::Close() {
   packets_.Clear();
+  pending_packet_ = nullptr;
   state_ = rtc::SS_CLOSED;
 }
 
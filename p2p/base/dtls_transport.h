@@ -38,7 +38,9 @@ class StreamInterfaceChannel : public rtc::StreamInterface {
  public:
   explicit StreamInterfaceChannel(IceTransportInternal* ice_transport);
 
-  // Push in a packet; this gets pulled out from Read().
+  // Push in a packet; this gets pulled out from Read(). If nothing is queued,
+  // the packet is read in place by the SE_READ handler, and only copied into
+  // the queue if the handler left it unread.
   bool OnPacketReceived(const char* data, size_t size);
 
   // Implementations of StreamInterface
@@ -57,6 +59,9 @@ class StreamInterfaceChannel : public rtc::StreamInterface {
   IceTransportInternal* ice_transport_;  // owned by DtlsTransport
   rtc::StreamState state_;
   rtc::BufferQueue packets_;
+  // Packet handed to the reader in place while OnPacketReceived() signals it.
+  const char* pending_packet_ = nullptr;
+  size_t pending_packet_size_ = 0;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(StreamInterfaceChannel);
 };
@@ -11,7 +11,9 @@
 #include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "p2p/base/dtls_transport.h"
@@ -25,6 +27,7 @@
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/ssl_identity.h"
 #include "rtc_base/ssl_stream_adapter.h"
+#include "test/gmock.h"
 
 #define MAYBE_SKIP_TEST(feature)                                  \
   if (!(rtc::SSLStreamAdapter::feature())) {                      \
@@ -738,4 +741,56 @@ INSTANTIATE_TEST_SUITE_P(
                                             CALLER_RECEIVES_FINGERPRINT}),
         ::testing::Bool()));
 
+class StreamInterfaceChannelReader : public sigslot::has_slots<> {
+ public:
+  explicit StreamInterfaceChannelReader(StreamInterfaceChannel* channel)
+      : channel_(channel) {
+    channel_->SignalEvent.connect(this, &StreamInterfaceChannelReader::OnEvent);
+  }
+
+  void set_read_on_event(bool read_on_event) { read_on_event_ = read_on_event; }
+  const std::vector<std::string>& packets() const { return packets_; }
+
+  void Read() {
+    char buffer[100];
+    size_t read;
+    while (channel_->Read(buffer, sizeof(buffer), &read, nullptr) ==
+           rtc::SR_SUCCESS) {
+      packets_.push_back(std::string(buffer, read));
+    }
+  }
+
+ private:
+  void OnEvent(rtc::StreamInterface* stream, int sig, int err) {
+    if ((sig & rtc::SE_READ) && read_on_event_)
+      Read();
+  }
+
+  StreamInterfaceChannel* const channel_;
+  bool read_on_event_ = true;
+  std::vector<std::string> packets_;
+};
+
+// Test that a packet is read from the event without going through the queue.
+TEST(StreamInterfaceChannelTest, PacketIsReadFromEvent) {
+  FakeIceTransport ice_transport("test", ICE_CANDIDATE_COMPONENT_RTP);
+  StreamInterfaceChannel channel(&ice_transport);
+  StreamInterfaceChannelReader reader(&channel);
+  EXPECT_TRUE(channel.OnPacketReceived("first", 5));
+  EXPECT_TRUE(channel.OnPacketReceived("second", 6));
+  EXPECT_THAT(reader.packets(), ::testing::ElementsAre("first", "second"));
+}
+
+// Test that a packet that is not read from the event is queued.
+TEST(StreamInterfaceChannelTest, UnreadPacketIsQueued) {
+  FakeIceTransport ice_transport("test", ICE_CANDIDATE_COMPONENT_RTP);
+  StreamInterfaceChannel channel(&ice_transport);
+  StreamInterfaceChannelReader reader(&channel);
+  reader.set_read_on_event(false);
+  EXPECT_TRUE(channel.OnPacketReceived("first", 5));
+  EXPECT_TRUE(reader.packets().empty());
+  reader.Read();
+  EXPECT_THAT(reader.packets(), ::testing::ElementsAre("first"));
+}
+
 }  // namespace cricket
@@ -10,6 +10,7 @@
 
 #include "p2p/base/p2p_transport_channel.h"
 
+#include <algorithm>
 #include <iterator>
 #include <set>
 #include <utility>
@@ -1748,6 +1749,102 @@ bool P2PTransportChannel::PresumedWritable(const Connection* conn) const {
            conn->remote_candidate().type() == PRFLX_PORT_TYPE));
 }
 
+bool P2PTransportChannel::ConnectionRankKey::operator==(
+    const ConnectionRankKey& other) const {
+  return writable_or_presumed == other.writable_or_presumed &&
+         write_state == other.write_state && receiving == other.receiving &&
+         connected == other.connected &&
+         remote_nomination == other.remote_nomination &&
+         last_data_received == other.last_data_received &&
+         uses_preferred_network == other.uses_preferred_network &&
+         network_cost == other.network_cost && priority == other.priority &&
+         generation == other.generation && pruned == other.pruned &&
+         rtt == other.rtt;
+}
+
+P2PTransportChannel::ConnectionRankKey
+P2PTransportChannel::GetConnectionRankKey(const Connection* conn) const {
+  ConnectionRankKey key;
+  key.writable_or_presumed = conn->writable() || PresumedWritable(conn);
+  key.write_state = conn->write_state();
+  key.receiving = conn->receiving();
+  key.connected = conn->connected();
+  key.remote_nomination = conn->remote_nomination();
+  key.last_data_received = conn->last_data_received();
+  key.uses_preferred_network =
+      LocalCandidateUsesPreferredNetwork(conn, config_.network_preference);
+  key.network_cost = conn->ComputeNetworkCost();
+  key.priority = conn->priority();
+  key.generation =
+      conn->remote_candidate().generation() + conn->port()->generation();
+  key.pruned = IsPortPruned(conn->port()) ||
+               IsRemoteCandidatePruned(conn->remote_candidate());
+  key.rtt = conn->rtt();
+  return key;
+}
+
+void P2PTransportChannel::RankConnections() {
+  auto is_better = [this](const Connection* a, const Connection* b) {
+    int cmp = CompareConnections(a, b, absl::nullopt, nullptr);
+    if (cmp != 0) {
+      return cmp > 0;
+    }
+    // Otherwise, sort based on latency estimate.
+    return a->rtt() < b->rtt();
+  };
+  // The order a stable sort produces: connections that are neither better nor
+  // worse than each other keep their previous order.
+  auto ranks_before = [&is_better](const RankedConnection& a,
+                                   const RankedConnection& b) {
+    if (is_better(a.connection, b.connection)) {
+      return true;
+    }
+    if (is_better(b.connection, a.connection)) {
+      return false;
+    }
+    return a.previous_index < b.previous_index;
+  };
+
+  // The ICE role changes how nominations and connection priorities compare.
+  const bool rank_all = ice_role_ != ranked_ice_role_;
+  ranked_ice_role_ = ice_role_;
+  ranked_connections_.clear();
+  moved_connections_.clear();
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    RankedConnection entry = {connections_[i],
+                              GetConnectionRankKey(connections_[i]), i};
+    if (!rank_all && i < connection_rank_keys_.size() &&
+        connection_rank_keys_[i] == entry.key) {
+      ranked_connections_.push_back(entry);
+    } else {
+      moved_connections_.push_back(entry);
+    }
+  }
+
+  if (moved_connections_.size() * 4 > connections_.size()) {
+    // Most keys changed, e.g. during setup; sort everything.
+    ranked_connections_.insert(ranked_connections_.end(),
+                               moved_connections_.begin(),
+                               moved_connections_.end());
+    absl::c_sort(ranked_connections_, ranks_before);
+  } else {
+    // The unchanged connections are still sorted by |ranks_before|: they
+    // compare as before and keep their previous order.
+    for (const RankedConnection& entry : moved_connections_) {
+      ranked_connections_.insert(
+          std::lower_bound(ranked_connections_.begin(),
+                           ranked_connections_.end(), entry, ranks_before),
+          entry);
+    }
+  }
+
+  connection_rank_keys_.resize(ranked_connections_.size());
+  for (size_t i = 0; i < ranked_connections_.size(); ++i) {
+    connections_[i] = ranked_connections_[i].connection;
+    connection_rank_keys_[i] = ranked_connections_[i].key;
+  }
+}
+
 // Sort the available connections to find the best one.  We also monitor
 // the number of available connections and the current state.
 void P2PTransportChannel::SortConnectionsAndUpdateState(const std::string& reason_to_sort) 
@@ -1765,16 +1862,7 @@ void P2PTransportChannel::SortConnectionsAndUpdateState(const std::string& reaso
   // that amongst equal preference, writable connections, this will choose the
   // one whose estimated latency is lowest.  So it is the only one that we
   // need to consider switching to.
-  // TODO(honghaiz): Don't sort;  Just use std::max_element in the right places.
-  absl::c_stable_sort(
-      connections_, [this](const Connection* a, const Connection* b) {
-        int cmp = CompareConnections(a, b, absl::nullopt, nullptr);
-        if (cmp != 0) {
-          return cmp > 0;
-        }
-        // Otherwise, sort based on latency estimate.
-        return a->rtt() < b->rtt();
-      });
+  RankConnections();
 
   RTC_LOG(LS_VERBOSE) << "Sorting " << connections_.size()
                       << " available connections";
@@ -2466,6 +2554,10 @@ void P2PTransportChannel::OnConnectionDestroyed(Connection* connection) {
   // Remove this connection from the list.
   auto iter = absl::c_find(connections_, connection);
   RTC_DCHECK(iter != connections_.end());
+  const size_t index = iter - connections_.begin();
+  if (index < connection_rank_keys_.size()) {
+    connection_rank_keys_.erase(connection_rank_keys_.begin() + index);
+  }
   // TODO@chensong 2023-05-06 删除connection --???
   pinged_connections_.erase(connection);
   unpinged_connections_.erase(connection);
@@ -242,6 +242,41 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
 
   bool PresumedWritable(const cricket::Connection* conn) const;
 
+  // Everything that CompareConnections() without a receiving threshold and
+  // the latency tie-break look at for one connection, apart from the ICE role.
+  struct ConnectionRankKey {
+    bool writable_or_presumed = false;
+    Connection::WriteState write_state = Connection::STATE_WRITE_INIT;
+    bool receiving = false;
+    bool connected = false;
+    uint32_t remote_nomination = 0;
+    int64_t last_data_received = 0;
+    bool uses_preferred_network = false;
+    uint32_t network_cost = 0;
+    uint64_t priority = 0;
+    uint32_t generation = 0;
+    bool pruned = false;
+    int rtt = 0;
+
+    bool operator==(const ConnectionRankKey& other) const;
+    bool operator!=(const ConnectionRankKey& other) const {
+      return !(*this == other);
+    }
+  };
+  struct RankedConnection {
+    Connection* connection;
+    ConnectionRankKey key;
+    // Position in |connections_| before ranking; breaks ties like a stable
+    // sort does.
+    size_t previous_index;
+  };
+  ConnectionRankKey GetConnectionRankKey(const Connection* conn) const;
+  // Orders |connections_| exactly like a stable sort by CompareConnections()
+  // and rtt would, but only repositions the connections whose rank key
+  // changed since the last call; the others are still in order relative to
+  // each other. Falls back to a full sort when many keys changed.
+  void RankConnections();
+
   void SortConnectionsAndUpdateState(const std::string& reason_to_sort);
   void SwitchSelectedConnection(Connection* conn);
   void UpdateState();
@@ -398,6 +433,14 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
   // connections as |connections_|. These 2 sets maintain whether a
   // connection should be pinged next or not.
   std::vector<Connection*> connections_;
+  // Rank keys of the first connection_rank_keys_.size() entries of
+  // |connections_| as of the last RankConnections(); connections added since
+  // then have no key yet.
+  std::vector<ConnectionRankKey> connection_rank_keys_;
+  IceRole ranked_ice_role_ = ICEROLE_UNKNOWN;
+  // Scratch space for RankConnections().
+  std::vector<RankedConnection> ranked_connections_;
+  std::vector<RankedConnection> moved_connections_;
   std::set<Connection*> pinged_connections_;
   std::set<Connection*> unpinged_connections_;
 
@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdio.h>
+
 #include <list>
 #include <memory>
 
@@ -35,6 +37,7 @@
 #include "rtc_base/socket_address.h"
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/virtual_socket_server.h"
 #include "system_wrappers/include/metrics.h"
 
@@ -4362,6 +4365,86 @@ TEST_F(P2PTransportChannelPingTest, TestPortDestroyedAfterTimeoutAndPruned) {
   EXPECT_EQ_SIMULATED_WAIT(nullptr, GetPrunedPort(&ch), 1, fake_clock);
 }
 
+// Connections whose state did not change keep their place when the channel
+// re-ranks its connections; the ones that changed move as a full sort would
+// move them.
+TEST_F(P2PTransportChannelPingTest, TestConnectionRankingAfterStateChanges) {
+  rtc::ScopedFakeClock clock;
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("ranking", ICE_CANDIDATE_COMPONENT_DEFAULT, &pa);
+  PrepareChannel(&ch);
+  // Keep the controlling side from pruning the lower priority connections.
+  ch.SetIceRole(ICEROLE_CONTROLLED);
+  ch.MaybeStartGathering();
+  Connection* conns[6] = {};
+  for (int port = 1; port <= 5; ++port) {
+    conns[port] = CreateConnectionWithCandidate(&ch, &clock, "1.1.1.1", port,
+                                                port, false);
+    ASSERT_TRUE(conns[port] != nullptr);
+  }
+  auto ranked_ports = [&ch] {
+    std::vector<int> ports;
+    for (const Connection* conn : ch.connections()) {
+      ports.push_back(conn->remote_candidate().address().port());
+    }
+    return ports;
+  };
+  EXPECT_EQ(std::vector<int>({5, 4, 3, 2, 1}), ranked_ports());
+
+  // A writable connection ranks above the higher priority ones.
+  conns[2]->ReceivedPingResponse(LOW_RTT, "id");
+  EXPECT_EQ_SIMULATED_WAIT(conns[2], ch.connections()[0], kDefaultTimeout,
+                           clock);
+  EXPECT_EQ(std::vector<int>({2, 5, 4, 3, 1}), ranked_ports());
+
+  // Among writable connections the priority still decides.
+  conns[4]->ReceivedPingResponse(LOW_RTT, "id");
+  EXPECT_EQ_SIMULATED_WAIT(conns[4], ch.connections()[0], kDefaultTimeout,
+                           clock);
+  EXPECT_EQ(std::vector<int>({4, 2, 5, 3, 1}), ranked_ports());
+
+  conns[5]->Destroy();
+  conns[3]->ReceivedPingResponse(LOW_RTT, "id");
+  EXPECT_EQ_SIMULATED_WAIT(4u, ch.connections().size(), kDefaultTimeout,
+                           clock);
+  EXPECT_EQ(std::vector<int>({4, 3, 2, 1}), ranked_ports());
+  EXPECT_EQ(conns[4], ch.selected_connection());
+}
+
+// Nominates one of 100 candidate pairs after another on the controlled side,
+// which re-ranks the connections each time. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*RankingPerformance*.
+TEST_F(P2PTransportChannelPingTest, DISABLED_ConnectionRankingPerformance) {
+  static const int kNumConnections = 100;
+  static const int kNumNominations = 10000;
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("ranking", ICE_CANDIDATE_COMPONENT_DEFAULT, &pa);
+  PrepareChannel(&ch);
+  ch.SetIceRole(ICEROLE_CONTROLLED);
+  ch.MaybeStartGathering();
+  std::vector<Connection*> conns;
+  for (int port = 1; port <= kNumConnections; ++port) {
+    ch.AddRemoteCandidate(
+        CreateUdpCandidate(LOCAL_PORT_TYPE, "1.1.1.1", port, port));
+    Connection* conn = WaitForConnectionTo(&ch, "1.1.1.1", port);
+    ASSERT_TRUE(conn != nullptr);
+    conn->ReceivedPingResponse(LOW_RTT + port, "id");
+    conns.push_back(conn);
+  }
+  rtc::Thread::Current()->ProcessMessages(0);
+
+  int64_t start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumNominations; ++i) {
+    Connection* conn = conns[(i * 37) % kNumConnections];
+    conn->ReceivedPingResponse(LOW_RTT + i % 50, "id");
+    NominateConnection(conn, i + 1);
+    rtc::Thread::Current()->ProcessMessages(0);
+  }
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  printf("%d connections: %.2f us per nomination and re-ranking\n",
+         kNumConnections, static_cast<double>(elapsed_us) / kNumNominations);
+}
+
 class P2PTransportChannelMostLikelyToWorkFirstTest
     : public P2PTransportChannelPingTest {
  public:
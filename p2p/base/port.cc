@@ -383,6 +383,8 @@ const std::vector<Candidate>& Port::Candidates() const {
 }
 
 Connection* Port::GetConnection(const rtc::SocketAddress& remote_addr) {
+  if (ConnectionAddressTable::CanIndex(remote_addr))
+    return connection_table_.Find(remote_addr);
   AddressMap::const_iterator iter = connections_.find(remote_addr);
   if (iter != connections_.end())
     return iter->second;
@@ -508,6 +510,8 @@ void Port::AddOrReplaceConnection(Connection* conn)
     ret.first->second->Destroy();
     ret.first->second = conn;
   }
+  if (ConnectionAddressTable::CanIndex(ret.first->first))
+    connection_table_.Insert(ret.first->first, conn);
 #if 0
   RTC_NORMAL_EX_LOG("insert --> [%s]",
                     conn->remote_candidate().address().ToString().c_str());
@@ -608,10 +612,12 @@ bool Port::GetStunMessage(const char* data, size_t size, const rtc::SocketAddres
   RTC_DCHECK(out_username != NULL);
   out_username->clear();
 
-  // Don't bother parsing the packet if we can tell it's not STUN.
-  // In ICE mode, all STUN packets will have a valid fingerprint.
+  // Don't bother parsing the packet if we can tell it's not STUN. Media is
+  // rejected by its first byte; in ICE mode, all STUN packets will have a
+  // valid fingerprint.
   // TODO@chensong 2023-04-07 验证是否stun协议
-  if (!StunMessage::ValidateFingerprint(data, size)) 
+  if (!IsStunPacket(data, size) ||
+      !StunMessage::ValidateFingerprint(data, size)) 
   {
     return false;
   }
@@ -664,7 +670,8 @@ bool Port::GetStunMessage(const char* data, size_t size, const rtc::SocketAddres
 
     // If ICE, and the MESSAGE-INTEGRITY is bad, fail with a 401 Unauthorized
 	// TODO@chensong 2023-04-07 stun协议数据的完整性验证 还有拿到密码
-    if (!stun_msg->ValidateMessageIntegrity(data, size, password_)) 
+    password_key_.SetPassword(password_);
+    if (!stun_msg->ValidateMessageIntegrity(data, size, &password_key_)) 
 	{
       RTC_LOG(LS_ERROR) << ToString()
                         << ": Received STUN request with bad M-I from "
@@ -1053,6 +1060,7 @@ void Port::OnConnectionDestroyed(Connection* conn) {
 #endif //_DEBUGMSG
   RTC_LOG(INFO) << __FUNCTION__ << "][ " << __LINE__ << "] ["
                 << conn->remote_candidate().address().ToString() << "]";
+  connection_table_.Erase(iter->first);
   connections_.erase(iter);
   HandleConnectionDestroyed(conn);
 
@@ -1428,7 +1436,8 @@ void Connection::OnReadPacket(const char* data, size_t size, int64_t packet_time
       // id's match.
       case STUN_BINDING_RESPONSE:
       case STUN_BINDING_ERROR_RESPONSE:
-        if (msg->ValidateMessageIntegrity(data, size, remote_candidate().password())) 
+        remote_password_key_.SetPassword(remote_candidate().password());
+        if (msg->ValidateMessageIntegrity(data, size, &remote_password_key_)) 
 		{
           requests_.CheckResponse(msg.get());
         }
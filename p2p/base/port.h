@@ -24,6 +24,7 @@
 #include "logging/rtc_event_log/events/rtc_event_ice_candidate_pair_config.h"
 #include "logging/rtc_event_log/ice_logger.h"
 #include "p2p/base/candidate_pair_interface.h"
+#include "p2p/base/connection_address_table.h"
 #include "p2p/base/p2p_constants.h"
 #include "p2p/base/packet_socket_factory.h"
 #include "p2p/base/port_interface.h"
@@ -492,8 +493,13 @@ class Port : public PortInterface,
   // username_fragment().
   std::string ice_username_fragment_;
   std::string password_;
+  // HMAC state of |password_|, for the M-I of every received binding request.
+  StunMessageIntegrityKey password_key_;
   std::vector<Candidate> candidates_;
   AddressMap connections_;
+  // Index of |connections_| by resolved remote address, for the lookup of
+  // every received packet.
+  ConnectionAddressTable connection_table_;
   int timeout_delay_;
   bool enable_port_packets_;
   IceRole ice_role_;
@@ -780,6 +786,8 @@ class Connection : public CandidatePairInterface,
   Port* port_;
   size_t local_candidate_index_;
   Candidate remote_candidate_;
+  // HMAC state of the remote password, for the M-I of binding responses.
+  StunMessageIntegrityKey remote_password_key_;
 
   ConnectionInfo stats_;
   rtc::RateTracker recv_rate_tracker_;
@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_turn_server.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/stun_server.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/location.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/socket_server.h"
+#include "rtc_base/string_encode.h"
+
+namespace cricket {
+
+struct ShardedTurnServer::Shard {
+  std::unique_ptr<rtc::Thread> thread;
+  // Created and destroyed on |thread|.
+  std::unique_ptr<TurnServer> turn_server;
+  std::unique_ptr<StunServer> stun_server;
+};
+
+ShardedTurnServer::ShardedTurnServer(int num_threads) {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    auto shard = absl::make_unique<Shard>();
+    shard->thread = rtc::Thread::CreateWithSocketServer();
+    shard->thread->SetName("TurnServer" + rtc::ToString(i), nullptr);
+    shard->thread->Start();
+    shards_.push_back(std::move(shard));
+  }
+}
+
+ShardedTurnServer::~ShardedTurnServer() {
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    s->thread->Invoke<void>(RTC_FROM_HERE, [s] {
+      s->stun_server.reset();
+      s->turn_server.reset();
+    });
+    s->thread->Stop();
+  }
+}
+
+bool ShardedTurnServer::Start(const rtc::SocketAddress& int_addr,
+                              const rtc::IPAddress& ext_ip,
+                              const ConfigureCallback& configure) {
+  RTC_DCHECK(int_addr_.IsNil());
+  rtc::SocketAddress addr = int_addr;
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    bool started = s->thread->Invoke<bool>(RTC_FROM_HERE, [&] {
+      rtc::AsyncUDPSocket* socket = CreateListenSocket(s->thread.get(), addr);
+      if (!socket)
+        return false;
+      addr = socket->GetLocalAddress();
+      s->turn_server = absl::make_unique<TurnServer>(s->thread.get());
+      if (configure)
+        configure(s->turn_server.get());
+      s->turn_server->AddInternalSocket(socket, PROTO_UDP);
+      // Relayed sockets are created on, and served by, the owning thread.
+      s->turn_server->SetExternalSocketFactory(
+          new rtc::BasicPacketSocketFactory(s->thread.get()),
+          rtc::SocketAddress(ext_ip, 0));
+      return true;
+    });
+    if (!started) {
+      RTC_LOG(LS_ERROR) << "Failed to listen on " << addr.ToString();
+      StopTurnServers();
+      return false;
+    }
+  }
+  int_addr_ = addr;
+  RTC_LOG(LS_INFO) << "TURN server listening on " << int_addr_.ToString()
+                   << " with " << shards_.size() << " threads";
+  return true;
+}
+
+bool ShardedTurnServer::StartStunServer(const rtc::SocketAddress& addr) {
+  RTC_DCHECK(stun_addr_.IsNil());
+  rtc::SocketAddress bound_addr = addr;
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    bool started = s->thread->Invoke<bool>(RTC_FROM_HERE, [&] {
+      rtc::AsyncUDPSocket* socket =
+          CreateListenSocket(s->thread.get(), bound_addr);
+      if (!socket)
+        return false;
+      bound_addr = socket->GetLocalAddress();
+      s->stun_server = absl::make_unique<StunServer>(socket);
+      return true;
+    });
+    if (!started) {
+      RTC_LOG(LS_ERROR) << "Failed to listen on " << bound_addr.ToString();
+      StopStunServers();
+      return false;
+    }
+  }
+  stun_addr_ = bound_addr;
+  return true;
+}
+
+std::vector<size_t> ShardedTurnServer::GetAllocationCounts() const {
+  std::vector<size_t> counts;
+  for (const auto& shard : shards_) {
+    const Shard* s = shard.get();
+    counts.push_back(s->thread->Invoke<size_t>(RTC_FROM_HERE, [s] {
+      return s->turn_server ? s->turn_server->allocations().size() : 0;
+    }));
+  }
+  return counts;
+}
+
+void ShardedTurnServer::StopTurnServers() {
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    s->thread->Invoke<void>(RTC_FROM_HERE, [s] { s->turn_server.reset(); });
+  }
+}
+
+void ShardedTurnServer::StopStunServers() {
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    s->thread->Invoke<void>(RTC_FROM_HERE, [s] { s->stun_server.reset(); });
+  }
+}
+
+rtc::AsyncUDPSocket* ShardedTurnServer::CreateListenSocket(
+    rtc::Thread* thread,
+    const rtc::SocketAddress& addr) const {
+  RTC_DCHECK(thread->IsCurrent());
+  rtc::AsyncSocket* socket =
+      thread->socketserver()->CreateAsyncSocket(addr.family(), SOCK_DGRAM);
+  if (!socket)
+    return nullptr;
+  // A single thread doesn't need to share the port, which keeps that mode
+  // working where SO_REUSEPORT is unavailable.
+  if (shards_.size() > 1 &&
+      socket->SetOption(rtc::Socket::OPT_REUSEPORT, 1) != 0) {
+    RTC_LOG(LS_ERROR) << "Can't share " << addr.ToString()
+                      << " between threads without SO_REUSEPORT";
+    delete socket;
+    return nullptr;
+  }
+  return rtc::AsyncUDPSocket::Create(socket, addr);
+}
+
+}  // namespace cricket
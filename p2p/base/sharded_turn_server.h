@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_SHARDED_TURN_SERVER_H_
+#define P2P_BASE_SHARDED_TURN_SERVER_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "p2p/base/turn_server.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/ip_address.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/thread.h"
+
+namespace cricket {
+
+// Runs a TurnServer, and optionally a StunServer, on each of several threads
+// so that relaying can use more than one core. Every thread listens on its own
+// UDP socket bound to the shared address with SO_REUSEPORT, and the kernel
+// spreads clients over the sockets by hashing their 5-tuple. All packets of a
+// client thus reach the same thread, which owns the client's allocation and
+// creates its relayed socket; the servers share no state.
+//
+// Only UDP is supported on the internal side. Hooks installed on the servers
+// are called from all threads and must be thread-safe.
+class ShardedTurnServer {
+ public:
+  // Configures the TurnServer of one thread, e.g. with set_realm() and
+  // set_auth_hook(). Called on that thread, before it starts listening.
+  typedef std::function<void(TurnServer*)> ConfigureCallback;
+
+  explicit ShardedTurnServer(int num_threads);
+  // Destroys the servers on their threads and stops the threads.
+  ~ShardedTurnServer();
+
+  // Listens on |int_addr| and relays through sockets bound to |ext_ip|. If the
+  // port of |int_addr| is 0, all threads share the port picked for the first
+  // one. Returns false if a socket couldn't be bound, after stopping the
+  // servers already started on other threads.
+  bool Start(const rtc::SocketAddress& int_addr,
+             const rtc::IPAddress& ext_ip,
+             const ConfigureCallback& configure);
+  // Answers STUN binding requests on |addr| on every thread as well. Like
+  // Start(), stops all of them again if one fails to bind.
+  bool StartStunServer(const rtc::SocketAddress& addr);
+
+  int num_threads() const { return static_cast<int>(shards_.size()); }
+  // The addresses shared by all threads, nil until started.
+  const rtc::SocketAddress& internal_address() const { return int_addr_; }
+  const rtc::SocketAddress& stun_address() const { return stun_addr_; }
+
+  // Returns the number of allocations owned by each thread.
+  std::vector<size_t> GetAllocationCounts() const;
+
+ private:
+  struct Shard;
+
+  // Destroy the servers of every thread, on that thread.
+  void StopTurnServers();
+  void StopStunServers();
+
+  // Binds a UDP socket on |thread|, sharing |addr| with the other threads.
+  rtc::AsyncUDPSocket* CreateListenSocket(rtc::Thread* thread,
+                                          const rtc::SocketAddress& addr) const;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  rtc::SocketAddress int_addr_;
+  rtc::SocketAddress stun_addr_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ShardedTurnServer);
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_SHARDED_TURN_SERVER_H_
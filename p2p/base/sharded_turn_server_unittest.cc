@@ -0,0 +1,180 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_turn_server.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/test_turn_client.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/physical_socket_server.h"
+#include "rtc_base/test_client.h"
+#include "test/gtest.h"
+
+#if defined(WEBRTC_POSIX)
+#include <sys/socket.h>
+#endif
+
+// Sharing the listening port between the threads needs SO_REUSEPORT.
+#if defined(WEBRTC_POSIX) && defined(SO_REUSEPORT)
+
+namespace cricket {
+
+namespace {
+
+const char kRealm[] = "example.org";
+// The password of every user is its username.
+const char kUsername[] = "test";
+const int kNumThreads = 4;
+
+}  // namespace
+
+// Uses real sockets on the loopback interface, since the threads of the server
+// each run their own socket server.
+class ShardedTurnServerTest : public ::testing::Test,
+                              public TurnAuthInterface {
+ public:
+  ShardedTurnServerTest()
+      : thread_(&ss_), socket_factory_(&thread_), server_(kNumThreads) {}
+
+  // Called on all server threads.
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return ComputeStunCredentialHash(username, realm, username, key);
+  }
+
+ protected:
+  bool StartServer() {
+    const rtc::IPAddress loopback(INADDR_LOOPBACK);
+    return server_.Start(rtc::SocketAddress(loopback, 0), loopback,
+                         [this](TurnServer* turn_server) {
+                           turn_server->set_realm(kRealm);
+                           turn_server->set_auth_hook(this);
+                         });
+  }
+
+  std::unique_ptr<rtc::TestClient> CreateClient() {
+    return absl::make_unique<rtc::TestClient>(
+        absl::WrapUnique(socket_factory_.CreateUdpSocket(
+            rtc::SocketAddress(rtc::IPAddress(INADDR_LOOPBACK), 0), 0, 0)));
+  }
+
+  // Sends requests from |client| to the server and waits for the response.
+  TestTurnClient::Exchange ExchangeWith(rtc::TestClient* client) {
+    return [this, client](const char* data, size_t size) {
+      client->SendTo(data, size, server_.internal_address());
+      std::unique_ptr<rtc::TestClient::Packet> packet =
+          client->NextPacket(rtc::TestClient::kTimeoutMs);
+      return packet ? std::string(packet->buf, packet->size) : std::string();
+    };
+  }
+
+  rtc::PhysicalSocketServer ss_;
+  rtc::AutoSocketServerThread thread_;
+  rtc::BasicPacketSocketFactory socket_factory_;
+  ShardedTurnServer server_;
+};
+
+TEST_F(ShardedTurnServerTest, SpreadsAllocationsOverThreads) {
+  static const int kNumClients = 32;
+  ASSERT_TRUE(StartServer());
+  EXPECT_NE(0, server_.internal_address().port());
+
+  std::vector<std::unique_ptr<rtc::TestClient>> clients;
+  for (int i = 0; i < kNumClients; ++i) {
+    clients.push_back(CreateClient());
+    // Each thread hands out its own nonces, so each client authenticates
+    // separately.
+    TestTurnClient turn_client(kUsername, kRealm);
+    ASSERT_FALSE(
+        turn_client.Allocate(ExchangeWith(clients.back().get())).IsNil());
+  }
+
+  std::vector<size_t> counts = server_.GetAllocationCounts();
+  ASSERT_EQ(static_cast<size_t>(kNumThreads), counts.size());
+  size_t total = 0;
+  int busy_threads = 0;
+  for (size_t count : counts) {
+    total += count;
+    if (count > 0)
+      ++busy_threads;
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumClients), total);
+  // The kernel hashes the clients' ports over the sockets; it would be
+  // astronomically unlikely to pick one socket for all of them.
+  EXPECT_GT(busy_threads, 1);
+}
+
+TEST_F(ShardedTurnServerTest, RelaysThroughOwningThread) {
+  ASSERT_TRUE(StartServer());
+  std::unique_ptr<rtc::TestClient> client = CreateClient();
+  std::unique_ptr<rtc::TestClient> peer = CreateClient();
+  TestTurnClient turn_client(kUsername, kRealm);
+  rtc::SocketAddress relayed = turn_client.Allocate(ExchangeWith(client.get()));
+  ASSERT_FALSE(relayed.IsNil());
+  EXPECT_EQ(rtc::IPAddress(INADDR_LOOPBACK), relayed.ipaddr());
+
+  TurnMessage bind;
+  bind.SetType(TURN_CHANNEL_BIND_REQUEST);
+  bind.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+      STUN_ATTR_CHANNEL_NUMBER, 0x4000 << 16));
+  bind.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+      STUN_ATTR_XOR_PEER_ADDRESS, peer->address()));
+  TurnMessage response;
+  ASSERT_TRUE(
+      turn_client.SendRequest(ExchangeWith(client.get()), &bind, &response));
+  ASSERT_EQ(TURN_CHANNEL_BIND_RESPONSE, response.type());
+
+  const char kChannelData[] = {0x40, 0x00, 0x00, 0x04, 'd', 'a', 't', 'a'};
+  client->SendTo(kChannelData, sizeof(kChannelData),
+                 server_.internal_address());
+  rtc::SocketAddress from;
+  EXPECT_TRUE(peer->CheckNextPacket("data", 4, &from));
+  EXPECT_EQ(relayed, from);
+
+  peer->SendTo("data", 4, relayed);
+  EXPECT_TRUE(
+      client->CheckNextPacket(kChannelData, sizeof(kChannelData), nullptr));
+}
+
+TEST_F(ShardedTurnServerTest, AnswersStunBindingRequests) {
+  ASSERT_TRUE(server_.StartStunServer(
+      rtc::SocketAddress(rtc::IPAddress(INADDR_LOOPBACK), 0)));
+  std::unique_ptr<rtc::TestClient> client = CreateClient();
+
+  StunMessage request;
+  request.SetType(STUN_BINDING_REQUEST);
+  request.SetTransactionID(rtc::CreateRandomString(kStunTransactionIdLength));
+  rtc::ByteBufferWriter buf;
+  request.Write(&buf);
+  client->SendTo(buf.Data(), buf.Length(), server_.stun_address());
+  std::unique_ptr<rtc::TestClient::Packet> packet =
+      client->NextPacket(rtc::TestClient::kTimeoutMs);
+  ASSERT_TRUE(packet);
+  StunMessage response;
+  rtc::ByteBufferReader reader(packet->buf, packet->size);
+  ASSERT_TRUE(response.Read(&reader));
+  EXPECT_EQ(STUN_BINDING_RESPONSE, response.type());
+  const StunAddressAttribute* mapped =
+      response.GetAddress(STUN_ATTR_MAPPED_ADDRESS);
+  ASSERT_TRUE(mapped);
+  EXPECT_EQ(client->address(), mapped->GetAddress());
+}
+
+}  // namespace cricket
+
+#endif  // defined(WEBRTC_POSIX) && defined(SO_REUSEPORT)
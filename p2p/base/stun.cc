@@ -22,6 +22,7 @@
 #include "rtc_base/crc32.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/message_digest.h"
+#include "rtc_base/openssl_digest.h"
 
 using rtc::ByteBufferReader;
 using rtc::ByteBufferWriter;
@@ -64,6 +65,25 @@ const uint32_t STUN_FINGERPRINT_XOR_VALUE = 0x5354554E;
 
 // StunMessage
 
+StunMessageIntegrityKey::StunMessageIntegrityKey()
+    : StunMessageIntegrityKey(std::string()) {}
+
+StunMessageIntegrityKey::StunMessageIntegrityKey(const std::string& password)
+    : password_(password),
+      hmac_(new rtc::OpenSSLHmac(rtc::DIGEST_SHA_1,
+                                 password.data(),
+                                 password.size())) {}
+
+StunMessageIntegrityKey::~StunMessageIntegrityKey() = default;
+
+void StunMessageIntegrityKey::SetPassword(const std::string& password) {
+  if (password == password_)
+    return;
+  password_ = password;
+  hmac_.reset(new rtc::OpenSSLHmac(rtc::DIGEST_SHA_1, password.data(),
+                                   password.size()));
+}
+
 StunMessage::StunMessage()
     : type_(0),
       length_(0),
@@ -180,8 +200,16 @@ const StunUInt16ListAttribute* StunMessage::GetUnknownAttributes() const {
 
 // Verifies a STUN message has a valid MESSAGE-INTEGRITY attribute, using the
 // procedure outlined in RFC 5389, section 15.4.
-bool StunMessage::ValidateMessageIntegrity(const char* data, size_t size, const std::string& password) 
-{
+bool StunMessage::ValidateMessageIntegrity(const char* data,
+                                           size_t size,
+                                           const std::string& password) {
+  StunMessageIntegrityKey key(password);
+  return ValidateMessageIntegrity(data, size, &key);
+}
+
+bool StunMessage::ValidateMessageIntegrity(const char* data,
+                                           size_t size,
+                                           StunMessageIntegrityKey* key) {
    // TODO@chensong 2023-04-07 stun MESSAGE-INTEGRITY 数据的长度24字节 ^_^
   // Verifying the size of the message.
   if ((size % 4) != 0 || size < kStunHeaderSize) 
@@ -239,36 +267,34 @@ bool StunMessage::ValidateMessageIntegrity(const char* data, size_t size, const
     return false;
   }
 
-  // Getting length of the message to calculate Message Integrity.
+  // Hash the message up to the M-I attribute in place. The length field is
+  // taken to end with M-I, which differs from the header when other attributes
+  // (e.g. FINGERPRINT) follow it.
+  //      0                   1                   2                   3
+  //      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  //     |0 0|     STUN Message Type     |         Message Length        |
+  //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   size_t mi_pos = current_pos;
-  std::unique_ptr<char[]> temp_data(new char[current_pos]);
-  memcpy(temp_data.get(), data, current_pos);
-  if (size > mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize)
-  {
-    // Stun message has other attributes after message integrity.
-    // Adjust the length parameter in stun message to calculate HMAC.
-    size_t extra_offset = size - (mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize);
-    size_t new_adjusted_len = size - extra_offset - kStunHeaderSize;
-
-    // Writing new length of the STUN message @ Message Length in temp buffer.
-    //      0                   1                   2                   3
-    //      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //     |0 0|     STUN Message Type     |         Message Length        |
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    rtc::SetBE16(temp_data.get() + 2, static_cast<uint16_t>(new_adjusted_len));
-  }
-
-  char hmac[kStunMessageIntegritySize];
-  size_t ret = rtc::ComputeHmac(rtc::DIGEST_SHA_1, password.c_str(), password.size(),
-                       temp_data.get(), mi_pos, hmac, sizeof(hmac));
-  RTC_DCHECK(ret == sizeof(hmac));
-  if (ret != sizeof(hmac))
+  uint8_t adjusted_length[2];
+  rtc::SetBE16(adjusted_length,
+               static_cast<uint16_t>(mi_pos + kStunAttributeHeaderSize +
+                                     kStunMessageIntegritySize -
+                                     kStunHeaderSize));
+  rtc::OpenSSLHmac* hmac = key->hmac_.get();
+  hmac->Update(data, 2);
+  hmac->Update(adjusted_length, sizeof(adjusted_length));
+  hmac->Update(data + 4, mi_pos - 4);
+
+  char computed[kStunMessageIntegritySize];
+  size_t ret = hmac->Finish(computed, sizeof(computed));
+  RTC_DCHECK(ret == sizeof(computed));
+  if (ret != sizeof(computed))
     return false;
 
   // Comparing the calculated HMAC with the one present in the message.
-  return memcmp(data + current_pos + kStunAttributeHeaderSize, hmac,
-                sizeof(hmac)) == 0;
+  return memcmp(data + current_pos + kStunAttributeHeaderSize, computed,
+                sizeof(computed)) == 0;
 }
 
 bool StunMessage::AddMessageIntegrity(const std::string& password) {
@@ -1046,6 +1072,10 @@ int GetStunErrorResponseType(int req_type) {
   return IsStunRequestType(req_type) ? (req_type | 0x110) : -1;
 }
 
+bool IsStunPacket(const char* data, size_t size) {
+  return size >= kStunHeaderSize && static_cast<uint8_t>(data[0]) < 4;
+}
+
 bool IsStunRequestType(int msg_type) {
   return ((msg_type & kStunTypeMask) == 0x000);
 }
@@ -21,9 +21,14 @@
 #include <vector>
 
 #include "rtc_base/byte_buffer.h"
+#include "rtc_base/constructor_magic.h"
 #include "rtc_base/ip_address.h"
 #include "rtc_base/socket_address.h"
 
+namespace rtc {
+class OpenSSLHmac;
+}  // namespace rtc
+
 namespace cricket {
 
 // These are the types of STUN messages defined in RFC 5389.
@@ -129,6 +134,29 @@ class StunUInt32Attribute;
 class StunUInt64Attribute;
 class StunXorAddressAttribute;
 
+// The key of MESSAGE-INTEGRITY attributes, typically an ICE password, with its
+// HMAC-SHA1 state precomputed. Validating a message with it needs no key setup
+// and no allocation, which adds up over the binding requests and responses of
+// many connections.
+class StunMessageIntegrityKey {
+ public:
+  StunMessageIntegrityKey();
+  explicit StunMessageIntegrityKey(const std::string& password);
+  ~StunMessageIntegrityKey();
+
+  // Rekeys, unless |password| is the current password.
+  void SetPassword(const std::string& password);
+  const std::string& password() const { return password_; }
+
+ private:
+  friend class StunMessage;
+
+  std::string password_;
+  std::unique_ptr<rtc::OpenSSLHmac> hmac_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(StunMessageIntegrityKey);
+};
+
 // Records a complete STUN/TURN message.  Each message consists of a type and
 // any number of attributes.  Each attribute is parsed into an instance of an
 // appropriate class (see above).  The Get* methods will return instances of
@@ -178,6 +206,11 @@ class StunMessage {
   static bool ValidateMessageIntegrity(const char* data,
                                        size_t size,
                                        const std::string& password);
+  // As above, but with a key that is reused across messages. The message is
+  // hashed in place.
+  static bool ValidateMessageIntegrity(const char* data,
+                                       size_t size,
+                                       StunMessageIntegrityKey* key);
   // Adds a MESSAGE-INTEGRITY attribute that is valid for the current message.
   bool AddMessageIntegrity(const std::string& password);
   bool AddMessageIntegrity(const char* key, size_t keylen);
@@ -474,6 +507,11 @@ int GetStunSuccessResponseType(int request_type);
 // Returns -1 if |request_type| is not a valid request type.
 int GetStunErrorResponseType(int request_type);
 
+// Returns whether |data| may be a STUN message, judging only from its length
+// and first byte. STUN messages start with 0-3 (RFC 7983), so this tells them
+// apart from RTP, RTCP and DTLS without parsing.
+bool IsStunPacket(const char* data, size_t size);
+
 // Returns whether a given message is a request type.
 bool IsStunRequestType(int msg_type);
 
@@ -431,7 +431,8 @@ void UDPPort::OnReadPacket(rtc::AsyncPacketSocket* socket,
   // Even if the response doesn't match one of our outstanding requests, we
   // will eat it because it might be a response to a retransmitted packet, and
   // we already cleared the request when we got the first response.
-  if (server_addresses_.find(remote_addr) != server_addresses_.end())
+  if (IsStunPacket(data, size) &&
+      server_addresses_.find(remote_addr) != server_addresses_.end())
   {
     requests_.CheckResponse(data, size);
     return;
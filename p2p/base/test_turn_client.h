@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_TEST_TURN_CLIENT_H_
+#define P2P_BASE_TEST_TURN_CLIENT_H_
+
+#include <functional>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/socket_address.h"
+
+namespace cricket {
+
+// Speaks the client side of the TURN control protocol for server tests. The
+// transport is up to the test: an Exchange sends a serialized request and
+// returns the raw response, or an empty string if none arrived.
+class TestTurnClient {
+ public:
+  using Exchange = std::function<std::string(const char* data, size_t size)>;
+
+  // The password of |username| is assumed to be the username itself.
+  TestTurnClient(const std::string& username, const std::string& realm)
+      : username_(username), realm_(realm) {
+    ComputeStunCredentialHash(username_, realm_, username_, &key_);
+  }
+
+  // Sends |request| and parses the response into |response|. Requests are
+  // authenticated once the server has handed out a nonce.
+  bool SendRequest(const Exchange& exchange,
+                   TurnMessage* request,
+                   TurnMessage* response) {
+    request->SetTransactionID(
+        rtc::CreateRandomString(kStunTransactionIdLength));
+    if (!nonce_.empty()) {
+      request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+          STUN_ATTR_USERNAME, username_));
+      request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+          STUN_ATTR_REALM, realm_));
+      request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+          STUN_ATTR_NONCE, nonce_));
+      request->AddMessageIntegrity(key_);
+    }
+    rtc::ByteBufferWriter buf;
+    request->Write(&buf);
+    std::string packet = exchange(buf.Data(), buf.Length());
+    if (packet.empty())
+      return false;
+    rtc::ByteBufferReader reader(packet.data(), packet.size());
+    return response->Read(&reader) &&
+           response->transaction_id() == request->transaction_id();
+  }
+
+  // Allocates a relayed address, or returns a nil address on failure.
+  rtc::SocketAddress Allocate(const Exchange& exchange) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      TurnMessage request;
+      request.SetType(STUN_ALLOCATE_REQUEST);
+      request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+          STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+      TurnMessage response;
+      if (!SendRequest(exchange, &request, &response))
+        break;
+      if (response.type() == STUN_ALLOCATE_RESPONSE) {
+        const StunAddressAttribute* relayed =
+            response.GetAddress(STUN_ATTR_XOR_RELAYED_ADDRESS);
+        return relayed ? relayed->GetAddress() : rtc::SocketAddress();
+      }
+      // The first request is rejected with the nonce to authenticate with.
+      const StunByteStringAttribute* nonce =
+          response.GetByteString(STUN_ATTR_NONCE);
+      if (!nonce)
+        break;
+      nonce_ = nonce->GetString();
+    }
+    return rtc::SocketAddress();
+  }
+
+ private:
+  const std::string username_;
+  const std::string realm_;
+  std::string key_;
+  std::string nonce_;
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_TEST_TURN_CLIENT_H_
@@ -11,17 +11,19 @@
 #ifndef P2P_BASE_TURN_SERVER_H_
 #define P2P_BASE_TURN_SERVER_H_
 
-#include <list>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "p2p/base/port_interface.h"
 #include "rtc_base/async_invoker.h"
 #include "rtc_base/async_packet_socket.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/ip_address.h"
 #include "rtc_base/message_queue.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
@@ -49,10 +51,17 @@ class TurnServerConnection {
   TurnServerConnection(const rtc::SocketAddress& src,
                        ProtocolType proto,
                        rtc::AsyncPacketSocket* socket);
+  // Takes the remote address of |socket| as |dst|, which saves a system call
+  // per packet for callers that already know it.
+  TurnServerConnection(const rtc::SocketAddress& src,
+                       ProtocolType proto,
+                       rtc::AsyncPacketSocket* socket,
+                       const rtc::SocketAddress& dst);
   const rtc::SocketAddress& src() const { return src_; }
   rtc::AsyncPacketSocket* socket() { return socket_; }
   bool operator==(const TurnServerConnection& t) const;
   bool operator<(const TurnServerConnection& t) const;
+  size_t Hash() const;
   std::string ToString() const;
 
  private:
@@ -62,6 +71,12 @@ class TurnServerConnection {
   rtc::AsyncPacketSocket* socket_;
 };
 
+struct TurnServerConnectionHash {
+  size_t operator()(const TurnServerConnection& conn) const {
+    return conn.Hash();
+  }
+};
+
 // Encapsulates a TURN allocation.
 // The object is created when an allocation request is received, and then
 // handles TURN messages (via HandleTurnMessage) and channel data messages
@@ -95,8 +110,21 @@ class TurnServerAllocation : public rtc::MessageHandler,
  private:
   class Channel;
   class Permission;
-  typedef std::list<Permission*> PermissionList;
-  typedef std::list<Channel*> ChannelList;
+  struct IPAddressHash {
+    size_t operator()(const rtc::IPAddress& ip) const {
+      return rtc::HashIP(ip);
+    }
+  };
+  struct SocketAddressHash {
+    size_t operator()(const rtc::SocketAddress& addr) const {
+      return addr.Hash();
+    }
+  };
+  typedef std::unordered_map<rtc::IPAddress, Permission*, IPAddressHash>
+      PermissionMap;
+  typedef std::unordered_map<int, Channel*> ChannelIdMap;
+  typedef std::unordered_map<rtc::SocketAddress, Channel*, SocketAddressHash>
+      ChannelPeerMap;
 
   void HandleAllocateRequest(const TurnMessage* msg);
   void HandleRefreshRequest(const TurnMessage* msg);
@@ -137,8 +165,13 @@ class TurnServerAllocation : public rtc::MessageHandler,
   std::string username_;
   std::string origin_;
   std::string last_nonce_;
-  PermissionList perms_;
-  ChannelList channels_;
+  // Permissions by peer IP, and channels by number and by peer address; every
+  // relayed packet looks up one of them.
+  PermissionMap perms_;
+  ChannelIdMap channels_by_id_;
+  ChannelPeerMap channels_by_peer_;
+  // Reused for every ChannelData message relayed to the client.
+  rtc::Buffer channel_data_;
 };
 
 // An interface through which the MD5 credential hash can be retrieved.
@@ -173,7 +206,9 @@ class StunMessageObserver {
 // Not yet wired up: TCP support.
 class TurnServer : public sigslot::has_slots<> {
  public:
-  typedef std::map<TurnServerConnection, std::unique_ptr<TurnServerAllocation>>
+  typedef std::unordered_map<TurnServerConnection,
+                             std::unique_ptr<TurnServerAllocation>,
+                             TurnServerConnectionHash>
       AllocationMap;
 
   explicit TurnServer(rtc::Thread* thread);
@@ -299,6 +334,7 @@ class TurnServer : public sigslot::has_slots<> {
 
   void SendStun(TurnServerConnection* conn, StunMessage* msg);
   void Send(TurnServerConnection* conn, const rtc::ByteBufferWriter& buf);
+  void Send(TurnServerConnection* conn, const char* data, size_t size);
 
   void OnAllocationDestroyed(TurnServerAllocation* allocation);
   void DestroyInternalSocket(rtc::AsyncPacketSocket* socket);
@@ -306,8 +342,12 @@ class TurnServer : public sigslot::has_slots<> {
   // Just clears |sockets_to_delete_|; called asynchronously.
   void FreeSockets();
 
-  typedef std::map<rtc::AsyncPacketSocket*,
-                   ProtocolType> InternalSocketMap;
+  struct InternalSocket {
+    ProtocolType proto;
+    // Looked up once; GetRemoteAddress() is a system call on real sockets.
+    rtc::SocketAddress remote_address;
+  };
+  typedef std::map<rtc::AsyncPacketSocket*, InternalSocket> InternalSocketMap;
   typedef std::map<rtc::AsyncSocket*,
                    ProtocolType> ServerSocketMap;
 
@@ -10,13 +10,23 @@
 
 #include "p2p/base/turn_server.h"
 
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/test_turn_client.h"
+#include "p2p/base/test_turn_server.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/virtual_socket_server.h"
 #include "test/gtest.h"
 
-// NOTE: This is a work in progress. Currently this file only has tests for
-// TurnServerConnection, a primitive class used by TurnServer.
-
 namespace cricket {
 
 class TurnServerConnectionTest : public ::testing::Test {
@@ -64,4 +74,225 @@ TEST_F(TurnServerConnectionTest, ComparisonOperators) {
   ExpectNotEqual(connection1, connection4);
 }
 
+namespace {
+
+const rtc::SocketAddress kTurnIntAddr("99.99.99.3", 3478);
+const rtc::SocketAddress kTurnExtAddr("99.99.99.5", 0);
+// TestTurnServer uses the username as password.
+const char kUsername[] = "test";
+const int kTimeout = 1000;
+
+// A UDP endpoint that remembers the last packet it received.
+class TestEndpoint : public sigslot::has_slots<> {
+ public:
+  explicit TestEndpoint(rtc::AsyncPacketSocket* socket) : socket_(socket) {
+    socket_->SignalReadPacket.connect(this, &TestEndpoint::OnReadPacket);
+  }
+
+  rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+  int packets_received() const { return packets_received_; }
+  const std::string& last_packet() const { return last_packet_; }
+  const rtc::SocketAddress& last_sender() const { return last_sender_; }
+
+  void SendTo(const char* data, size_t size, const rtc::SocketAddress& addr) {
+    socket_->SendTo(data, size, addr, rtc::PacketOptions());
+  }
+  void SendTo(const std::string& data, const rtc::SocketAddress& addr) {
+    SendTo(data.data(), data.size(), addr);
+  }
+  void Reset() {
+    packets_received_ = 0;
+    last_packet_.clear();
+  }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& remote_addr,
+                    const int64_t& packet_time_us) {
+    ++packets_received_;
+    last_packet_.assign(data, size);
+    last_sender_ = remote_addr;
+  }
+
+  std::unique_ptr<rtc::AsyncPacketSocket> socket_;
+  int packets_received_ = 0;
+  std::string last_packet_;
+  rtc::SocketAddress last_sender_;
+};
+
+std::string ChannelData(uint16_t channel_id, const std::string& payload) {
+  std::string packet(4, '\0');
+  rtc::SetBE16(&packet[0], channel_id);
+  rtc::SetBE16(&packet[2], static_cast<uint16_t>(payload.size()));
+  return packet + payload;
+}
+
+// Sends requests from |client| to the server and waits for the response.
+TestTurnClient::Exchange ExchangeWith(TestEndpoint* client) {
+  return [client](const char* data, size_t size) {
+    client->Reset();
+    client->SendTo(data, size, kTurnIntAddr);
+    bool received;
+    WAIT_(client->packets_received() > 0, kTimeout, received);
+    return received ? client->last_packet() : std::string();
+  };
+}
+
+}  // namespace
+
+// Drives a TestTurnServer through the client side of the protocol.
+class TurnServerTest : public ::testing::Test {
+ public:
+  TurnServerTest()
+      : thread_(&vss_),
+        turn_server_(&thread_, kTurnIntAddr, kTurnExtAddr),
+        turn_client_(kUsername, kTestRealm) {}
+
+ protected:
+  std::unique_ptr<TestEndpoint> CreateEndpoint(const std::string& ip) {
+    return absl::make_unique<TestEndpoint>(socket_factory_.CreateUdpSocket(
+        rtc::SocketAddress(ip, 0), 0, 0));
+  }
+
+  // Sends |request| from |client| and parses the response into |response|.
+  bool SendRequest(TestEndpoint* client,
+                   TurnMessage* request,
+                   TurnMessage* response) {
+    return turn_client_.SendRequest(ExchangeWith(client), request, response);
+  }
+
+  // Allocates a relayed address for |client|.
+  rtc::SocketAddress Allocate(TestEndpoint* client) {
+    return turn_client_.Allocate(ExchangeWith(client));
+  }
+
+  // Returns the response type of a ChannelBind request.
+  int BindChannel(TestEndpoint* client,
+                  uint16_t channel_id,
+                  const rtc::SocketAddress& peer) {
+    TurnMessage request;
+    request.SetType(TURN_CHANNEL_BIND_REQUEST);
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_CHANNEL_NUMBER, channel_id << 16));
+    request.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_PEER_ADDRESS, peer));
+    TurnMessage response;
+    return SendRequest(client, &request, &response) ? response.type() : 0;
+  }
+
+  rtc::VirtualSocketServer vss_;
+  rtc::AutoSocketServerThread thread_;
+  TestTurnServer turn_server_;
+  rtc::BasicPacketSocketFactory socket_factory_;
+  TestTurnClient turn_client_;
+};
+
+TEST_F(TurnServerTest, RelaysChannelData) {
+  std::unique_ptr<TestEndpoint> client = CreateEndpoint("1.1.1.1");
+  std::unique_ptr<TestEndpoint> peer = CreateEndpoint("2.2.2.2");
+  rtc::SocketAddress relayed = Allocate(client.get());
+  ASSERT_FALSE(relayed.IsNil());
+  ASSERT_EQ(TURN_CHANNEL_BIND_RESPONSE,
+            BindChannel(client.get(), 0x4000, peer->address()));
+
+  client->SendTo(ChannelData(0x4000, "hello"), kTurnIntAddr);
+  ASSERT_TRUE_WAIT(peer->packets_received() == 1, kTimeout);
+  EXPECT_EQ("hello", peer->last_packet());
+  EXPECT_EQ(relayed, peer->last_sender());
+
+  client->Reset();
+  peer->SendTo("world", relayed);
+  ASSERT_TRUE_WAIT(client->packets_received() == 1, kTimeout);
+  EXPECT_EQ(ChannelData(0x4000, "world"), client->last_packet());
+
+  // An empty message, and data on an unbound channel, which is dropped.
+  client->SendTo(ChannelData(0x4001, "dropped"), kTurnIntAddr);
+  client->SendTo(ChannelData(0x4000, ""), kTurnIntAddr);
+  ASSERT_TRUE_WAIT(peer->packets_received() == 2, kTimeout);
+  EXPECT_EQ("", peer->last_packet());
+  client->Reset();
+  peer->SendTo("", relayed);
+  ASSERT_TRUE_WAIT(client->packets_received() == 1, kTimeout);
+  EXPECT_EQ(ChannelData(0x4000, ""), client->last_packet());
+  EXPECT_EQ(2, peer->packets_received());
+}
+
+// A channel number and a peer address can each be bound only once per
+// allocation, though a binding can be refreshed.
+TEST_F(TurnServerTest, ChannelBindingsAreUnique) {
+  std::unique_ptr<TestEndpoint> client = CreateEndpoint("1.1.1.1");
+  std::unique_ptr<TestEndpoint> peer1 = CreateEndpoint("2.2.2.2");
+  std::unique_ptr<TestEndpoint> peer2 = CreateEndpoint("3.3.3.3");
+  ASSERT_FALSE(Allocate(client.get()).IsNil());
+  EXPECT_EQ(TURN_CHANNEL_BIND_RESPONSE,
+            BindChannel(client.get(), 0x4000, peer1->address()));
+  EXPECT_EQ(TURN_CHANNEL_BIND_ERROR_RESPONSE,
+            BindChannel(client.get(), 0x4000, peer2->address()));
+  EXPECT_EQ(TURN_CHANNEL_BIND_ERROR_RESPONSE,
+            BindChannel(client.get(), 0x4001, peer1->address()));
+  EXPECT_EQ(TURN_CHANNEL_BIND_RESPONSE,
+            BindChannel(client.get(), 0x4000, peer1->address()));
+  EXPECT_EQ(TURN_CHANNEL_BIND_RESPONSE,
+            BindChannel(client.get(), 0x4001, peer2->address()));
+}
+
+// Relays ChannelData in both directions through 1000 allocations, each bound
+// to one of a few peers, and reports the rate against a target of 100k
+// packets/s. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*RelayPerformance*.
+TEST_F(TurnServerTest, DISABLED_RelayPerformance) {
+  static const int kNumAllocations = 1000;
+  static const int kNumPeers = 10;
+  static const int kPacketsPerAllocation = 100;
+  static const uint16_t kChannelId = 0x4000;
+  std::vector<std::unique_ptr<TestEndpoint>> peers;
+  for (int i = 0; i < kNumPeers; ++i)
+    peers.push_back(CreateEndpoint("2.2.2." + std::to_string(i + 1)));
+  std::vector<std::unique_ptr<TestEndpoint>> clients;
+  std::vector<rtc::SocketAddress> relayed;
+  for (int i = 0; i < kNumAllocations; ++i) {
+    clients.push_back(
+        CreateEndpoint("10.0." + std::to_string(i / 250) + "." +
+                       std::to_string(i % 250 + 1)));
+    relayed.push_back(Allocate(clients.back().get()));
+    ASSERT_FALSE(relayed.back().IsNil());
+    ASSERT_EQ(TURN_CHANNEL_BIND_RESPONSE,
+              BindChannel(clients.back().get(), kChannelId,
+                          peers[i % kNumPeers]->address()));
+    clients.back()->Reset();
+  }
+
+  const std::string to_peer = ChannelData(kChannelId, std::string(160, 'x'));
+  const std::string to_client(160, 'y');
+  const int kTotalPackets = 2 * kNumAllocations * kPacketsPerAllocation;
+  int received = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int round = 0; round < kPacketsPerAllocation; ++round) {
+    for (int i = 0; i < kNumAllocations; ++i) {
+      clients[i]->SendTo(to_peer, kTurnIntAddr);
+      peers[i % kNumPeers]->SendTo(to_client, relayed[i]);
+    }
+    // Deliver this round before sending the next one.
+    const int expected = 2 * kNumAllocations * (round + 1);
+    int64_t deadline_ms = rtc::TimeMillis() + kTimeout;
+    do {
+      thread_.ProcessMessages(0);
+      received = 0;
+      for (const auto& client : clients)
+        received += client->packets_received();
+      for (const auto& peer : peers)
+        received += peer->packets_received();
+    } while (received < expected && rtc::TimeMillis() < deadline_ms);
+  }
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(kTotalPackets, received);
+  double packets_per_second = received * 1e6 / elapsed_us;
+  printf("%d allocations: relayed %d packets at %.0f packets/s, %.1f%% of a "
+         "core at 100k packets/s (including the virtual network)\n",
+         kNumAllocations, received, packets_per_second,
+         100.0 * 100000 / packets_per_second);
+}
+
 }  // namespace cricket
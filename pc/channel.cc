@@ -111,6 +111,16 @@ enum {
   MSG_READYTOSENDDATA,
   MSG_DATARECEIVED,
   MSG_FIRSTPACKETRECEIVED,
+  MSG_SEND_PACKETS,
+};
+
+struct BaseChannel::SendPacketsMessageData : public rtc::MessageData {
+  struct Packet {
+    bool rtcp;
+    rtc::CopyOnWriteBuffer packet;
+    rtc::PacketOptions options;
+  };
+  std::vector<Packet> packets;
 };
 
 static void SafeSetError(const std::string& message, std::string* error_desc) {
@@ -257,7 +267,9 @@ void BaseChannel::Deinit() {
     }
     // Clear pending read packets/messages.
     network_thread_->Clear(&invoker_);
+    rtc::CritScope cs(&send_batch_crit_);
     network_thread_->Clear(this);
+    open_send_batch_ = nullptr;
   });
 }
 
@@ -424,8 +436,6 @@ void BaseChannel::OnTransportReadyToSend(bool ready) {
 bool BaseChannel::SendPacket(bool rtcp,
                              rtc::CopyOnWriteBuffer* packet,
                              const rtc::PacketOptions& options) {
-  // Until all the code is migrated to use RtpPacketType instead of bool.
-  RtpPacketType packet_type = rtcp ? RtpPacketType::kRtcp : RtpPacketType::kRtp;
   // SendPacket gets called from MediaEngine, on a pacer or an encoder thread.
   // If the thread is not our network thread, we will post to our network
   // so that the real work happens on our network. This avoids us having to
@@ -434,17 +444,36 @@ bool BaseChannel::SendPacket(bool rtcp,
   // The only downside is that we can't return a proper failure code if
   // needed. Since UDP is unreliable anyway, this should be a non-issue.
   if (!network_thread_->IsCurrent()) {
+    if (options.batchable) {
+      PostBatchablePacket(rtcp, packet, options);
+      return true;
+    }
     // Avoid a copy by transferring the ownership of the packet data.
     int message_id = rtcp ? MSG_SEND_RTCP_PACKET : MSG_SEND_RTP_PACKET;
     SendPacketMessageData* data = new SendPacketMessageData;
     data->packet = std::move(*packet);
     data->options = options;
+    rtc::CritScope cs(&send_batch_crit_);
+    // Batchable packets sent after this one must not overtake it.
+    open_send_batch_ = nullptr;
     network_thread_->Post(RTC_FROM_HERE, this, message_id, data);
     return true;
   }
 
   TRACE_EVENT0("webrtc", "BaseChannel::SendPacket");
 
+  if (!CanSendPacket_n(rtcp, *packet))
+    return false;
+
+  // Bon voyage.
+  return rtcp ? rtp_transport_->SendRtcpPacket(packet, options, PF_SRTP_BYPASS)
+              : rtp_transport_->SendRtpPacket(packet, options, PF_SRTP_BYPASS);
+}
+
+bool BaseChannel::CanSendPacket_n(bool rtcp,
+                                  const rtc::CopyOnWriteBuffer& packet) {
+  // Until all the code is migrated to use RtpPacketType instead of bool.
+  RtpPacketType packet_type = rtcp ? RtpPacketType::kRtcp : RtpPacketType::kRtp;
   // Now that we are on the correct thread, ensure we have a place to send this
   // packet before doing anything. (We might get RTCP packets that we don't
   // intend to send.) If we've negotiated RTCP mux, send RTCP over the RTP
@@ -454,10 +483,10 @@ bool BaseChannel::SendPacket(bool rtcp,
   }
 
   // Protect ourselves against crazy data.
-  if (!IsValidRtpPacketSize(packet_type, packet->size())) {
+  if (!IsValidRtpPacketSize(packet_type, packet.size())) {
     RTC_LOG(LS_ERROR) << "Dropping outgoing " << content_name_ << " "
                       << RtpPacketTypeToString(packet_type)
-                      << " packet: wrong size=" << packet->size();
+                      << " packet: wrong size=" << packet.size();
     return false;
   }
 
@@ -482,10 +511,48 @@ bool BaseChannel::SendPacket(bool rtcp,
     RTC_LOG(LS_WARNING) << "Sending an " << packet_type
                         << " packet without encryption.";
   }
+  return true;
+}
 
-  // Bon voyage.
-  return rtcp ? rtp_transport_->SendRtcpPacket(packet, options, PF_SRTP_BYPASS)
-              : rtp_transport_->SendRtpPacket(packet, options, PF_SRTP_BYPASS);
+void BaseChannel::SendPackets_n(SendPacketsMessageData* data) {
+  TRACE_EVENT0("webrtc", "BaseChannel::SendPackets_n");
+  // Consecutive RTP packets go to the transport in one call, so that SRTP
+  // protects them together. RTCP keeps its place in between.
+  std::vector<webrtc::RtpTransportInternal::OutgoingRtpPacket> rtp_packets;
+  rtp_packets.reserve(data->packets.size());
+  auto send_rtp_packets = [this, &rtp_packets] {
+    if (rtp_packets.empty())
+      return;
+    rtp_transport_->SendRtpPackets(rtp_packets, PF_SRTP_BYPASS);
+    rtp_packets.clear();
+  };
+  for (SendPacketsMessageData::Packet& packet : data->packets) {
+    if (packet.rtcp) {
+      send_rtp_packets();
+      SendPacket(/*rtcp=*/true, &packet.packet, packet.options);
+    } else if (CanSendPacket_n(/*rtcp=*/false, packet.packet)) {
+      webrtc::RtpTransportInternal::OutgoingRtpPacket rtp_packet;
+      rtp_packet.packet = &packet.packet;
+      rtp_packet.options = &packet.options;
+      rtp_packets.push_back(rtp_packet);
+    }
+  }
+  send_rtp_packets();
+}
+
+void BaseChannel::PostBatchablePacket(bool rtcp,
+                                      rtc::CopyOnWriteBuffer* packet,
+                                      const rtc::PacketOptions& options) {
+  rtc::CritScope cs(&send_batch_crit_);
+  if (!open_send_batch_) {
+    // The network thread takes |send_batch_crit_| before reading the
+    // packets, so the message can be posted before they are added.
+    open_send_batch_ = new SendPacketsMessageData;
+    network_thread_->Post(RTC_FROM_HERE, this, MSG_SEND_PACKETS,
+                          open_send_batch_);
+  }
+  open_send_batch_->packets.push_back(
+      SendPacketsMessageData::Packet{rtcp, std::move(*packet), options});
 }
 
 void BaseChannel::OnRtpPacket(const webrtc::RtpPacketReceived& parsed_packet) {
@@ -793,6 +860,19 @@ void BaseChannel::OnMessage(rtc::Message* pmsg) {
       delete data;
       break;
     }
+    case MSG_SEND_PACKETS: {
+      RTC_DCHECK(network_thread_->IsCurrent());
+      SendPacketsMessageData* data =
+          static_cast<SendPacketsMessageData*>(pmsg->pdata);
+      {
+        rtc::CritScope cs(&send_batch_crit_);
+        if (open_send_batch_ == data)
+          open_send_batch_ = nullptr;
+      }
+      SendPackets_n(data);
+      delete data;
+      break;
+    }
     case MSG_FIRSTPACKETRECEIVED: {
       SignalFirstPacketReceived_(this);
       break;
@@ -232,6 +232,8 @@ class BaseChannel : public ChannelInterface,
   bool SendPacket(bool rtcp,
                   rtc::CopyOnWriteBuffer* packet,
                   const rtc::PacketOptions& options);
+  // Checks on the network thread whether |packet| may be sent now.
+  bool CanSendPacket_n(bool rtcp, const rtc::CopyOnWriteBuffer& packet);
 
   void OnRtcpPacketReceived(rtc::CopyOnWriteBuffer* packet,
                             int64_t packet_time_us);
@@ -306,6 +308,14 @@ class BaseChannel : public ChannelInterface,
   void SignalSentPacket_w(const rtc::SentPacket& sent_packet);
   bool IsReadyToSendMedia_n() const;
 
+  // Batchable packets sent from other threads reach the network thread in one
+  // message per burst, so that the socket can send them together.
+  struct SendPacketsMessageData;
+  void PostBatchablePacket(bool rtcp,
+                           rtc::CopyOnWriteBuffer* packet,
+                           const rtc::PacketOptions& options);
+  void SendPackets_n(SendPacketsMessageData* data);
+
   // MediaTransportNetworkChangeCallback override.
   void OnNetworkRouteChanged(const rtc::NetworkRoute& network_route) override;
 
@@ -315,6 +325,12 @@ class BaseChannel : public ChannelInterface,
   rtc::AsyncInvoker invoker_;
   sigslot::signal1<ChannelInterface*> SignalFirstPacketReceived_;
 
+  rtc::CriticalSection send_batch_crit_;
+  // The posted message that batchable packets are added to, until the network
+  // thread handles it or a non-batchable packet is posted after it.
+  SendPacketsMessageData* open_send_batch_ RTC_GUARDED_BY(send_batch_crit_) =
+      nullptr;
+
   const std::string content_name_;
 
   // Won't be set when using raw packet transports. SDP-specific thing.
@@ -183,14 +183,16 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
     bool srtp_required,
     const webrtc::CryptoOptions& crypto_options,
     rtc::UniqueRandomIdGenerator* ssrc_generator,
-    const AudioOptions& options)
+    const AudioOptions& options,
+    rtc::Thread* network_thread)
 {
   if (!worker_thread_->IsCurrent()) 
   {
     return worker_thread_->Invoke<VoiceChannel*>(RTC_FROM_HERE, [&] {
       return CreateVoiceChannel(
           call, media_config, rtp_transport, media_transport, signaling_thread,
-          content_name, srtp_required, crypto_options, ssrc_generator, options);
+          content_name, srtp_required, crypto_options, ssrc_generator, options,
+          network_thread);
     });
   }
 
@@ -210,7 +212,8 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
   }
 
   auto voice_channel = absl::make_unique<VoiceChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread ? network_thread : network_thread_,
+      signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -260,14 +263,16 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     bool srtp_required,
     const webrtc::CryptoOptions& crypto_options,
     rtc::UniqueRandomIdGenerator* ssrc_generator,
-    const VideoOptions& options) 
+    const VideoOptions& options,
+    rtc::Thread* network_thread) 
 {
   if (!worker_thread_->IsCurrent()) 
   {
     return worker_thread_->Invoke<VideoChannel*>(RTC_FROM_HERE, [&] {
       return CreateVideoChannel(
           call, media_config, rtp_transport, media_transport, signaling_thread,
-          content_name, srtp_required, crypto_options, ssrc_generator, options);
+          content_name, srtp_required, crypto_options, ssrc_generator, options,
+          network_thread);
     });
   }
 
@@ -286,7 +291,8 @@ VideoChannel* ChannelManager::CreateVideoChannel(
   }
 
   auto video_channel = absl::make_unique<VideoChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread ? network_thread : network_thread_,
+      signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -329,12 +335,13 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
     const std::string& content_name,
     bool srtp_required,
     const webrtc::CryptoOptions& crypto_options,
-    rtc::UniqueRandomIdGenerator* ssrc_generator) {
+    rtc::UniqueRandomIdGenerator* ssrc_generator,
+    rtc::Thread* network_thread) {
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<RtpDataChannel*>(RTC_FROM_HERE, [&] {
       return CreateRtpDataChannel(media_config, rtp_transport, signaling_thread,
                                   content_name, srtp_required, crypto_options,
-                                  ssrc_generator);
+                                  ssrc_generator, network_thread);
     });
   }
 
@@ -347,7 +354,8 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
   }
 
   auto data_channel = absl::make_unique<RtpDataChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread ? network_thread : network_thread_,
+      signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
   data_channel->Init_w(rtp_transport);
@@ -89,6 +89,8 @@ class ChannelManager final {
   // The operations below all occur on the worker thread.
   // ChannelManager retains ownership of the created channels, so clients should
   // call the appropriate Destroy*Channel method when done.
+  // |network_thread| must be the thread |rtp_transport| runs on; if null, the
+  // ChannelManager's own network thread is used.
 
   // Creates a voice channel, to be associated with the specified session.
   VoiceChannel* CreateVoiceChannel(
@@ -101,7 +103,8 @@ class ChannelManager final {
       bool srtp_required,
       const webrtc::CryptoOptions& crypto_options,
       rtc::UniqueRandomIdGenerator* ssrc_generator,
-      const AudioOptions& options);
+      const AudioOptions& options,
+      rtc::Thread* network_thread = nullptr);
   // Destroys a voice channel created by CreateVoiceChannel.
   void DestroyVoiceChannel(VoiceChannel* voice_channel);
 
@@ -118,7 +121,8 @@ class ChannelManager final {
       bool srtp_required,
       const webrtc::CryptoOptions& crypto_options,
       rtc::UniqueRandomIdGenerator* ssrc_generator,
-      const VideoOptions& options);
+      const VideoOptions& options,
+      rtc::Thread* network_thread = nullptr);
   // Destroys a video channel created by CreateVideoChannel.
   void DestroyVideoChannel(VideoChannel* video_channel);
 
@@ -129,7 +133,8 @@ class ChannelManager final {
       const std::string& content_name,
       bool srtp_required,
       const webrtc::CryptoOptions& crypto_options,
-      rtc::UniqueRandomIdGenerator* ssrc_generator);
+      rtc::UniqueRandomIdGenerator* ssrc_generator,
+      rtc::Thread* network_thread = nullptr);
   // Destroys a data channel created by CreateRtpDataChannel.
   void DestroyRtpDataChannel(RtpDataChannel* data_channel);
 
@@ -10,11 +10,10 @@
 
 #include "pc/data_channel.h"
 
-#include <memory>
+#include <algorithm>
 #include <string>
 #include <utility>
 
-#include "absl/memory/memory.h"
 #include "media/sctp/sctp_transport_internal.h"
 #include "pc/sctp_utils.h"
 #include "rtc_base/checks.h"
@@ -27,6 +26,8 @@ namespace webrtc {
 
 static size_t kMaxQueuedReceivedDataBytes = 16 * 1024 * 1024;
 static size_t kMaxQueuedSendDataBytes = 16 * 1024 * 1024;
+// Initial number of slots in a PacketQueue.
+static size_t kMinPacketQueueSlots = 16;
 
 InternalDataChannelInit::InternalDataChannelInit(const DataChannelInit& base)
     : DataChannelInit(base), open_handshake_role(kOpener) {
@@ -90,38 +91,62 @@ bool SctpSidAllocator::IsSidAvailable(int sid) const {
 }
 
 bool DataChannel::PacketQueue::Empty() const {
-  return packets_.empty();
+  return size_ == 0;
 }
 
-std::unique_ptr<DataBuffer> DataChannel::PacketQueue::PopFront() {
-  RTC_DCHECK(!packets_.empty());
-  byte_count_ -= packets_.front()->size();
-  std::unique_ptr<DataBuffer> packet = std::move(packets_.front());
-  packets_.pop_front();
+DataBuffer DataChannel::PacketQueue::PopFront() {
+  RTC_DCHECK_GT(size_, 0);
+  // Moving out of the slot releases its reference to the packet data.
+  DataBuffer packet = std::move(slots_[head_]);
+  byte_count_ -= packet.size();
+  head_ = (head_ + 1) & (slots_.size() - 1);
+  --size_;
   return packet;
 }
 
-void DataChannel::PacketQueue::PushFront(std::unique_ptr<DataBuffer> packet) {
-  byte_count_ += packet->size();
-  packets_.push_front(std::move(packet));
+void DataChannel::PacketQueue::PushFront(const DataBuffer& packet) {
+  if (size_ == slots_.size()) {
+    Grow();
+  }
+  head_ = (head_ - 1) & (slots_.size() - 1);
+  slots_[head_] = packet;
+  ++size_;
+  byte_count_ += packet.size();
 }
 
-void DataChannel::PacketQueue::PushBack(std::unique_ptr<DataBuffer> packet) {
-  byte_count_ += packet->size();
-  packets_.push_back(std::move(packet));
+void DataChannel::PacketQueue::PushBack(const DataBuffer& packet) {
+  if (size_ == slots_.size()) {
+    Grow();
+  }
+  slots_[(head_ + size_) & (slots_.size() - 1)] = packet;
+  ++size_;
+  byte_count_ += packet.size();
 }
 
 void DataChannel::PacketQueue::Clear() {
-  packets_.clear();
+  while (size_ > 0) {
+    PopFront();
+  }
+  head_ = 0;
   byte_count_ = 0;
 }
 
 void DataChannel::PacketQueue::Swap(PacketQueue* other) {
-  size_t other_byte_count = other->byte_count_;
-  other->byte_count_ = byte_count_;
-  byte_count_ = other_byte_count;
+  std::swap(slots_, other->slots_);
+  std::swap(head_, other->head_);
+  std::swap(size_, other->size_);
+  std::swap(byte_count_, other->byte_count_);
+}
 
-  other->packets_.swap(packets_);
+void DataChannel::PacketQueue::Grow() {
+  std::vector<DataBuffer> slots(
+      std::max(kMinPacketQueueSlots, slots_.size() * 2),
+      DataBuffer(rtc::CopyOnWriteBuffer(), false));
+  for (size_t i = 0; i < size_; ++i) {
+    slots[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+  }
+  slots_.swap(slots);
+  head_ = 0;
 }
 
 rtc::scoped_refptr<DataChannel> DataChannel::Create(
@@ -413,11 +438,11 @@ void DataChannel::OnDataReceived(const cricket::ReceiveDataParams& params,
   }
 
   bool binary = (params.type == cricket::DMT_BINARY);
-  auto buffer = absl::make_unique<DataBuffer>(payload, binary);
+  DataBuffer buffer(payload, binary);
   if (state_ == kOpen && observer_) {
     ++messages_received_;
-    bytes_received_ += buffer->size();
-    observer_->OnMessage(*buffer.get());
+    bytes_received_ += buffer.size();
+    observer_->OnMessage(buffer);
   } else {
     if (queued_received_data_.byte_count() + payload.size() >
         kMaxQueuedReceivedDataBytes) {
@@ -430,7 +455,7 @@ void DataChannel::OnDataReceived(const cricket::ReceiveDataParams& params,
 
       return;
     }
-    queued_received_data_.PushBack(std::move(buffer));
+    queued_received_data_.PushBack(buffer);
   }
 }
 
@@ -562,10 +587,10 @@ void DataChannel::DeliverQueuedReceivedData() {
   }
 
   while (!queued_received_data_.Empty()) {
-    std::unique_ptr<DataBuffer> buffer = queued_received_data_.PopFront();
+    DataBuffer buffer = queued_received_data_.PopFront();
     ++messages_received_;
-    bytes_received_ += buffer->size();
-    observer_->OnMessage(*buffer);
+    bytes_received_ += buffer.size();
+    observer_->OnMessage(buffer);
   }
 }
 
@@ -576,14 +601,25 @@ void DataChannel::SendQueuedDataMessages() {
 
   RTC_DCHECK(state_ == kOpen || state_ == kClosing);
 
+  uint64_t start_buffered_amount = buffered_amount_;
   while (!queued_send_data_.Empty()) {
-    std::unique_ptr<DataBuffer> buffer = queued_send_data_.PopFront();
-    if (!SendDataMessage(*buffer, false)) {
+    DataBuffer buffer = queued_send_data_.PopFront();
+    if (!SendDataMessage(buffer, false)) {
       // Return the message to the front of the queue if sending is aborted.
-      queued_send_data_.PushFront(std::move(buffer));
+      queued_send_data_.PushFront(buffer);
       break;
     }
   }
+
+  // Notify once per drain rather than per message, so that an observer which
+  // refills the buffer from OnBufferedAmountLow doesn't recurse into this
+  // loop. Data sent straight through by Send() never shows up as buffered, so
+  // only this path can cross the threshold.
+  if (observer_ && state_ != kClosed &&
+      start_buffered_amount > buffered_amount_low_threshold_ &&
+      buffered_amount_ <= buffered_amount_low_threshold_) {
+    observer_->OnBufferedAmountLow();
+  }
 }
 
 bool DataChannel::SendDataMessage(const DataBuffer& buffer,
@@ -650,7 +686,7 @@ bool DataChannel::QueueSendDataMessage(const DataBuffer& buffer) {
     RTC_LOG(LS_ERROR) << "Can't buffer any more data for the data channel.";
     return false;
   }
-  queued_send_data_.PushBack(absl::make_unique<DataBuffer>(buffer));
+  queued_send_data_.PushBack(buffer);
   return true;
 }
 
@@ -659,13 +695,13 @@ void DataChannel::SendQueuedControlMessages() {
   control_packets.Swap(&queued_control_data_);
 
   while (!control_packets.Empty()) {
-    std::unique_ptr<DataBuffer> buf = control_packets.PopFront();
-    SendControlMessage(buf->data);
+    DataBuffer buf = control_packets.PopFront();
+    SendControlMessage(buf.data);
   }
 }
 
 void DataChannel::QueueControlMessage(const rtc::CopyOnWriteBuffer& buffer) {
-  queued_control_data_.PushBack(absl::make_unique<DataBuffer>(buffer, true));
+  queued_control_data_.PushBack(DataBuffer(buffer, true));
 }
 
 bool DataChannel::SendControlMessage(const rtc::CopyOnWriteBuffer& buffer) {
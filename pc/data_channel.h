@@ -11,10 +11,10 @@
 #ifndef PC_DATA_CHANNEL_H_
 #define PC_DATA_CHANNEL_H_
 
-#include <deque>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "api/data_channel_interface.h"
 #include "api/proxy.h"
@@ -143,6 +143,12 @@ class DataChannel : public DataChannelInterface, public sigslot::has_slots<> {
   virtual bool negotiated() const { return config_.negotiated; }
   virtual int id() const { return config_.id; }
   virtual uint64_t buffered_amount() const;
+  virtual uint64_t buffered_amount_low_threshold() const {
+    return buffered_amount_low_threshold_;
+  }
+  virtual void SetBufferedAmountLowThreshold(uint64_t threshold) {
+    buffered_amount_low_threshold_ = threshold;
+  }
   virtual void Close();
   virtual DataState state() const { return state_; }
   virtual uint32_t messages_sent() const { return messages_sent_; }
@@ -221,25 +227,33 @@ class DataChannel : public DataChannelInterface, public sigslot::has_slots<> {
   virtual ~DataChannel();
 
  private:
-  // A packet queue which tracks the total queued bytes. Queued packets are
-  // owned by this class.
+  // A packet queue which tracks the total queued bytes. Packets are stored by
+  // value in a ring of slots that is reused as the queue drains, so queuing a
+  // packet only takes a reference to its data instead of allocating.
   class PacketQueue final {
    public:
     size_t byte_count() const { return byte_count_; }
 
     bool Empty() const;
 
-    std::unique_ptr<DataBuffer> PopFront();
+    DataBuffer PopFront();
 
-    void PushFront(std::unique_ptr<DataBuffer> packet);
-    void PushBack(std::unique_ptr<DataBuffer> packet);
+    void PushFront(const DataBuffer& packet);
+    void PushBack(const DataBuffer& packet);
 
     void Clear();
 
     void Swap(PacketQueue* other);
 
    private:
-    std::deque<std::unique_ptr<DataBuffer>> packets_;
+    // Doubles the number of slots, moving the packets to the start.
+    void Grow();
+
+    // Holds |size_| packets starting at |head_| and wrapping around. The
+    // number of slots is zero or a power of two.
+    std::vector<DataBuffer> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
     size_t byte_count_ = 0;
   };
 
@@ -278,6 +292,7 @@ class DataChannel : public DataChannelInterface, public sigslot::has_slots<> {
   // Number of bytes of data that have been queued using Send(). Increased
   // before each transport send and decreased after each successful send.
   uint64_t buffered_amount_;
+  uint64_t buffered_amount_low_threshold_ = 0;
   cricket::DataChannelType data_channel_type_;
   DataChannelProviderInterface* provider_;
   HandshakeState handshake_state_;
@@ -318,6 +333,8 @@ PROXY_CONSTMETHOD0(uint64_t, bytes_sent)
 PROXY_CONSTMETHOD0(uint32_t, messages_received)
 PROXY_CONSTMETHOD0(uint64_t, bytes_received)
 PROXY_CONSTMETHOD0(uint64_t, buffered_amount)
+PROXY_CONSTMETHOD0(uint64_t, buffered_amount_low_threshold)
+PROXY_METHOD1(void, SetBufferedAmountLowThreshold, uint64_t)
 PROXY_METHOD0(void, Close)
 PROXY_METHOD1(bool, Send, const DataBuffer&)
 END_PROXY_MAP()
@@ -10,6 +10,7 @@
 
 #include <string.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "pc/data_channel.h"
@@ -29,14 +30,18 @@ class FakeDataChannelObserver : public webrtc::DataChannelObserver {
   FakeDataChannelObserver()
       : messages_received_(0),
         on_state_change_count_(0),
-        on_buffered_amount_change_count_(0) {}
+        on_buffered_amount_change_count_(0),
+        on_buffered_amount_low_count_(0) {}
 
   void OnStateChange() { ++on_state_change_count_; }
 
-  void OnBufferedAmountChange(uint64_t previous_amount) {
+  void OnBufferedAmountChange(uint64_t sent_data_size) {
     ++on_buffered_amount_change_count_;
+    sent_data_sizes_.push_back(sent_data_size);
   }
 
+  void OnBufferedAmountLow() { ++on_buffered_amount_low_count_; }
+
   void OnMessage(const webrtc::DataBuffer& buffer) { ++messages_received_; }
 
   size_t messages_received() const { return messages_received_; }
@@ -53,10 +58,21 @@ class FakeDataChannelObserver : public webrtc::DataChannelObserver {
     return on_buffered_amount_change_count_;
   }
 
+  size_t on_buffered_amount_low_count() const {
+    return on_buffered_amount_low_count_;
+  }
+
+  // The sizes of the sent messages, in the order they were sent.
+  const std::vector<uint64_t>& sent_data_sizes() const {
+    return sent_data_sizes_;
+  }
+
  private:
   size_t messages_received_;
   size_t on_state_change_count_;
   size_t on_buffered_amount_change_count_;
+  size_t on_buffered_amount_low_count_;
+  std::vector<uint64_t> sent_data_sizes_;
 };
 
 // TODO(deadbeef): The fact that these tests use a fake provider makes them not
@@ -226,6 +242,79 @@ TEST_F(SctpDataChannelTest, BlockedWhenSendQueuedDataNoCrash) {
   EXPECT_EQ(1U, observer_->on_buffered_amount_change_count());
 }
 
+// Tests that OnBufferedAmountLow is called once the queued data drains, but
+// not for data that was sent without being queued.
+TEST_F(SctpDataChannelTest, BufferedAmountLowWhenQueueDrains) {
+  AddObserver();
+  SetChannelReady();
+  webrtc::DataBuffer buffer("abcd");
+  EXPECT_EQ(0U, webrtc_data_channel_->buffered_amount_low_threshold());
+  EXPECT_TRUE(webrtc_data_channel_->Send(buffer));
+  EXPECT_EQ(0U, observer_->on_buffered_amount_low_count());
+
+  provider_->set_send_blocked(true);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(webrtc_data_channel_->Send(buffer));
+  }
+  EXPECT_EQ(0U, observer_->on_buffered_amount_low_count());
+
+  provider_->set_send_blocked(false);
+  EXPECT_EQ(0U, webrtc_data_channel_->buffered_amount());
+  EXPECT_EQ(1U, observer_->on_buffered_amount_low_count());
+}
+
+// Tests that OnBufferedAmountLow is only called when the buffered amount drops
+// from above the threshold to at or below it.
+TEST_F(SctpDataChannelTest, BufferedAmountLowOnlyWhenCrossingThreshold) {
+  AddObserver();
+  SetChannelReady();
+  webrtc::DataBuffer buffer("abcd");
+  webrtc_data_channel_->SetBufferedAmountLowThreshold(3 * buffer.size());
+  EXPECT_EQ(3 * buffer.size(),
+            webrtc_data_channel_->buffered_amount_low_threshold());
+
+  // Never above the threshold.
+  provider_->set_send_blocked(true);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(webrtc_data_channel_->Send(buffer));
+  }
+  provider_->set_send_blocked(false);
+  EXPECT_EQ(0U, webrtc_data_channel_->buffered_amount());
+  EXPECT_EQ(0U, observer_->on_buffered_amount_low_count());
+
+  provider_->set_send_blocked(true);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(webrtc_data_channel_->Send(buffer));
+  }
+  provider_->set_send_blocked(false);
+  EXPECT_EQ(0U, webrtc_data_channel_->buffered_amount());
+  EXPECT_EQ(1U, observer_->on_buffered_amount_low_count());
+}
+
+// Tests that queued data is sent in order, including when the send queue has
+// wrapped around and grows.
+TEST_F(SctpDataChannelTest, QueuedDataSentInOrder) {
+  AddObserver();
+  SetChannelReady();
+  std::vector<uint64_t> expected_sizes;
+  provider_->set_send_blocked(true);
+  for (int i = 1; i <= 10; ++i) {
+    EXPECT_TRUE(
+        webrtc_data_channel_->Send(webrtc::DataBuffer(std::string(i, 'a'))));
+    expected_sizes.push_back(i);
+  }
+  provider_->set_send_blocked(false);
+  provider_->set_send_blocked(true);
+  for (int i = 11; i <= 50; ++i) {
+    EXPECT_TRUE(
+        webrtc_data_channel_->Send(webrtc::DataBuffer(std::string(i, 'a'))));
+    expected_sizes.push_back(i);
+  }
+  provider_->set_send_blocked(false);
+  EXPECT_EQ(0U, webrtc_data_channel_->buffered_amount());
+  EXPECT_EQ(expected_sizes, observer_->sent_data_sizes());
+}
+
 // Tests that DataChannel::messages_sent() and DataChannel::bytes_sent() are
 // correct, sending data both while unblocked and while blocked.
 TEST_F(SctpDataChannelTest, VerifyMessagesAndBytesSent) {
@@ -871,9 +871,11 @@ void ExtractSharedMediaSessionOptions(
 }
 // 建立通道
 PeerConnection::PeerConnection(PeerConnectionFactory* factory,
+                               rtc::Thread* network_thread,
                                std::unique_ptr<RtcEventLog> event_log,
                                std::unique_ptr<Call> call)
     : factory_(factory),
+      network_thread_(network_thread),
       event_log_(std::move(event_log)),
       event_log_ptr_(event_log_.get()),
       rtcp_cname_(GenerateRtcpCname()),
@@ -923,6 +925,7 @@ PeerConnection::~PeerConnection() {
     // The event log must outlive call (and any other object that uses it).
     event_log_.reset();
   });
+  factory_->ReleaseNetworkThread(network_thread_);
 }
 
 void PeerConnection::DestroyAllChannels() {
@@ -1102,7 +1105,11 @@ bool PeerConnection::Initialize(const PeerConnectionInterface::RTCConfiguration&
       this, &PeerConnection::OnTransportControllerDtlsHandshakeError);
   /////////////////////////////////////////////////////////////////////////////////////////////
 
-  sctp_factory_ = factory_->CreateSctpTransportInternalFactory();
+  sctp_factory_ =
+      network_thread() == factory_->network_thread()
+          ? factory_->CreateSctpTransportInternalFactory()
+          : factory_->CreateSctpTransportInternalFactoryForThread(
+                network_thread());
 
   /////////////////////////////////////RTC
   /// Statistics//////////////////////////////////////////////////////////
@@ -6418,7 +6425,7 @@ cricket::VoiceChannel* PeerConnection::CreateVoiceChannel(const std::string& mid
   cricket::VoiceChannel* voice_channel = channel_manager()->CreateVoiceChannel(
       call_ptr_, configuration_.media_config, rtp_transport, media_transport,
       signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
-      &ssrc_generator_, audio_options_);
+      &ssrc_generator_, audio_options_, network_thread());
   if (!voice_channel) {
     return nullptr;
   }
@@ -6445,7 +6452,7 @@ cricket::VideoChannel* PeerConnection::CreateVideoChannel( const std::string& mi
   cricket::VideoChannel* video_channel = channel_manager()->CreateVideoChannel( 
 	  call_ptr_, configuration_.media_config, rtp_transport, media_transport,
       signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
-      &ssrc_generator_, video_options_);
+      &ssrc_generator_, video_options_, network_thread());
   if (!video_channel) 
   {
     return nullptr;
@@ -6492,7 +6499,8 @@ bool PeerConnection::CreateDataChannel(const std::string& mid) {
       RtpTransportInternal* rtp_transport = GetRtpTransport(mid);
       rtp_data_channel_ = channel_manager()->CreateRtpDataChannel(
           configuration_.media_config, rtp_transport, signaling_thread(), mid,
-          SrtpRequired(), GetCryptoOptions(), &ssrc_generator_);
+          SrtpRequired(), GetCryptoOptions(), &ssrc_generator_,
+          network_thread());
       if (!rtp_data_channel_) {
         return false;
       }
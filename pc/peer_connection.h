@@ -76,9 +76,13 @@ class PeerConnection : public PeerConnectionInternal,
     MAX_VALUE = 0x1000,
   };
 
-  explicit PeerConnection(PeerConnectionFactory* factory,
-                          std::unique_ptr<RtcEventLog> event_log,
-                          std::unique_ptr<Call> call);
+  // |network_thread| is one of the factory's network threads, acquired with
+  // PeerConnectionFactory::AcquireNetworkThread(); it is released when the
+  // PeerConnection is destroyed.
+  PeerConnection(PeerConnectionFactory* factory,
+                 rtc::Thread* network_thread,
+                 std::unique_ptr<RtcEventLog> event_log,
+                 std::unique_ptr<Call> call);
 
   bool Initialize(
       const PeerConnectionInterface::RTCConfiguration& configuration,
@@ -214,9 +218,7 @@ class PeerConnection : public PeerConnectionInternal,
   void Close() override;
 
   // PeerConnectionInternal implementation.
-  rtc::Thread* network_thread() const final {
-    return factory_->network_thread();
-  }
+  rtc::Thread* network_thread() const final { return network_thread_; }
   rtc::Thread* worker_thread() const final { return factory_->worker_thread(); }
   rtc::Thread* signaling_thread() const final {
     return factory_->signaling_thread();
@@ -1094,6 +1096,8 @@ class PeerConnection : public PeerConnectionInternal,
   // PeerConnectionFactoryInterface all instances created using the raw pointer
   // will refer to the same reference count.
   const rtc::scoped_refptr<PeerConnectionFactory> factory_;
+  // The factory network thread this PeerConnection is pinned to.
+  rtc::Thread* const network_thread_;
   PeerConnectionObserver* observer_ RTC_GUARDED_BY(signaling_thread()) = nullptr;
 
   // The EventLog needs to outlive |call_| (and any other object that uses it).
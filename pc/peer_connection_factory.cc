@@ -10,6 +10,7 @@
 
 #include "pc/peer_connection_factory.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -37,10 +38,29 @@
 #include "pc/video_track.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/physical_socket_server.h"
+#include "rtc_base/string_encode.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
 
+namespace {
+
+// Creates a network thread whose socket server is configured from the field
+// trials, which rtc_base itself doesn't read.
+std::unique_ptr<rtc::Thread> CreateNetworkThread() {
+#if defined(WEBRTC_USE_EPOLL)
+  auto socket_server = absl::make_unique<rtc::PhysicalSocketServer>();
+  socket_server->SetEdgeTriggeredEpoll(
+      field_trial::IsEnabled("WebRTC-EdgeTriggeredEpoll"));
+  return absl::make_unique<rtc::Thread>(std::move(socket_server));
+#else
+  return rtc::Thread::CreateWithSocketServer();
+#endif
+}
+
+}  // namespace
+
 rtc::scoped_refptr<PeerConnectionFactoryInterface>
 CreateModularPeerConnectionFactory(
     rtc::Thread* network_thread,
@@ -115,14 +135,28 @@ PeerConnectionFactory::PeerConnectionFactory(
       fec_controller_factory_(std::move(dependencies.fec_controller_factory)),
       network_state_predictor_factory_(std::move(dependencies.network_state_predictor_factory)),
       injected_network_controller_factory_(std::move(dependencies.network_controller_factory)),
-      media_transport_factory_(std::move(dependencies.media_transport_factory)) {
+      media_transport_factory_(std::move(dependencies.media_transport_factory)),
+      network_thread_policy_(std::move(dependencies.network_thread_policy)) {
   if (!network_thread_) 
   {
-    owned_network_thread_ = rtc::Thread::CreateWithSocketServer();
+    owned_network_thread_ = CreateNetworkThread();
     owned_network_thread_->SetName("pc_network_thread", nullptr);
     owned_network_thread_->Start();
     network_thread_ = owned_network_thread_.get();
+    for (int i = 1; i < dependencies.network_thread_count; ++i) 
+    {
+      std::unique_ptr<rtc::Thread> thread = CreateNetworkThread();
+      thread->SetName("pc_network_thread_" + rtc::ToString(i), nullptr);
+      thread->Start();
+      owned_additional_network_threads_.push_back(std::move(thread));
+    }
+  }
+  network_threads_.push_back(network_thread_);
+  for (const auto& thread : owned_additional_network_threads_) 
+  {
+    network_threads_.push_back(thread.get());
   }
+  peer_connections_per_network_thread_.resize(network_threads_.size(), 0);
 
   if (!worker_thread_) 
   {
@@ -149,9 +183,9 @@ PeerConnectionFactory::~PeerConnectionFactory() {
   channel_manager_.reset(nullptr);
 
   // Make sure |worker_thread_| and |signaling_thread_| outlive
-  // |default_socket_factory_| and |default_network_manager_|.
-  default_socket_factory_ = nullptr;
-  default_network_manager_ = nullptr;
+  // |default_socket_factories_| and |default_network_managers_|.
+  default_socket_factories_.clear();
+  default_network_managers_.clear();
 
   if (wraps_current_thread_)
     rtc::ThreadManager::Instance()->UnwrapCurrentThread();
@@ -161,16 +195,18 @@ bool PeerConnectionFactory::Initialize() {
   RTC_DCHECK(signaling_thread_->IsCurrent());
   rtc::InitRandom(rtc::Time32());
   // 1. 网络管理类初始化  --> TODO@chensong 2022-10-30  管理网卡
-  default_network_manager_.reset(new rtc::BasicNetworkManager());
-  if (!default_network_manager_) 
-  {
-    return false;
-  }
   // 2. 设置网络线程
-  default_socket_factory_.reset( new rtc::BasicPacketSocketFactory(network_thread_));
-  if (!default_socket_factory_) 
+  // Each network thread gets its own network manager and socket factory, so
+  // that ports and sockets of a PeerConnection stay on its thread.
+  for (rtc::Thread* thread : network_threads_) 
   {
-    return false;
+    default_network_managers_.push_back(absl::make_unique<rtc::BasicNetworkManager>());
+    default_socket_factories_.push_back(absl::make_unique<rtc::BasicPacketSocketFactory>(thread));
+    if (thread != network_thread_) 
+    {
+      // ChannelManager::Init does this for the first network thread.
+      thread->Invoke<void>(RTC_FROM_HERE, [thread] { thread->DisallowBlockingCalls(); });
+    }
   }
   // 3. 网络通道 和设置网络线程和工作线程
   channel_manager_ = absl::make_unique<cricket::ChannelManager>(
@@ -288,18 +324,22 @@ PeerConnectionFactory::CreatePeerConnection(const PeerConnectionInterface::RTCCo
 {
   RTC_DCHECK(signaling_thread_->IsCurrent());
 
+  // An injected allocator is already bound to the first network thread.
+  rtc::Thread* network_thread = AcquireNetworkThread(dependencies.allocator != nullptr);
+  size_t network_index = std::find(network_threads_.begin(), network_threads_.end(), network_thread) - network_threads_.begin();
+
   // Set internal defaults if optional dependencies are not set.
   if (!dependencies.cert_generator) 
   {
 	  //TODO@chensong 2022-09-29  创建负责证书的生成的转发类
-    dependencies.cert_generator = absl::make_unique<rtc::RTCCertificateGenerator>(signaling_thread_, network_thread_);
+    dependencies.cert_generator = absl::make_unique<rtc::RTCCertificateGenerator>(signaling_thread_, network_thread);
   }
   if (!dependencies.allocator)
   {
-    network_thread_->Invoke<void>(RTC_FROM_HERE, [this, &configuration, &dependencies]() 
+    network_thread->Invoke<void>(RTC_FROM_HERE, [this, network_index, &configuration, &dependencies]() 
 	{
       dependencies.allocator = absl::make_unique<cricket::BasicPortAllocator>(
-          default_network_manager_.get(), default_socket_factory_.get(), configuration.turn_customizer);
+          default_network_managers_[network_index].get(), default_socket_factories_[network_index].get(), configuration.turn_customizer);
     });
   }
 
@@ -307,7 +347,7 @@ PeerConnectionFactory::CreatePeerConnection(const PeerConnectionInterface::RTCCo
   // |dependencies.async_resolver_factory| to a new
   // |rtc::BasicAsyncResolverFactory| if no factory is provided.
 
-  network_thread_->Invoke<void>(
+  network_thread->Invoke<void>(
       RTC_FROM_HERE, rtc::Bind(&cricket::PortAllocator::SetNetworkIgnoreMask, dependencies.allocator.get(), options_.network_ignore_mask));
 
   std::unique_ptr<RtcEventLog> event_log = worker_thread_->Invoke<std::unique_ptr<RtcEventLog>>(
@@ -317,7 +357,8 @@ PeerConnectionFactory::CreatePeerConnection(const PeerConnectionInterface::RTCCo
   std::unique_ptr<Call> call = worker_thread_->Invoke<std::unique_ptr<Call>>(
       RTC_FROM_HERE, rtc::Bind(&PeerConnectionFactory::CreateCall_w, this, event_log.get()));
 
-  rtc::scoped_refptr<PeerConnection> pc(new rtc::RefCountedObject<PeerConnection>(this, std::move(event_log), std::move(call)));
+  // From here on the PeerConnection releases |network_thread| when destroyed.
+  rtc::scoped_refptr<PeerConnection> pc(new rtc::RefCountedObject<PeerConnection>(this, network_thread, std::move(event_log), std::move(call)));
 
  // TODO@chensong  20220929 应用层预处理回调函数
   ActionsBeforeInitializeForTesting(pc);
@@ -366,6 +407,47 @@ PeerConnectionFactory::CreateSctpTransportInternalFactory() {
 #endif
 }
 
+std::unique_ptr<cricket::SctpTransportInternalFactory>
+PeerConnectionFactory::CreateSctpTransportInternalFactoryForThread(
+    rtc::Thread* network_thread) {
+#ifdef HAVE_SCTP
+  return absl::make_unique<cricket::SctpTransportFactory>(network_thread);
+#else
+  return nullptr;
+#endif
+}
+
+rtc::Thread* PeerConnectionFactory::AcquireNetworkThread(
+    bool first_thread_only) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  size_t index = 0;
+  if (!first_thread_only && network_threads_.size() > 1) {
+    if (network_thread_policy_) {
+      index = std::min(network_thread_policy_->SelectNetworkThread(
+                           peer_connections_per_network_thread_),
+                       network_threads_.size() - 1);
+    } else {
+      index = std::min_element(peer_connections_per_network_thread_.begin(),
+                               peer_connections_per_network_thread_.end()) -
+              peer_connections_per_network_thread_.begin();
+    }
+  }
+  ++peer_connections_per_network_thread_[index];
+  return network_threads_[index];
+}
+
+void PeerConnectionFactory::ReleaseNetworkThread(rtc::Thread* thread) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  auto it = std::find(network_threads_.begin(), network_threads_.end(), thread);
+  RTC_DCHECK(it != network_threads_.end());
+  if (it == network_threads_.end()) {
+    return;
+  }
+  int& count = peer_connections_per_network_thread_[it - network_threads_.begin()];
+  RTC_DCHECK_GT(count, 0);
+  --count;
+}
+
 cricket::ChannelManager* PeerConnectionFactory::channel_manager() {
   return channel_manager_.get();
 }
@@ -83,7 +83,21 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
     return signaling_thread_;
   }
   rtc::Thread* worker_thread() { return worker_thread_; }
+  // The first network thread. Used by everything that is not tied to a
+  // particular PeerConnection.
   rtc::Thread* network_thread() { return network_thread_; }
+  size_t network_thread_count() const { return network_threads_.size(); }
+
+  // Picks the network thread for a new PeerConnection with the assignment
+  // policy and counts it as in use until ReleaseNetworkThread(). If
+  // |first_thread_only| is true, the first network thread is used.
+  rtc::Thread* AcquireNetworkThread(bool first_thread_only);
+  void ReleaseNetworkThread(rtc::Thread* thread);
+
+  // Like CreateSctpTransportInternalFactory(), for a PeerConnection pinned to
+  // |network_thread|.
+  virtual std::unique_ptr<cricket::SctpTransportInternalFactory>
+  CreateSctpTransportInternalFactoryForThread(rtc::Thread* network_thread);
 
   const Options& options() const { return options_; }
 
@@ -113,11 +127,20 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   rtc::Thread* signaling_thread_;
   std::unique_ptr<rtc::Thread> owned_network_thread_;
   std::unique_ptr<rtc::Thread> owned_worker_thread_;
+  // All network threads, starting with |network_thread_|, and per thread the
+  // number of PeerConnections pinned to it.
+  std::vector<rtc::Thread*> network_threads_;
+  std::vector<std::unique_ptr<rtc::Thread>> owned_additional_network_threads_;
+  std::vector<int> peer_connections_per_network_thread_;
+  std::unique_ptr<NetworkThreadAssignmentPolicy> network_thread_policy_;
   const std::unique_ptr<TaskQueueFactory> task_queue_factory_;
   Options options_;
   std::unique_ptr<cricket::ChannelManager> channel_manager_;
-  std::unique_ptr<rtc::BasicNetworkManager> default_network_manager_;
-  std::unique_ptr<rtc::BasicPacketSocketFactory> default_socket_factory_;
+  // Default network manager and socket factory, one per network thread.
+  std::vector<std::unique_ptr<rtc::BasicNetworkManager>>
+      default_network_managers_;
+  std::vector<std::unique_ptr<rtc::BasicPacketSocketFactory>>
+      default_socket_factories_;
   std::unique_ptr<cricket::MediaEngineInterface> media_engine_;
   std::unique_ptr<webrtc::CallFactoryInterface> call_factory_;
   std::unique_ptr<RtcEventLogFactoryInterface> event_log_factory_;
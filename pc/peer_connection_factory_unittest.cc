@@ -14,28 +14,37 @@
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "api/audio/audio_mixer.h"
 #include "api/audio_codecs/audio_decoder_factory.h"
 #include "api/audio_codecs/audio_encoder_factory.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/call/call_factory_interface.h"
 #include "api/create_peerconnection_factory.h"
 #include "api/data_channel_interface.h"
 #include "api/jsep.h"
 #include "api/media_stream_interface.h"
+#include "api/peer_connection_proxy.h"
 #include "api/video_codecs/builtin_video_decoder_factory.h"
 #include "api/video_codecs/builtin_video_encoder_factory.h"
 #include "api/video_codecs/video_decoder_factory.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "media/base/fake_frame_source.h"
+#include "media/base/fake_media_engine.h"
 #include "modules/audio_device/include/audio_device.h"
 #include "modules/audio_processing/include/audio_processing.h"
 #include "p2p/base/fake_port_allocator.h"
+#include "p2p/base/p2p_transport_channel.h"
 #include "p2p/base/port.h"
 #include "p2p/base/port_interface.h"
+#include "p2p/client/basic_port_allocator.h"
+#include "pc/peer_connection.h"
 #include "pc/peer_connection_factory.h"
+#include "pc/peer_connection_wrapper.h"
 #include "pc/test/fake_audio_capture_module.h"
 #include "pc/test/fake_video_track_source.h"
+#include "pc/test/mock_peer_connection_observers.h"
 #include "rtc_base/socket_address.h"
 #include "test/gtest.h"
 
@@ -479,3 +488,95 @@ TEST_F(PeerConnectionFactoryTest, LocalRendering) {
   EXPECT_EQ(3, local_renderer.num_rendered_frames());
   EXPECT_FALSE(local_renderer.black_frame());
 }
+
+// Verifies that PeerConnections are spread over the network thread pool and
+// that released threads are reused first.
+TEST(PeerConnectionFactoryTestInternal, AssignsLeastLoadedNetworkThread) {
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.signaling_thread = rtc::Thread::Current();
+  dependencies.worker_thread = rtc::Thread::Current();
+  dependencies.network_thread_count = 3;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactory> factory(
+      new rtc::RefCountedObject<webrtc::PeerConnectionFactory>(
+          std::move(dependencies)));
+  ASSERT_EQ(3u, factory->network_thread_count());
+
+  rtc::Thread* first = factory->AcquireNetworkThread(false);
+  rtc::Thread* second = factory->AcquireNetworkThread(false);
+  rtc::Thread* third = factory->AcquireNetworkThread(false);
+  EXPECT_EQ(factory->network_thread(), first);
+  EXPECT_NE(first, second);
+  EXPECT_NE(first, third);
+  EXPECT_NE(second, third);
+
+  factory->ReleaseNetworkThread(second);
+  EXPECT_EQ(second, factory->AcquireNetworkThread(false));
+  // PeerConnections with an injected allocator stay on the first thread.
+  EXPECT_EQ(first, factory->AcquireNetworkThread(true));
+
+  factory->ReleaseNetworkThread(first);
+  factory->ReleaseNetworkThread(first);
+  factory->ReleaseNetworkThread(second);
+  factory->ReleaseNetworkThread(third);
+}
+
+// Verifies that PeerConnections created without an injected allocator are
+// spread over the network threads, and that their ICE transports run on the
+// thread each one was assigned.
+TEST(PeerConnectionFactoryTestInternal, TransportsRunOnAssignedNetworkThread) {
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.signaling_thread = rtc::Thread::Current();
+  dependencies.worker_thread = rtc::Thread::Current();
+  dependencies.network_thread_count = 2;
+  dependencies.media_engine = absl::make_unique<cricket::FakeMediaEngine>();
+  dependencies.call_factory = webrtc::CreateCallFactory();
+  rtc::scoped_refptr<webrtc::PeerConnectionFactory> factory(
+      new rtc::RefCountedObject<webrtc::PeerConnectionFactory>(
+          std::move(dependencies)));
+  ASSERT_TRUE(factory->Initialize());
+
+  webrtc::PeerConnectionInterface::RTCConfiguration config;
+  config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+  std::vector<std::unique_ptr<webrtc::PeerConnectionWrapper>> wrappers;
+  for (int i = 0; i < 2; ++i) {
+    auto observer = absl::make_unique<webrtc::MockPeerConnectionObserver>();
+    webrtc::PeerConnectionDependencies pc_dependencies(observer.get());
+    pc_dependencies.cert_generator =
+        absl::make_unique<FakeRTCCertificateGenerator>();
+    // No allocator is injected, so the factory picks the network thread.
+    rtc::scoped_refptr<PeerConnectionInterface> pc =
+        factory->CreatePeerConnection(config, std::move(pc_dependencies));
+    ASSERT_TRUE(pc);
+    observer->SetPeerConnectionInterface(pc.get());
+    wrappers.push_back(absl::make_unique<webrtc::PeerConnectionWrapper>(
+        factory, pc, std::move(observer)));
+  }
+
+  std::vector<rtc::Thread*> threads;
+  for (const auto& wrapper : wrappers) {
+    auto transceiver = wrapper->AddTransceiver(cricket::MEDIA_TYPE_AUDIO);
+    ASSERT_TRUE(wrapper->CreateOfferAndSetAsLocal());
+    auto* proxy = static_cast<
+        webrtc::PeerConnectionProxyWithInternal<PeerConnectionInterface>*>(
+        wrapper->pc());
+    auto* pc = static_cast<webrtc::PeerConnection*>(proxy->internal());
+    threads.push_back(pc->network_thread());
+
+    auto dtls_transport =
+        pc->LookupDtlsTransportByMidInternal(*transceiver->mid());
+    ASSERT_TRUE(dtls_transport);
+    auto* ice_transport = static_cast<cricket::P2PTransportChannel*>(
+        dtls_transport->internal()->ice_transport());
+    // The ICE transport gathers ports with an allocator session it started on
+    // its own thread.
+    rtc::Thread* session_thread =
+        pc->network_thread()->Invoke<rtc::Thread*>(RTC_FROM_HERE, [&] {
+          auto* session = static_cast<cricket::BasicPortAllocatorSession*>(
+              ice_transport->allocator_session());
+          return session ? session->network_thread() : nullptr;
+        });
+    EXPECT_EQ(pc->network_thread(), session_thread);
+  }
+  EXPECT_EQ(factory->network_thread(), threads[0]);
+  EXPECT_NE(threads[0], threads[1]);
+}
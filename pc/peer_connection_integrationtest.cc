@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
@@ -3385,6 +3386,75 @@ TEST_P(PeerConnectionIntegrationTest, StressTestUnorderedSctpDataChannel) {
   EXPECT_EQ(sent_messages, callee_received_messages);
 }
 
+// Sends a few tens of megabytes from |sender| to |receiver| over their open
+// data channel and prints the throughput. Like a file transfer would, the
+// sender keeps the channel's buffer topped up to a high watermark and refills
+// it from OnBufferedAmountLow, so memory stays bounded without stalling.
+void MeasureSctpDataChannelThroughput(PeerConnectionWrapper* sender,
+                                      PeerConnectionWrapper* receiver,
+                                      const char* description) {
+  static constexpr int kNumMessages = 2000;
+  static constexpr size_t kMessageSize = 16 * 1024;
+  static constexpr uint64_t kHighWatermark = 1024 * 1024;
+  static constexpr int kTransferTimeoutMs = 60000;
+  DataChannelInterface* channel = sender->data_channel();
+  channel->SetBufferedAmountLowThreshold(kHighWatermark / 2);
+  const DataBuffer message(rtc::CopyOnWriteBuffer(kMessageSize), true);
+
+  int64_t start_ms = rtc::TimeMillis();
+  int sent = 0;
+  while (sent < kNumMessages) {
+    while (sent < kNumMessages && channel->buffered_amount() < kHighWatermark) {
+      ASSERT_TRUE(channel->Send(message));
+      ++sent;
+    }
+    if (sent < kNumMessages) {
+      int low_count = sender->data_observer()->buffered_amount_low_count();
+      ASSERT_TRUE_WAIT(
+          sender->data_observer()->buffered_amount_low_count() > low_count,
+          kTransferTimeoutMs);
+    }
+  }
+  EXPECT_EQ_WAIT(rtc::checked_cast<size_t>(kNumMessages),
+                 receiver->data_observer()->received_message_count(),
+                 kTransferTimeoutMs);
+  int64_t elapsed_ms = std::max<int64_t>(1, rtc::TimeMillis() - start_ms);
+  printf("%s: %d messages of %zu bytes in %d ms, %.1f Mbps\n", description,
+         kNumMessages, kMessageSize, static_cast<int>(elapsed_ms),
+         kNumMessages * kMessageSize * 8.0 / (elapsed_ms * 1000.0));
+}
+
+// Run manually, e.g. with --gtest_also_run_disabled_tests
+// --gtest_filter=*SctpDataChannelThroughput*.
+TEST_P(PeerConnectionIntegrationTest,
+       DISABLED_ReliableSctpDataChannelThroughput) {
+  ASSERT_TRUE(CreatePeerConnectionWrappers());
+  ConnectFakeSignaling();
+  caller()->CreateDataChannel();
+  caller()->CreateAndSetAndSignalOffer();
+  ASSERT_TRUE_WAIT(SignalingStateStable(), kDefaultTimeout);
+  ASSERT_TRUE_WAIT(callee()->data_channel() != nullptr, kDefaultTimeout);
+  ASSERT_TRUE_WAIT(caller()->data_observer()->IsOpen(), kDefaultTimeout);
+  ASSERT_TRUE_WAIT(callee()->data_observer()->IsOpen(), kDefaultTimeout);
+  MeasureSctpDataChannelThroughput(caller(), callee(), "Reliable");
+}
+
+TEST_P(PeerConnectionIntegrationTest,
+       DISABLED_UnreliableSctpDataChannelThroughput) {
+  ASSERT_TRUE(CreatePeerConnectionWrappers());
+  ConnectFakeSignaling();
+  webrtc::DataChannelInit init;
+  init.ordered = false;
+  init.maxRetransmits = 0;
+  caller()->CreateDataChannel(&init);
+  caller()->CreateAndSetAndSignalOffer();
+  ASSERT_TRUE_WAIT(SignalingStateStable(), kDefaultTimeout);
+  ASSERT_TRUE_WAIT(callee()->data_channel() != nullptr, kDefaultTimeout);
+  ASSERT_TRUE_WAIT(caller()->data_observer()->IsOpen(), kDefaultTimeout);
+  ASSERT_TRUE_WAIT(callee()->data_observer()->IsOpen(), kDefaultTimeout);
+  MeasureSctpDataChannelThroughput(caller(), callee(), "Unreliable");
+}
+
 // This test sets up a call between two parties with audio, and video. When
 // audio and video are setup and flowing, an SCTP data channel is negotiated.
 TEST_P(PeerConnectionIntegrationTest, AddSctpDataChannelInSubsequentOffer) {
@@ -140,6 +140,12 @@ bool RtpTransport::SendRtpPacket(rtc::CopyOnWriteBuffer* packet,
   return SendPacket(false, packet, options, flags);
 }
 
+void RtpTransport::SendRtpPackets(rtc::ArrayView<OutgoingRtpPacket> packets,
+                                  int flags) {
+  for (OutgoingRtpPacket& packet : packets)
+    packet.sent = SendRtpPacket(packet.packet, *packet.options, flags);
+}
+
 bool RtpTransport::SendRtcpPacket(rtc::CopyOnWriteBuffer* packet,
                                   const rtc::PacketOptions& options,
                                   int flags) {
@@ -216,7 +222,9 @@ RtpTransportParameters RtpTransport::GetParameters() const {
 
 void RtpTransport::DemuxPacket(rtc::CopyOnWriteBuffer packet,
                                int64_t packet_time_us) {
-  webrtc::RtpPacketReceived parsed_packet(&header_extension_map_);
+  // Parse() takes over the buffer of |packet|, don't allocate one.
+  webrtc::RtpPacketReceived parsed_packet(&header_extension_map_,
+                                          /*capacity=*/0);
   if (!parsed_packet.Parse(std::move(packet))) {
     RTC_LOG(LS_ERROR)
         << "Failed to parse the incoming RTP packet before demuxing. Drop it.";
@@ -72,6 +72,9 @@ class RtpTransport : public RtpTransportInternal {
                       const rtc::PacketOptions& options,
                       int flags) override;
 
+  void SendRtpPackets(rtc::ArrayView<OutgoingRtpPacket> packets,
+                      int flags) override;
+
   bool IsSrtpActive() const override { return false; }
 
   void UpdateRtpHeaderExtensionMap(
@@ -13,6 +13,7 @@
 
 #include <string>
 
+#include "api/array_view.h"
 #include "api/ortc/srtp_transport_interface.h"
 #include "call/rtp_demuxer.h"
 #include "p2p/base/ice_transport_internal.h"
@@ -82,6 +83,19 @@ class RtpTransportInternal : public SrtpTransportInterface,
                               const rtc::PacketOptions& options,
                               int flags) = 0;
 
+  // An RTP packet in a burst passed to SendRtpPackets().
+  struct OutgoingRtpPacket {
+    rtc::CopyOnWriteBuffer* packet = nullptr;
+    const rtc::PacketOptions* options = nullptr;
+    // Set to the result SendRtpPacket() would have returned.
+    bool sent = false;
+  };
+  // Sends a burst of RTP packets in order, e.g. the packets of one pacer
+  // burst, as if SendRtpPacket() was called for each. SRTP transports protect
+  // the burst with a single SrtpSession call.
+  virtual void SendRtpPackets(rtc::ArrayView<OutgoingRtpPacket> packets,
+                              int flags) = 0;
+
   // This method updates the RTP header extension map so that the RTP transport
   // can parse the received packets and identify the MID. This is called by the
   // BaseChannel when setting the content description.
@@ -10,8 +10,15 @@
 
 #include "pc/srtp_session.h"
 
+#include <string.h>
+
+#include <type_traits>
+
+#include "absl/types/optional.h"
 #include "media/base/rtp_utils.h"
 #include "pc/external_hmac.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/constructor_magic.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/ssl_stream_adapter.h"
@@ -26,6 +33,87 @@ namespace cricket {
 // in srtp.h.
 constexpr int kSrtpErrorCodeBoundary = 28;
 
+// Offsets of the SSRC that libsrtp uses to find the stream of a packet.
+constexpr int kRtpSsrcOffset = 8;
+constexpr int kRtcpSsrcOffset = 4;
+
+// ScopedStreamList relies on these private parts of libsrtp. Any change of
+// the stream list representation must break the build here.
+static_assert(std::is_same<decltype(srtp_ctx_t::stream_list),
+                           srtp_stream_ctx_t*>::value,
+              "libsrtp no longer keeps its streams in a linked list");
+static_assert(std::is_same<decltype(srtp_stream_ctx_t::next),
+                           srtp_stream_ctx_t*>::value,
+              "libsrtp no longer keeps its streams in a linked list");
+static_assert(std::is_same<decltype(srtp_stream_ctx_t::ssrc), uint32_t>::value,
+              "libsrtp changed the type of stream SSRCs");
+
+class SrtpSession::ScopedStreamList {
+ public:
+  ScopedStreamList(SrtpSession* session, const void* p, int len, bool rtcp)
+      : session_(session),
+        ssrc_offset_(rtcp ? kRtcpSsrcOffset : kRtpSsrcOffset) {
+    uint32_t ssrc;
+    if (!ReadSsrc(p, len, &ssrc))
+      return;
+    ssrc_ = ssrc;
+    auto it = session_->streams_.find(ssrc);
+    if (it == session_->streams_.end()) {
+      // Let libsrtp search the full list; it adds a stream for a new SSRC at
+      // its head.
+      return;
+    }
+    narrowed_stream_ = it->second;
+    RTC_DCHECK_EQ(ssrc, narrowed_stream_->ssrc);
+    srtp_ctx_t* srtp = session_->session_;
+    full_stream_list_ = srtp->stream_list;
+    narrowed_stream_next_ = narrowed_stream_->next;
+    narrowed_stream_->next = nullptr;
+    srtp->stream_list = narrowed_stream_;
+  }
+
+  ~ScopedStreamList() {
+    if (!ssrc_)
+      return;
+    srtp_ctx_t* srtp = session_->session_;
+    if (narrowed_stream_) {
+      // libsrtp only adds streams for SSRCs that it did not find.
+      RTC_DCHECK_EQ(narrowed_stream_, srtp->stream_list);
+      RTC_DCHECK(!narrowed_stream_->next);
+      narrowed_stream_->next = narrowed_stream_next_;
+      srtp->stream_list = full_stream_list_;
+      return;
+    }
+    srtp_stream_ctx_t* head = srtp->stream_list;
+    if (head && head->ssrc == *ssrc_)
+      session_->streams_.emplace(*ssrc_, head);
+  }
+
+  // Whether the list is narrowed to the stream of packet |p|, so that a batch
+  // can keep it for the next packet of the same stream.
+  bool Covers(const void* p, int len) const {
+    uint32_t ssrc;
+    return narrowed_stream_ && ReadSsrc(p, len, &ssrc) && ssrc == *ssrc_;
+  }
+
+ private:
+  bool ReadSsrc(const void* p, int len, uint32_t* ssrc) const {
+    if (len < ssrc_offset_ + static_cast<int>(sizeof(uint32_t)))
+      return false;
+    memcpy(ssrc, static_cast<const uint8_t*>(p) + ssrc_offset_, sizeof(*ssrc));
+    return true;
+  }
+
+  SrtpSession* const session_;
+  const int ssrc_offset_;
+  absl::optional<uint32_t> ssrc_;
+  srtp_stream_ctx_t* full_stream_list_ = nullptr;
+  srtp_stream_ctx_t* narrowed_stream_ = nullptr;
+  srtp_stream_ctx_t* narrowed_stream_next_ = nullptr;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedStreamList);
+};
+
 SrtpSession::SrtpSession() {}
 
 SrtpSession::~SrtpSession() {
@@ -81,7 +169,11 @@ bool SrtpSession::ProtectRtp(void* p, int in_len, int max_len, int* out_len) {
   }
 
   *out_len = in_len;
-  int err = srtp_protect(session_, p, out_len);
+  int err;
+  {
+    ScopedStreamList stream_list(this, p, in_len, /*rtcp=*/false);
+    err = srtp_protect(session_, p, out_len);
+  }
   int seq_num;
   GetRtpSeqNum(p, in_len, &seq_num);
   if (err != srtp_err_status_ok) {
@@ -120,7 +212,11 @@ bool SrtpSession::ProtectRtcp(void* p, int in_len, int max_len, int* out_len) {
   }
 
   *out_len = in_len;
-  int err = srtp_protect_rtcp(session_, p, out_len);
+  int err;
+  {
+    ScopedStreamList stream_list(this, p, in_len, /*rtcp=*/true);
+    err = srtp_protect_rtcp(session_, p, out_len);
+  }
   if (err != srtp_err_status_ok) {
     RTC_LOG(LS_WARNING) << "Failed to protect SRTCP packet, err=" << err;
     return false;
@@ -136,24 +232,111 @@ bool SrtpSession::UnprotectRtp(void* p, int in_len, int* out_len) {
   }
 
   *out_len = in_len;
-  int err = srtp_unprotect(session_, p, out_len);
+  int err;
+  {
+    ScopedStreamList stream_list(this, p, in_len, /*rtcp=*/false);
+    err = srtp_unprotect(session_, p, out_len);
+  }
   if (err != srtp_err_status_ok) {
-    // Limit the error logging to avoid excessive logs when there are lots of
-    // bad packets.
-    const int kFailureLogThrottleCount = 100;
-    if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
-      RTC_LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err
-                          << ", previous failure count: "
-                          << decryption_failure_count_;
-    }
-    ++decryption_failure_count_;
-    RTC_HISTOGRAM_ENUMERATION("WebRTC.PeerConnection.SrtpUnprotectError",
-                              static_cast<int>(err), kSrtpErrorCodeBoundary);
+    OnUnprotectRtpFailure(err);
     return false;
   }
   return true;
 }
 
+size_t SrtpSession::ProtectRtp(rtc::ArrayView<RtpPacketRef> packets) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  for (RtpPacketRef& packet : packets)
+    packet.ok = false;
+  if (!session_) {
+    RTC_LOG(LS_WARNING) << "Failed to protect " << packets.size()
+                        << " SRTP packets: no SRTP Session";
+    return 0;
+  }
+
+  size_t num_protected = 0;
+  int num_failed = 0;
+  int first_err = srtp_err_status_ok;
+  int first_failed_seq_num = -1;
+  absl::optional<ScopedStreamList> stream_list;
+  for (RtpPacketRef& packet : packets) {
+    const int in_len = packet.len;
+    int err = srtp_err_status_bad_param;
+    if (packet.max_len >= in_len + rtp_auth_tag_len_) {
+      if (!stream_list || !stream_list->Covers(packet.data, in_len)) {
+        stream_list.reset();
+        stream_list.emplace(this, packet.data, in_len, /*rtcp=*/false);
+      }
+      err = srtp_protect(session_, packet.data, &packet.len);
+    }
+    int seq_num;
+    GetRtpSeqNum(packet.data, in_len, &seq_num);
+    if (err != srtp_err_status_ok) {
+      packet.len = in_len;
+      if (num_failed++ == 0) {
+        first_err = err;
+        first_failed_seq_num = seq_num;
+      }
+      continue;
+    }
+    last_send_seq_num_ = seq_num;
+    packet.ok = true;
+    ++num_protected;
+  }
+  stream_list.reset();
+  if (num_failed > 0) {
+    RTC_LOG(LS_WARNING) << "Failed to protect " << num_failed << " of "
+                        << packets.size() << " SRTP packets, first seqnum="
+                        << first_failed_seq_num << ", err=" << first_err
+                        << ", last seqnum=" << last_send_seq_num_;
+  }
+  return num_protected;
+}
+
+size_t SrtpSession::UnprotectRtp(rtc::ArrayView<RtpPacketRef> packets) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  for (RtpPacketRef& packet : packets)
+    packet.ok = false;
+  if (!session_) {
+    RTC_LOG(LS_WARNING) << "Failed to unprotect " << packets.size()
+                        << " SRTP packets: no SRTP Session";
+    return 0;
+  }
+
+  size_t num_unprotected = 0;
+  absl::optional<ScopedStreamList> stream_list;
+  for (RtpPacketRef& packet : packets) {
+    const int in_len = packet.len;
+    if (!stream_list || !stream_list->Covers(packet.data, in_len)) {
+      stream_list.reset();
+      stream_list.emplace(this, packet.data, in_len, /*rtcp=*/false);
+    }
+    int err = srtp_unprotect(session_, packet.data, &packet.len);
+    if (err != srtp_err_status_ok) {
+      packet.len = in_len;
+      OnUnprotectRtpFailure(err);
+      continue;
+    }
+    packet.ok = true;
+    ++num_unprotected;
+  }
+  return num_unprotected;
+}
+
+void SrtpSession::OnUnprotectRtpFailure(int err) {
+  // Limit the error logging to avoid excessive logs when there are lots of
+  // bad packets.
+  const int kFailureLogThrottleCount = 100;
+  if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
+    RTC_LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err
+                        << ", previous failure count: "
+                        << decryption_failure_count_;
+  }
+  ++decryption_failure_count_;
+  RTC_HISTOGRAM_ENUMERATION("WebRTC.PeerConnection.SrtpUnprotectError",
+                            static_cast<int>(err), kSrtpErrorCodeBoundary);
+}
+
 bool SrtpSession::UnprotectRtcp(void* p, int in_len, int* out_len) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   if (!session_) {
@@ -162,7 +345,11 @@ bool SrtpSession::UnprotectRtcp(void* p, int in_len, int* out_len) {
   }
 
   *out_len = in_len;
-  int err = srtp_unprotect_rtcp(session_, p, out_len);
+  int err;
+  {
+    ScopedStreamList stream_list(this, p, in_len, /*rtcp=*/true);
+    err = srtp_unprotect_rtcp(session_, p, out_len);
+  }
   if (err != srtp_err_status_ok) {
     RTC_LOG(LS_WARNING) << "Failed to unprotect SRTCP packet, err=" << err;
     RTC_HISTOGRAM_ENUMERATION("WebRTC.PeerConnection.SrtcpUnprotectError",
@@ -222,7 +409,7 @@ bool SrtpSession::GetSendStreamPacketIndex(void* p,
                                            int64_t* index) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   srtp_hdr_t* hdr = reinterpret_cast<srtp_hdr_t*>(p);
-  srtp_stream_ctx_t* stream = srtp_get_stream(session_, hdr->ssrc);
+  srtp_stream_ctx_t* stream = FindStream(hdr->ssrc);
   if (!stream) {
     return false;
   }
@@ -233,6 +420,19 @@ bool SrtpSession::GetSendStreamPacketIndex(void* p,
   return true;
 }
 
+void SrtpSession::RebuildStreamTable() {
+  streams_.clear();
+  for (srtp_stream_ctx_t* stream = session_ ? session_->stream_list : nullptr;
+       stream; stream = stream->next) {
+    streams_.emplace(stream->ssrc, stream);
+  }
+}
+
+srtp_stream_ctx_t_* SrtpSession::FindStream(uint32_t ssrc) const {
+  auto it = streams_.find(ssrc);
+  return it != streams_.end() ? it->second : nullptr;
+}
+
 bool SrtpSession::DoSetKey(int type,
                            int cs,
                            const uint8_t* key,
@@ -313,6 +513,8 @@ bool SrtpSession::DoSetKey(int type,
     srtp_set_user_data(session_, this);
   } else {
     int err = srtp_update(session_, &policy);
+    // The streams are recreated with the new keys.
+    RebuildStreamTable();
     if (err != srtp_err_status_ok) {
       RTC_LOG(LS_ERROR) << "Failed to update SRTP session, err=" << err;
       return false;
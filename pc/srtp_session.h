@@ -11,14 +11,19 @@
 #ifndef PC_SRTP_SESSION_H_
 #define PC_SRTP_SESSION_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
+#include "api/array_view.h"
 #include "api/scoped_refptr.h"
 #include "rtc_base/thread_checker.h"
 
 // Forward declaration to avoid pulling in libsrtp headers here
 struct srtp_event_data_t;
 struct srtp_ctx_t_;
+struct srtp_stream_ctx_t_;
 
 namespace cricket {
 
@@ -65,6 +70,23 @@ class SrtpSession {
   bool UnprotectRtp(void* data, int in_len, int* out_len);
   bool UnprotectRtcp(void* data, int in_len, int* out_len);
 
+  // An RTP packet in a batch passed to the ProtectRtp()/UnprotectRtp()
+  // overloads below. The packet is processed in place and |len| is updated
+  // if |ok| is set.
+  struct RtpPacketRef {
+    void* data = nullptr;
+    int len = 0;
+    // Size of the |data| buffer; only used when protecting.
+    int max_len = 0;
+    bool ok = false;
+  };
+  // Encrypts/decrypts a batch of RTP packets, in order. libsrtp still works
+  // per packet, but the session is checked once, the stream of a run of
+  // packets with the same SSRC is looked up once, and protect failures are
+  // logged once per batch. Returns the number of packets that succeeded.
+  size_t ProtectRtp(rtc::ArrayView<RtpPacketRef> packets);
+  size_t UnprotectRtp(rtc::ArrayView<RtpPacketRef> packets);
+
   // Helper method to get authentication params.
   bool GetRtpAuthParams(uint8_t** key, int* key_len, int* tag_len);
 
@@ -99,6 +121,19 @@ class SrtpSession {
                  const uint8_t* key,
                  size_t len,
                  const std::vector<int>& extension_ids);
+  // Logs and counts a failed srtp_unprotect() call.
+  void OnUnprotectRtpFailure(int err);
+  // libsrtp finds the stream of a packet by walking a linked list of all
+  // streams of the session, which costs O(n) per packet with n SSRCs. Around
+  // every libsrtp call a ScopedStreamList narrows the list to the packet's
+  // stream, looked up in |streams_|, and restores it when it goes out of
+  // scope. Streams that libsrtp creates for new SSRCs are added to |streams_|
+  // at that point.
+  class ScopedStreamList;
+  // Rebuilds |streams_| after libsrtp created or replaced streams.
+  void RebuildStreamTable();
+  srtp_stream_ctx_t_* FindStream(uint32_t ssrc) const;
+
   // Returns send stream current packet index from srtp db.
   bool GetSendStreamPacketIndex(void* data, int in_len, int64_t* index);
 
@@ -123,6 +158,8 @@ class SrtpSession {
   bool external_auth_active_ = false;
   bool external_auth_enabled_ = false;
   int decryption_failure_count_ = 0;
+  // libsrtp streams by SSRC, in network byte order like in libsrtp.
+  std::unordered_map<uint32_t, srtp_stream_ctx_t_*> streams_;
   RTC_DISALLOW_COPY_AND_ASSIGN(SrtpSession);
 };
 
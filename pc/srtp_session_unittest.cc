@@ -10,13 +10,17 @@
 
 #include "pc/srtp_session.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <string>
+#include <vector>
 
 #include "media/base/fake_rtp.h"
 #include "pc/test/srtp_test_util.h"
+#include "rtc_base/arraysize.h"
 #include "rtc_base/byte_order.h"
 #include "rtc_base/ssl_stream_adapter.h"  // For rtc::SRTP_*
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
@@ -246,4 +250,180 @@ TEST_F(SrtpSessionTest, TestReplay) {
       s1_.ProtectRtp(rtp_packet_, rtp_len_, sizeof(rtp_packet_), &out_len));
 }
 
+// Test that packets of many SSRCs, interleaved, keep their own streams, also
+// across a key update.
+TEST_F(SrtpSessionTest, TestProtectUnprotectManySsrcs) {
+  static const int kNumSsrcs = 50;
+  EXPECT_TRUE(s1_.SetSend(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+  EXPECT_TRUE(s2_.SetRecv(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+  char packet[sizeof(rtp_packet_)];
+  int out_len;
+  for (int round = 0; round < 4; ++round) {
+    if (round == 2) {
+      EXPECT_TRUE(s1_.UpdateSend(SRTP_AES128_CM_SHA1_80, kTestKey2,
+                                 kTestKeyLen, kEncryptedHeaderExtensionIds));
+      EXPECT_TRUE(s2_.UpdateRecv(SRTP_AES128_CM_SHA1_80, kTestKey2,
+                                 kTestKeyLen, kEncryptedHeaderExtensionIds));
+    }
+    for (int i = 0; i < kNumSsrcs; ++i) {
+      memcpy(packet, kPcmuFrame, rtp_len_);
+      SetBE16(reinterpret_cast<uint8_t*>(packet) + 2, round + 1);
+      SetBE32(reinterpret_cast<uint8_t*>(packet) + 8, 1000 + i);
+      ASSERT_TRUE(s1_.ProtectRtp(packet, rtp_len_, sizeof(packet), &out_len));
+      ASSERT_TRUE(s2_.UnprotectRtp(packet, out_len, &out_len));
+      EXPECT_EQ(rtp_len_, out_len);
+      // A replay is rejected by the stream of its SSRC.
+      ASSERT_TRUE(s1_.ProtectRtp(packet, rtp_len_, sizeof(packet), &out_len));
+      EXPECT_FALSE(s2_.UnprotectRtp(packet, out_len, &out_len));
+    }
+  }
+}
+
+// Test that a batch is protected and unprotected packet by packet, and that a
+// bad packet does not affect the rest of its batch.
+TEST_F(SrtpSessionTest, TestProtectUnprotectRtpBatch) {
+  static const int kNumPackets = 4;
+  EXPECT_TRUE(s1_.SetSend(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+  EXPECT_TRUE(s2_.SetRecv(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+
+  char packets[kNumPackets][sizeof(rtp_packet_)];
+  cricket::SrtpSession::RtpPacketRef refs[kNumPackets];
+  for (int i = 0; i < kNumPackets; ++i) {
+    memcpy(packets[i], kPcmuFrame, rtp_len_);
+    SetBE16(reinterpret_cast<uint8_t*>(packets[i]) + 2, i + 1);
+    refs[i].data = packets[i];
+    refs[i].len = rtp_len_;
+    refs[i].max_len = sizeof(packets[i]);
+  }
+  // No room for the auth tag.
+  refs[1].max_len = rtp_len_;
+  EXPECT_EQ(3u, s1_.ProtectRtp(refs));
+  EXPECT_TRUE(refs[0].ok);
+  EXPECT_FALSE(refs[1].ok);
+  EXPECT_EQ(rtp_len_, refs[1].len);
+  EXPECT_TRUE(refs[2].ok);
+  EXPECT_TRUE(refs[3].ok);
+  EXPECT_EQ(rtp_len_ + rtp_auth_tag_len(CS_AES_CM_128_HMAC_SHA1_80),
+            refs[3].len);
+
+  // Tamper with the third packet.
+  packets[2][rtp_len_ - 1] ^= 0x01;
+  EXPECT_EQ(2u, s2_.UnprotectRtp(refs));
+  EXPECT_TRUE(refs[0].ok);
+  EXPECT_FALSE(refs[1].ok);
+  EXPECT_FALSE(refs[2].ok);
+  EXPECT_TRUE(refs[3].ok);
+  EXPECT_EQ(rtp_len_, refs[3].len);
+  // Everything but the sequence number matches the original packet.
+  EXPECT_EQ(0, memcmp(packets[0] + 4, kPcmuFrame + 4, rtp_len_ - 4));
+  EXPECT_EQ(0, memcmp(packets[3] + 4, kPcmuFrame + 4, rtp_len_ - 4));
+  EXPECT_THAT(
+      webrtc::metrics::Samples("WebRTC.PeerConnection.SrtpUnprotectError"),
+      ElementsAre(Pair(srtp_err_status_auth_fail, 2)));
+}
+
+// Test that runs of packets with the same SSRC share a stream lookup without
+// mixing up streams, including SSRCs that first appear within the batch and
+// a replay of a packet earlier in the batch.
+TEST_F(SrtpSessionTest, TestProtectUnprotectRtpBatchOfSsrcRuns) {
+  static const uint32_t kSsrcs[] = {1, 1, 2, 2, 1, 3, 3, 1};
+  static const int kNumPackets = arraysize(kSsrcs);
+  EXPECT_TRUE(s1_.SetSend(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+  EXPECT_TRUE(s2_.SetRecv(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+
+  char packets[kNumPackets + 1][sizeof(rtp_packet_)];
+  cricket::SrtpSession::RtpPacketRef refs[kNumPackets + 1];
+  for (int i = 0; i < kNumPackets; ++i) {
+    memcpy(packets[i], kPcmuFrame, rtp_len_);
+    SetBE16(reinterpret_cast<uint8_t*>(packets[i]) + 2, i + 1);
+    SetBE32(reinterpret_cast<uint8_t*>(packets[i]) + 8, kSsrcs[i]);
+    refs[i].data = packets[i];
+    refs[i].len = rtp_len_;
+    refs[i].max_len = sizeof(packets[i]);
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumPackets),
+            s1_.ProtectRtp(rtc::ArrayView<cricket::SrtpSession::RtpPacketRef>(
+                refs, kNumPackets)));
+  // The last packet replays the first.
+  memcpy(packets[kNumPackets], packets[0], refs[0].len);
+  refs[kNumPackets].data = packets[kNumPackets];
+  refs[kNumPackets].len = refs[0].len;
+
+  EXPECT_EQ(static_cast<size_t>(kNumPackets), s2_.UnprotectRtp(refs));
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_TRUE(refs[i].ok) << i;
+    EXPECT_EQ(kSsrcs[i],
+              GetBE32(reinterpret_cast<uint8_t*>(packets[i]) + 8));
+    EXPECT_EQ(0, memcmp(packets[i] + 12, kPcmuFrame + 12, rtp_len_ - 12));
+  }
+  EXPECT_FALSE(refs[kNumPackets].ok);
+
+  // The streams created within the batch are used by single packets too.
+  int out_len;
+  memcpy(rtp_packet_, kPcmuFrame, rtp_len_);
+  SetBE16(reinterpret_cast<uint8_t*>(rtp_packet_) + 2, kNumPackets + 1);
+  SetBE32(reinterpret_cast<uint8_t*>(rtp_packet_) + 8, 3);
+  ASSERT_TRUE(
+      s1_.ProtectRtp(rtp_packet_, rtp_len_, sizeof(rtp_packet_), &out_len));
+  EXPECT_TRUE(s2_.UnprotectRtp(rtp_packet_, out_len, &out_len));
+}
+
+// Test that a batch fails as a whole without a session.
+TEST_F(SrtpSessionTest, TestProtectRtpBatchWithoutSession) {
+  cricket::SrtpSession::RtpPacketRef refs[1];
+  refs[0].data = rtp_packet_;
+  refs[0].len = rtp_len_;
+  refs[0].max_len = sizeof(rtp_packet_);
+  EXPECT_EQ(0u, s1_.ProtectRtp(refs));
+  EXPECT_FALSE(refs[0].ok);
+  EXPECT_EQ(0u, s2_.UnprotectRtp(refs));
+  EXPECT_FALSE(refs[0].ok);
+}
+
+// Measures the cost of unprotecting packets that round-robin over up to 500
+// SSRCs. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*ManySsrcsPerformance*.
+TEST(SrtpSessionPerfTest, DISABLED_UnprotectManySsrcsPerformance) {
+  static const int kPacketsPerRun = 200000;
+  for (int num_ssrcs : {1, 10, 100, 500}) {
+    cricket::SrtpSession sender;
+    cricket::SrtpSession receiver;
+    ASSERT_TRUE(sender.SetSend(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                               kEncryptedHeaderExtensionIds));
+    ASSERT_TRUE(receiver.SetRecv(SRTP_AES128_CM_SHA1_80, kTestKey1,
+                                 kTestKeyLen, kEncryptedHeaderExtensionIds));
+    std::vector<std::vector<char>> packets(num_ssrcs);
+    std::vector<int> lengths(num_ssrcs);
+    int64_t elapsed_ns = 0;
+    uint16_t seq_num = 0;
+    for (int sent = 0; sent < kPacketsPerRun; sent += num_ssrcs) {
+      ++seq_num;
+      for (int i = 0; i < num_ssrcs; ++i) {
+        packets[i].assign(kPcmuFrame, kPcmuFrame + sizeof(kPcmuFrame));
+        packets[i].resize(sizeof(kPcmuFrame) + 10);
+        uint8_t* data = reinterpret_cast<uint8_t*>(packets[i].data());
+        SetBE16(data + 2, seq_num);
+        SetBE32(data + 8, 1000 + i);
+        ASSERT_TRUE(sender.ProtectRtp(data, sizeof(kPcmuFrame),
+                                      static_cast<int>(packets[i].size()),
+                                      &lengths[i]));
+      }
+      int64_t start_ns = TimeNanos();
+      for (int i = 0; i < num_ssrcs; ++i) {
+        int out_len;
+        receiver.UnprotectRtp(packets[i].data(), lengths[i], &out_len);
+      }
+      elapsed_ns += TimeNanos() - start_ns;
+    }
+    printf("%d SSRCs: %.0f ns per unprotect\n", num_ssrcs,
+           static_cast<double>(elapsed_ns) / kPacketsPerRun);
+  }
+}
+
 }  // namespace rtc
@@ -35,6 +35,10 @@ namespace webrtc {
 SrtpTransport::SrtpTransport(bool rtcp_mux_enabled)
     : RtpTransport(rtcp_mux_enabled) {}
 
+SrtpTransport::~SrtpTransport() {
+  rtc::ScopedReadBatch::Cancel(this);
+}
+
 RTCError SrtpTransport::SetSrtpSendKey(const cricket::CryptoParams& params) {
   if (send_params_) {
     LOG_AND_RETURN_ERROR(
@@ -173,6 +177,41 @@ bool SrtpTransport::SendRtpPacket(rtc::CopyOnWriteBuffer* packet,
   return SendPacket(/*rtcp=*/false, packet, updated_options, flags);
 }
 
+void SrtpTransport::SendRtpPackets(rtc::ArrayView<OutgoingRtpPacket> packets,
+                                   int flags) {
+  if (packets.size() < 2 || !IsSrtpActive() || IsExternalAuthActive()) {
+    RtpTransport::SendRtpPackets(packets, flags);
+    return;
+  }
+
+  TRACE_EVENT1("webrtc", "SRTP Encode batch", "packets", packets.size());
+  batch_refs_.resize(packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    rtc::CopyOnWriteBuffer* packet = packets[i].packet;
+    batch_refs_[i].data = packet->data();
+    batch_refs_[i].len = rtc::checked_cast<int>(packet->size());
+    batch_refs_[i].max_len = rtc::checked_cast<int>(packet->capacity());
+  }
+  send_session_->ProtectRtp(batch_refs_);
+  for (size_t i = 0; i < packets.size(); ++i) {
+    OutgoingRtpPacket& outgoing = packets[i];
+    const int len = batch_refs_[i].len;
+    if (!batch_refs_[i].ok) {
+      int seq_num = -1;
+      uint32_t ssrc = 0;
+      cricket::GetRtpSeqNum(outgoing.packet->data(), len, &seq_num);
+      cricket::GetRtpSsrc(outgoing.packet->data(), len, &ssrc);
+      RTC_LOG(LS_ERROR) << "Failed to protect RTP packet: size=" << len
+                        << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+      outgoing.sent = false;
+      continue;
+    }
+    outgoing.packet->SetSize(len);
+    outgoing.sent =
+        SendPacket(/*rtcp=*/false, outgoing.packet, *outgoing.options, flags);
+  }
+}
+
 bool SrtpTransport::SendRtcpPacket(rtc::CopyOnWriteBuffer* packet,
                                    const rtc::PacketOptions& options,
                                    int flags) {
@@ -205,31 +244,39 @@ void SrtpTransport::OnRtpPacketReceived(rtc::CopyOnWriteBuffer packet,
         << "Inactive SRTP transport received an RTP packet. Drop it.";
     return;
   }
+  if (rtc::ScopedReadBatch::NotifyAtEnd(this)) {
+    pending_recv_.push_back({std::move(packet), packet_time_us});
+    return;
+  }
   TRACE_EVENT0("webrtc", "SRTP Decode");
   char* data = packet.data<char>();
   int len = rtc::checked_cast<int>(packet.size());
   if (!UnprotectRtp(data, len, &len)) {
-    int seq_num = -1;
-    uint32_t ssrc = 0;
-    cricket::GetRtpSeqNum(data, len, &seq_num);
-    cricket::GetRtpSsrc(data, len, &ssrc);
-
-    // Limit the error logging to avoid excessive logs when there are lots of
-    // bad packets.
-    const int kFailureLogThrottleCount = 100;
-    if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
-      RTC_LOG(LS_ERROR) << "Failed to unprotect RTP packet: size=" << len
-                        << ", seqnum=" << seq_num << ", SSRC=" << ssrc
-                        << ", previous failure count: "
-                        << decryption_failure_count_;
-    }
-    ++decryption_failure_count_;
+    LogUnprotectRtpFailure(data, len);
     return;
   }
   packet.SetSize(len);
   DemuxPacket(std::move(packet), packet_time_us);
 }
 
+void SrtpTransport::LogUnprotectRtpFailure(const char* data, int len) {
+  int seq_num = -1;
+  uint32_t ssrc = 0;
+  cricket::GetRtpSeqNum(data, len, &seq_num);
+  cricket::GetRtpSsrc(data, len, &ssrc);
+
+  // Limit the error logging to avoid excessive logs when there are lots of
+  // bad packets.
+  const int kFailureLogThrottleCount = 100;
+  if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
+    RTC_LOG(LS_ERROR) << "Failed to unprotect RTP packet: size=" << len
+                      << ", seqnum=" << seq_num << ", SSRC=" << ssrc
+                      << ", previous failure count: "
+                      << decryption_failure_count_;
+  }
+  ++decryption_failure_count_;
+}
+
 void SrtpTransport::OnRtcpPacketReceived(rtc::CopyOnWriteBuffer packet,
                                          int64_t packet_time_us) {
   if (!IsSrtpActive()) {
@@ -237,6 +284,8 @@ void SrtpTransport::OnRtcpPacketReceived(rtc::CopyOnWriteBuffer packet,
         << "Inactive SRTP transport received an RTCP packet. Drop it.";
     return;
   }
+  // Deliver the RTP packets that arrived before this one first.
+  FlushRecvBatch();
   TRACE_EVENT0("webrtc", "SRTP Decode");
   char* data = packet.data<char>();
   int len = rtc::checked_cast<int>(packet.size());
@@ -277,6 +326,8 @@ bool SrtpTransport::SetRtpParams(int send_cs,
                                  const uint8_t* recv_key,
                                  int recv_key_len,
                                  const std::vector<int>& recv_extension_ids) {
+  // Held packets belong to the current keys.
+  FlushRecvBatch();
   // If parameters are being set for the first time, we should create new SRTP
   // sessions and call "SetSend/SetRecv". Otherwise we should call
   // "UpdateSend"/"UpdateRecv" on the existing sessions, which will internally
@@ -356,6 +407,7 @@ bool SrtpTransport::IsWritable(bool rtcp) const {
 }
 
 void SrtpTransport::ResetParams() {
+  FlushRecvBatch();
   send_session_ = nullptr;
   recv_session_ = nullptr;
   send_rtcp_session_ = nullptr;
@@ -364,6 +416,51 @@ void SrtpTransport::ResetParams() {
   RTC_LOG(LS_INFO) << "The params in SRTP transport are reset.";
 }
 
+void SrtpTransport::OnReadBatchEnd() {
+  FlushRecvBatch();
+}
+
+void SrtpTransport::FlushRecvBatch() {
+  if (pending_recv_.empty())
+    return;
+  // Taken out first, a demuxed packet may lead to more packets being held.
+  std::vector<PendingRecv> batch;
+  batch.swap(pending_recv_);
+  if (!IsSrtpActive()) {
+    RTC_LOG(LS_WARNING) << "Inactive SRTP transport dropped " << batch.size()
+                        << " held RTP packets.";
+    return;
+  }
+
+  TRACE_EVENT1("webrtc", "SRTP Decode batch", "packets", batch.size());
+  batch_refs_.resize(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    rtc::CopyOnWriteBuffer& packet = batch[i].packet;
+    batch_refs_[i].data = packet.data();
+    batch_refs_[i].len = rtc::checked_cast<int>(packet.size());
+    batch_refs_[i].max_len = batch_refs_[i].len;
+  }
+  recv_session_->UnprotectRtp(batch_refs_);
+  for (size_t i = 0; i < batch.size(); ++i) {
+    rtc::CopyOnWriteBuffer& packet = batch[i].packet;
+    if (batch_refs_[i].ok) {
+      packet.SetSize(batch_refs_[i].len);
+    } else {
+      LogUnprotectRtpFailure(packet.data<char>(), batch_refs_[i].len);
+      packet.Clear();
+    }
+  }
+  for (PendingRecv& pending : batch) {
+    if (pending.packet.size() > 0)
+      DemuxPacket(std::move(pending.packet), pending.packet_time_us);
+  }
+  if (pending_recv_.empty()) {
+    // Keeps the capacity for the next batch.
+    batch.clear();
+    pending_recv_.swap(batch);
+  }
+}
+
 void SrtpTransport::CreateSrtpSessions() {
   send_session_.reset(new cricket::SrtpSession());
   recv_session_.reset(new cricket::SrtpSession());
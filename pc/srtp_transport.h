@@ -33,11 +33,12 @@ namespace webrtc {
 // This subclass of the RtpTransport is used for SRTP which is reponsible for
 // protecting/unprotecting the packets. It provides interfaces to set the crypto
 // parameters for the SrtpSession underneath.
-class SrtpTransport : public RtpTransport {
+class SrtpTransport : public RtpTransport,
+                      public rtc::ScopedReadBatch::Listener {
  public:
   explicit SrtpTransport(bool rtcp_mux_enabled);
 
-  virtual ~SrtpTransport() = default;
+  ~SrtpTransport() override;
 
   // SrtpTransportInterface specific implementation.
   RTCError SetSrtpSendKey(const cricket::CryptoParams& params) override;
@@ -51,6 +52,11 @@ class SrtpTransport : public RtpTransport {
                       const rtc::PacketOptions& options,
                       int flags) override;
 
+  // Protects the whole burst with one SrtpSession call, unless external auth
+  // is active, which needs the options of each packet updated.
+  void SendRtpPackets(rtc::ArrayView<OutgoingRtpPacket> packets,
+                      int flags) override;
+
   // The transport becomes active if the send_session_ and recv_session_ are
   // created.
   bool IsSrtpActive() const override;
@@ -126,6 +132,14 @@ class SrtpTransport : public RtpTransport {
   // Override the RtpTransport::OnWritableState.
   void OnWritableState(rtc::PacketTransportInternal* packet_transport) override;
 
+  // RTP packets received while the socket delivers a recvmmsg batch, see
+  // rtc::ScopedReadBatch, are held in |pending_recv_| and unprotected with
+  // one SrtpSession call when the batch ends. RTCP and key changes process
+  // them first, to keep their order.
+  void OnReadBatchEnd() override;
+  void FlushRecvBatch();
+  void LogUnprotectRtpFailure(const char* data, int len);
+
   bool ProtectRtp(void* data, int in_len, int max_len, int* out_len);
 
   // Overloaded version, outputs packet index.
@@ -166,6 +180,13 @@ class SrtpTransport : public RtpTransport {
   int rtp_abs_sendtime_extn_id_ = -1;
 
   int decryption_failure_count_ = 0;
+
+  struct PendingRecv {
+    rtc::CopyOnWriteBuffer packet;
+    int64_t packet_time_us;
+  };
+  std::vector<PendingRecv> pending_recv_;
+  std::vector<cricket::SrtpSession::RtpPacketRef> batch_refs_;
 };
 
 }  // namespace webrtc
@@ -403,6 +403,121 @@ INSTANTIATE_TEST_SUITE_P(ExternalAuth,
                          SrtpTransportTestWithExternalAuth,
                          ::testing::Values(true, false));
 
+// Test that a burst sent through SendRtpPackets is protected together, that
+// each packet reports whether it was sent, and that a packet without room for
+// the auth tag does not stop the rest of the burst.
+TEST_F(SrtpTransportTest, SendRtpPacketsBurst) {
+  static const int kNumPackets = 3;
+  std::vector<int> extension_ids;
+  EXPECT_TRUE(srtp_transport1_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids));
+  EXPECT_TRUE(srtp_transport2_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids));
+
+  size_t rtp_len = sizeof(kPcmuFrame);
+  size_t packet_size =
+      rtp_len + rtc::rtp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80);
+  rtc::PacketOptions options;
+  std::vector<rtc::CopyOnWriteBuffer> buffers;
+  for (int i = 0; i < kNumPackets; ++i) {
+    // The second packet has no room for the auth tag.
+    buffers.emplace_back(kPcmuFrame, rtp_len, i == 1 ? rtp_len : packet_size);
+    rtc::SetBE16(buffers.back().data() + 2, ++sequence_number_);
+  }
+  RtpTransportInternal::OutgoingRtpPacket packets[kNumPackets];
+  for (int i = 0; i < kNumPackets; ++i) {
+    packets[i].packet = &buffers[i];
+    packets[i].options = &options;
+  }
+  srtp_transport1_->SendRtpPackets(packets, cricket::PF_SRTP_BYPASS);
+  EXPECT_TRUE(packets[0].sent);
+  EXPECT_FALSE(packets[1].sent);
+  EXPECT_TRUE(packets[2].sent);
+
+  // The packets were unprotected one by one on arrival.
+  EXPECT_EQ(2, rtp_sink2_.rtp_count());
+  ASSERT_TRUE(rtp_sink2_.last_recv_rtp_packet().data());
+  EXPECT_EQ(0, memcmp(rtp_sink2_.last_recv_rtp_packet().data() + 4,
+                      kPcmuFrame + 4, rtp_len - 4));
+}
+
+// Test that RTP received within a read batch is unprotected when the batch
+// ends, and that RTCP received within the batch does not overtake it.
+TEST_F(SrtpTransportTest, RecvRtpPacketsInReadBatch) {
+  static const int kNumPackets = 3;
+  std::vector<int> extension_ids;
+  EXPECT_TRUE(srtp_transport1_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids));
+  EXPECT_TRUE(srtp_transport2_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids));
+
+  size_t rtp_len = sizeof(kPcmuFrame);
+  size_t packet_size =
+      rtp_len + rtc::rtp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80);
+  rtc::PacketOptions options;
+  auto send_rtp = [&] {
+    rtc::CopyOnWriteBuffer packet(kPcmuFrame, rtp_len, packet_size);
+    rtc::SetBE16(packet.data() + 2, ++sequence_number_);
+    return srtp_transport1_->SendRtpPacket(&packet, options,
+                                           cricket::PF_SRTP_BYPASS);
+  };
+
+  // The fake transport delivers synchronously, so the receiver sees the
+  // packets within the batch.
+  {
+    rtc::ScopedReadBatch read_batch;
+    for (int i = 0; i < kNumPackets; ++i)
+      ASSERT_TRUE(send_rtp());
+    EXPECT_EQ(0, rtp_sink2_.rtp_count());
+  }
+  EXPECT_EQ(kNumPackets, rtp_sink2_.rtp_count());
+  ASSERT_TRUE(rtp_sink2_.last_recv_rtp_packet().data());
+  EXPECT_EQ(0, memcmp(rtp_sink2_.last_recv_rtp_packet().data() + 4,
+                      kPcmuFrame + 4, rtp_len - 4));
+
+  {
+    rtc::ScopedReadBatch read_batch;
+    ASSERT_TRUE(send_rtp());
+    size_t rtcp_len = sizeof(::kRtcpReport);
+    rtc::CopyOnWriteBuffer rtcp_packet(
+        ::kRtcpReport, rtcp_len,
+        rtcp_len + 4 + rtc::rtcp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80));
+    ASSERT_TRUE(srtp_transport1_->SendRtcpPacket(
+        &rtcp_packet, rtc::PacketOptions(), cricket::PF_SRTP_BYPASS));
+    EXPECT_EQ(kNumPackets + 1, rtp_sink2_.rtp_count());
+    EXPECT_EQ(1, rtp_sink2_.rtcp_count());
+  }
+  EXPECT_EQ(kNumPackets + 1, rtp_sink2_.rtp_count());
+}
+
+// Test that a transport destroyed within a read batch is not notified when
+// the batch ends.
+TEST_F(SrtpTransportTest, DestroyedWithinReadBatch) {
+  std::vector<int> extension_ids;
+  EXPECT_TRUE(srtp_transport1_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids));
+  EXPECT_TRUE(srtp_transport2_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids));
+
+  size_t rtp_len = sizeof(kPcmuFrame);
+  rtc::CopyOnWriteBuffer packet(
+      kPcmuFrame, rtp_len,
+      rtp_len + rtc::rtp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80));
+  rtc::SetBE16(packet.data() + 2, ++sequence_number_);
+  rtc::ScopedReadBatch read_batch;
+  ASSERT_TRUE(srtp_transport1_->SendRtpPacket(&packet, rtc::PacketOptions(),
+                                              cricket::PF_SRTP_BYPASS));
+  srtp_transport2_->UnregisterRtpDemuxerSink(&rtp_sink2_);
+  srtp_transport2_.reset();
+  EXPECT_EQ(0, rtp_sink2_.rtp_count());
+}
+
 // Test directly setting the params with bogus keys.
 TEST_F(SrtpTransportTest, TestSetParamsKeyTooShort) {
   std::vector<int> extension_ids;
@@ -323,6 +323,7 @@ class MockDataChannelObserver : public webrtc::DataChannelObserver {
   virtual ~MockDataChannelObserver() { channel_->UnregisterObserver(); }
 
   void OnBufferedAmountChange(uint64_t previous_amount) override {}
+  void OnBufferedAmountLow() override { ++buffered_amount_low_count_; }
 
   void OnStateChange() override { state_ = channel_->state(); }
   void OnMessage(const DataBuffer& buffer) override {
@@ -336,11 +337,13 @@ class MockDataChannelObserver : public webrtc::DataChannelObserver {
     return messages_.empty() ? std::string() : messages_.back();
   }
   size_t received_message_count() const { return messages_.size(); }
+  int buffered_amount_low_count() const { return buffered_amount_low_count_; }
 
  private:
   rtc::scoped_refptr<webrtc::DataChannelInterface> channel_;
   DataChannelInterface::DataState state_;
   std::vector<std::string> messages_;
+  int buffered_amount_low_count_ = 0;
 };
 
 class MockStatsObserver : public webrtc::StatsObserver {
@@ -9,9 +9,16 @@
  */
 
 #include "rtc_base/async_packet_socket.h"
+
+#include <algorithm>
+
+#include "absl/base/attributes.h"
 #include "rtc_base/net_helper.h"
 
 namespace rtc {
+namespace {
+ABSL_CONST_INIT thread_local ScopedReadBatch* current_read_batch = nullptr;
+}  // namespace
 
 PacketTimeUpdateParams::PacketTimeUpdateParams() = default;
 
@@ -42,6 +49,49 @@ void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
   }
 }
 
+ScopedReadBatch::ScopedReadBatch() : outer_(current_read_batch) {
+  if (!outer_)
+    current_read_batch = this;
+}
+
+ScopedReadBatch::~ScopedReadBatch() {
+  if (outer_)
+    return;
+  // Listeners may cancel others, or themselves, while being notified; their
+  // entries are cleared rather than erased. Packets that they deliver while
+  // the batch ends are not batched again.
+  ending_ = true;
+  for (size_t i = 0; i < listeners_.size(); ++i) {
+    Listener* listener = listeners_[i];
+    if (listener) {
+      listeners_[i] = nullptr;
+      listener->OnReadBatchEnd();
+    }
+  }
+  current_read_batch = nullptr;
+}
+
+// static
+bool ScopedReadBatch::NotifyAtEnd(Listener* listener) {
+  ScopedReadBatch* batch = current_read_batch;
+  if (!batch || batch->ending_)
+    return false;
+  if (std::find(batch->listeners_.begin(), batch->listeners_.end(),
+                listener) == batch->listeners_.end()) {
+    batch->listeners_.push_back(listener);
+  }
+  return true;
+}
+
+// static
+void ScopedReadBatch::Cancel(Listener* listener) {
+  ScopedReadBatch* batch = current_read_batch;
+  if (!batch)
+    return;
+  std::replace(batch->listeners_.begin(), batch->listeners_.end(), listener,
+               static_cast<Listener*>(nullptr));
+}
+
 }  // namespace rtc
 
 namespace webrtc {
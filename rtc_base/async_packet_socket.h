@@ -11,6 +11,8 @@
 #ifndef RTC_BASE_ASYNC_PACKET_SOCKET_H_
 #define RTC_BASE_ASYNC_PACKET_SOCKET_H_
 
+#include <vector>
+
 #include "rtc_base/constructor_magic.h"
 #include "rtc_base/dscp.h"
 #include "rtc_base/network/sent_packet.h"
@@ -49,6 +51,9 @@ struct PacketOptions {
   PacketTimeUpdateParams packet_time_params;
   // PacketInfo is passed to SentPacket when signaling this packet is sent.
   PacketInfo info_signaled_after_sent;
+  // The packet is part of a burst (e.g. released by the pacer) and the socket
+  // may hold it back briefly to send several packets with one system call.
+  bool batchable = false;
 };
 
 // Provides the ability to receive packets asynchronously. Sends are not
@@ -106,6 +111,13 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
                    const int64_t&>
       SignalReadPacket;
 
+  // Emitted once per batched read with all datagrams drained by that read, in
+  // arrival order (see AsyncUDPSocket::SetRecvBatchSize). Timestamps are
+  // always set. If nothing is connected to this signal, each datagram is
+  // emitted through SignalReadPacket instead.
+  sigslot::signal3<AsyncPacketSocket*, const ReceivedDatagram*, size_t>
+      SignalReadPacketBatch;
+
   // Emitted each time a packet is sent.
   sigslot::signal2<AsyncPacketSocket*, const SentPacket&> SignalSentPacket;
 
@@ -138,6 +150,39 @@ void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
                                        bool is_connectionless,
                                        rtc::PacketInfo* info);
 
+// Marks the delivery of a batch of received packets on the current thread,
+// e.g. the datagrams of one recvmmsg() call that AsyncUDPSocket emits one by
+// one through SignalReadPacket. A receiver further up the stack can hold on
+// to packets while the batch is delivered and process them together when the
+// scope ends, in the same call stack. Nested scopes belong to the outermost.
+class ScopedReadBatch final {
+ public:
+  class Listener {
+   public:
+    virtual void OnReadBatchEnd() = 0;
+
+   protected:
+    virtual ~Listener() = default;
+  };
+
+  ScopedReadBatch();
+  ScopedReadBatch(const ScopedReadBatch&) = delete;
+  ScopedReadBatch& operator=(const ScopedReadBatch&) = delete;
+  ~ScopedReadBatch();
+
+  // If a batch is being delivered on the current thread, |listener| is
+  // notified once when it ends, and true is returned. Adding a listener again
+  // has no further effect.
+  static bool NotifyAtEnd(Listener* listener);
+  // Stops |listener| from being notified, e.g. when it is destroyed.
+  static void Cancel(Listener* listener);
+
+ private:
+  ScopedReadBatch* const outer_;
+  bool ending_ = false;
+  std::vector<Listener*> listeners_;
+};
+
 }  // namespace rtc
 namespace webrtc {
 std::string ToString(const rtc::PacketTimeUpdateParams& packet);
@@ -11,12 +11,15 @@
 #include "rtc_base/async_udp_socket.h"
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
+#include <utility>
 
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/network/sent_packet.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
 #include "rtc_base/time_utils.h"
 
 namespace rtc {
@@ -52,6 +55,8 @@ namespace rtc {
 
 static const int BUF_SIZE = 64 * 1024;
 
+enum { MSG_FLUSH_SEND_BATCH = 1 };
+
 AsyncUDPSocket* AsyncUDPSocket::Create(AsyncSocket* socket,
                                        const SocketAddress& bind_address) {
   std::unique_ptr<AsyncSocket> owned_socket(socket);
@@ -81,9 +86,74 @@ AsyncUDPSocket::AsyncUDPSocket(AsyncSocket* socket) : socket_(socket) {
 }
 
 AsyncUDPSocket::~AsyncUDPSocket() {
+  FlushSendBatch();
   delete[] buf_;
 }
 
+void AsyncUDPSocket::SetSendBatchSize(size_t batch_size,
+                                      size_t max_datagram_size) {
+  RTC_DCHECK_GT(max_datagram_size, 0);
+  FlushSendBatch();
+  send_batch_.clear();
+  send_batch_info_.clear();
+  send_batch_buf_.reset();
+  send_batch_slot_size_ = 0;
+  if (batch_size <= 1)
+    return;
+  send_batch_buf_.reset(new char[batch_size * max_datagram_size]);
+  send_batch_slot_size_ = max_datagram_size;
+  send_batch_.resize(batch_size);
+  send_batch_info_.resize(batch_size);
+  for (size_t i = 0; i < batch_size; ++i)
+    send_batch_[i].data = send_batch_buf_.get() + i * max_datagram_size;
+}
+
+void AsyncUDPSocket::FlushSendBatch() {
+  if (send_batch_count_ == 0)
+    return;
+  size_t sent = 0;
+  while (sent < send_batch_count_) {
+    int result = socket_->SendToBatch(&send_batch_[sent],
+                                      send_batch_count_ - sent);
+    if (result <= 0) {
+      // Like a failed SendTo(), the remaining datagrams are dropped; UDP
+      // senders already tolerate loss under load.
+      SocketAddress local_addr = socket_->GetLocalAddress();
+      RTC_LOG(LS_INFO) << "AsyncUDPSocket[" << local_addr.ToSensitiveString()
+                       << "] dropped " << send_batch_count_ - sent
+                       << " batched packets, error " << socket_->GetError();
+      break;
+    }
+    sent += result;
+  }
+  // Only packets that made it to the kernel are reported, with the time
+  // SendTo() was called for them.
+  send_batch_count_ = 0;
+  for (size_t i = 0; i < sent; ++i)
+    SignalSentPacket(this, send_batch_info_[i]);
+}
+
+void AsyncUDPSocket::OnMessage(Message* msg) {
+  RTC_DCHECK_EQ(MSG_FLUSH_SEND_BATCH, msg->message_id);
+  send_flush_pending_ = false;
+  FlushSendBatch();
+}
+
+void AsyncUDPSocket::SetRecvBatchSize(size_t batch_size,
+                                      size_t max_datagram_size) {
+  RTC_DCHECK_GT(max_datagram_size, 0);
+  recv_batch_.clear();
+  recv_batch_buf_.reset();
+  if (batch_size <= 1)
+    return;
+  recv_batch_buf_.reset(new char[batch_size * max_datagram_size]);
+  recv_batch_.resize(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    recv_batch_[i].data = recv_batch_buf_.get() + i * max_datagram_size;
+    recv_batch_[i].capacity = max_datagram_size;
+  }
+}
+
 SocketAddress AsyncUDPSocket::GetLocalAddress() const {
   return socket_->GetLocalAddress();
 }
@@ -95,6 +165,8 @@ SocketAddress AsyncUDPSocket::GetRemoteAddress() const {
 int AsyncUDPSocket::Send(const void* pv,
                          size_t cb,
                          const rtc::PacketOptions& options) {
+  // Keep packets in order with anything queued by SendTo().
+  FlushSendBatch();
   rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
                               options.info_signaled_after_sent);
   CopySocketInformationToPacketInfo(cb, *this, false, &sent_packet.info);
@@ -119,6 +191,30 @@ int AsyncUDPSocket::SendTo(const void* pv,
   rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
                               options.info_signaled_after_sent);
   CopySocketInformationToPacketInfo(cb, *this, true, &sent_packet.info);
+  if (options.batchable && !send_batch_.empty() &&
+      cb <= send_batch_slot_size_) {
+    char* slot =
+        send_batch_buf_.get() + send_batch_count_ * send_batch_slot_size_;
+    memcpy(slot, pv, cb);
+    OutgoingDatagram& datagram = send_batch_[send_batch_count_];
+    datagram.size = cb;
+    datagram.destination = addr;
+    send_batch_info_[send_batch_count_] = sent_packet;
+    if (++send_batch_count_ == send_batch_.size()) {
+      FlushSendBatch();
+    } else if (!send_flush_pending_) {
+      // Send the burst once the message that is sending it has been handled.
+      // Outside of a message, e.g. in an I/O callback, there is nothing to
+      // wait for.
+      Thread* thread = Thread::Current();
+      if (thread && thread->PostAfterDispatch(this, MSG_FLUSH_SEND_BATCH))
+        send_flush_pending_ = true;
+      else
+        FlushSendBatch();
+    }
+    return static_cast<int>(cb);
+  }
+  FlushSendBatch();
   int ret = socket_->SendTo(pv, cb, addr);
 
     #if 0
@@ -132,6 +228,7 @@ int AsyncUDPSocket::SendTo(const void* pv,
 }
 
 int AsyncUDPSocket::Close() {
+  FlushSendBatch();
   return socket_->Close();
 }
 
@@ -158,6 +255,11 @@ void AsyncUDPSocket::SetError(int error) {
 void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
 
+  if (!recv_batch_.empty()) {
+    ReadBatch();
+    return;
+  }
+
   SocketAddress remote_addr;
   int64_t timestamp;
   int len = socket_->RecvFrom(buf_, size_, &remote_addr, &timestamp);
@@ -178,6 +280,56 @@ void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   SignalReadPacket(this, buf_, static_cast<size_t>(len), remote_addr, (timestamp > -1 ? timestamp : TimeMicros()));
 }
 
+void AsyncUDPSocket::ReadBatch() {
+  int received = socket_->RecvFromBatch(recv_batch_.data(), recv_batch_.size());
+  if (received < 0) {
+    // See OnReadEvent() for why this is only logged.
+    SocketAddress local_addr = socket_->GetLocalAddress();
+    RTC_LOG(LS_INFO) << "AsyncUDPSocket[" << local_addr.ToSensitiveString()
+                     << "] batched receive failed with error "
+                     << socket_->GetError();
+    return;
+  }
+
+  // Drop truncated datagrams and fill in missing timestamps. Slots are
+  // swapped rather than copied so that each still owns a distinct part of
+  // |recv_batch_buf_|.
+  int64_t now_us = -1;
+  size_t count = 0;
+  for (int i = 0; i < received; ++i) {
+    ReceivedDatagram& datagram = recv_batch_[i];
+    if (datagram.truncated) {
+      RTC_LOG(LS_WARNING) << "Dropping datagram from "
+                          << datagram.source.ToSensitiveString()
+                          << " larger than " << datagram.capacity << " bytes";
+      continue;
+    }
+    if (datagram.timestamp < 0) {
+      if (now_us < 0)
+        now_us = TimeMicros();
+      datagram.timestamp = now_us;
+    }
+    if (count != static_cast<size_t>(i))
+      std::swap(recv_batch_[count], datagram);
+    ++count;
+  }
+  if (count == 0)
+    return;
+
+  if (!SignalReadPacketBatch.is_empty()) {
+    SignalReadPacketBatch(this, recv_batch_.data(), count);
+    return;
+  }
+  // Lets receivers up the stack process the datagrams together, see
+  // ScopedReadBatch.
+  ScopedReadBatch read_batch;
+  for (size_t i = 0; i < count; ++i) {
+    const ReceivedDatagram& datagram = recv_batch_[i];
+    SignalReadPacket(this, datagram.data, datagram.size, datagram.source,
+                     datagram.timestamp);
+  }
+}
+
 void AsyncUDPSocket::OnWriteEvent(AsyncSocket* socket) {
   SignalReadyToSend(this);
 }
@@ -13,9 +13,11 @@
 
 #include <stddef.h>
 #include <memory>
+#include <vector>
 
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/async_socket.h"
+#include "rtc_base/message_handler.h"
 #include "rtc_base/socket.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/socket_factory.h"
@@ -24,7 +26,7 @@ namespace rtc {
 
 // Provides the ability to receive packets asynchronously.  Sends are not
 // buffered since it is acceptable to drop packets under high load.
-class AsyncUDPSocket : public AsyncPacketSocket {
+class AsyncUDPSocket : public AsyncPacketSocket, public MessageHandler {
  public:
   // Binds |socket| and creates AsyncUDPSocket for it. Takes ownership
   // of |socket|. Returns null if bind() fails (|socket| is destroyed
@@ -35,9 +37,40 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   // asynchronous socket from the given factory.
   static AsyncUDPSocket* Create(SocketFactory* factory,
                                 const SocketAddress& bind_address);
+  // Default per-datagram buffer size used in batched receive mode. Large
+  // enough for any RTP/RTCP/STUN packet on a regular Ethernet path.
+  static const size_t kDefaultMaxBatchedDatagramSize = 2048;
+
   explicit AsyncUDPSocket(AsyncSocket* socket);
   ~AsyncUDPSocket() override;
 
+  // Enables batched receive: every read event drains up to |batch_size|
+  // datagrams of at most |max_datagram_size| bytes into a preallocated slab
+  // and delivers them through SignalReadPacketBatch, or through
+  // SignalReadPacket inside a ScopedReadBatch.
+  // Larger datagrams are dropped. A |batch_size| of 1 restores the default
+  // one-datagram-per-event mode with a 64 kB buffer.
+  void SetRecvBatchSize(
+      size_t batch_size,
+      size_t max_datagram_size = kDefaultMaxBatchedDatagramSize);
+  size_t recv_batch_size() const { return recv_batch_.size(); }
+
+  // Enables batched send: SendTo() calls with PacketOptions::batchable set
+  // are copied into up to |batch_size| preallocated slots and sent together
+  // by FlushSendBatch(). The batch is flushed when it is full, before any
+  // non-batchable send, and at the latest when the thread has handled the
+  // message that queued the first packet (see
+  // MessageQueue::PostAfterDispatch), so a burst is never held back past its
+  // end. Outside of a message, packets are sent right away. SignalSentPacket
+  // fires for the packets that were sent, at the flush. A |batch_size| of 1
+  // disables batching.
+  void SetSendBatchSize(
+      size_t batch_size,
+      size_t max_datagram_size = kDefaultMaxBatchedDatagramSize);
+  size_t send_batch_size() const { return send_batch_.size(); }
+  // Sends all queued batchable packets now.
+  void FlushSendBatch();
+
   SocketAddress GetLocalAddress() const override;
   SocketAddress GetRemoteAddress() const override;
   int Send(const void* pv,
@@ -55,15 +88,31 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   int GetError() const override;
   void SetError(int error) override;
 
+  // MessageHandler:
+  void OnMessage(Message* msg) override;
+
  private:
   // Called when the underlying socket is ready to be read from.
   void OnReadEvent(AsyncSocket* socket);
   // Called when the underlying socket is ready to send.
   void OnWriteEvent(AsyncSocket* socket);
+  // Read path used when SetRecvBatchSize() selected more than one datagram.
+  void ReadBatch();
 
   std::unique_ptr<AsyncSocket> socket_;
   char* buf_;
   size_t size_;
+  // Batched receive state; |recv_batch_| slots point into |recv_batch_buf_|.
+  std::unique_ptr<char[]> recv_batch_buf_;
+  std::vector<ReceivedDatagram> recv_batch_;
+  // Batched send state. |send_batch_| has one slot per datagram, pointing
+  // into |send_batch_buf_|; the first |send_batch_count_| are queued.
+  std::unique_ptr<char[]> send_batch_buf_;
+  std::vector<OutgoingDatagram> send_batch_;
+  std::vector<SentPacket> send_batch_info_;
+  size_t send_batch_slot_size_ = 0;
+  size_t send_batch_count_ = 0;
+  bool send_flush_pending_ = false;
 };
 
 }  // namespace rtc
@@ -8,12 +8,16 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rtc_base/async_udp_socket.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/physical_socket_server.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/virtual_socket_server.h"
 
 namespace rtc {
@@ -46,4 +50,295 @@ TEST_F(AsyncUdpSocketTest, OnWriteEvent) {
   EXPECT_TRUE(ready_to_send_);
 }
 
+class AsyncUdpSocketBatchTest : public ::testing::Test,
+                                public sigslot::has_slots<>,
+                                public ScopedReadBatch::Listener {
+ public:
+  AsyncUdpSocketBatchTest()
+      : pss_(new rtc::PhysicalSocketServer),
+        thread_(pss_.get()),
+        sender_(AsyncUDPSocket::Create(pss_.get(),
+                                       SocketAddress("127.0.0.1", 0))),
+        receiver_(AsyncUDPSocket::Create(pss_.get(),
+                                         SocketAddress("127.0.0.1", 0))) {
+    sender_->SignalSentPacket.connect(this,
+                                      &AsyncUdpSocketBatchTest::OnSentPacket);
+  }
+
+  // Runs |function| as a message dispatched by |thread_|.
+  class MessageRunner : public MessageHandler {
+   public:
+    explicit MessageRunner(std::function<void()> function)
+        : function_(std::move(function)) {}
+    void OnMessage(Message* msg) override { function_(); }
+
+   private:
+    std::function<void()> function_;
+  };
+
+  void RunInMessage(std::function<void()> function) {
+    MessageRunner runner(std::move(function));
+    thread_.Post(RTC_FROM_HERE, &runner);
+    thread_.ProcessMessages(0);
+  }
+
+  void ListenForPackets() {
+    receiver_->SignalReadPacket.connect(this,
+                                        &AsyncUdpSocketBatchTest::OnReadPacket);
+  }
+
+  void ListenForBatches() {
+    receiver_->SignalReadPacketBatch.connect(
+        this, &AsyncUdpSocketBatchTest::OnReadPacketBatch);
+  }
+
+  void OnSentPacket(AsyncPacketSocket* socket, const SentPacket& sent_packet) {
+    sent_packets_.push_back(sent_packet);
+  }
+
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const int64_t& timestamp) {
+    packets_.emplace_back(data, size);
+    EXPECT_GE(timestamp, 0);
+    if (ScopedReadBatch::NotifyAtEnd(this))
+      ++packets_in_read_batches_;
+  }
+
+  void OnReadBatchEnd() override {
+    read_batch_ends_.push_back(packets_.size());
+  }
+
+  void OnReadPacketBatch(AsyncPacketSocket* socket,
+                         const ReceivedDatagram* datagrams,
+                         size_t count) {
+    ++batches_;
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(sender_->GetLocalAddress(), datagrams[i].source);
+      EXPECT_GE(datagrams[i].timestamp, 0);
+      packets_.emplace_back(datagrams[i].data, datagrams[i].size);
+    }
+  }
+
+  void SendPackets(int count, bool batchable = false) {
+    PacketOptions options;
+    options.batchable = batchable;
+    for (int i = 0; i < count; ++i) {
+      std::string payload = "packet" + std::to_string(i);
+      options.packet_id = i;
+      EXPECT_EQ(static_cast<int>(payload.size()),
+                sender_->SendTo(payload.data(), payload.size(),
+                                receiver_->GetLocalAddress(), options));
+    }
+  }
+
+  void ProcessUntilReceived(size_t count) {
+    for (int i = 0; i < 100 && packets_.size() < count; ++i)
+      pss_->Wait(10, true);
+  }
+
+ protected:
+  std::unique_ptr<PhysicalSocketServer> pss_;
+  AutoSocketServerThread thread_;
+  std::unique_ptr<AsyncUDPSocket> sender_;
+  std::unique_ptr<AsyncUDPSocket> receiver_;
+  std::vector<std::string> packets_;
+  std::vector<SentPacket> sent_packets_;
+  int batches_ = 0;
+  size_t packets_in_read_batches_ = 0;
+  // The number of packets received when each ScopedReadBatch ended.
+  std::vector<size_t> read_batch_ends_;
+};
+
+TEST_F(AsyncUdpSocketBatchTest, DeliversBatchInOrder) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  receiver_->SetRecvBatchSize(8);
+  EXPECT_EQ(8u, receiver_->recv_batch_size());
+  ListenForBatches();
+
+  SendPackets(5);
+  ProcessUntilReceived(5);
+
+  ASSERT_EQ(5u, packets_.size());
+  for (int i = 0; i < 5; ++i)
+    EXPECT_EQ("packet" + std::to_string(i), packets_[i]);
+  EXPECT_GE(batches_, 1);
+#if defined(WEBRTC_LINUX)
+  // All datagrams were queued before the first read event.
+  EXPECT_EQ(1, batches_);
+#endif
+}
+
+TEST_F(AsyncUdpSocketBatchTest, FallsBackToReadPacketSignal) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  receiver_->SetRecvBatchSize(4);
+  ListenForPackets();
+
+  SendPackets(6);
+  ProcessUntilReceived(6);
+
+  ASSERT_EQ(6u, packets_.size());
+  for (int i = 0; i < 6; ++i)
+    EXPECT_EQ("packet" + std::to_string(i), packets_[i]);
+  // Each read is delivered inside a ScopedReadBatch.
+  EXPECT_EQ(6u, packets_in_read_batches_);
+  ASSERT_FALSE(read_batch_ends_.empty());
+  EXPECT_EQ(6u, read_batch_ends_.back());
+#if defined(WEBRTC_LINUX)
+  EXPECT_EQ(std::vector<size_t>({4, 6}), read_batch_ends_);
+#endif
+}
+
+TEST_F(AsyncUdpSocketBatchTest, NoReadBatchWithoutBatchedReceive) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  ListenForPackets();
+
+  SendPackets(2);
+  ProcessUntilReceived(2);
+
+  ASSERT_EQ(2u, packets_.size());
+  EXPECT_EQ(0u, packets_in_read_batches_);
+  EXPECT_TRUE(read_batch_ends_.empty());
+}
+
+class ReadBatchRecorder : public ScopedReadBatch::Listener {
+ public:
+  void OnReadBatchEnd() override { ++ends; }
+  int ends = 0;
+};
+
+TEST(ScopedReadBatchTest, NotifiesOnceWhenOutermostScopeEnds) {
+  ReadBatchRecorder listener;
+  EXPECT_FALSE(ScopedReadBatch::NotifyAtEnd(&listener));
+  {
+    ScopedReadBatch batch;
+    EXPECT_TRUE(ScopedReadBatch::NotifyAtEnd(&listener));
+    {
+      ScopedReadBatch nested;
+      EXPECT_TRUE(ScopedReadBatch::NotifyAtEnd(&listener));
+    }
+    EXPECT_EQ(0, listener.ends);
+  }
+  EXPECT_EQ(1, listener.ends);
+}
+
+TEST(ScopedReadBatchTest, CancelledListenerIsNotNotified) {
+  ReadBatchRecorder listener;
+  ReadBatchRecorder cancelled;
+  {
+    ScopedReadBatch batch;
+    ScopedReadBatch::NotifyAtEnd(&cancelled);
+    ScopedReadBatch::NotifyAtEnd(&listener);
+    ScopedReadBatch::Cancel(&cancelled);
+  }
+  EXPECT_EQ(1, listener.ends);
+  EXPECT_EQ(0, cancelled.ends);
+}
+
+TEST_F(AsyncUdpSocketBatchTest, BatchesSendsUntilEndOfMessage) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  sender_->SetSendBatchSize(8);
+  EXPECT_EQ(8u, sender_->send_batch_size());
+  ListenForPackets();
+
+  RunInMessage([this] {
+    SendPackets(3, /*batchable=*/true);
+    // Held back until the message has been handled.
+    EXPECT_TRUE(sent_packets_.empty());
+  });
+  EXPECT_EQ(3u, sent_packets_.size());
+
+  ProcessUntilReceived(3);
+  ASSERT_EQ(3u, packets_.size());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ("packet" + std::to_string(i), packets_[i]);
+}
+
+TEST_F(AsyncUdpSocketBatchTest, SendsRightAwayOutsideOfMessage) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  sender_->SetSendBatchSize(8);
+
+  SendPackets(1, /*batchable=*/true);
+  EXPECT_EQ(1u, sent_packets_.size());
+}
+
+TEST_F(AsyncUdpSocketBatchTest, NonBatchableSendFlushesFirst) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  sender_->SetSendBatchSize(8);
+  ListenForPackets();
+
+  RunInMessage([this] {
+    PacketOptions options;
+    options.batchable = true;
+    std::string first = "packet0";
+    sender_->SendTo(first.data(), first.size(), receiver_->GetLocalAddress(),
+                    options);
+    std::string second = "packet1";
+    sender_->SendTo(second.data(), second.size(),
+                    receiver_->GetLocalAddress(), PacketOptions());
+    EXPECT_EQ(2u, sent_packets_.size());
+  });
+  ProcessUntilReceived(2);
+
+  ASSERT_EQ(2u, packets_.size());
+  EXPECT_EQ("packet0", packets_[0]);
+  EXPECT_EQ("packet1", packets_[1]);
+}
+
+TEST_F(AsyncUdpSocketBatchTest, ReportsSendTimeOfBatchedPackets) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  sender_->SetSendBatchSize(8);
+
+  int64_t first_send_time_ms = -1;
+  RunInMessage([this, &first_send_time_ms] {
+    first_send_time_ms = TimeMillis();
+    SendPackets(1, /*batchable=*/true);
+    Thread::SleepMs(20);
+  });
+  ASSERT_EQ(1u, sent_packets_.size());
+  EXPECT_LT(sent_packets_[0].send_time_ms, first_send_time_ms + 20);
+}
+
+TEST_F(AsyncUdpSocketBatchTest, DoesNotReportFailedBatchedSends) {
+  ASSERT_TRUE(sender_);
+  sender_->SetSendBatchSize(8);
+
+  RunInMessage([this] {
+    PacketOptions options;
+    options.batchable = true;
+    // An IPv4 socket can't send to an IPv6 address.
+    for (int i = 0; i < 2; ++i)
+      sender_->SendTo("packet", 6, SocketAddress("::1", 1234), options);
+  });
+  EXPECT_TRUE(sent_packets_.empty());
+}
+
+#if defined(WEBRTC_LINUX)
+// Truncation is only detected by the recvmmsg() based implementation.
+TEST_F(AsyncUdpSocketBatchTest, DropsOversizedDatagrams) {
+  ASSERT_TRUE(sender_);
+  ASSERT_TRUE(receiver_);
+  receiver_->SetRecvBatchSize(4, 16);
+  ListenForBatches();
+
+  std::string big(64, 'x');
+  sender_->SendTo(big.data(), big.size(), receiver_->GetLocalAddress(),
+                  PacketOptions());
+  SendPackets(1);
+  ProcessUntilReceived(1);
+
+  ASSERT_EQ(1u, packets_.size());
+  EXPECT_EQ("packet0", packets_[0]);
+}
+#endif
+
 }  // namespace rtc
@@ -58,6 +58,14 @@ bool Event::Wait(const int give_up_after_ms, int /*warn_after_ms*/) {
   return (WaitForSingleObject(event_handle_, ms) == WAIT_OBJECT_0);
 }
 
+bool Event::WaitUs(const int64_t give_up_after_us) {
+  ScopedYieldPolicy::YieldExecution();
+  const DWORD ms = give_up_after_us == kForever
+                       ? INFINITE
+                       : static_cast<DWORD>((give_up_after_us + 999) / 1000);
+  return (WaitForSingleObject(event_handle_, ms) == WAIT_OBJECT_0);
+}
+
 #elif defined(WEBRTC_POSIX)
 
 // On MacOS, clock_gettime is available from version 10.12, and on
@@ -109,7 +117,7 @@ void Event::Reset() {
 
 namespace {
 
-timespec GetTimespec(const int milliseconds_from_now) {
+timespec GetTimespecUs(const int64_t microseconds_from_now) {
   timespec ts;
 
   // Get the current time.
@@ -122,9 +130,9 @@ timespec GetTimespec(const int milliseconds_from_now) {
   ts.tv_nsec = tv.tv_usec * 1000;
 #endif
 
-  // Add the specified number of milliseconds to it.
-  ts.tv_sec += (milliseconds_from_now / 1000);
-  ts.tv_nsec += (milliseconds_from_now % 1000) * 1000000;
+  // Add the specified number of microseconds to it.
+  ts.tv_sec += static_cast<time_t>(microseconds_from_now / 1000000);
+  ts.tv_nsec += static_cast<long>(microseconds_from_now % 1000000) * 1000;
 
   // Normalize.
   if (ts.tv_nsec >= 1000000000) {
@@ -135,6 +143,10 @@ timespec GetTimespec(const int milliseconds_from_now) {
   return ts;
 }
 
+timespec GetTimespec(const int milliseconds_from_now) {
+  return GetTimespecUs(int64_t{milliseconds_from_now} * 1000);
+}
+
 }  // namespace
 
 bool Event::Wait(const int give_up_after_ms, const int warn_after_ms) {
@@ -154,6 +166,19 @@ bool Event::Wait(const int give_up_after_ms, const int warn_after_ms) {
           ? absl::nullopt
           : absl::make_optional(GetTimespec(give_up_after_ms));
 
+  return WaitUntil(give_up_ts, warn_ts);
+}
+
+bool Event::WaitUs(const int64_t give_up_after_us) {
+  const absl::optional<timespec> give_up_ts =
+      give_up_after_us == kForever
+          ? absl::nullopt
+          : absl::make_optional(GetTimespecUs(give_up_after_us));
+  return WaitUntil(give_up_ts, absl::nullopt);
+}
+
+bool Event::WaitUntil(const absl::optional<timespec>& give_up_ts,
+                      const absl::optional<timespec>& warn_ts) {
   ScopedYieldPolicy::YieldExecution();
   pthread_mutex_lock(&event_mutex_);
 
@@ -11,14 +11,19 @@
 #ifndef RTC_BASE_EVENT_H_
 #define RTC_BASE_EVENT_H_
 
+#include <stdint.h>
+
 #if defined(WEBRTC_WIN)
 #include <windows.h>
 #elif defined(WEBRTC_POSIX)
 #include <pthread.h>
+#include <time.h>
 #else
 #error "Must define either WEBRTC_WIN or WEBRTC_POSIX."
 #endif
 
+#include "absl/types/optional.h"
+
 namespace rtc {
 
 class Event {
@@ -50,10 +55,18 @@ class Event {
                 give_up_after_ms == kForever ? 3000 : kForever);
   }
 
+  // Like Wait(give_up_after_ms), but with a timeout in microseconds, for
+  // callers that need better than millisecond precision. Never logs a
+  // warning. On Windows the timeout is rounded up to whole milliseconds.
+  bool WaitUs(int64_t give_up_after_us);
+
  private:
 #if defined(WEBRTC_WIN)
   HANDLE event_handle_;
 #elif defined(WEBRTC_POSIX)
+  bool WaitUntil(const absl::optional<timespec>& give_up_ts,
+                 const absl::optional<timespec>& warn_ts);
+
   pthread_mutex_t event_mutex_;
   pthread_cond_t event_cond_;
   const bool is_manual_reset_;
@@ -11,6 +11,7 @@
 #include "rtc_base/event.h"
 
 #include "rtc_base/platform_thread.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
 
 namespace rtc {
@@ -41,6 +42,17 @@ TEST(EventTest, AutoReset) {
   ASSERT_FALSE(event.Wait(0));
 }
 
+TEST(EventTest, WaitUsTimesOut) {
+  Event event;
+  int64_t start_us = TimeMicros();
+  EXPECT_FALSE(event.WaitUs(1500));
+  EXPECT_GE(TimeMicros() - start_us, 1500);
+
+  event.Set();
+  EXPECT_TRUE(event.WaitUs(1500));
+  EXPECT_FALSE(event.WaitUs(0));
+}
+
 class SignalerThread {
  public:
   SignalerThread() : thread_(&ThreadFn, this, "EventPerf") {}
@@ -10,6 +10,7 @@
 
 #include "rtc_base/message_digest.h"
 
+#include "rtc_base/openssl_digest.h"
 #include "rtc_base/string_encode.h"
 #include "test/gtest.h"
 
@@ -146,6 +147,45 @@ TEST(MessageDigestTest, TestSha1Hmac) {
                         input.size(), output, sizeof(output) - 1));
 }
 
+// OpenSSLHmac must match ComputeHmac for short and long keys, and over
+// several messages with the same key.
+TEST(MessageDigestTest, TestOpenSSLHmac) {
+  const std::string kKeys[] = {"Jefe", std::string(20, '\x0b'),
+                               std::string(80, '\xaa')};
+  const std::string kInputs[] = {"", "Hi There",
+                                 "what do ya want for nothing?",
+                                 std::string(200, '\xdd')};
+  for (const std::string& key : kKeys) {
+    for (const char* alg : {DIGEST_MD5, DIGEST_SHA_1, DIGEST_SHA_256}) {
+      OpenSSLHmac hmac(alg, key.data(), key.size());
+      char output[32];
+      ASSERT_LE(hmac.Size(), sizeof(output));
+      for (const std::string& input : kInputs) {
+        // Feed the input in two parts.
+        hmac.Update(input.data(), input.size() / 2);
+        hmac.Update(input.data() + input.size() / 2,
+                    input.size() - input.size() / 2);
+        size_t size = hmac.Finish(output, sizeof(output));
+        EXPECT_EQ(ComputeHmac(alg, key, input), hex_encode(output, size));
+      }
+    }
+  }
+
+  // Check the output buffer size and an unknown algorithm. A message whose
+  // output did not fit is dropped, and the next one starts from scratch.
+  char output[20];
+  OpenSSLHmac sha1(DIGEST_SHA_1, "Jefe", 4);
+  sha1.Update("dropped", 7);
+  EXPECT_EQ(0U, sha1.Finish(output, sizeof(output) - 1));
+  sha1.Update("Hi There", 8);
+  ASSERT_EQ(sizeof(output), sha1.Finish(output, sizeof(output)));
+  EXPECT_EQ(ComputeHmac(DIGEST_SHA_1, "Jefe", "Hi There"),
+            hex_encode(output, sizeof(output)));
+  OpenSSLHmac bad("sha-9000", "key", 3);
+  EXPECT_EQ(0U, bad.Size());
+  EXPECT_EQ(0U, bad.Finish(output, sizeof(output)));
+}
+
 TEST(MessageDigestTest, TestBadHmac) {
   std::string output;
   EXPECT_FALSE(ComputeHmac("sha-9000", "key", "abc", &output));
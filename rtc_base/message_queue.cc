@@ -7,8 +7,13 @@
  *  in the file PATENTS.  All contributing project authors may
  *  be found in the AUTHORS file in the root of the source tree.
  */
+#if defined(WEBRTC_POSIX)
+#include <sched.h>
+#endif
+
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "rtc_base/atomic_ops.h"
@@ -25,6 +30,16 @@ namespace {
 const int kMaxMsgLatency = 150;                // 150 ms
 const int kSlowDispatchLoggingThreshold = 50;  // 50 ms
 
+// Lets a Post() on another thread finish. Unlike Thread::SleepMs(), allowed
+// on threads that disallow blocking calls.
+void YieldCurrentThread() {
+#if defined(WEBRTC_WIN)
+  ::SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
 class RTC_SCOPED_LOCKABLE MarkProcessingCritScope {
  public:
   MarkProcessingCritScope(const CriticalSection* cs, size_t* processing)
@@ -148,9 +163,124 @@ void MessageQueueManager::ProcessAllMessageQueuesInternal() {
 
 //------------------------------------------------------------------
 // MessageQueue
+
+// Nodes for |posted_|, handed out and taken back without locks. A node
+// returns to the pool once DrainPosted() has copied its message out.
+//
+// The free list is a stack. Its head holds a node index next to a tag that
+// changes on every update, so that a Post() preempted in Allocate() can't pop
+// a node that was taken and given back in the meantime (the ABA problem).
+// Nodes live in chunks that double in size and are only freed with the pool,
+// so a stale index always points at a valid node.
+class MessageQueue::PostedMessagePool {
+ public:
+  PostedMessagePool() : free_head_(0) {
+    for (std::atomic<PostedMessage*>& chunk : chunks_)
+      chunk.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~PostedMessagePool() {
+    for (std::atomic<PostedMessage*>& chunk : chunks_)
+      delete[] chunk.load(std::memory_order_relaxed);
+  }
+
+  // Can be called on any thread.
+  PostedMessage* Allocate() {
+    PostedMessage* node = TryPop();
+    return node ? node : Grow();
+  }
+
+  // Can be called on any thread.
+  void Free(PostedMessage* node) {
+    if (node->pool_index == kNoNode) {
+      delete node;
+      return;
+    }
+    Push(node, node);
+  }
+
+ private:
+  static const uint32_t kNoNode = 0;
+  static const uint32_t kFirstChunkSize = 64;
+  // Room for about four million pooled nodes; beyond that, nodes are
+  // allocated and deleted one by one.
+  static const int kMaxChunks = 16;
+
+  static uint64_t MakeHead(uint32_t index, uint64_t previous_head) {
+    return (((previous_head >> 32) + 1) << 32) | index;
+  }
+
+  PostedMessage* NodeAt(uint32_t index) const {
+    uint32_t offset = index - 1;
+    uint32_t chunk_size = kFirstChunkSize;
+    int chunk = 0;
+    while (offset >= chunk_size) {
+      offset -= chunk_size;
+      chunk_size *= 2;
+      ++chunk;
+    }
+    return chunks_[chunk].load(std::memory_order_acquire) + offset;
+  }
+
+  PostedMessage* TryPop() {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != kNoNode) {
+      PostedMessage* node = NodeAt(static_cast<uint32_t>(head));
+      uint64_t next =
+          MakeHead(node->next_free.load(std::memory_order_relaxed), head);
+      if (free_head_.compare_exchange_weak(head, next,
+                                           std::memory_order_acquire)) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // Pushes the nodes from |first| to |last|, linked through |next_free|.
+  void Push(PostedMessage* first, PostedMessage* last) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    do {
+      last->next_free.store(static_cast<uint32_t>(head),
+                            std::memory_order_relaxed);
+    } while (!free_head_.compare_exchange_weak(
+        head, MakeHead(first->pool_index, head), std::memory_order_release,
+        std::memory_order_relaxed));
+  }
+
+  PostedMessage* Grow() {
+    CritScope cs(&grow_crit_);
+    // Another thread may have grown the pool while this one waited.
+    if (PostedMessage* node = TryPop())
+      return node;
+    if (num_chunks_ == kMaxChunks)
+      return new PostedMessage();
+    const uint32_t chunk_size = kFirstChunkSize << num_chunks_;
+    const uint32_t first_index =
+        kFirstChunkSize * ((1u << num_chunks_) - 1) + 1;
+    PostedMessage* chunk = new PostedMessage[chunk_size];
+    for (uint32_t i = 0; i < chunk_size; ++i) {
+      chunk[i].pool_index = first_index + i;
+      chunk[i].next_free.store(first_index + i + 1, std::memory_order_relaxed);
+    }
+    chunks_[num_chunks_].store(chunk, std::memory_order_release);
+    ++num_chunks_;
+    // The first node is returned, the others go to the free list.
+    Push(&chunk[1], &chunk[chunk_size - 1]);
+    return &chunk[0];
+  }
+
+  std::atomic<uint64_t> free_head_;
+  std::atomic<PostedMessage*> chunks_[kMaxChunks];
+  CriticalSection grow_crit_;
+  int num_chunks_ RTC_GUARDED_BY(grow_crit_) = 0;
+};
+
 MessageQueue::MessageQueue(SocketServer* ss, bool init_queue)
     : fPeekKeep_(false),
       dmsgq_next_num_(0),
+      posted_count_(0),
+      posted_pool_(new PostedMessagePool()),
+      has_after_dispatch_(false),
       fInitialized_(false),
       fDestroyed_(false),
       stop_(0),
@@ -196,6 +326,10 @@ void MessageQueue::DoDestroy() {
   // is going away.
   SignalQueueDestroyed();
   MessageQueueManager::Remove(this);
+  // Nobody else uses the queue by now, apart from a Post() that may still be
+  // finishing on another thread.
+  while (!DrainPosted())
+    YieldCurrentThread();
   ClearInternal(nullptr, MQID_ANY, nullptr);
 
   if (ss_) {
@@ -269,6 +403,7 @@ bool MessageQueue::Get(Message* pmsg, int cmsWait, bool process_io) {
       // Otherwise, disposed MessageHandlers will cause deadlocks.
       {
         CritScope cs(&crit_);
+        DrainPosted();
         // On the first pass, check for delayed messages that have been
         // triggered and calculate the next trigger time.
         if (first_pass) {
@@ -358,21 +493,41 @@ void MessageQueue::Post(const Location& posted_from,
   // Add the message to the end of the queue
   // Signal for the multiplexer to return
 
-  {
-    CritScope cs(&crit_);
-    Message msg;
-    msg.posted_from = posted_from;
-    msg.phandler = phandler;
-    msg.message_id = id;
-    msg.pdata = pdata;
-    if (time_sensitive) {
-      msg.ts_sensitive = TimeMillis() + kMaxMsgLatency;
-    }
-    msgq_.push_back(msg);
-  }
+  PostedMessage* posted = posted_pool_->Allocate();
+  Message& msg = posted->msg;
+  msg.posted_from = posted_from;
+  msg.phandler = phandler;
+  msg.message_id = id;
+  msg.pdata = pdata;
+  msg.ts_sensitive = time_sensitive ? TimeMillis() + kMaxMsgLatency : 0;
+  posted_count_.fetch_add(1, std::memory_order_relaxed);
+  posted_.Push(posted);
   WakeUpSocketServer();
 }
 
+bool MessageQueue::DrainPosted() {
+  while (PostedMessage* posted = posted_.Pop()) {
+    msgq_.push_back(posted->msg);
+    posted_pool_->Free(posted);
+    posted_count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  // Pop() only fails on a non-empty queue while a Post() on another thread is
+  // between the two steps of MpscQueue::Push(). That Post() wakes up the
+  // socket server when it is done, so Get() comes back for it.
+  return posted_.Empty();
+}
+
+void MessageQueue::DrainAllPosted() {
+  // Clear() must see every message posted before it, including those queued
+  // behind a Post() that is still in progress. That Post() doesn't need
+  // |crit_| to finish, so let it run instead of spinning.
+  while (!DrainPosted()) {
+    crit_.Leave();
+    YieldCurrentThread();
+    crit_.Enter();
+  }
+}
+
 void MessageQueue::PostDelayed(const Location& posted_from,
                                int cmsDelay,
                                MessageHandler* phandler,
@@ -436,6 +591,7 @@ void MessageQueue::DoDelayPost(const Location& posted_from,
 
 int MessageQueue::GetDelay() {
   CritScope cs(&crit_);
+  DrainPosted();
 
   if (!msgq_.empty())
     return 0;
@@ -454,37 +610,53 @@ void MessageQueue::Clear(MessageHandler* phandler,
                          uint32_t id,
                          MessageList* removed) {
   CritScope cs(&crit_);
+  DrainAllPosted();
   ClearInternal(phandler, id, removed);
 }
 
 void MessageQueue::ClearInternal(MessageHandler* phandler,
                                  uint32_t id,
                                  MessageList* removed) {
+  // Deleting message data can destroy a MessageHandler, which clears the queue
+  // again. Delete only after the queues are consistent, so that the re-entrant
+  // call does not see (or invalidate) a half-updated queue.
+  std::vector<MessageData*> doomed;
+
   // Remove messages with phandler
 
   if (fPeekKeep_ && msgPeek_.Match(phandler, id)) {
     if (removed) {
       removed->push_back(msgPeek_);
     } else {
-      delete msgPeek_.pdata;
+      doomed.push_back(msgPeek_.pdata);
     }
     fPeekKeep_ = false;
   }
 
   // Remove from ordered message queue
 
-  for (MessageList::iterator it = msgq_.begin(); it != msgq_.end();) {
+  auto msgq_end = msgq_.begin();
+  for (auto it = msgq_end; it != msgq_.end(); ++it) {
     if (it->Match(phandler, id)) {
       if (removed) {
         removed->push_back(*it);
       } else {
-        delete it->pdata;
+        doomed.push_back(it->pdata);
       }
-      it = msgq_.erase(it);
     } else {
-      ++it;
+      *msgq_end++ = *it;
     }
   }
+  msgq_.erase(msgq_end, msgq_.end());
+
+  // Remove from the messages to handle after the current one. They carry no
+  // data.
+  after_dispatch_.erase(
+      std::remove_if(after_dispatch_.begin(), after_dispatch_.end(),
+                     [phandler, id](const Message& msg) {
+                       return msg.Match(phandler, id);
+                     }),
+      after_dispatch_.end());
 
   // Remove from priority queue. Not directly iterable, so use this approach
 
@@ -495,7 +667,7 @@ void MessageQueue::ClearInternal(MessageHandler* phandler,
       if (removed) {
         removed->push_back(it->msg_);
       } else {
-        delete it->msg_.pdata;
+        doomed.push_back(it->msg_.pdata);
       }
     } else {
       *new_end++ = *it;
@@ -503,6 +675,40 @@ void MessageQueue::ClearInternal(MessageHandler* phandler,
   }
   dmsgq_.container().erase(new_end, dmsgq_.container().end());
   dmsgq_.reheap();
+
+  for (MessageData* data : doomed)
+    delete data;
+}
+
+bool MessageQueue::PostAfterDispatch(MessageHandler* phandler, uint32_t id) {
+  if (dispatch_depth_ == 0)
+    return false;
+  Message msg;
+  msg.posted_from = RTC_FROM_HERE;
+  msg.phandler = phandler;
+  msg.message_id = id;
+  CritScope cs(&crit_);
+  after_dispatch_.push_back(msg);
+  has_after_dispatch_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void MessageQueue::DispatchAfterDispatch() {
+  // One message at a time, since handling one may destroy (and clear) the
+  // handler of another.
+  while (true) {
+    Message msg;
+    {
+      CritScope cs(&crit_);
+      if (after_dispatch_.empty()) {
+        has_after_dispatch_.store(false, std::memory_order_relaxed);
+        return;
+      }
+      msg = after_dispatch_.front();
+      after_dispatch_.erase(after_dispatch_.begin());
+    }
+    msg.phandler->OnMessage(&msg);
+  }
 }
 
 void MessageQueue::Dispatch(Message* pmsg) {
@@ -510,7 +716,11 @@ void MessageQueue::Dispatch(Message* pmsg) {
                pmsg->posted_from.file_and_line(), "src_func",
                pmsg->posted_from.function_name());
   int64_t start_time = TimeMillis();
+  ++dispatch_depth_;
   pmsg->phandler->OnMessage(pmsg);
+  --dispatch_depth_;
+  if (has_after_dispatch_.load(std::memory_order_relaxed))
+    DispatchAfterDispatch();
   int64_t end_time = TimeMillis();
   int64_t diff = TimeDiff(end_time, start_time);
   if (diff >= kSlowDispatchLoggingThreshold) {
@@ -14,6 +14,8 @@
 #include <string.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <list>
 #include <memory>
 #include <queue>
@@ -24,6 +26,7 @@
 #include "rtc_base/critical_section.h"
 #include "rtc_base/location.h"
 #include "rtc_base/message_handler.h"
+#include "rtc_base/mpsc_queue.h"
 #include "rtc_base/socket_server.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
 #include "rtc_base/thread_annotations.h"
@@ -251,6 +254,12 @@ class MessageQueue {
                       MessageHandler* phandler,
                       uint32_t id = 0,
                       MessageData* pdata = nullptr);
+  // Calls |phandler|->OnMessage() with |id| as soon as the message this queue
+  // is dispatching has been handled, ahead of any queued message. Lets a
+  // handler defer work, such as flushing a batch of writes, to the end of the
+  // current message. Must be called on the thread processing this queue.
+  // Returns false, and schedules nothing, if no message is being dispatched.
+  bool PostAfterDispatch(MessageHandler* phandler, uint32_t id = 0);
   virtual void Clear(MessageHandler* phandler,
                      uint32_t id = MQID_ANY,
                      MessageList* removed = nullptr);
@@ -263,7 +272,8 @@ class MessageQueue {
   bool empty() const { return size() == 0u; }
   size_t size() const {
     CritScope cs(&crit_);  // msgq_.size() is not thread safe.
-    return msgq_.size() + dmsgq_.size() + (fPeekKeep_ ? 1u : 0u);
+    return msgq_.size() + dmsgq_.size() + (fPeekKeep_ ? 1u : 0u) +
+           posted_count_.load(std::memory_order_relaxed);
   }
 
   // Internally posts a message which causes the doomed object to be deleted
@@ -297,7 +307,8 @@ class MessageQueue {
   void DoInit();
 
   // Does not take any lock. Must be called either while holding crit_, or by
-  // the destructor (by definition, the latter has exclusive access).
+  // the destructor (by definition, the latter has exclusive access), after
+  // DrainAllPosted().
   void ClearInternal(MessageHandler* phandler,
                      uint32_t id,
                      MessageList* removed) RTC_EXCLUSIVE_LOCKS_REQUIRED(&crit_);
@@ -308,9 +319,22 @@ class MessageQueue {
 
   void WakeUpSocketServer();
 
+  // Moves messages added by Post() from |posted_| to the end of |msgq_|.
+  // Returns false if it stopped at a Post() on another thread that is midway
+  // through adding its message; that message and the ones behind it are
+  // moved by a later call.
+  bool DrainPosted() RTC_EXCLUSIVE_LOCKS_REQUIRED(&crit_);
+  // Like DrainPosted(), but also waits for such a Post() to finish, so that
+  // every message whose Post() has returned is in |msgq_|. Releases |crit_|
+  // while waiting, unless it is held recursively.
+  void DrainAllPosted() RTC_EXCLUSIVE_LOCKS_REQUIRED(&crit_);
+
+  // Handles the messages added by PostAfterDispatch().
+  void DispatchAfterDispatch();
+
   bool fPeekKeep_;
   Message msgPeek_;
-  MessageList msgq_ RTC_GUARDED_BY(crit_);
+  std::deque<Message> msgq_ RTC_GUARDED_BY(crit_);
   PriorityQueue dmsgq_ RTC_GUARDED_BY(crit_);
   uint32_t dmsgq_next_num_ RTC_GUARDED_BY(crit_);
   CriticalSection crit_;
@@ -318,6 +342,31 @@ class MessageQueue {
   bool fDestroyed_;
 
  private:
+  struct PostedMessage : public MpscQueueNode {
+    Message msg;
+    // Position in |posted_pool_| plus one, or zero if not pooled.
+    uint32_t pool_index = 0;
+    // Next node in the pool's free list, as a |pool_index|.
+    std::atomic<uint32_t> next_free{0};
+  };
+  class PostedMessagePool;
+
+  // Post() hands messages over through this lock-free queue, so that posting
+  // threads never wait for |crit_|. It is consumed by whoever holds |crit_|,
+  // which keeps it single-consumer.
+  MpscQueue<PostedMessage> posted_;
+  std::atomic<size_t> posted_count_;
+  // Recycles the nodes of |posted_|, so that Post() does not allocate once
+  // the queue has warmed up.
+  const std::unique_ptr<PostedMessagePool> posted_pool_;
+
+  // Nesting depth of Dispatch(). Only used on the thread processing messages.
+  int dispatch_depth_ = 0;
+  // Messages added by PostAfterDispatch(). Dispatch() only takes |crit_| to
+  // handle them when |has_after_dispatch_| is set.
+  std::vector<Message> after_dispatch_ RTC_GUARDED_BY(crit_);
+  std::atomic<bool> has_after_dispatch_;
+
   volatile int stop_;
 
   // The SocketServer might not be owned by MessageQueue.
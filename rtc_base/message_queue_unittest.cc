@@ -11,13 +11,17 @@
 #include "rtc_base/message_queue.h"
 
 #include <functional>
+#include <memory>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/event.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/null_socket_server.h"
+#include "rtc_base/platform_thread.h"
 #include "rtc_base/ref_count.h"
 #include "rtc_base/ref_counted_object.h"
 #include "rtc_base/thread.h"
@@ -233,5 +237,96 @@ TEST(MessageQueueManager, ClearReentrant) {
           new ScopedRefMessageData<RefCountedHandler>(inner_handler));
 }
 
+// Post() does not take the queue lock; check that messages posted
+// concurrently are all delivered, in order per posting thread, and that
+// Clear() sees every message posted before it.
+TEST_F(MessageQueueTest, ConcurrentPostsAreDeliveredAndCleared) {
+  static const int kNumThreads = 4;
+  static const uint32_t kPostsPerThread = 5000;
+  NullSocketServer nullss;
+  MessageQueue q(&nullss, true);
+  EmptyHandler handlers[kNumThreads];
+  struct Poster {
+    MessageQueue* queue;
+    MessageHandler* handler;
+  } posters[kNumThreads];
+  std::vector<std::unique_ptr<PlatformThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    posters[i] = {&q, &handlers[i]};
+    threads.push_back(absl::make_unique<PlatformThread>(
+        [](void* context) {
+          Poster* poster = static_cast<Poster*>(context);
+          for (uint32_t id = 0; id < kPostsPerThread; ++id)
+            poster->queue->Post(RTC_FROM_HERE, poster->handler, id);
+        },
+        &posters[i], "poster"));
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+  EXPECT_EQ(kNumThreads * kPostsPerThread, q.size());
+
+  q.Clear(&handlers[0]);
+  EXPECT_EQ((kNumThreads - 1) * kPostsPerThread, q.size());
+
+  uint32_t next_id[kNumThreads] = {};
+  Message msg;
+  while (q.Get(&msg, 0)) {
+    int index = static_cast<int>(
+        static_cast<EmptyHandler*>(msg.phandler) - handlers);
+    ASSERT_GT(index, 0);
+    ASSERT_LT(index, kNumThreads);
+    EXPECT_EQ(next_id[index]++, msg.message_id);
+  }
+  for (int i = 1; i < kNumThreads; ++i)
+    EXPECT_EQ(kPostsPerThread, next_id[i]);
+}
+
+// Records the order in which messages are handled; message 1 asks for message
+// 2 to be handled right after it.
+class AfterDispatchHandler : public MessageHandler {
+ public:
+  explicit AfterDispatchHandler(MessageQueue* queue) : queue_(queue) {}
+  void OnMessage(Message* msg) override {
+    handled_.push_back(msg->message_id);
+    if (msg->message_id == 1) {
+      EXPECT_TRUE(queue_->PostAfterDispatch(this, 2));
+      if (clear_after_posting_)
+        queue_->Clear(this);
+    }
+  }
+
+  MessageQueue* const queue_;
+  bool clear_after_posting_ = false;
+  std::vector<uint32_t> handled_;
+};
+
+TEST_F(MessageQueueTest, PostAfterDispatchRunsBeforeQueuedMessages) {
+  NullSocketServer nullss;
+  MessageQueue q(&nullss, true);
+  AfterDispatchHandler handler(&q);
+  EXPECT_FALSE(q.PostAfterDispatch(&handler, 2));
+
+  q.Post(RTC_FROM_HERE, &handler, 1);
+  q.Post(RTC_FROM_HERE, &handler, 3);
+  Message msg;
+  while (q.Get(&msg, 0))
+    q.Dispatch(&msg);
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 3}), handler.handled_);
+}
+
+TEST_F(MessageQueueTest, ClearRemovesMessagesPostedAfterDispatch) {
+  NullSocketServer nullss;
+  MessageQueue q(&nullss, true);
+  AfterDispatchHandler handler(&q);
+  handler.clear_after_posting_ = true;
+
+  q.Post(RTC_FROM_HERE, &handler, 1);
+  Message msg;
+  while (q.Get(&msg, 0))
+    q.Dispatch(&msg);
+  EXPECT_EQ(std::vector<uint32_t>({1}), handler.handled_);
+}
+
 }  // namespace
 }  // namespace rtc
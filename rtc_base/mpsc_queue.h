@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_MPSC_QUEUE_H_
+#define RTC_BASE_MPSC_QUEUE_H_
+
+#include <atomic>
+
+#include "rtc_base/constructor_magic.h"
+
+namespace rtc {
+
+// Link embedded in elements of an MpscQueue. An element can be in at most one
+// queue at a time.
+class MpscQueueNode {
+ public:
+  MpscQueueNode() : mpsc_next_(nullptr) {}
+
+ private:
+  template <class T>
+  friend class MpscQueue;
+
+  std::atomic<MpscQueueNode*> mpsc_next_;
+};
+
+// Intrusive, unbounded multi-producer/single-consumer FIFO (Dmitry Vyukov's
+// algorithm). Push() is wait-free and can be called from any thread. Pop() and
+// Empty() must only be called by one consumer at a time; callers that want
+// several consumers must serialize them with a lock of their own.
+//
+// The queue does not own its elements. T must derive from MpscQueueNode.
+template <class T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  void Push(T* element) { PushNode(element); }
+
+  // Returns the oldest element, or null if the queue is empty or a producer
+  // is in the middle of Push(). In the latter case Empty() returns false and
+  // a later Pop() returns the element.
+  T* Pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next)
+        return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->mpsc_next_.load(std::memory_order_acquire);
+    }
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire))
+      return nullptr;
+    // |tail| is the last element; put the stub behind it so it can be handed
+    // out without leaving the queue without a node.
+    PushNode(&stub_);
+    next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+  bool Empty() const {
+    return tail_ == &stub_ &&
+           head_.load(std::memory_order_acquire) == &stub_;
+  }
+
+ private:
+  void PushNode(MpscQueueNode* node) {
+    node->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // Between the exchange and this store the queue is momentarily unlinked;
+    // Pop() returns null for elements behind |node| until the store is done.
+    prev->mpsc_next_.store(node, std::memory_order_release);
+  }
+
+  // Written by producers.
+  std::atomic<MpscQueueNode*> head_;
+  // Only touched by the consumer.
+  MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_MPSC_QUEUE_H_
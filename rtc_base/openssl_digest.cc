@@ -10,11 +10,21 @@
 
 #include "rtc_base/openssl_digest.h"
 
+#include <stdint.h>
+#include <string.h>
+
 #include "rtc_base/checks.h"  // RTC_DCHECK, RTC_CHECK
 #include "rtc_base/openssl.h"
 
 namespace rtc {
 
+namespace {
+
+// The largest block size of the supported digests (SHA-384 and SHA-512).
+const size_t kMaxBlockSize = 128;
+
+}  // namespace
+
 OpenSSLDigest::OpenSSLDigest(const std::string& algorithm) {
   ctx_ = EVP_MD_CTX_new();
   RTC_CHECK(ctx_ != nullptr);
@@ -115,4 +125,77 @@ bool OpenSSLDigest::GetDigestSize(const std::string& algorithm,
   return true;
 }
 
+OpenSSLHmac::OpenSSLHmac(const std::string& algorithm,
+                         const void* key,
+                         size_t key_len) {
+  if (!OpenSSLDigest::GetDigestEVP(algorithm, &md_)) {
+    md_ = nullptr;
+    return;
+  }
+  const size_t block_size = EVP_MD_block_size(md_);
+  RTC_CHECK_LE(block_size, kMaxBlockSize);
+  // Keys longer than a block are hashed first; shorter ones are zero-padded.
+  uint8_t block_key[kMaxBlockSize] = {0};
+  if (key_len > block_size) {
+    EVP_Digest(key, key_len, block_key, nullptr, md_, nullptr);
+  } else {
+    memcpy(block_key, key, key_len);
+  }
+
+  uint8_t pad[kMaxBlockSize];
+  inner_ = EVP_MD_CTX_new();
+  outer_ = EVP_MD_CTX_new();
+  ctx_ = EVP_MD_CTX_new();
+  RTC_CHECK(inner_ && outer_ && ctx_);
+  for (size_t i = 0; i < block_size; ++i)
+    pad[i] = block_key[i] ^ 0x36;
+  EVP_DigestInit_ex(inner_, md_, nullptr);
+  EVP_DigestUpdate(inner_, pad, block_size);
+  for (size_t i = 0; i < block_size; ++i)
+    pad[i] = block_key[i] ^ 0x5c;
+  EVP_DigestInit_ex(outer_, md_, nullptr);
+  EVP_DigestUpdate(outer_, pad, block_size);
+  EVP_MD_CTX_copy_ex(ctx_, inner_);
+}
+
+OpenSSLHmac::~OpenSSLHmac() {
+  EVP_MD_CTX_destroy(ctx_);
+  EVP_MD_CTX_destroy(outer_);
+  EVP_MD_CTX_destroy(inner_);
+}
+
+size_t OpenSSLHmac::Size() const {
+  if (!md_) {
+    return 0;
+  }
+  return EVP_MD_size(md_);
+}
+
+void OpenSSLHmac::Update(const void* buf, size_t len) {
+  if (!md_) {
+    return;
+  }
+  EVP_DigestUpdate(ctx_, buf, len);
+}
+
+size_t OpenSSLHmac::Finish(void* buf, size_t len) {
+  if (!md_) {
+    return 0;
+  }
+  if (len < Size()) {
+    // Drop the message, so that the next one does not continue it.
+    EVP_MD_CTX_copy_ex(ctx_, inner_);
+    return 0;
+  }
+  unsigned char inner_digest[EVP_MAX_MD_SIZE];
+  unsigned int md_len;
+  EVP_DigestFinal_ex(ctx_, inner_digest, &md_len);
+  EVP_MD_CTX_copy_ex(ctx_, outer_);
+  EVP_DigestUpdate(ctx_, inner_digest, md_len);
+  EVP_DigestFinal_ex(ctx_, static_cast<unsigned char*>(buf), &md_len);
+  EVP_MD_CTX_copy_ex(ctx_, inner_);  // prepare for the next message
+  RTC_DCHECK(md_len == Size());
+  return md_len;
+}
+
 }  // namespace rtc
@@ -15,6 +15,7 @@
 #include <stddef.h>
 #include <string>
 
+#include "rtc_base/constructor_magic.h"
 #include "rtc_base/message_digest.h"
 
 namespace rtc {
@@ -44,6 +45,34 @@ class OpenSSLDigest final : public MessageDigest {
   const EVP_MD* md_;
 };
 
+// HMAC with a fixed key. The digest states after the inner and outer key pads
+// are computed once, at construction, so that each message costs only the
+// hashing of the message itself. Unlike ComputeHmac(), this allocates nothing
+// per message.
+class OpenSSLHmac final {
+ public:
+  // Creates an HMAC with |algorithm| as the hash algorithm. The key is not
+  // retained.
+  OpenSSLHmac(const std::string& algorithm, const void* key, size_t key_len);
+  ~OpenSSLHmac();
+  // Returns the HMAC output size, or 0 if the algorithm is unknown.
+  size_t Size() const;
+  // Updates the HMAC of the current message with |len| bytes from |buf|.
+  void Update(const void* buf, size_t len);
+  // Outputs the HMAC of the current message to |buf| with length |len|, and
+  // starts a new message. Returns 0 if |len| is too small, in which case the
+  // current message is dropped.
+  size_t Finish(void* buf, size_t len);
+
+ private:
+  const EVP_MD* md_ = nullptr;
+  EVP_MD_CTX* inner_ = nullptr;  // After hashing the inner pad.
+  EVP_MD_CTX* outer_ = nullptr;  // After hashing the outer pad.
+  EVP_MD_CTX* ctx_ = nullptr;    // The message in progress.
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(OpenSSLHmac);
+};
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_OPENSSL_DIGEST_H_
@@ -90,6 +90,24 @@ int64_t GetSocketRecvTimestamp(int socket) {
 typedef char* SockOptArg;
 #endif
 
+#if defined(WEBRTC_LINUX)
+// Upper bound on datagrams read by a single recvmmsg() call. Bounds the
+// on-stack message headers used by PhysicalSocket::RecvFromBatch.
+static const size_t kMaxRecvBatchSize = 64;
+// Same for sendmmsg() and UDP GSO in PhysicalSocket::SendToBatch.
+static const size_t kMaxSendBatchSize = 64;
+// A single GSO send carries at most UDP_MAX_SEGMENTS segments and, like any
+// UDP datagram, at most 65507 bytes of payload in total.
+static const size_t kMaxGsoSegments = 64;
+static const size_t kMaxGsoPayloadSize = 65507;
+#if !defined(SOL_UDP)
+#define SOL_UDP 17
+#endif
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#endif
+
 #if defined(WEBRTC_USE_EPOLL)
 // POLLRDHUP / EPOLLRDHUP are only defined starting with Linux 2.6.17.
 #if !defined(POLLRDHUP)
@@ -376,6 +394,7 @@ int PhysicalSocket::Recv(void* buffer, size_t length, int64_t* timestamp) {
   UpdateLastError();
   int error = GetError();
   bool success = (received >= 0) || IsBlockingError(error);
+  UpdateRecvDrained(received < 0 || static_cast<size_t>(received) < length);
   if (udp_ || success) {
     EnableEvents(DE_READ);
   }
@@ -402,6 +421,8 @@ int PhysicalSocket::RecvFrom(void* buffer,
     SocketAddressFromSockAddrStorage(addr_storage, out_addr);
   int error = GetError();
   bool success = (received >= 0) || IsBlockingError(error);
+  // A datagram socket is only known to be empty once a read would block.
+  UpdateRecvDrained(received < 0);
   if (udp_ || success) {
     EnableEvents(DE_READ);
   }
@@ -411,6 +432,181 @@ int PhysicalSocket::RecvFrom(void* buffer,
   return received;
 }
 
+int PhysicalSocket::RecvFromBatch(ReceivedDatagram* datagrams, size_t count) {
+#if defined(WEBRTC_LINUX)
+  if (!udp_ || count <= 1)
+    return Socket::RecvFromBatch(datagrams, count);
+  count = std::min(count, kMaxRecvBatchSize);
+
+  if (!recv_timestamps_enabled_) {
+    // recvmmsg() cannot use SIOCGSTAMP, which only reports the last datagram,
+    // so ask for a per-datagram SCM_TIMESTAMP control message instead.
+    int on = 1;
+    ::setsockopt(s_, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+    recv_timestamps_enabled_ = true;
+  }
+
+  mmsghdr msgs[kMaxRecvBatchSize];
+  iovec iovs[kMaxRecvBatchSize];
+  sockaddr_storage addrs[kMaxRecvBatchSize];
+  char controls[kMaxRecvBatchSize][CMSG_SPACE(sizeof(timeval))];
+  memset(msgs, 0, sizeof(msgs[0]) * count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].capacity;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = controls[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+  }
+
+  int received =
+      ::recvmmsg(s_, msgs, static_cast<unsigned int>(count), 0, nullptr);
+  UpdateLastError();
+  for (int i = 0; i < received; ++i) {
+    ReceivedDatagram& datagram = datagrams[i];
+    const msghdr& hdr = msgs[i].msg_hdr;
+    datagram.size = std::min<size_t>(msgs[i].msg_len, datagram.capacity);
+    datagram.truncated = (hdr.msg_flags & MSG_TRUNC) != 0;
+    SocketAddressFromSockAddrStorage(addrs[i], &datagram.source);
+    datagram.timestamp = -1;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&hdr), cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP) {
+        timeval tv;
+        memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+        datagram.timestamp =
+            kNumMicrosecsPerSec * static_cast<int64_t>(tv.tv_sec) +
+            static_cast<int64_t>(tv.tv_usec);
+      }
+    }
+  }
+  int error = GetError();
+  bool success = (received >= 0) || IsBlockingError(error);
+  UpdateRecvDrained(received < static_cast<int>(count));
+  // Datagram sockets always re-arm reads, as in RecvFrom().
+  EnableEvents(DE_READ);
+  if (!success) {
+    RTC_LOG_F(LS_VERBOSE) << "Error = " << error;
+  }
+  return received;
+#else
+  return Socket::RecvFromBatch(datagrams, count);
+#endif
+}
+
+int PhysicalSocket::SendToBatch(const OutgoingDatagram* datagrams,
+                                size_t count) {
+#if defined(WEBRTC_LINUX)
+  if (!udp_ || count <= 1)
+    return Socket::SendToBatch(datagrams, count);
+  count = std::min(count, kMaxSendBatchSize);
+
+  if (udp_gso_supported_) {
+    // GSO requires one destination and equally sized segments; only the last
+    // one may be shorter. Empty datagrams can't be segments, so they go
+    // through sendmmsg().
+    bool can_segment = datagrams[0].size > 0;
+    for (size_t i = 1; i < count && can_segment; ++i) {
+      can_segment = datagrams[i].destination == datagrams[0].destination &&
+                    datagrams[i].size > 0 &&
+                    (datagrams[i].size == datagrams[0].size ||
+                     (i == count - 1 && datagrams[i].size < datagrams[0].size));
+    }
+    // Larger batches are split into several GSO sends.
+    size_t max_segments =
+        can_segment
+            ? std::min(kMaxGsoSegments, kMaxGsoPayloadSize / datagrams[0].size)
+            : 0;
+    if (max_segments > 1) {
+      size_t sent = 0;
+      while (sent < count) {
+        size_t segments = std::min(count - sent, max_segments);
+        if (SendToBatchGso(datagrams + sent, segments) < 0)
+          break;
+        sent += segments;
+      }
+      if (sent > 0)
+        return static_cast<int>(sent);
+      int error = GetError();
+      if (error != EINVAL && error != EOPNOTSUPP && error != EIO)
+        return SOCKET_ERROR;
+      // Not supported by this kernel or device; use sendmmsg() from now on.
+      RTC_LOG(LS_INFO) << "UDP GSO unavailable, error " << error;
+      udp_gso_supported_ = false;
+    }
+  }
+
+  mmsghdr msgs[kMaxSendBatchSize];
+  iovec iovs[kMaxSendBatchSize];
+  sockaddr_storage addrs[kMaxSendBatchSize];
+  memset(msgs, 0, sizeof(msgs[0]) * count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = const_cast<char*>(datagrams[i].data);
+    iovs[i].iov_len = datagrams[i].size;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(
+        datagrams[i].destination.ToSockAddrStorage(&addrs[i]));
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  // Suppress SIGPIPE, see Send().
+  int sent = ::sendmmsg(s_, msgs, static_cast<unsigned int>(count),
+                        MSG_NOSIGNAL);
+  UpdateLastError();
+  MaybeRemapSendError();
+  if ((sent >= 0 && sent < static_cast<int>(count)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+#else
+  return Socket::SendToBatch(datagrams, count);
+#endif
+}
+
+#if defined(WEBRTC_LINUX)
+int PhysicalSocket::SendToBatchGso(const OutgoingDatagram* datagrams,
+                                   size_t count) {
+  iovec iovs[kMaxSendBatchSize];
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = const_cast<char*>(datagrams[i].data);
+    iovs[i].iov_len = datagrams[i].size;
+  }
+  sockaddr_storage addr;
+  char control[CMSG_SPACE(sizeof(uint16_t))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  memset(control, 0, sizeof(control));
+  msg.msg_name = &addr;
+  msg.msg_namelen =
+      static_cast<socklen_t>(datagrams[0].destination.ToSockAddrStorage(&addr));
+  msg.msg_iov = iovs;
+  msg.msg_iovlen = count;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_UDP;
+  cmsg->cmsg_type = UDP_SEGMENT;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  uint16_t segment_size = static_cast<uint16_t>(datagrams[0].size);
+  memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+  int sent = ::sendmsg(s_, &msg, MSG_NOSIGNAL);
+  UpdateLastError();
+  MaybeRemapSendError();
+  if (sent < 0) {
+    if (IsBlockingError(GetError()))
+      EnableEvents(DE_WRITE);
+    return SOCKET_ERROR;
+  }
+  // A GSO send is all or nothing.
+  return static_cast<int>(count);
+}
+#endif
+
 int PhysicalSocket::Listen(int backlog) {
   int err = ::listen(s_, backlog);
   UpdateLastError();
@@ -554,6 +750,15 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       return -1;
     case OPT_RTP_SENDTIME_EXTN_ID:
       return -1;  // No logging is necessary as this not a OS socket option.
+    case OPT_REUSEPORT:
+#if defined(SO_REUSEPORT)
+      *slevel = SOL_SOCKET;
+      *sopt = SO_REUSEPORT;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -708,6 +913,10 @@ bool SocketDispatcher::IsDescriptorClosed() {
   }
 }
 
+bool SocketDispatcher::SupportsEdgeTriggeredEvents() {
+  return true;
+}
+
 #endif  // WEBRTC_POSIX
 
 uint32_t SocketDispatcher::GetRequestedEvents() {
@@ -783,6 +992,7 @@ void SocketDispatcher::OnEvent(uint32_t ff, int err) {
   }
   if ((ff & DE_READ) != 0) {
     DisableEvents(DE_READ);
+    UpdateRecvDrained(false);
     SignalReadEvent(this);
   }
   if ((ff & DE_WRITE) != 0) {
@@ -796,6 +1006,15 @@ void SocketDispatcher::OnEvent(uint32_t ff, int err) {
   }
 #if defined(WEBRTC_USE_EPOLL)
   FinishBatchedEventUpdates();
+  // With edge-triggered epoll, a read or accept event is not reported again
+  // for data that was already queued. If the handler re-enabled the event
+  // without draining the socket, re-arm it so the remaining data is seen.
+  if (ss_->edge_triggered_epoll() &&
+      (((ff & DE_READ) != 0 && (enabled_events() & DE_READ) != 0 &&
+        !recv_drained_) ||
+       ((ff & DE_ACCEPT) != 0 && (enabled_events() & DE_ACCEPT) != 0))) {
+    ss_->Update(this);
+  }
 #endif
 }
 
@@ -1166,13 +1385,11 @@ class Signaler : public EventDispatcher {
 
 PhysicalSocketServer::PhysicalSocketServer() : fWait_(false) {
 #if defined(WEBRTC_USE_EPOLL)
-  // Since Linux 2.6.8, the size argument is ignored, but must be greater than
-  // zero. Before that the size served as hint to the kernel for the amount of
-  // space to initially allocate in internal data structures.
-  epoll_fd_ = epoll_create(FD_SETSIZE);
+  // The epoll set grows as needed, so no size hint is passed.
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
   if (epoll_fd_ == -1) {
     // Not an error, will fall back to "select" below.
-    RTC_LOG_E(LS_WARNING, EN, errno) << "epoll_create";
+    RTC_LOG_E(LS_WARNING, EN, errno) << "epoll_create1";
     epoll_fd_ = INVALID_SOCKET;
   }
 #endif
@@ -1287,10 +1504,6 @@ void PhysicalSocketServer::Update(Dispatcher* pdispatcher) {
   }
 
   CritScope cs(&crit_);
-  if (dispatchers_.find(pdispatcher) == dispatchers_.end()) {
-    return;
-  }
-
   UpdateEpoll(pdispatcher);
 #endif
 }
@@ -1512,19 +1725,52 @@ void PhysicalSocketServer::AddEpoll(Dispatcher* pdispatcher) {
   if (fd == INVALID_SOCKET) {
     return;
   }
+  if (epoll_slot_index_.count(pdispatcher)) {
+    // Duplicate call to Add, already registered.
+    return;
+  }
+
+  uint32_t index;
+  if (!free_epoll_slots_.empty()) {
+    index = free_epoll_slots_.back();
+    free_epoll_slots_.pop_back();
+  } else {
+    index = static_cast<uint32_t>(epoll_slots_.size());
+    epoll_slots_.emplace_back();
+  }
+  EpollSlot& slot = epoll_slots_[index];
+  slot.dispatcher = pdispatcher;
+  slot.edge_triggered =
+      edge_triggered_epoll_ && pdispatcher->SupportsEdgeTriggeredEvents();
 
   struct epoll_event event = {0};
-  event.events = GetEpollEvents(pdispatcher->GetRequestedEvents());
-  event.data.ptr = pdispatcher;
+  event.events = GetEpollEvents(pdispatcher->GetRequestedEvents()) |
+                 (slot.edge_triggered ? EPOLLET : 0);
+  event.data.u64 = EpollKey(index, slot.generation);
   int err = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
   RTC_DCHECK_EQ(err, 0);
   if (err == -1) {
     RTC_LOG_E(LS_ERROR, EN, errno) << "epoll_ctl EPOLL_CTL_ADD";
+    slot.dispatcher = nullptr;
+    free_epoll_slots_.push_back(index);
+    return;
   }
+  epoll_slot_index_[pdispatcher] = index;
 }
 
 void PhysicalSocketServer::RemoveEpoll(Dispatcher* pdispatcher) {
   RTC_DCHECK(epoll_fd_ != INVALID_SOCKET);
+  auto it = epoll_slot_index_.find(pdispatcher);
+  if (it != epoll_slot_index_.end()) {
+    // Bumping the generation invalidates events for this slot that are still
+    // pending in the current epoll_wait result.
+    EpollSlot& slot = epoll_slots_[it->second];
+    slot.dispatcher = nullptr;
+    ++slot.generation;
+    free_epoll_slots_.push_back(it->second);
+    epoll_slot_index_.erase(it);
+  }
+
   int fd = pdispatcher->GetDescriptor();
   RTC_DCHECK(fd != INVALID_SOCKET);
   if (fd == INVALID_SOCKET) {
@@ -1546,15 +1792,21 @@ void PhysicalSocketServer::RemoveEpoll(Dispatcher* pdispatcher) {
 
 void PhysicalSocketServer::UpdateEpoll(Dispatcher* pdispatcher) {
   RTC_DCHECK(epoll_fd_ != INVALID_SOCKET);
+  auto it = epoll_slot_index_.find(pdispatcher);
+  if (it == epoll_slot_index_.end()) {
+    return;
+  }
   int fd = pdispatcher->GetDescriptor();
   RTC_DCHECK(fd != INVALID_SOCKET);
   if (fd == INVALID_SOCKET) {
     return;
   }
 
+  const EpollSlot& slot = epoll_slots_[it->second];
   struct epoll_event event = {0};
-  event.events = GetEpollEvents(pdispatcher->GetRequestedEvents());
-  event.data.ptr = pdispatcher;
+  event.events = GetEpollEvents(pdispatcher->GetRequestedEvents()) |
+                 (slot.edge_triggered ? EPOLLET : 0);
+  event.data.u64 = EpollKey(it->second, slot.generation);
   int err = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
   RTC_DCHECK_EQ(err, 0);
   if (err == -1) {
@@ -1603,11 +1855,15 @@ bool PhysicalSocketServer::WaitEpoll(int cmsWait) {
       CritScope cr(&crit_);
       for (int i = 0; i < n; ++i) {
         const epoll_event& event = epoll_events_[i];
-        Dispatcher* pdispatcher = static_cast<Dispatcher*>(event.data.ptr);
-        if (dispatchers_.find(pdispatcher) == dispatchers_.end()) {
+        uint32_t index = static_cast<uint32_t>(event.data.u64);
+        uint32_t generation = static_cast<uint32_t>(event.data.u64 >> 32);
+        if (index >= epoll_slots_.size() ||
+            epoll_slots_[index].generation != generation ||
+            !epoll_slots_[index].dispatcher) {
           // The dispatcher for this socket no longer exists.
           continue;
         }
+        Dispatcher* pdispatcher = epoll_slots_[index].dispatcher;
 
         bool readable = (event.events & (EPOLLIN | EPOLLPRI));
         bool writable = (event.events & EPOLLOUT);
@@ -1621,7 +1877,7 @@ bool PhysicalSocketServer::WaitEpoll(int cmsWait) {
         epoll_events_.size() < kMaxEpollEvents) {
       // We used the complete space to receive events, increase size for future
       // iterations.
-      epoll_events_.resize(std::max(epoll_events_.size() * 2, kMaxEpollEvents));
+      epoll_events_.resize(std::min(epoll_events_.size() * 2, kMaxEpollEvents));
     }
 
     if (cmsWait != kForever) {
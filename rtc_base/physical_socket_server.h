@@ -17,7 +17,8 @@
 #endif
 
 #include <memory>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "rtc_base/critical_section.h"
@@ -57,6 +58,9 @@ class Dispatcher {
 #elif defined(WEBRTC_POSIX)
   virtual int GetDescriptor() = 0;
   virtual bool IsDescriptorClosed() = 0;
+  // Whether the dispatcher re-arms itself when it stops short of draining its
+  // descriptor, so that it may be registered with EPOLLET.
+  virtual bool SupportsEdgeTriggeredEvents() { return false; }
 #endif
 };
 
@@ -81,6 +85,16 @@ class PhysicalSocketServer : public SocketServer {
   void Remove(Dispatcher* dispatcher);
   void Update(Dispatcher* dispatcher);
 
+#if defined(WEBRTC_USE_EPOLL)
+  // Registers dispatchers that support it with edge-triggered epoll, which
+  // avoids reporting sockets again on every Wait() while they stay readable.
+  // Applies to dispatchers added after the call, so it should be called
+  // before any socket is created. PeerConnectionFactory enables it on its
+  // network threads with the "WebRTC-EdgeTriggeredEpoll" field trial.
+  void SetEdgeTriggeredEpoll(bool enabled) { edge_triggered_epoll_ = enabled; }
+  bool edge_triggered_epoll() const { return edge_triggered_epoll_; }
+#endif
+
 #if defined(WEBRTC_POSIX)
   // Sets the function to be executed in response to the specified POSIX signal.
   // The function is executed from inside Wait() using the "self-pipe trick"--
@@ -99,7 +113,7 @@ class PhysicalSocketServer : public SocketServer {
 #endif
 
  private:
-  typedef std::set<Dispatcher*> DispatcherSet;
+  typedef std::unordered_set<Dispatcher*> DispatcherSet;
 
   void AddRemovePendingDispatchers();
 
@@ -116,8 +130,25 @@ class PhysicalSocketServer : public SocketServer {
   bool WaitEpoll(int cms);
   bool WaitPoll(int cms, Dispatcher* dispatcher);
 
+  // Dispatchers registered with epoll live in a slab of slots. The slot index
+  // and a generation counter are stored in epoll_event.data, so events map
+  // back to their dispatcher in O(1) and stale events for a removed (and
+  // possibly reused) slot are recognized and dropped.
+  struct EpollSlot {
+    Dispatcher* dispatcher = nullptr;
+    uint32_t generation = 0;
+    bool edge_triggered = false;
+  };
+  static uint64_t EpollKey(uint32_t index, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | index;
+  }
+
   int epoll_fd_ = INVALID_SOCKET;
   std::vector<struct epoll_event> epoll_events_;
+  bool edge_triggered_epoll_ = false;
+  std::vector<EpollSlot> epoll_slots_;
+  std::vector<uint32_t> free_epoll_slots_;
+  std::unordered_map<Dispatcher*, uint32_t> epoll_slot_index_;
 #endif  // WEBRTC_USE_EPOLL
   DispatcherSet dispatchers_;
   DispatcherSet pending_add_dispatchers_;
@@ -163,6 +194,15 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
                size_t length,
                SocketAddress* out_addr,
                int64_t* timestamp) override;
+  // Uses recvmmsg() on Linux to read a whole batch with one system call.
+  int RecvFromBatch(ReceivedDatagram* datagrams, size_t count) override;
+  // Uses UDP GSO when all datagrams share a destination and size, and
+  // sendmmsg() otherwise, on Linux.
+  int SendToBatch(const OutgoingDatagram* datagrams, size_t count) override;
+#if defined(WEBRTC_LINUX)
+  // False once the kernel has rejected UDP GSO for this socket.
+  bool udp_gso_supported() const { return udp_gso_supported_; }
+#endif
 
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* out_addr) override;
@@ -192,6 +232,9 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 
   void UpdateLastError();
   void MaybeRemapSendError();
+  // Records whether the last receive emptied the socket's queue, see
+  // recv_drained_.
+  void UpdateRecvDrained(bool drained) { recv_drained_ = drained; }
 
   uint8_t enabled_events() const { return enabled_events_; }
   virtual void SetEnabledEvents(uint8_t events);
@@ -207,6 +250,11 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   int error_ RTC_GUARDED_BY(crit_);
   ConnState state_;
   AsyncResolver* resolver_;
+  // True if the last Recv/RecvFrom/RecvFromBatch call left no data behind
+  // (it would have blocked or returned less than asked for). With
+  // edge-triggered epoll, a socket that has not been drained must be re-armed
+  // after a read event because the kernel won't report it again.
+  bool recv_drained_ = false;
 
 #if !defined(NDEBUG)
   std::string dbg_addr_;
@@ -214,6 +262,15 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 
  private:
   uint8_t enabled_events_ = 0;
+#if defined(WEBRTC_LINUX)
+  // Set once SO_TIMESTAMP has been enabled for batched receives.
+  bool recv_timestamps_enabled_ = false;
+  // Cleared when the kernel rejects UDP_SEGMENT as unsupported (EINVAL,
+  // EOPNOTSUPP or EIO), so that later batches go straight to sendmmsg().
+  bool udp_gso_supported_ = true;
+
+  int SendToBatchGso(const OutgoingDatagram* datagrams, size_t count);
+#endif
 };
 
 class SocketDispatcher : public Dispatcher, public PhysicalSocket {
@@ -234,6 +291,7 @@ class SocketDispatcher : public Dispatcher, public PhysicalSocket {
 #elif defined(WEBRTC_POSIX)
   int GetDescriptor() override;
   bool IsDescriptorClosed() override;
+  bool SupportsEdgeTriggeredEvents() override;
 #endif
 
   uint32_t GetRequestedEvents() override;
@@ -11,6 +11,7 @@
 #include <signal.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "rtc_base/gunit.h"
 #include "rtc_base/ip_address.h"
@@ -459,6 +460,191 @@ TEST_F(PhysicalSocketTest, TestSocketRecvTimestampIPv6) {
 }
 #endif
 
+#if defined(WEBRTC_POSIX) && defined(SO_REUSEPORT)
+// UDP sockets can bind the same address once each has set OPT_REUSEPORT.
+TEST_F(PhysicalSocketTest, TestReusePortIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> socket1(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> socket2(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> socket3(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, socket1->SetOption(Socket::OPT_REUSEPORT, 1));
+  ASSERT_EQ(0, socket2->SetOption(Socket::OPT_REUSEPORT, 1));
+  int value = 0;
+  EXPECT_EQ(0, socket1->GetOption(Socket::OPT_REUSEPORT, &value));
+  EXPECT_EQ(1, value);
+
+  ASSERT_EQ(0, socket1->Bind(SocketAddress(kIPv4Loopback, 0)));
+  EXPECT_EQ(0, socket2->Bind(socket1->GetLocalAddress()));
+  EXPECT_EQ(socket1->GetLocalAddress(), socket2->GetLocalAddress());
+  EXPECT_NE(0, socket3->Bind(socket1->GetLocalAddress()));
+}
+#endif
+
+#if defined(WEBRTC_USE_EPOLL)
+TEST_F(PhysicalSocketTest, TestTcpIPv4EdgeTriggered) {
+  MAYBE_SKIP_IPV4;
+  server_->SetEdgeTriggeredEpoll(true);
+  SocketTest::TestTcpIPv4();
+}
+
+TEST_F(PhysicalSocketTest, TestUdpIPv4EdgeTriggered) {
+  MAYBE_SKIP_IPV4;
+  server_->SetEdgeTriggeredEpoll(true);
+  SocketTest::TestUdpIPv4();
+}
+
+// Datagrams queued before a read event that only consumes one of them must
+// still be delivered with edge-triggered epoll, which won't report them again.
+TEST_F(PhysicalSocketTest, EdgeTriggeredRearmsUndrainedSocket) {
+  MAYBE_SKIP_IPV4;
+  server_->SetEdgeTriggeredEpoll(true);
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+
+  int read_events = 0;
+  size_t received = 0;
+  class Reader : public sigslot::has_slots<> {
+   public:
+    Reader(int* read_events, size_t* received)
+        : read_events_(read_events), received_(received) {}
+    void OnReadEvent(AsyncSocket* socket) {
+      ++*read_events_;
+      char buf[64];
+      if (socket->RecvFrom(buf, sizeof(buf), nullptr, nullptr) >= 0)
+        ++*received_;
+    }
+
+   private:
+    int* read_events_;
+    size_t* received_;
+  } reader(&read_events, &received);
+  receiver->SignalReadEvent.connect(&reader, &Reader::OnReadEvent);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(4, sender->SendTo("test", 4, receiver->GetLocalAddress()));
+  }
+  for (int i = 0; i < 10 && received < 3; ++i)
+    server_->Wait(100, true);
+  EXPECT_EQ(3u, received);
+  EXPECT_GE(read_events, 3);
+}
+
+// Creates and destroys batches of UDP sockets to measure dispatcher
+// registration cost. Disabled by default; run manually with
+// --gtest_also_run_disabled_tests.
+TEST_F(PhysicalSocketTest, DISABLED_SocketChurnPerformance) {
+  MAYBE_SKIP_IPV4;
+  static const int kRounds = 200;
+  static const int kSocketsPerRound = 1000;
+  for (int round = 0; round < kRounds; ++round) {
+    std::vector<std::unique_ptr<AsyncSocket>> sockets;
+    sockets.reserve(kSocketsPerRound);
+    for (int i = 0; i < kSocketsPerRound; ++i) {
+      sockets.emplace_back(server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+      ASSERT_TRUE(sockets.back());
+      ASSERT_EQ(0, sockets.back()->Bind(SocketAddress(kIPv4Loopback, 0)));
+    }
+    EXPECT_TRUE(server_->Wait(0, true));
+    // Destroy in a different order than creation to exercise slot reuse.
+    for (int i = 0; i < kSocketsPerRound; i += 2)
+      sockets[i].reset();
+    EXPECT_TRUE(server_->Wait(0, true));
+  }
+}
+#endif  // WEBRTC_USE_EPOLL
+
+#if defined(WEBRTC_LINUX)
+// A batch of more than 64 kB must be split into several GSO sends rather
+// than being rejected with EMSGSIZE, which would also turn GSO off.
+TEST_F(PhysicalSocketTest, SendToBatchLargerThanMaxUdpPayload) {
+  MAYBE_SKIP_IPV4;
+  static const size_t kDatagramSize = 1200;
+  static const size_t kBatchSize = 60;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender_socket(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender_socket->Bind(SocketAddress(kIPv4Loopback, 0)));
+  PhysicalSocket* sender = static_cast<PhysicalSocket*>(sender_socket.get());
+
+  std::vector<char> payload(kDatagramSize * kBatchSize, 'x');
+  std::vector<OutgoingDatagram> datagrams(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    datagrams[i].data = &payload[i * kDatagramSize];
+    datagrams[i].size = kDatagramSize;
+    datagrams[i].destination = receiver->GetLocalAddress();
+  }
+  // A small batch first finds out whether this kernel supports GSO at all.
+  ASSERT_EQ(2, sender->SendToBatch(datagrams.data(), 2));
+  bool gso_supported = sender->udp_gso_supported();
+
+  size_t sent = 0;
+  while (sent < kBatchSize) {
+    int result = sender->SendToBatch(&datagrams[sent], kBatchSize - sent);
+    ASSERT_GT(result, 0) << "error " << sender->GetError();
+    sent += result;
+  }
+  EXPECT_EQ(gso_supported, sender->udp_gso_supported());
+
+  size_t received = 0;
+  char buf[2 * kDatagramSize];
+  for (int i = 0; i < 100 && received < kBatchSize + 2; ++i) {
+    int len;
+    while ((len = receiver->RecvFrom(buf, sizeof(buf), nullptr, nullptr)) >=
+           0) {
+      EXPECT_EQ(kDatagramSize, static_cast<size_t>(len));
+      ++received;
+    }
+    server_->Wait(10, true);
+  }
+  EXPECT_EQ(kBatchSize + 2, received);
+}
+
+// Empty datagrams are valid, but can't be sent as GSO segments.
+TEST_F(PhysicalSocketTest, SendToBatchWithEmptyDatagrams) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender_socket(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender_socket->Bind(SocketAddress(kIPv4Loopback, 0)));
+  PhysicalSocket* sender = static_cast<PhysicalSocket*>(sender_socket.get());
+
+  const char kPayload[] = "payload";
+  OutgoingDatagram datagrams[3];
+  for (OutgoingDatagram& datagram : datagrams)
+    datagram.destination = receiver->GetLocalAddress();
+  datagrams[1].data = kPayload;
+  datagrams[1].size = sizeof(kPayload);
+  // First, then last datagram empty.
+  ASSERT_EQ(2, sender->SendToBatch(datagrams, 2));
+  ASSERT_EQ(2, sender->SendToBatch(&datagrams[1], 2));
+
+  std::vector<int> lengths;
+  char buf[64];
+  for (int i = 0; i < 100 && lengths.size() < 4; ++i) {
+    int len;
+    while ((len = receiver->RecvFrom(buf, sizeof(buf), nullptr, nullptr)) >=
+           0) {
+      lengths.push_back(len);
+    }
+    server_->Wait(10, true);
+  }
+  EXPECT_EQ(std::vector<int>({0, static_cast<int>(sizeof(kPayload)),
+                              static_cast<int>(sizeof(kPayload)), 0}),
+            lengths);
+}
+#endif  // WEBRTC_LINUX
+
 // Verify that if the socket was unable to be bound to a real network interface
 // (not loopback), Bind will return an error.
 TEST_F(PhysicalSocketTest,
@@ -12,4 +12,29 @@
 
 namespace rtc {
 
+int Socket::RecvFromBatch(ReceivedDatagram* datagrams, size_t count) {
+  if (count == 0)
+    return 0;
+  ReceivedDatagram& datagram = datagrams[0];
+  int received = RecvFrom(datagram.data, datagram.capacity, &datagram.source,
+                          &datagram.timestamp);
+  if (received < 0)
+    return SOCKET_ERROR;
+  datagram.size = static_cast<size_t>(received);
+  datagram.truncated = false;
+  return 1;
+}
+
+int Socket::SendToBatch(const OutgoingDatagram* datagrams, size_t count) {
+  size_t sent = 0;
+  for (; sent < count; ++sent) {
+    const OutgoingDatagram& datagram = datagrams[sent];
+    if (SendTo(datagram.data, datagram.size, datagram.destination) < 0)
+      break;
+  }
+  if (sent == 0 && count > 0)
+    return SOCKET_ERROR;
+  return static_cast<int>(sent);
+}
+
 }  // namespace rtc
@@ -122,6 +122,26 @@ inline bool IsBlockingError(int e) {
   return (e == EWOULDBLOCK) || (e == EAGAIN) || (e == EINPROGRESS);
 }
 
+// One slot of a batched datagram receive, see Socket::RecvFromBatch. The
+// caller owns |data| and sets |capacity|; the socket fills in the rest.
+struct ReceivedDatagram {
+  char* data = nullptr;
+  size_t capacity = 0;
+  size_t size = 0;
+  // True if the datagram did not fit in |capacity| bytes and was cut short.
+  bool truncated = false;
+  SocketAddress source;
+  // Receive time in microseconds, or -1 if not available.
+  int64_t timestamp = -1;
+};
+
+// One datagram of a batched send, see Socket::SendToBatch.
+struct OutgoingDatagram {
+  const char* data = nullptr;
+  size_t size = 0;
+  SocketAddress destination;
+};
+
 // General interface for the socket implementations of various networks.  The
 // methods match those of normal UNIX sockets very closely.
 class Socket {
@@ -146,6 +166,16 @@ class Socket {
                        size_t cb,
                        SocketAddress* paddr,
                        int64_t* timestamp) = 0;
+  // Receives up to |count| datagrams into |datagrams| with as few system
+  // calls as the platform allows. Returns the number of datagrams received,
+  // or SOCKET_ERROR if none could be read (see GetError()). The default
+  // implementation reads a single datagram through RecvFrom().
+  virtual int RecvFromBatch(ReceivedDatagram* datagrams, size_t count);
+  // Sends |count| datagrams in order with as few system calls as the platform
+  // allows. Returns the number of datagrams sent, which may be less than
+  // |count| if the socket would block, or SOCKET_ERROR if none was sent. The
+  // default implementation calls SendTo() for each datagram.
+  virtual int SendToBatch(const OutgoingDatagram* datagrams, size_t count);
   virtual int Listen(int backlog) = 0;
   virtual Socket* Accept(SocketAddress* paddr) = 0;
   virtual int Close() = 0;
@@ -166,6 +196,9 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_REUSEPORT,             // Whether sockets may bind the same address and
+                               // have the kernel balance packets among them.
+                               // Must be set before Bind().
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
@@ -47,6 +47,8 @@ class TaskQueueGcd : public TaskQueueBase {
   void PostTask(std::unique_ptr<QueuedTask> task) override;
   void PostDelayedTask(std::unique_ptr<QueuedTask> task,
                        uint32_t milliseconds) override;
+  void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                         int64_t microseconds) override;
 
  private:
   struct TaskContext {
@@ -109,6 +111,14 @@ void TaskQueueGcd::PostDelayedTask(std::unique_ptr<QueuedTask> task,
       context, &RunTask);
 }
 
+void TaskQueueGcd::PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                     int64_t microseconds) {
+  auto* context = new TaskContext(this, std::move(task));
+  dispatch_after_f(
+      dispatch_time(DISPATCH_TIME_NOW, microseconds * NSEC_PER_USEC), queue_,
+      context, &RunTask);
+}
+
 // static
 void TaskQueueGcd::RunTask(void* task_context) {
   std::unique_ptr<TaskContext> tc(static_cast<TaskContext*>(task_context));
@@ -17,7 +17,11 @@
 #include <stdint.h>
 #include <time.h>
 #include <unistd.h>
+#if defined(WEBRTC_LINUX)
+#include <sys/timerfd.h>
+#endif
 #include <list>
+#include <map>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -112,6 +116,8 @@ class TaskQueueLibevent final : public TaskQueueBase {
   void PostTask(std::unique_ptr<QueuedTask> task) override;
   void PostDelayedTask(std::unique_ptr<QueuedTask> task,
                        uint32_t milliseconds) override;
+  void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                         int64_t microseconds) override;
 
  private:
   class SetTimerTask;
@@ -123,6 +129,10 @@ class TaskQueueLibevent final : public TaskQueueBase {
   static void OnWakeup(int socket, short flags, void* context);  // NOLINT
   static void RunTask(int fd, short flags, void* context);       // NOLINT
   static void RunTimer(int fd, short flags, void* context);      // NOLINT
+#if defined(WEBRTC_LINUX)
+  static void OnPreciseTimer(int fd, short flags, void* context);  // NOLINT
+  void ArmPreciseTimer();
+#endif
 
   bool is_active_ = true;
   int wakeup_pipe_in_ = -1;
@@ -134,8 +144,25 @@ class TaskQueueLibevent final : public TaskQueueBase {
   std::list<std::unique_ptr<QueuedTask>> pending_ RTC_GUARDED_BY(pending_lock_);
   // Holds a list of events pending timers for cleanup when the loop exits.
   std::list<TimerEvent*> pending_timers_;
+#if defined(WEBRTC_LINUX)
+  // libevent's epoll backend rounds its wait up to whole milliseconds, so
+  // delayed tasks are kept here, keyed by due time on the monotonic clock in
+  // microseconds, and woken by a single timerfd armed for the earliest one.
+  int timer_fd_ = -1;
+  event timer_fd_event_;
+  std::multimap<int64_t, std::unique_ptr<QueuedTask>> precise_timers_;
+#endif
 };
 
+#if defined(WEBRTC_LINUX)
+int64_t MonotonicMicros() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * rtc::kNumMicrosecsPerSec +
+         ts.tv_nsec / rtc::kNumNanosecsPerMicrosec;
+}
+#endif
+
 struct TaskQueueLibevent::TimerEvent {
   TimerEvent(TaskQueueLibevent* task_queue, std::unique_ptr<QueuedTask> task)
       : task_queue(task_queue), task(std::move(task)) {}
@@ -148,25 +175,25 @@ struct TaskQueueLibevent::TimerEvent {
 
 class TaskQueueLibevent::SetTimerTask : public QueuedTask {
  public:
-  SetTimerTask(std::unique_ptr<QueuedTask> task, uint32_t milliseconds)
+  SetTimerTask(std::unique_ptr<QueuedTask> task, int64_t microseconds)
       : task_(std::move(task)),
-        milliseconds_(milliseconds),
-        posted_(rtc::Time32()) {}
+        microseconds_(microseconds),
+        posted_us_(rtc::TimeMicros()) {}
 
  private:
   bool Run() override {
     // Compensate for the time that has passed since construction
     // and until we got here.
-    uint32_t post_time = rtc::Time32() - posted_;
-    TaskQueueLibevent::Current()->PostDelayedTask(
+    int64_t post_time_us = rtc::TimeMicros() - posted_us_;
+    TaskQueueLibevent::Current()->PostDelayedTaskUs(
         std::move(task_),
-        post_time > milliseconds_ ? 0 : milliseconds_ - post_time);
+        post_time_us > microseconds_ ? 0 : microseconds_ - post_time_us);
     return true;
   }
 
   std::unique_ptr<QueuedTask> task_;
-  const uint32_t milliseconds_;
-  const uint32_t posted_;
+  const int64_t microseconds_;
+  const int64_t posted_us_;
 };
 
 TaskQueueLibevent::TaskQueueLibevent(absl::string_view queue_name,
@@ -183,6 +210,17 @@ TaskQueueLibevent::TaskQueueLibevent(absl::string_view queue_name,
   EventAssign(&wakeup_event_, event_base_, wakeup_pipe_out_,
               EV_READ | EV_PERSIST, OnWakeup, this);
   event_add(&wakeup_event_, 0);
+#if defined(WEBRTC_LINUX)
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timer_fd_ != -1) {
+    EventAssign(&timer_fd_event_, event_base_, timer_fd_,
+                EV_READ | EV_PERSIST, OnPreciseTimer, this);
+    event_add(&timer_fd_event_, 0);
+  } else {
+    RTC_LOG(WARNING) << "timerfd_create failed, delayed tasks will be "
+                        "rounded up to whole milliseconds.";
+  }
+#endif
   thread_.Start();
 }
 
@@ -201,6 +239,13 @@ void TaskQueueLibevent::Delete() {
   thread_.Stop();
 
   event_del(&wakeup_event_);
+#if defined(WEBRTC_LINUX)
+  if (timer_fd_ != -1) {
+    event_del(&timer_fd_event_);
+    close(timer_fd_);
+    timer_fd_ = -1;
+  }
+#endif
 
   IgnoreSigPipeSignalOnCurrentThread();
 
@@ -243,17 +288,35 @@ void TaskQueueLibevent::PostTask(std::unique_ptr<QueuedTask> task) {
 
 void TaskQueueLibevent::PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                         uint32_t milliseconds) {
-  if (IsCurrent()) {
-    TimerEvent* timer = new TimerEvent(this, std::move(task));
-    EventAssign(&timer->ev, event_base_, -1, 0, &TaskQueueLibevent::RunTimer,
-                timer);
-    pending_timers_.push_back(timer);
-    timeval tv = {rtc::dchecked_cast<int>(milliseconds / 1000),
-                  rtc::dchecked_cast<int>(milliseconds % 1000) * 1000};
-    event_add(&timer->ev, &tv);
-  } else {
-    PostTask(absl::make_unique<SetTimerTask>(std::move(task), milliseconds));
+  PostDelayedTaskUs(std::move(task),
+                    int64_t{milliseconds} * rtc::kNumMicrosecsPerMillisec);
+}
+
+void TaskQueueLibevent::PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                          int64_t microseconds) {
+  if (!IsCurrent()) {
+    PostTask(absl::make_unique<SetTimerTask>(std::move(task), microseconds));
+    return;
+  }
+#if defined(WEBRTC_LINUX)
+  if (timer_fd_ != -1) {
+    int64_t fire_at_us = MonotonicMicros() + microseconds;
+    bool earliest = precise_timers_.empty() ||
+                    fire_at_us < precise_timers_.begin()->first;
+    precise_timers_.emplace(fire_at_us, std::move(task));
+    if (earliest)
+      ArmPreciseTimer();
+    return;
   }
+#endif
+  TimerEvent* timer = new TimerEvent(this, std::move(task));
+  EventAssign(&timer->ev, event_base_, -1, 0, &TaskQueueLibevent::RunTimer,
+              timer);
+  pending_timers_.push_back(timer);
+  timeval tv = {
+      rtc::dchecked_cast<int>(microseconds / rtc::kNumMicrosecsPerSec),
+      rtc::dchecked_cast<int>(microseconds % rtc::kNumMicrosecsPerSec)};
+  event_add(&timer->ev, &tv);
 }
 
 // static
@@ -268,6 +331,9 @@ void TaskQueueLibevent::ThreadMain(void* context) {
 
   for (TimerEvent* timer : me->pending_timers_)
     delete timer;
+#if defined(WEBRTC_LINUX)
+  me->precise_timers_.clear();
+#endif
 }
 
 // static
@@ -320,6 +386,43 @@ void TaskQueueLibevent::RunTimer(int fd,
   delete timer;
 }
 
+#if defined(WEBRTC_LINUX)
+// static
+void TaskQueueLibevent::OnPreciseTimer(int fd,
+                                       short flags,  // NOLINT
+                                       void* context) {
+  TaskQueueLibevent* me = static_cast<TaskQueueLibevent*>(context);
+  RTC_DCHECK(me->timer_fd_ == fd);
+  uint64_t expirations;
+  // Only clears the readable state, the due times are in |precise_timers_|.
+  if (read(fd, &expirations, sizeof(expirations)) < 0)
+    RTC_DCHECK_EQ(EAGAIN, errno);
+  const int64_t now_us = MonotonicMicros();
+  while (!me->precise_timers_.empty() &&
+         me->precise_timers_.begin()->first <= now_us) {
+    std::unique_ptr<QueuedTask> task =
+        std::move(me->precise_timers_.begin()->second);
+    me->precise_timers_.erase(me->precise_timers_.begin());
+    if (!task->Run())
+      task.release();
+  }
+  me->ArmPreciseTimer();
+}
+
+void TaskQueueLibevent::ArmPreciseTimer() {
+  // An all zero |it_value| disarms the timer.
+  itimerspec spec = {};
+  if (!precise_timers_.empty()) {
+    int64_t fire_at_us = precise_timers_.begin()->first;
+    spec.it_value.tv_sec = fire_at_us / rtc::kNumMicrosecsPerSec;
+    spec.it_value.tv_nsec = (fire_at_us % rtc::kNumMicrosecsPerSec) *
+                            rtc::kNumNanosecsPerMicrosec;
+  }
+  RTC_CHECK_EQ(0, timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec,
+                                  nullptr));
+}
+#endif
+
 class TaskQueueLibeventFactory final : public TaskQueueFactory {
  public:
   std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
@@ -0,0 +1,295 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_mpsc.h"
+
+#include <atomic>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/mpsc_queue.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+namespace {
+
+rtc::ThreadPriority TaskQueuePriorityToThreadPriority(
+    TaskQueueFactory::Priority priority) {
+  switch (priority) {
+    case TaskQueueFactory::Priority::HIGH:
+      return rtc::kRealtimePriority;
+    case TaskQueueFactory::Priority::LOW:
+      return rtc::kLowPriority;
+    case TaskQueueFactory::Priority::NORMAL:
+      return rtc::kNormalPriority;
+    default:
+      RTC_NOTREACHED();
+      return rtc::kNormalPriority;
+  }
+}
+
+class TaskQueueMpsc final : public TaskQueueBase {
+ public:
+  TaskQueueMpsc(absl::string_view queue_name, rtc::ThreadPriority priority);
+  ~TaskQueueMpsc() override;
+
+  void Delete() override;
+  void PostTask(std::unique_ptr<QueuedTask> task) override;
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override;
+  void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                         int64_t microseconds) override;
+
+ private:
+  using OrderId = uint64_t;
+
+  // A posted task. Allocated by the posting thread and deleted by the queue's
+  // thread once the task has run.
+  struct TaskNode : public rtc::MpscQueueNode {
+    std::unique_ptr<QueuedTask> task;
+    OrderId order = 0;
+    // -1 for tasks that should run as soon as possible.
+    int64_t fire_at_us = -1;
+    // Link in |ready_head_|.
+    TaskNode* next_ready = nullptr;
+  };
+
+  struct FiresLater {
+    bool operator()(const TaskNode* a, const TaskNode* b) const {
+      if (a->fire_at_us != b->fire_at_us)
+        return a->fire_at_us > b->fire_at_us;
+      return a->order > b->order;
+    }
+  };
+
+  static void ThreadMain(void* context);
+
+  void Enqueue(TaskNode* node);
+  void ProcessTasks();
+  // Moves everything posted so far to the ready list or the timer heap.
+  void DrainIncoming();
+  // Returns the next task to run, or null and sets |*sleep_time_us| to how
+  // long to wait for the next delayed task (rtc::Event::kForever if none).
+  TaskNode* NextTask(int64_t* sleep_time_us);
+
+  // Indicates if the thread has started.
+  rtc::Event started_;
+
+  // Indicates if the thread has stopped.
+  rtc::Event stopped_;
+
+  // Signaled when a task is posted while the thread is (about to be) waiting.
+  rtc::Event flag_notify_;
+
+  // Contains the active worker thread assigned to processing
+  // tasks (including delayed tasks).
+  rtc::PlatformThread thread_;
+
+  std::atomic<bool> thread_should_quit_{false};
+  std::atomic<bool> sleeping_{false};
+  std::atomic<OrderId> thread_posting_order_{0};
+
+  // Tasks posted from any thread that the queue's thread has not looked at
+  // yet.
+  rtc::MpscQueue<TaskNode> incoming_;
+
+  // The members below are only used on the queue's thread.
+  TaskNode* ready_head_ = nullptr;
+  TaskNode* ready_tail_ = nullptr;
+  std::priority_queue<TaskNode*, std::vector<TaskNode*>, FiresLater>
+      delayed_queue_;
+};
+
+TaskQueueMpsc::TaskQueueMpsc(absl::string_view queue_name,
+                             rtc::ThreadPriority priority)
+    : started_(/*manual_reset=*/false, /*initially_signaled=*/false),
+      stopped_(/*manual_reset=*/false, /*initially_signaled=*/false),
+      flag_notify_(/*manual_reset=*/false, /*initially_signaled=*/false),
+      thread_(&TaskQueueMpsc::ThreadMain, this, queue_name, priority) {
+  thread_.Start();
+  started_.Wait(rtc::Event::kForever);
+}
+
+TaskQueueMpsc::~TaskQueueMpsc() {
+  // The queue's thread has stopped, so this thread is the only consumer now.
+  while (!incoming_.Empty()) {
+    TaskNode* node = incoming_.Pop();
+    if (node)
+      delete node;
+  }
+  while (ready_head_) {
+    TaskNode* node = ready_head_;
+    ready_head_ = node->next_ready;
+    delete node;
+  }
+  while (!delayed_queue_.empty()) {
+    delete delayed_queue_.top();
+    delayed_queue_.pop();
+  }
+}
+
+void TaskQueueMpsc::Delete() {
+  RTC_DCHECK(!IsCurrent());
+
+  thread_should_quit_.store(true, std::memory_order_release);
+  flag_notify_.Set();
+
+  stopped_.Wait(rtc::Event::kForever);
+  thread_.Stop();
+  delete this;
+}
+
+void TaskQueueMpsc::PostTask(std::unique_ptr<QueuedTask> task) {
+  TaskNode* node = new TaskNode();
+  node->task = std::move(task);
+  node->order =
+      thread_posting_order_.fetch_add(1, std::memory_order_relaxed);
+  Enqueue(node);
+}
+
+void TaskQueueMpsc::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                    uint32_t milliseconds) {
+  PostDelayedTaskUs(std::move(task),
+                    int64_t{milliseconds} * rtc::kNumMicrosecsPerMillisec);
+}
+
+void TaskQueueMpsc::PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                      int64_t microseconds) {
+  TaskNode* node = new TaskNode();
+  node->task = std::move(task);
+  node->order =
+      thread_posting_order_.fetch_add(1, std::memory_order_relaxed);
+  node->fire_at_us = rtc::TimeMicros() + microseconds;
+  Enqueue(node);
+}
+
+void TaskQueueMpsc::Enqueue(TaskNode* node) {
+  incoming_.Push(node);
+  // Pairs with the fence in ProcessTasks(): either the queue's thread sees
+  // the task before it waits, or this thread sees |sleeping_| and wakes it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed) &&
+      sleeping_.exchange(false, std::memory_order_relaxed)) {
+    flag_notify_.Set();
+  }
+}
+
+// static
+void TaskQueueMpsc::ThreadMain(void* context) {
+  TaskQueueMpsc* me = static_cast<TaskQueueMpsc*>(context);
+  CurrentTaskQueueSetter set_current(me);
+  me->ProcessTasks();
+}
+
+void TaskQueueMpsc::DrainIncoming() {
+  // Pop() only returns null with a non-empty queue while a producer is
+  // between the two steps of Push(), which is a handful of instructions.
+  while (!incoming_.Empty()) {
+    TaskNode* node = incoming_.Pop();
+    if (!node)
+      continue;
+    if (node->fire_at_us >= 0) {
+      delayed_queue_.push(node);
+    } else if (ready_tail_) {
+      ready_tail_->next_ready = node;
+      ready_tail_ = node;
+    } else {
+      ready_head_ = ready_tail_ = node;
+    }
+  }
+}
+
+TaskQueueMpsc::TaskNode* TaskQueueMpsc::NextTask(int64_t* sleep_time_us) {
+  *sleep_time_us = rtc::Event::kForever;
+  if (!delayed_queue_.empty()) {
+    TaskNode* delayed = delayed_queue_.top();
+    int64_t tick = rtc::TimeMicros();
+    if (tick >= delayed->fire_at_us) {
+      // Tasks posted before the delayed task became due run first.
+      if (ready_head_ && ready_head_->order < delayed->order) {
+        TaskNode* node = ready_head_;
+        ready_head_ = node->next_ready;
+        if (!ready_head_)
+          ready_tail_ = nullptr;
+        return node;
+      }
+      delayed_queue_.pop();
+      return delayed;
+    }
+    *sleep_time_us = delayed->fire_at_us - tick;
+  }
+  if (ready_head_) {
+    TaskNode* node = ready_head_;
+    ready_head_ = node->next_ready;
+    if (!ready_head_)
+      ready_tail_ = nullptr;
+    return node;
+  }
+  return nullptr;
+}
+
+void TaskQueueMpsc::ProcessTasks() {
+  started_.Set();
+
+  while (true) {
+    if (thread_should_quit_.load(std::memory_order_acquire))
+      break;
+
+    DrainIncoming();
+
+    int64_t sleep_time_us;
+    TaskNode* node = NextTask(&sleep_time_us);
+    if (node) {
+      QueuedTask* release_ptr = node->task.release();
+      delete node;
+      if (release_ptr->Run())
+        delete release_ptr;
+      continue;
+    }
+
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (incoming_.Empty() &&
+        !thread_should_quit_.load(std::memory_order_acquire)) {
+      flag_notify_.WaitUs(sleep_time_us);
+    }
+    // A producer that saw |sleeping_| may still set |flag_notify_| after
+    // this; that only costs one extra loop iteration later.
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+
+  stopped_.Set();
+}
+
+class TaskQueueMpscFactory final : public TaskQueueFactory {
+ public:
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+      absl::string_view name,
+      Priority priority) const override {
+    return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(
+        new TaskQueueMpsc(name, TaskQueuePriorityToThreadPriority(priority)));
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueMpscFactory() {
+  return absl::make_unique<TaskQueueMpscFactory>();
+}
+
+}  // namespace webrtc
@@ -0,0 +1,29 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_TASK_QUEUE_MPSC_H_
+#define RTC_BASE_TASK_QUEUE_MPSC_H_
+
+#include <memory>
+
+#include "api/task_queue/task_queue_factory.h"
+
+namespace webrtc {
+
+// Creates task queues that run on a dedicated thread, like the stdlib
+// implementation, but take no lock when tasks are posted: tasks go through a
+// lock-free multi-producer/single-consumer queue, delayed tasks are kept in a
+// timer heap owned by the queue's thread, and the thread is only signaled
+// when it is about to sleep.
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueMpscFactory();
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_TASK_QUEUE_MPSC_H_
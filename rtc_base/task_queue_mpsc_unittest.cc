@@ -0,0 +1,169 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_mpsc.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/task_queue/task_queue_test.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/task_queue_stdlib.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+INSTANTIATE_TEST_SUITE_P(Mpsc,
+                         TaskQueueTest,
+                         ::testing::Values(CreateTaskQueueMpscFactory));
+
+TEST(TaskQueueMpscTest, KeepsOrderOfTasksFromOneProducer) {
+  std::unique_ptr<TaskQueueFactory> factory = CreateTaskQueueMpscFactory();
+  auto queue = factory->CreateTaskQueue("KeepsOrder",
+                                        TaskQueueFactory::Priority::NORMAL);
+  static const int kNumTasks = 10000;
+  std::vector<int> order;
+  rtc::Event done;
+  for (int i = 0; i < kNumTasks; ++i) {
+    queue->PostTask(ToQueuedTask([&order, i] { order.push_back(i); }));
+  }
+  queue->PostTask(ToQueuedTask([&done] { done.Set(); }));
+  ASSERT_TRUE(done.Wait(10000));
+  ASSERT_EQ(static_cast<size_t>(kNumTasks), order.size());
+  for (int i = 0; i < kNumTasks; ++i)
+    EXPECT_EQ(i, order[i]);
+}
+
+TEST(TaskQueueMpscTest, RunsTasksFromManyProducers) {
+  std::unique_ptr<TaskQueueFactory> factory = CreateTaskQueueMpscFactory();
+  auto queue = factory->CreateTaskQueue("ManyProducers",
+                                        TaskQueueFactory::Priority::NORMAL);
+  static const int kNumProducers = 4;
+  static const int kTasksPerProducer = 10000;
+  std::atomic<int> remaining(kNumProducers * kTasksPerProducer);
+  rtc::Event done;
+  struct Producer {
+    TaskQueueBase* queue;
+    std::atomic<int>* remaining;
+    rtc::Event* done;
+  } producer = {queue.get(), &remaining, &done};
+  auto produce = [](void* context) {
+    Producer* p = static_cast<Producer*>(context);
+    for (int i = 0; i < kTasksPerProducer; ++i) {
+      p->queue->PostTask(ToQueuedTask([p] {
+        if (--*p->remaining == 0)
+          p->done->Set();
+      }));
+    }
+  };
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < kNumProducers; ++i) {
+    threads.push_back(
+        absl::make_unique<rtc::PlatformThread>(produce, &producer, "producer"));
+    threads.back()->Start();
+  }
+  EXPECT_TRUE(done.Wait(10000));
+  for (auto& thread : threads)
+    thread->Stop();
+  EXPECT_EQ(0, remaining.load());
+}
+
+struct ContentionResult {
+  double tasks_per_second;
+  double mean_latency_us;
+  int64_t max_latency_us;
+};
+
+// Posts |tasks_per_producer| tasks from each of |num_producers| threads and
+// measures how long it takes to run them all, and the delay between posting
+// and running each task.
+ContentionResult MeasureContention(const TaskQueueFactory& factory,
+                                   int num_producers,
+                                   int tasks_per_producer) {
+  auto queue =
+      factory.CreateTaskQueue("Contention", TaskQueueFactory::Priority::NORMAL);
+  struct State {
+    TaskQueueBase* queue;
+    int tasks_per_producer;
+    rtc::Event start{/*manual_reset=*/true, /*initially_signaled=*/false};
+    rtc::Event done;
+    int remaining;
+    int64_t total_latency_us = 0;
+    int64_t max_latency_us = 0;
+  } state;
+  state.queue = queue.get();
+  state.tasks_per_producer = tasks_per_producer;
+  state.remaining = num_producers * tasks_per_producer;
+  auto produce = [](void* context) {
+    State* s = static_cast<State*>(context);
+    s->start.Wait(rtc::Event::kForever);
+    for (int i = 0; i < s->tasks_per_producer; ++i) {
+      int64_t posted_us = rtc::TimeMicros();
+      // Runs on the queue, so |s| needs no locking.
+      s->queue->PostTask(ToQueuedTask([s, posted_us] {
+        int64_t latency_us = rtc::TimeMicros() - posted_us;
+        s->total_latency_us += latency_us;
+        s->max_latency_us = std::max(s->max_latency_us, latency_us);
+        if (--s->remaining == 0)
+          s->done.Set();
+      }));
+    }
+  };
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < num_producers; ++i) {
+    threads.push_back(
+        absl::make_unique<rtc::PlatformThread>(produce, &state, "producer"));
+    threads.back()->Start();
+  }
+  int64_t start_us = rtc::TimeMicros();
+  state.start.Set();
+  state.done.Wait(rtc::Event::kForever);
+  int64_t elapsed_us = std::max<int64_t>(1, rtc::TimeMicros() - start_us);
+  for (auto& thread : threads)
+    thread->Stop();
+
+  int total_tasks = num_producers * tasks_per_producer;
+  ContentionResult result;
+  result.tasks_per_second = total_tasks * 1e6 / elapsed_us;
+  result.mean_latency_us =
+      static_cast<double>(state.total_latency_us) / total_tasks;
+  result.max_latency_us = state.max_latency_us;
+  return result;
+}
+
+// Compares the lock-free queue with the stdlib one. Run manually, e.g. with
+// --gtest_also_run_disabled_tests --gtest_filter=*ContentionPerformance*.
+TEST(TaskQueueMpscTest, DISABLED_ContentionPerformance) {
+  static const int kTasksPerProducer = 200000;
+  for (int num_producers : {1, 4, 8}) {
+    ContentionResult stdlib = MeasureContention(
+        *CreateTaskQueueStdlibFactory(), num_producers, kTasksPerProducer);
+    ContentionResult mpsc = MeasureContention(
+        *CreateTaskQueueMpscFactory(), num_producers, kTasksPerProducer);
+    printf("%d producers: stdlib %.0f tasks/s, latency mean %.1f us max %d us\n",
+           num_producers, stdlib.tasks_per_second, stdlib.mean_latency_us,
+           static_cast<int>(stdlib.max_latency_us));
+    printf("%d producers: mpsc   %.0f tasks/s, latency mean %.1f us max %d us\n",
+           num_producers, mpsc.tasks_per_second, mpsc.mean_latency_us,
+           static_cast<int>(mpsc.max_latency_us));
+  }
+}
+
+}  // namespace
+}  // namespace webrtc
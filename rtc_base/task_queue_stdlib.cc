@@ -55,24 +55,26 @@ class TaskQueueStdlib final : public TaskQueueBase {
   void PostTask(std::unique_ptr<QueuedTask> task) override;
   void PostDelayedTask(std::unique_ptr<QueuedTask> task,
                        uint32_t milliseconds) override;
+  void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                         int64_t microseconds) override;
 
  private:
   using OrderId = uint64_t;
 
   struct DelayedEntryTimeout {
-    int64_t next_fire_at_ms_{};
+    int64_t next_fire_at_us_{};
     OrderId order_{};
 
     bool operator<(const DelayedEntryTimeout& o) const {
-      return std::tie(next_fire_at_ms_, order_) <
-             std::tie(o.next_fire_at_ms_, o.order_);
+      return std::tie(next_fire_at_us_, order_) <
+             std::tie(o.next_fire_at_us_, o.order_);
     }
   };
 
   struct NextTask {
     bool final_task_{false};
     std::unique_ptr<QueuedTask> run_task_;
-    int64_t sleep_time_ms_{};
+    int64_t sleep_time_us_{};
   };
 
   NextTask GetNextTask();
@@ -159,10 +161,16 @@ void TaskQueueStdlib::PostTask(std::unique_ptr<QueuedTask> task) {
 
 void TaskQueueStdlib::PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                       uint32_t milliseconds) {
-  auto fire_at = rtc::TimeMillis() + milliseconds;
+  PostDelayedTaskUs(std::move(task),
+                    int64_t{milliseconds} * rtc::kNumMicrosecsPerMillisec);
+}
+
+void TaskQueueStdlib::PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                        int64_t microseconds) {
+  auto fire_at = rtc::TimeMicros() + microseconds;
 
   DelayedEntryTimeout delay;
-  delay.next_fire_at_ms_ = fire_at;
+  delay.next_fire_at_us_ = fire_at;
 
   {
     rtc::CritScope lock(&pending_lock_);
@@ -176,7 +184,7 @@ void TaskQueueStdlib::PostDelayedTask(std::unique_ptr<QueuedTask> task,
 TaskQueueStdlib::NextTask TaskQueueStdlib::GetNextTask() {
   NextTask result{};
 
-  auto tick = rtc::TimeMillis();
+  auto tick = rtc::TimeMicros();
 
   rtc::CritScope lock(&pending_lock_);
 
@@ -189,7 +197,7 @@ TaskQueueStdlib::NextTask TaskQueueStdlib::GetNextTask() {
     auto delayed_entry = delayed_queue_.begin();
     const auto& delay_info = delayed_entry->first;
     auto& delay_run = delayed_entry->second;
-    if (tick >= delay_info.next_fire_at_ms_) {
+    if (tick >= delay_info.next_fire_at_us_) {
       if (pending_queue_.size() > 0) {
         auto& entry = pending_queue_.front();
         auto& entry_order = entry.first;
@@ -206,7 +214,7 @@ TaskQueueStdlib::NextTask TaskQueueStdlib::GetNextTask() {
       return result;
     }
 
-    result.sleep_time_ms_ = delay_info.next_fire_at_ms_ - tick;
+    result.sleep_time_us_ = delay_info.next_fire_at_us_ - tick;
   }
 
   if (pending_queue_.size() > 0) {
@@ -244,10 +252,10 @@ void TaskQueueStdlib::ProcessTasks() {
       continue;
     }
 
-    if (0 == task.sleep_time_ms_)
+    if (0 == task.sleep_time_us_)
       flag_notify_.Wait(rtc::Event::kForever);
     else
-      flag_notify_.Wait(task.sleep_time_ms_);
+      flag_notify_.WaitUs(task.sleep_time_us_);
   }
 
   stopped_.Set();
@@ -45,6 +45,11 @@ namespace {
 #define WM_RUN_TASK WM_USER + 1
 #define WM_QUEUE_DELAYED_TASK WM_USER + 2
 
+// Available since Windows 10 version 1803, older SDKs lack the define.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 void CALLBACK InitializeQueueThread(ULONG_PTR param) {
   MSG msg;
   ::PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
@@ -77,12 +82,26 @@ int64_t GetTick() {
   return ret;
 }
 
+// rtc::TimeMicros() is based on timeGetTime() here, which only has millisecond
+// resolution, so delayed tasks are timed with the performance counter.
+int64_t GetTickUs() {
+  static const int64_t kFrequency = [] {
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+  }();
+  LARGE_INTEGER now;
+  ::QueryPerformanceCounter(&now);
+  return now.QuadPart / kFrequency * rtc::kNumMicrosecsPerSec +
+         now.QuadPart % kFrequency * rtc::kNumMicrosecsPerSec / kFrequency;
+}
+
 class DelayedTaskInfo {
  public:
   // Default ctor needed to support priority_queue::pop().
   DelayedTaskInfo() {}
-  DelayedTaskInfo(uint32_t milliseconds, std::unique_ptr<QueuedTask> task)
-      : due_time_(GetTick() + milliseconds), task_(std::move(task)) {}
+  DelayedTaskInfo(int64_t microseconds, std::unique_ptr<QueuedTask> task)
+      : due_time_(GetTickUs() + microseconds), task_(std::move(task)) {}
   DelayedTaskInfo(DelayedTaskInfo&&) = default;
 
   // Implement for priority_queue.
@@ -102,7 +121,7 @@ class DelayedTaskInfo {
   int64_t due_time() const { return due_time_; }
 
  private:
-  int64_t due_time_ = 0;  // Absolute timestamp in milliseconds.
+  int64_t due_time_ = 0;  // Absolute GetTickUs() timestamp.
 
   // |task| needs to be mutable because std::priority_queue::top() returns
   // a const reference and a key in an ordered queue must not be changed.
@@ -114,26 +133,47 @@ class DelayedTaskInfo {
   mutable std::unique_ptr<QueuedTask> task_;
 };
 
+// Uses a high resolution waitable timer where the OS has one. Otherwise falls
+// back to a multimedia timer, which rounds delays up to whole milliseconds.
 class MultimediaTimer {
  public:
-  // Note: We create an event that requires manual reset.
-  MultimediaTimer() : event_(::CreateEvent(nullptr, true, false, nullptr)) {}
+  // Note: We create an event that requires manual reset. The waitable timer
+  // is a synchronization timer, a satisfied wait resets it.
+  MultimediaTimer()
+      : event_(::CreateEvent(nullptr, true, false, nullptr)),
+        high_res_timer_(::CreateWaitableTimerExW(
+            nullptr,
+            nullptr,
+            CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+            TIMER_ALL_ACCESS)) {}
 
   ~MultimediaTimer() {
     Cancel();
     ::CloseHandle(event_);
+    if (high_res_timer_)
+      ::CloseHandle(high_res_timer_);
   }
 
-  bool StartOneShotTimer(UINT delay_ms) {
-    RTC_DCHECK_EQ(0, timer_id_);
-    RTC_DCHECK(event_ != nullptr);
-    timer_id_ =
-        ::timeSetEvent(delay_ms, 0, reinterpret_cast<LPTIMECALLBACK>(event_), 0,
-                       TIME_ONESHOT | TIME_CALLBACK_EVENT_SET);
-    return timer_id_ != 0;
+  bool StartOneShotTimerUs(int64_t delay_us) {
+    if (!high_res_timer_) {
+      return StartOneShotTimer(rtc::dchecked_cast<UINT>(
+          (delay_us + rtc::kNumMicrosecsPerMillisec - 1) /
+          rtc::kNumMicrosecsPerMillisec));
+    }
+    // A negative due time is relative, in 100 nanosecond units.
+    LARGE_INTEGER due_time;
+    due_time.QuadPart = -delay_us * 10;
+    return ::SetWaitableTimer(high_res_timer_, &due_time, 0, nullptr, nullptr,
+                              FALSE) != 0;
   }
 
   void Cancel() {
+    if (high_res_timer_) {
+      ::CancelWaitableTimer(high_res_timer_);
+      // Consumes a signal that has not been waited for.
+      ::WaitForSingleObject(high_res_timer_, 0);
+      return;
+    }
     ::ResetEvent(event_);
     if (timer_id_) {
       ::timeKillEvent(timer_id_);
@@ -141,10 +181,22 @@ class MultimediaTimer {
     }
   }
 
-  HANDLE* event_for_wait() { return &event_; }
+  HANDLE* event_for_wait() {
+    return high_res_timer_ ? &high_res_timer_ : &event_;
+  }
 
  private:
+  bool StartOneShotTimer(UINT delay_ms) {
+    RTC_DCHECK_EQ(0, timer_id_);
+    RTC_DCHECK(event_ != nullptr);
+    timer_id_ =
+        ::timeSetEvent(delay_ms, 0, reinterpret_cast<LPTIMECALLBACK>(event_), 0,
+                       TIME_ONESHOT | TIME_CALLBACK_EVENT_SET);
+    return timer_id_ != 0;
+  }
+
   HANDLE event_ = nullptr;
+  HANDLE high_res_timer_ = nullptr;
   MMRESULT timer_id_ = 0;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(MultimediaTimer);
@@ -159,6 +211,8 @@ class TaskQueueWin : public TaskQueueBase {
   void PostTask(std::unique_ptr<QueuedTask> task) override;
   void PostDelayedTask(std::unique_ptr<QueuedTask> task,
                        uint32_t milliseconds) override;
+  void PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                         int64_t microseconds) override;
 
   void RunPendingTasks();
 
@@ -238,7 +292,13 @@ void TaskQueueWin::PostTask(std::unique_ptr<QueuedTask> task) {
 
 void TaskQueueWin::PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                    uint32_t milliseconds) {
-  if (!milliseconds) {
+  PostDelayedTaskUs(std::move(task),
+                    int64_t{milliseconds} * rtc::kNumMicrosecsPerMillisec);
+}
+
+void TaskQueueWin::PostDelayedTaskUs(std::unique_ptr<QueuedTask> task,
+                                     int64_t microseconds) {
+  if (microseconds <= 0) {
     PostTask(std::move(task));
     return;
   }
@@ -247,7 +307,7 @@ void TaskQueueWin::PostDelayedTask(std::unique_ptr<QueuedTask> task,
   // the timestamp stored in the task info object, is a 64bit timestamp
   // and WPARAM is 32bits in 32bit builds.  Otherwise, we could pass the
   // task pointer and timestamp as LPARAM and WPARAM.
-  auto* task_info = new DelayedTaskInfo(milliseconds, std::move(task));
+  auto* task_info = new DelayedTaskInfo(microseconds, std::move(task));
   if (!::PostThreadMessage(thread_.GetThreadRef(), WM_QUEUE_DELAYED_TASK, 0,
                            reinterpret_cast<LPARAM>(task_info))) {
     delete task_info;
@@ -363,7 +423,7 @@ bool TaskQueueWin::ProcessQueuedMessages() {
 
 void TaskQueueWin::RunDueTasks() {
   RTC_DCHECK(!timer_tasks_.empty());
-  auto now = GetTick();
+  auto now = GetTickUs();
   do {
     const auto& top = timer_tasks_.top();
     if (top.due_time() > now)
@@ -379,10 +439,13 @@ void TaskQueueWin::ScheduleNextTimer() {
     return;
 
   const auto& next_task = timer_tasks_.top();
-  int64_t delay_ms = std::max(0ll, next_task.due_time() - GetTick());
-  uint32_t milliseconds = rtc::dchecked_cast<uint32_t>(delay_ms);
-  if (!timer_.StartOneShotTimer(milliseconds))
+  int64_t delay_us = std::max(0ll, next_task.due_time() - GetTickUs());
+  if (!timer_.StartOneShotTimerUs(delay_us)) {
+    uint32_t milliseconds = rtc::dchecked_cast<uint32_t>(
+        (delay_us + rtc::kNumMicrosecsPerMillisec - 1) /
+        rtc::kNumMicrosecsPerMillisec);
     timer_id_ = ::SetTimer(nullptr, 0, milliseconds, nullptr);
+  }
 }
 
 void TaskQueueWin::CancelTimers() {
@@ -14,6 +14,7 @@
 
 #include "api/scoped_refptr.h"
 #include "api/video/i420_buffer.h"
+#include "api/video/i420_buffer_pyramid.h"
 #include "api/video/video_frame_buffer.h"
 #include "api/video/video_rotation.h"
 
@@ -36,11 +37,12 @@ void TestVideoCapturer::OnFrame(const VideoFrame& frame) {
   }
 
   if (out_height != frame.height() || out_width != frame.width()) {
-    // Video adapter has requested a down-scale. Allocate a new buffer and
-    // return scaled version.
-    rtc::scoped_refptr<I420Buffer> scaled_buffer =
-        I420Buffer::Create(out_width, out_height);
-    scaled_buffer->ScaleFrom(*frame.video_frame_buffer()->ToI420());
+    // Video adapter has requested a down-scale. Return a scaled version,
+    // shared with other consumers of the buffer.
+    rtc::scoped_refptr<I420BufferInterface> source_buffer =
+        frame.video_frame_buffer()->ToI420();
+    rtc::scoped_refptr<I420BufferInterface> scaled_buffer =
+        I420BufferPyramid::Of(source_buffer)->Scale(out_width, out_height);
     broadcaster_.OnFrame(VideoFrame::Builder()
                              .set_video_frame_buffer(scaled_buffer)
                              .set_rotation(kVideoRotation_0)
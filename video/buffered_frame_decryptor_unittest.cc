@@ -47,6 +47,12 @@ class FakePacketBuffer : public video_coding::PacketBuffer {
     return true;
   }
 
+  const uint8_t* GetContiguousBitstream(
+      const video_coding::RtpFrameObject& frame,
+      rtc::scoped_refptr<video_coding::PayloadSlab>* slab) override {
+    return nullptr;
+  }
+
   void ReturnFrame(video_coding::RtpFrameObject* frame) override {
     packets_.erase(frame->first_seq_num());
   }
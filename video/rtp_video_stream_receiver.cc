@@ -299,9 +299,10 @@ int32_t RtpVideoStreamReceiver::OnReceivedPayloadData(const uint8_t* payload_dat
   } 
   else 
   {
-    uint8_t* data = new uint8_t[packet.sizeBytes];
-    memcpy(data, packet.dataPtr, packet.sizeBytes);
-    packet.dataPtr = data;
+    // The payload is copied by the packet buffer, next to the payloads of the
+    // packets received before it.
+    packet_buffer_->CopyAndInsertPacket(&packet);
+    return 0;
   }
 
   packet_buffer_->InsertPacket(&packet);
@@ -19,6 +19,7 @@
 #include "absl/memory/memory.h"
 #include "api/video/encoded_image.h"
 #include "api/video/i420_buffer.h"
+#include "api/video/i420_buffer_pyramid.h"
 #include "api/video/video_bitrate_allocator_factory.h"
 #include "modules/video_coding/codecs/vp9/svc_rate_allocator.h"
 #include "modules/video_coding/include/video_codec_initializer.h"
@@ -1276,22 +1277,25 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
   {
     int cropped_width = video_frame.width() - crop_width_;
     int cropped_height = video_frame.height() - crop_height_;
-    rtc::scoped_refptr<I420Buffer> cropped_buffer = I420Buffer::Create(cropped_width, cropped_height);
+    // The pyramid shares the result with other consumers of the buffer.
+    rtc::scoped_refptr<I420BufferInterface> source_buffer =
+        video_frame.video_frame_buffer()->ToI420();
+    I420BufferPyramid* pyramid = I420BufferPyramid::Of(source_buffer);
+    rtc::scoped_refptr<I420BufferInterface> cropped_buffer;
     // TODO(ilnik): Remove scaling if cropping is too big, as it should never
     // happen after SinkWants signaled correctly from ReconfigureEncoder.
     VideoFrame::UpdateRect update_rect = video_frame.update_rect();
     if (crop_width_ < 4 && crop_height_ < 4) {
-      cropped_buffer->CropAndScaleFrom(
-          *video_frame.video_frame_buffer()->ToI420(), crop_width_ / 2,
-          crop_height_ / 2, cropped_width, cropped_height);
+      cropped_buffer = pyramid->CropAndScale(crop_width_ / 2, crop_height_ / 2,
+                                             cropped_width, cropped_height,
+                                             cropped_width, cropped_height);
       update_rect.offset_x -= crop_width_ / 2;
       update_rect.offset_y -= crop_height_ / 2;
       update_rect.Intersect(
           VideoFrame::UpdateRect{0, 0, cropped_width, cropped_height});
 
     } else {
-      cropped_buffer->ScaleFrom(
-          *video_frame.video_frame_buffer()->ToI420().get());
+      cropped_buffer = pyramid->Scale(cropped_width, cropped_height);
       if (!update_rect.IsEmpty()) {
         // Since we can't reason about pixels after scaling, we invalidate whole
         // picture, if anything changed.